@@ -0,0 +1,236 @@
+#include "ArcGauge.h"
+
+#include <Adafruit_GFX.h>
+#include <math.h>
+
+namespace {
+// sin(i * 0.5 deg) in Q14, i = 0..180
+const int16_t kSinQ14[181] = {
+  0, 143, 286, 429, 572, 715, 857, 1000, 1143, 1285, 1428, 1570,
+  1713, 1855, 1997, 2139, 2280, 2422, 2563, 2704, 2845, 2986, 3126, 3266,
+  3406, 3546, 3686, 3825, 3964, 4102, 4240, 4378, 4516, 4653, 4790, 4927,
+  5063, 5199, 5334, 5469, 5604, 5738, 5872, 6005, 6138, 6270, 6402, 6533,
+  6664, 6794, 6924, 7053, 7182, 7311, 7438, 7565, 7692, 7818, 7943, 8068,
+  8192, 8316, 8438, 8561, 8682, 8803, 8923, 9043, 9162, 9280, 9397, 9514,
+  9630, 9746, 9860, 9974, 10087, 10199, 10311, 10422, 10531, 10641, 10749, 10856,
+  10963, 11069, 11174, 11278, 11381, 11484, 11585, 11686, 11786, 11885, 11982, 12080,
+  12176, 12271, 12365, 12458, 12551, 12642, 12733, 12822, 12911, 12998, 13085, 13170,
+  13255, 13338, 13421, 13502, 13583, 13662, 13741, 13818, 13894, 13970, 14044, 14117,
+  14189, 14260, 14330, 14399, 14466, 14533, 14598, 14663, 14726, 14788, 14849, 14909,
+  14968, 15025, 15082, 15137, 15191, 15244, 15296, 15346, 15396, 15444, 15491, 15537,
+  15582, 15626, 15668, 15709, 15749, 15788, 15826, 15862, 15897, 15931, 15964, 15996,
+  16026, 16055, 16083, 16110, 16135, 16159, 16182, 16204, 16225, 16244, 16262, 16279,
+  16294, 16309, 16322, 16333, 16344, 16353, 16362, 16368, 16374, 16378, 16382, 16383,
+  16384,
+};
+
+constexpr uint16_t START_HALF_DEG = 300;   // 150 deg: sweep starts bottom-left, runs clockwise
+
+ArcGauge::Stats g_stats{};
+
+// Any angle in 0.5 degree units (screen coordinates, y down)
+int32_t sinQ14(int32_t h) {
+  h %= 720;
+  if (h < 0) h += 720;
+  if (h <= 180) return kSinQ14[h];
+  if (h <= 360) return kSinQ14[360 - h];
+  if (h <= 540) return -kSinQ14[h - 360];
+  return -kSinQ14[720 - h];
+}
+inline int32_t cosQ14(int32_t h) { return sinQ14(h + 180); }
+
+inline float unitX(uint16_t step) { return cosQ14(START_HALF_DEG + step) / 16384.0f; }
+inline float unitY(uint16_t step) { return sinQ14(START_HALF_DEG + step) / 16384.0f; }
+
+uint16_t blend565(uint16_t fg, uint16_t bg, float a) {
+  const uint8_t k = static_cast<uint8_t>(a * 32.0f + 0.5f);
+  const uint32_t f = (fg | (static_cast<uint32_t>(fg) << 16)) & 0x07E0F81Fu;
+  const uint32_t b = (bg | (static_cast<uint32_t>(bg) << 16)) & 0x07E0F81Fu;
+  const uint32_t m = ((f * k + b * (32 - k)) >> 5) & 0x07E0F81Fu;
+  return static_cast<uint16_t>(m | (m >> 16));
+}
+
+// floor(sqrt(n)), n >= 0
+int32_t isqrt(int32_t n) {
+  int32_t v = static_cast<int32_t>(sqrtf(static_cast<float>(n)));
+  while (v * v > n) v--;
+  while ((v + 1) * (v + 1) <= n) v++;
+  return v;
+}
+
+int32_t floorDiv(int32_t a, int32_t b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+
+struct Span {
+  int32_t lo, hi;
+};
+
+// The dx in [-lim, lim] with cx * dx + c0 >= 0; lo > hi when there are none
+Span halfPlane(int32_t cx, int32_t c0, int32_t lim) {
+  if (cx > 0) return {max(-lim, -floorDiv(c0, cx)), lim};
+  if (cx < 0) return {-lim, min(lim, floorDiv(c0, -cx))};
+  return c0 >= 0 ? Span{-lim, lim} : Span{1, 0};
+}
+
+struct Segment {
+  float ax, ay, bx, by;
+  float dx, dy, len2;
+};
+
+Segment needleSegment(const ArcGauge::Geometry& d, uint16_t step) {
+  const float ux = unitX(step), uy = unitY(step);
+  Segment s;
+  s.ax = d.cx + ux * d.needleIn;
+  s.ay = d.cy + uy * d.needleIn;
+  s.bx = d.cx + ux * d.needleOut;
+  s.by = d.cy + uy * d.needleOut;
+  s.dx = s.bx - s.ax;
+  s.dy = s.by - s.ay;
+  s.len2 = s.dx * s.dx + s.dy * s.dy;
+  return s;
+}
+
+// 0..1 pixel coverage of a thick segment with a one-pixel linear falloff
+float coverage(const Segment& s, float halfW, float px, float py) {
+  float t = ((px - s.ax) * s.dx + (py - s.ay) * s.dy) / s.len2;
+  t = t < 0 ? 0 : (t > 1 ? 1 : t);
+  const float ex = s.ax + t * s.dx - px, ey = s.ay + t * s.dy - py;
+  const float c = halfW + 0.5f - sqrtf(ex * ex + ey * ey);
+  return c <= 0 ? 0 : (c >= 1 ? 1 : c);
+}
+
+// Walk the needle's pixels row by row. Fully covered runs go out as one fast HLine,
+// edge pixels individually. erase: write bg instead, skipping pixels `keep` covers fully.
+uint32_t spanNeedle(Adafruit_GFX& g, const Segment& s, float halfW, uint16_t col, uint16_t bg,
+                    bool erase, const Segment* keep) {
+  const float pad = halfW + 1.0f;
+  const int y0 = static_cast<int>(floorf(fminf(s.ay, s.by) - pad));
+  const int y1 = static_cast<int>(ceilf(fmaxf(s.ay, s.by) + pad));
+  const int x0 = static_cast<int>(floorf(fminf(s.ax, s.bx) - pad));
+  const int x1 = static_cast<int>(ceilf(fmaxf(s.ax, s.bx) + pad));
+  uint32_t written = 0;
+  for (int y = y0; y <= y1; y++) {
+    int runStart = -1;
+    for (int x = x0; x <= x1 + 1; x++) {
+      float a = (x <= x1) ? coverage(s, halfW, x, y) : 0;
+      if (erase && a > 0 && keep && coverage(*keep, halfW, x, y) >= 1.0f) a = 0;
+      const bool full = erase ? (a > 0) : (a >= 1.0f);
+      if (full) {
+        if (runStart < 0) runStart = x;
+        continue;
+      }
+      if (runStart >= 0) {
+        g.drawFastHLine(runStart, y, x - runStart, erase ? bg : col);
+        written += x - runStart;
+        runStart = -1;
+      }
+      if (!erase && a > 0) {
+        g.drawPixel(x, y, blend565(col, bg, a));
+        written++;
+      }
+    }
+  }
+  return written;
+}
+}  // namespace
+
+namespace ArcGauge {
+Geometry geometryFor(int16_t x, int16_t y, int16_t w, int16_t h) {
+  Geometry d;
+  d.r = static_cast<int16_t>(min(w, h) / 2 - 5);
+  d.cx = x + w / 2;
+  d.cy = y + h / 2 + d.r / 8;                 // the open bottom needs less room than the top
+  const int16_t band = max<int16_t>(4, d.r / 9);
+  d.bandIn = d.r - band;
+  d.zoneIn = d.bandIn - 3;
+  d.tickOut = d.zoneIn - 2;
+  d.tickIn = d.tickOut - max<int16_t>(4, d.r / 8);
+  d.hub = max<int16_t>(3, d.r / 12);
+  d.needleHalfW = (d.r >= 70) ? 1.6f : 1.1f;
+  d.needleIn = d.hub + 3;
+  d.needleOut = d.tickIn - 4;
+  return d;
+}
+
+uint16_t stepFor(float t) {
+  if (!(t > 0)) return 0;
+  if (t >= 1) return SWEEP_STEPS;
+  return static_cast<uint16_t>(t * SWEEP_STEPS + 0.5f);
+}
+
+void fillArc(Adafruit_GFX& g, const Geometry& d, int16_t r0, int16_t r1, uint16_t s0, uint16_t s1, uint16_t col) {
+  if (s1 < s0 || r1 < r0) return;
+  const int32_t sx = cosQ14(START_HALF_DEG + s0), sy = sinQ14(START_HALF_DEG + s0);
+  const int32_t ex = cosQ14(START_HALF_DEG + s1), ey = sinQ14(START_HALF_DEG + s1);
+  const bool wide = (s1 - s0) > 360;          // over 180 degrees: the union of the two edge half-planes
+  const int32_t rin2 = static_cast<int32_t>(r0) * r0, rout2 = static_cast<int32_t>(r1) * r1;
+  for (int32_t dy = -r1; dy <= r1; dy++) {
+    const int32_t xo = isqrt(rout2 - dy * dy);
+    Span ring[2];
+    uint8_t nRing = 1;
+    ring[0] = {-xo, xo};
+    if (dy * dy < rin2) {
+      int32_t xi = isqrt(rin2 - dy * dy);
+      if (xi * xi < rin2 - dy * dy) xi++;
+      if (xi > xo) continue;
+      ring[0] = {-xo, -xi};
+      ring[1] = {xi, xo};
+      nRing = 2;
+    }
+    // cross(S, P) >= 0 and cross(P, E) >= 0, P = (dx, dy)
+    const Span a = halfPlane(-sy, sx * dy, xo), b = halfPlane(ey, -ex * dy, xo);
+    Span sector[2];
+    uint8_t nSector = 0;
+    if (!wide) {
+      Span s = {max(a.lo, b.lo), min(a.hi, b.hi)};
+      if (s0 == s1) {                         // a single ray: drop the opposite one
+        const Span fwd = halfPlane(sx, sy * dy, xo);
+        s = {max(s.lo, fwd.lo), min(s.hi, fwd.hi)};
+      }
+      if (s.lo <= s.hi) sector[nSector++] = s;
+    } else if (a.lo > a.hi || b.lo > b.hi) {
+      if (a.lo <= a.hi) sector[nSector++] = a;
+      if (b.lo <= b.hi) sector[nSector++] = b;
+    } else if (max(a.lo, b.lo) <= min(a.hi, b.hi) + 1) {
+      sector[nSector++] = {min(a.lo, b.lo), max(a.hi, b.hi)};
+    } else {
+      sector[nSector++] = a.lo < b.lo ? a : b;
+      sector[nSector++] = a.lo < b.lo ? b : a;
+    }
+    for (uint8_t i = 0; i < nRing; i++) {
+      for (uint8_t j = 0; j < nSector; j++) {
+        const int32_t lo = max(ring[i].lo, sector[j].lo), hi = min(ring[i].hi, sector[j].hi);
+        if (lo <= hi) g.drawFastHLine(d.cx + lo, d.cy + dy, hi - lo + 1, col);
+      }
+    }
+  }
+}
+
+void drawTicks(Adafruit_GFX& g, const Geometry& d, uint8_t majors, uint16_t col) {
+  if (majors == 0) return;
+  for (uint8_t i = 0; i <= majors; i++) {
+    const uint16_t step = static_cast<uint16_t>(static_cast<uint32_t>(SWEEP_STEPS) * i / majors);
+    const float ux = unitX(step), uy = unitY(step);
+    g.drawLine(d.cx + lroundf(ux * d.tickIn), d.cy + lroundf(uy * d.tickIn),
+               d.cx + lroundf(ux * d.tickOut), d.cy + lroundf(uy * d.tickOut), col);
+  }
+}
+
+void drawHub(Adafruit_GFX& g, const Geometry& d, uint16_t col) { g.fillCircle(d.cx, d.cy, d.hub, col); }
+
+void moveNeedle(Adafruit_GFX& g, const Geometry& d, int16_t oldStep, uint16_t newStep, uint16_t col, uint16_t bg) {
+  const Segment next = needleSegment(d, newStep);
+  uint32_t written = 0;
+  if (oldStep != NO_NEEDLE) {
+    const Segment prev = needleSegment(d, static_cast<uint16_t>(oldStep));
+    written += spanNeedle(g, prev, d.needleHalfW, col, bg, true, &next);
+  }
+  written += spanNeedle(g, next, d.needleHalfW, col, bg, false, nullptr);
+  const uint32_t box = static_cast<uint32_t>(2 * d.r + 1) * (2 * d.r + 1);
+  g_stats.updates++;
+  g_stats.pixelsWritten += written;
+  g_stats.naivePixels += box;
+}
+
+const Stats& stats() { return g_stats; }
+void resetStats() { g_stats = Stats{}; }
+}  // namespace ArcGauge
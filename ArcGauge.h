@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+
+class Adafruit_GFX;
+
+// Round 240-degree dial with a needle, for the layout engine's WK_DIAL cells.
+// Trig comes from a quarter-wave sine table (0.5 degree steps). The needle is an anti-aliased
+// thick line drawn as per-row spans; moving it rewrites only the old and new spans (old pixels
+// go back to the card colour, which is all that lies under the needle sweep), so the face,
+// ticks and arc band are never cleared.
+namespace ArcGauge {
+  constexpr uint16_t SWEEP_STEPS = 480;      // 240 degrees in 0.5 degree steps
+  constexpr int16_t  NO_NEEDLE   = -1;
+
+  struct Geometry {
+    int16_t cx, cy, r;
+    int16_t bandIn;       // arc band spans bandIn..r
+    int16_t zoneIn;       // warning-zone ring spans zoneIn..bandIn-1
+    int16_t tickIn, tickOut;
+    int16_t needleIn, needleOut;
+    int16_t hub;
+    float   needleHalfW;
+  };
+
+  Geometry geometryFor(int16_t x, int16_t y, int16_t w, int16_t h);
+
+  // t in 0..1 along the sweep (clamped)
+  uint16_t stepFor(float t);
+
+  // Annulus sector [r0, r1] x [s0, s1] in sweep steps, filled as horizontal runs whose ends come
+  // from the two edge directions row by row (integer half-plane bounds, no per-pixel trig)
+  void fillArc(Adafruit_GFX& g, const Geometry& d, int16_t r0, int16_t r1, uint16_t s0, uint16_t s1, uint16_t col);
+  // Tick marks every `majors` fraction of the sweep
+  void drawTicks(Adafruit_GFX& g, const Geometry& d, uint8_t majors, uint16_t col);
+  void drawHub(Adafruit_GFX& g, const Geometry& d, uint16_t col);
+  // Erase the needle at oldStep (NO_NEEDLE = nothing drawn yet) and draw it at newStep
+  void moveNeedle(Adafruit_GFX& g, const Geometry& d, int16_t oldStep, uint16_t newStep, uint16_t col, uint16_t bg);
+
+  // Pixels pushed by moveNeedle() versus what redrawing the whole dial box would push
+  struct Stats {
+    uint32_t updates;
+    uint32_t pixelsWritten;
+    uint32_t naivePixels;
+  };
+  const Stats& stats();
+  void resetStats();
+}
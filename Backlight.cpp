@@ -0,0 +1,101 @@
+#include "Backlight.h"
+#include <driver/ledc.h>
+
+namespace {
+// The backlight is the only LEDC user in the sketch
+constexpr ledc_mode_t    MODE    = LEDC_LOW_SPEED_MODE;
+constexpr ledc_channel_t CHANNEL = LEDC_CHANNEL_0;
+constexpr ledc_timer_t   TIMER   = LEDC_TIMER_0;
+constexpr uint32_t DUTY_MAX = (1u << Backlight::PWM_BITS) - 1;
+constexpr uint8_t  END_SLACK_MS = 2;   // fader end interrupt lands a tick after the nominal time
+
+bool s_ready = false;
+uint8_t s_target = 255;
+unsigned long s_rampEndMs = 0;
+bool s_ramping = false;
+bool s_parked = false;
+uint8_t s_parkedPct = 0;
+uint16_t s_parkedMs = 0;
+
+void start(uint8_t pct, uint16_t ms) {
+  const uint32_t duty = Backlight::dutyFor(pct);
+  if (ms == 0) {
+    ledc_set_duty(MODE, CHANNEL, duty);
+    ledc_update_duty(MODE, CHANNEL);
+    s_ramping = false;
+    return;
+  }
+  ledc_set_fade_with_time(MODE, CHANNEL, duty, ms);
+  ledc_fade_start(MODE, CHANNEL, LEDC_FADE_NO_WAIT);
+  s_ramping = true;
+  s_rampEndMs = millis() + ms + END_SLACK_MS;
+}
+}  // namespace
+
+namespace Backlight {
+void begin(uint8_t pin) {
+  ledc_timer_config_t t = {};
+  t.speed_mode = MODE;
+  t.duty_resolution = static_cast<ledc_timer_bit_t>(PWM_BITS);
+  t.timer_num = TIMER;
+  t.freq_hz = PWM_HZ;
+  t.clk_cfg = LEDC_AUTO_CLK;
+  ledc_timer_config(&t);
+
+  ledc_channel_config_t c = {};
+  c.gpio_num = pin;
+  c.speed_mode = MODE;
+  c.channel = CHANNEL;
+  c.timer_sel = TIMER;
+  c.duty = 0;
+  c.hpoint = 0;
+  ledc_channel_config(&c);
+  ledc_fade_func_install(0);
+  s_ready = true;
+}
+
+uint32_t dutyFor(uint8_t pct) {
+  if (pct == 0) {
+    return 0;
+  }
+  if (pct >= 100) {
+    return DUTY_MAX;
+  }
+  const uint32_t d = static_cast<uint32_t>(powf(pct / 100.0f, GAMMA) * DUTY_MAX + 0.5f);
+  return d ? d : 1;   // keep the lowest settings visibly on
+}
+
+void fadeTo(uint8_t pct, uint16_t ms) {
+  if (pct > 100) {
+    pct = 100;
+  }
+  if (!s_ready || (pct == s_target && !s_parked)) {
+    return;
+  }
+  s_target = pct;
+  if (busy(millis())) {
+    s_parked = true;
+    s_parkedPct = pct;
+    s_parkedMs = ms;
+    return;
+  }
+  start(pct, ms);
+}
+
+void update(unsigned long nowMs) {
+  if (s_ramping && static_cast<long>(nowMs - s_rampEndMs) >= 0) {
+    s_ramping = false;
+  }
+  if (s_parked && !s_ramping) {
+    s_parked = false;
+    start(s_parkedPct, s_parkedMs);
+  }
+}
+
+bool busy(unsigned long nowMs) {
+  update(nowMs);
+  return s_ramping || s_parked;
+}
+
+uint8_t target() { return s_target; }
+}  // namespace Backlight
@@ -0,0 +1,23 @@
+#pragma once
+#include <Arduino.h>
+
+// Backlight PWM on the ESP32 LEDC peripheral.
+// Brightness is requested in percent and mapped through a gamma curve, so equal steps look
+// equally bright. Ramps run on the LEDC hardware fader: fadeTo() programs the ramp and returns.
+// The driver blocks if a ramp is started while another is running, so a request that arrives
+// mid-ramp is parked and update() starts it once the running ramp has finished.
+namespace Backlight {
+  constexpr uint32_t PWM_HZ   = 5000;
+  constexpr uint8_t  PWM_BITS = 12;
+  constexpr float    GAMMA    = 2.2f;
+
+  void begin(uint8_t pin);
+  // Ramp to pct over ms (0 = immediate). Never blocks.
+  void fadeTo(uint8_t pct, uint16_t ms);
+  void update(unsigned long nowMs);
+  // Hardware ramp running or a request parked
+  bool busy(unsigned long nowMs);
+  // Most recent requested level (255 before the first request)
+  uint8_t target();
+  uint32_t dutyFor(uint8_t pct);
+}
@@ -0,0 +1,534 @@
+#include "BusSim.h"
+#include <math.h>
+#include <string.h>
+#include "CanDecode.h"
+#include "Config.h"
+#include "HeapMon.h"
+
+namespace {
+using namespace BusSim;
+
+constexpr uint8_t BUS_PT = CFG::CAN_BUS_PT;
+constexpr uint8_t BUS_BODY = CFG::CAN2_ENABLED ? CFG::CAN_BUS_BODY : CFG::CAN_BUS_PT;
+constexpr uint32_t FILLER_BASE[CanBus::MAX_BUSES] = {0x600, 0x700};
+constexpr uint8_t FILLER_IDS = 0x80;
+constexpr uint8_t BURST_FRAMES = 64;
+constexpr uint32_t BURST_EVERY_US = 10000000;
+constexpr uint8_t SHORT_DLC_EVERY = 10;
+constexpr uint32_t MISSING_EVERY_MS = 30000, MISSING_MS = 5000;
+
+struct Source {
+  uint32_t id;
+  uint16_t periodMs;
+  uint8_t bus;
+};
+
+const Source kSources[] = {
+  {CFG::ID_RPM_SPEED, 10, BUS_PT},   {CFG::ID_SPEED, 20, BUS_PT},      {CFG::ID_GEAR_LOCK, 20, BUS_PT},
+  {CFG::ID_TORQUE, 20, BUS_PT},      {CFG::ID_BOOST, 50, BUS_PT},      {CFG::ID_LAMBDA, 50, BUS_PT},
+  {CFG::ID_ACTUATOR, 50, BUS_PT},    {CFG::ID_TRANS_T, 100, BUS_PT},   {CFG::ID_BATTV, 100, BUS_PT},
+  {CFG::ID_COOLANT_ETC, 100, BUS_PT}, {CFG::ID_REGEN, 100, BUS_PT},    {CFG::ID_EGT1, 100, BUS_PT},
+  {CFG::ID_MAP_T, 100, BUS_PT},      {CFG::ID_SOOT, 500, BUS_PT},      {CFG::ID_HEADLIGHTS, 100, BUS_BODY},
+  {CFG::ID_SWBTN, 50, BUS_BODY},
+};
+constexpr uint8_t SOURCE_COUNT = sizeof(kSources) / sizeof(kSources[0]);
+
+// The mock controller's view of one bus: the wire, what is queued on it and the RX buffers
+struct Wire {
+  uint32_t bitrate;
+  uint64_t freeUs;        // wire idle from here
+  uint64_t busyUs;        // wire time used this level
+  uint64_t fillerNextUs;
+  uint32_t fillerEveryUs; // 0 = no filler needed
+  uint64_t burstNextUs;
+  uint8_t burstLeft;
+  uint8_t fillerSeq;
+  can_frame rx[RX_BUFFERS];
+  uint8_t rxHead, rxCount;
+};
+
+Config g_cfg = {};
+bool g_active = false;
+Wire g_wire[CanBus::MAX_BUSES] = {};
+uint64_t g_sourceNextUs[SOURCE_COUNT] = {};
+uint32_t g_sourceSent[SOURCE_COUNT] = {};
+uint64_t g_nowUs = 0;   // sim clock, micros() unwrapped
+uint32_t g_lastMicros = 0;
+
+uint8_t g_level = 0;
+unsigned long g_levelStartMs = 0;
+uint64_t g_levelStartUs = 0;
+LevelResult g_run = {};   // level in progress
+LevelResult g_last = {};
+uint32_t g_levelsDone = 0;
+
+// Pass boundaries, seen from read(): MAX_BUSES empty answers in a row end the drain
+uint8_t g_empty = 0;
+uint32_t g_passUs = 0;
+bool g_passSeen = false;
+
+// Loop gaps, log2 buckets with 4 linear steps each: under 19% error at any size
+constexpr uint8_t HIST_BUCKETS = 128;
+uint32_t g_hist[HIST_BUCKETS] = {};
+uint32_t g_histCount = 0;
+
+uint8_t bucketOf(uint32_t us) {
+  if (us < 4) {
+    return us;
+  }
+  const uint8_t e = 31 - __builtin_clz(us);
+  return 4 * (e - 1) + ((us >> (e - 2)) & 3);
+}
+
+uint32_t bucketTop(uint8_t i) {
+  if (i < 4) {
+    return i;
+  }
+  const uint8_t e = i / 4 + 1;
+  return ((4u + i % 4) << (e - 2)) + (1u << (e - 2)) - 1;
+}
+
+// The bucket's upper edge, clamped to the largest gap seen so a percentile never exceeds the max
+uint32_t percentile(uint8_t pct) {
+  if (!g_histCount) {
+    return 0;
+  }
+  const uint32_t rank = (static_cast<uint64_t>(g_histCount) * pct + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < HIST_BUCKETS; i++) {
+    seen += g_hist[i];
+    if (seen >= rank) {
+      return min(bucketTop(i), g_run.loopMaxUs);
+    }
+  }
+  return g_run.loopMaxUs;
+}
+
+// ---- Vehicle model: a pure function of time, so both buses agree without shared state ----
+
+struct Vehicle {
+  float speed, rpm, pedal, torqueNm, boostKpa, lambda;
+  float egt1, egt2, turboOut, manifold, trans1, trans2;
+  float coolant, iat, fuel, battV, soot, regenPct;
+  uint8_t gear, target, lock, actuator;
+  bool headlights, cancel;
+};
+
+// Upshift points; the drive cycle gains 1 km/h per 0.3 s from 10 s and loses 1 km/h per 0.2 s from 80 s
+constexpr float SHIFT_KMH[] = {15, 30, 45, 60, 80};
+constexpr float ACCEL_S_PER_KMH = 0.3f, DECEL_S_PER_KMH = 0.2f;
+constexpr float RPM_PER_KMH[] = {0, 110, 62, 42, 32, 26, 21};
+
+float cycleSpeed(float p) {
+  if (p < 10) return 0;
+  if (p < 40) return (p - 10) / ACCEL_S_PER_KMH;
+  if (p < 80) return 100 + 5 * sinf(2 * PI * (p - 40) / 20);
+  if (p < 100) return 100 - (p - 80) / DECEL_S_PER_KMH;
+  return 0;
+}
+
+uint8_t gearFor(float kmh) {
+  uint8_t g = 1;
+  for (float th : SHIFT_KMH) {
+    if (kmh >= th) {
+      g++;
+    }
+  }
+  return g;
+}
+
+// Seconds since the last shift at cycle position p (large when none this cycle)
+float sinceShift(float p) {
+  float last = -1000;
+  for (float th : SHIFT_KMH) {
+    const float up = 10 + th * ACCEL_S_PER_KMH, down = 80 + (100 - th) * DECEL_S_PER_KMH;
+    if (up <= p && up > last) last = up;
+    if (down <= p && down > last) last = down;
+  }
+  return p - last;
+}
+
+// Share of full load: drives EGTs, boost and temperatures
+float cycleHeat(float p) {
+  if (p < 10) return 0.1f;
+  if (p < 40) return 0.1f + 0.9f * (p - 10) / 30;
+  if (p < 80) return 0.6f;
+  if (p < 100) return 0.6f - 0.4f * (p - 80) / 20;
+  return 0.1f;
+}
+
+void vehicleAt(uint64_t us, Vehicle& v) {
+  const uint32_t ms = us / 1000;
+  const float p = (ms % CYCLE_MS) / 1000.0f;
+  v.speed = cycleSpeed(p);
+  v.gear = gearFor(v.speed);
+  v.target = gearFor(cycleSpeed(p + 0.4f));   // the TCU announces a shift before it happens
+  // Converter: release, open through the shift, re-apply, then full lock from 3rd up
+  const float dt = sinceShift(p);
+  v.lock = dt < 0.3f ? 0x20 : dt < 1.0f ? 0x00 : dt < 1.5f ? 0x20 : v.gear >= 3 ? 0x60 : v.gear == 2 ? 0x40 : 0x00;
+  v.pedal = p < 10 ? 0 : p < 40 ? 60 : p < 80 ? 20 + 5 * sinf(2 * PI * (p - 40) / 20) : 0;
+  v.rpm = v.speed < 1 ? 750 : fmaxf(800, v.speed * RPM_PER_KMH[v.gear]) + (v.lock == 0x00 ? 150 : 0);
+  v.torqueNm = v.pedal * 5;
+  v.boostKpa = v.pedal * 1.8f;
+  v.lambda = 1.0f + (1 - v.pedal / 100) * 1.5f;
+  v.actuator = static_cast<uint8_t>(v.pedal * 2);
+
+  const float h = cycleHeat(p);
+  const uint32_t q = ms % REGEN_EVERY_MS, build = REGEN_EVERY_MS - REGEN_MS;
+  const bool regen = q >= build;
+  v.soot = regen ? 95 - 80.0f * (q - build) / REGEN_MS : 20 + 75.0f * q / build;
+  v.regenPct = regen ? 100.0f * (q - build) / REGEN_MS : 0;
+  v.egt1 = 200 + 450 * h + (regen ? 150 : 0);
+  v.egt2 = v.egt1 - 40 + (regen ? 100 : 0);
+  v.turboOut = 70 + 80 * h;
+  v.manifold = 45 + 20 * h;
+  v.trans1 = 60 + 25 * h;
+  v.trans2 = v.trans1 + 8;
+  v.coolant = fminf(90, 20 + ms / 4000.0f);   // warms up over the first ~5 minutes
+  v.iat = 30;
+  v.fuel = 35;
+  v.battV = 14.1f + 0.1f * sinf(ms / 1000.0f);
+  v.headlights = (ms % CYCLE_MS) >= CYCLE_MS / 2;
+  // CANCEL double-tap (next screen) every 20 s: down 0-100 ms and 200-300 ms
+  const uint32_t b = ms % 20000;
+  v.cancel = b < 100 || (b >= 200 && b < 300);
+}
+
+uint8_t clampByte(float x) { return x <= 0 ? 0 : x >= 255 ? 255 : static_cast<uint8_t>(x + 0.5f); }
+
+uint16_t clampWord(float x) { return x <= 0 ? 0 : x >= 65535 ? 65535 : static_cast<uint16_t>(x + 0.5f); }
+
+void putBe16(uint8_t* d, uint16_t v) {
+  d[0] = v >> 8;
+  d[1] = v & 0xFF;
+}
+
+// The inverse of each decoder in CanDecode.cpp
+void encode(uint32_t id, const Vehicle& v, can_frame& f) {
+  uint8_t* d = f.data;
+  switch (id) {
+    case CFG::ID_SPEED: putBe16(d + 1, clampWord(v.speed * 64)); break;
+    case CFG::ID_RPM_SPEED:
+      putBe16(d, clampWord(v.rpm * 8));
+      d[2] = clampByte(v.pedal * 2.5f);
+      d[4] = clampByte(v.torqueNm / 300 * 100 * 2);   // demand %
+      break;
+    case CFG::ID_TRANS_T:
+      d[2] = clampByte(v.trans1 + 40);
+      d[3] = clampByte(v.trans2 + 40);
+      break;
+    case CFG::ID_GEAR_LOCK:
+      d[0] = 125 + v.target;
+      d[1] = v.lock;
+      d[2] = 125 + v.gear;
+      break;
+    case CFG::ID_BATTV: d[0] = clampByte(v.battV * 10); break;
+    case CFG::ID_COOLANT_ETC:
+      d[0] = clampByte(v.coolant + 40);
+      d[1] = clampByte(v.iat + 40);
+      d[2] = clampByte(v.fuel + 40);
+      break;
+    case CFG::ID_TORQUE: putBe16(d, clampWord(v.torqueNm * 2 + 1696)); break;
+    case CFG::ID_SOOT: putBe16(d + 4, clampWord(v.soot * CFG::SOOT_DIV)); break;
+    case CFG::ID_REGEN:
+      d[0] = clampByte(v.egt2 / 10);
+      putBe16(d + 5, clampWord(v.regenPct / 100 * CFG::REGEN_RAW_MAX));
+      break;
+    case CFG::ID_EGT1: {
+      const uint16_t raw = clampWord(v.egt1) & 0x3FF;
+      d[4] = raw >> 8;
+      d[5] = raw & 0xFF;
+      break;
+    }
+    case CFG::ID_BOOST: d[3] = clampByte((v.boostKpa + CFG::ATM_KPA) / 2); break;
+    case CFG::ID_MAP_T:
+      d[1] = clampByte(v.turboOut + 40);
+      d[7] = clampByte(v.manifold + 40);
+      break;
+    case CFG::ID_LAMBDA: putBe16(d + 1, clampWord(v.lambda * 1000)); break;
+    case CFG::ID_ACTUATOR: d[3] = v.actuator; break;
+    case CFG::ID_HEADLIGHTS: d[1] = v.headlights ? 0x50 : 0x00; break;
+    case CFG::ID_SWBTN: d[6] = v.cancel ? 1u << 4 : 0; break;
+    default: break;
+  }
+}
+
+// ---- Wire ----
+
+// Standard frame: 47 bits of framing plus data, and a stuff bit per ~10 bits of typical payload
+uint32_t frameUs(const Wire& w, uint8_t dlc) {
+  const uint32_t bits = 47 + 8 * dlc + (34 + 8 * dlc) / 10;
+  return (bits * 1000000u + w.bitrate - 1) / w.bitrate;
+}
+
+void deliver(uint8_t bus, const can_frame& f) {
+  if (!CanBus::accepts(bus, f.can_id)) {
+    return;
+  }
+  Wire& w = g_wire[bus];
+  if (w.rxCount == RX_BUFFERS) {
+    g_run.dropped++;
+    return;
+  }
+  w.rx[(w.rxHead + w.rxCount) % RX_BUFFERS] = f;
+  w.rxCount++;
+}
+
+// Average wire time of the signal sources on one bus, in µs per second
+uint32_t signalUsPerSec(uint8_t bus) {
+  uint32_t us = 0;
+  for (const Source& s : kSources) {
+    if (s.bus == bus) {
+      us += frameUs(g_wire[bus], 8) * (1000 / s.periodMs);
+    }
+  }
+  return us;
+}
+
+void setLoad(uint8_t pct) {
+  for (uint8_t b = 0; b < CanBus::MAX_BUSES; b++) {
+    Wire& w = g_wire[b];
+    if (!w.bitrate) {
+      continue;
+    }
+    const int32_t spare = static_cast<int32_t>(pct) * 10000 - static_cast<int32_t>(signalUsPerSec(b));
+    w.fillerEveryUs = spare > 0 ? static_cast<uint32_t>(static_cast<uint64_t>(frameUs(w, 8)) * 1000000 / spare) : 0;
+    w.fillerNextUs = g_nowUs;
+    w.busyUs = 0;
+  }
+}
+
+// A stall longer than MAX_CATCHUP_US is not replayed frame by frame: the schedule moves forward,
+// and the frames that would have overflowed the buffers anyway are not counted.
+void skipStall(uint8_t bus) {
+  Wire& w = g_wire[bus];
+  if (g_nowUs - w.freeUs <= MAX_CATCHUP_US) {
+    return;
+  }
+  const uint64_t shift = g_nowUs - MAX_CATCHUP_US - w.freeUs;
+  w.freeUs += shift;
+  w.fillerNextUs += shift;
+  w.burstNextUs += shift;
+  for (uint8_t i = 0; i < SOURCE_COUNT; i++) {
+    if (kSources[i].bus == bus) {
+      g_sourceNextUs[i] += shift;
+    }
+  }
+  if (bus == BUS_PT) {
+    g_run.skippedMs += shift / 1000;
+  }
+}
+
+void transmit(uint8_t bus, const can_frame& f, uint64_t start) {
+  Wire& w = g_wire[bus];
+  const uint32_t dur = frameUs(w, f.can_dlc);
+  w.freeUs = start + dur;
+  w.busyUs += dur;
+  deliver(bus, f);
+  if ((g_cfg.faults & FAULT_BURST) && w.freeUs >= w.burstNextUs) {
+    w.burstNextUs += BURST_EVERY_US;
+    w.burstLeft = BURST_FRAMES;
+  }
+}
+
+// Puts every frame that has finished on the wire by g_nowUs into the RX buffers
+void advance(uint8_t bus) {
+  Wire& w = g_wire[bus];
+  if (!w.bitrate) {
+    return;
+  }
+  skipStall(bus);
+  while (true) {
+    // Lowest ID among frames waiting when the wire frees up wins arbitration; otherwise the next due
+    int8_t pick = -1;   // source index, or SOURCE_COUNT for filler
+    uint64_t due = UINT64_MAX;
+    uint32_t id = UINT32_MAX;
+    auto consider = [&](int8_t who, uint64_t at, uint32_t cid) {
+      const bool waiting = at <= w.freeUs, bestWaiting = due <= w.freeUs;
+      if ((waiting && (!bestWaiting || cid < id)) || (!waiting && !bestWaiting && at < due)) {
+        pick = who;
+        due = at;
+        id = cid;
+      }
+    };
+    for (uint8_t i = 0; i < SOURCE_COUNT; i++) {
+      if (kSources[i].bus == bus) {
+        consider(i, g_sourceNextUs[i], kSources[i].id);
+      }
+    }
+    if (w.burstLeft) {
+      consider(SOURCE_COUNT, w.freeUs, FILLER_BASE[bus] + w.fillerSeq % FILLER_IDS);
+    } else if (w.fillerEveryUs) {
+      consider(SOURCE_COUNT, w.fillerNextUs, FILLER_BASE[bus] + w.fillerSeq % FILLER_IDS);
+    }
+    if (pick < 0) {
+      return;
+    }
+    const uint64_t start = due > w.freeUs ? due : w.freeUs;
+    if (start >= g_nowUs) {
+      return;
+    }
+    can_frame f = {};
+    f.can_id = id;
+    f.can_dlc = 8;
+    if (pick == SOURCE_COUNT) {
+      if (start + frameUs(w, f.can_dlc) > g_nowUs) {
+        return;   // still on the wire
+      }
+      f.data[0] = w.fillerSeq++;
+      if (w.burstLeft) {
+        w.burstLeft--;
+      } else {
+        w.fillerNextUs += w.fillerEveryUs;
+      }
+      transmit(bus, f, start);
+      continue;
+    }
+    const uint32_t periodUs = kSources[pick].periodMs * 1000u;
+    if ((g_cfg.faults & FAULT_MISSING) && id == CFG::ID_SPEED && (start / 1000) % MISSING_EVERY_MS < MISSING_MS) {
+      g_sourceNextUs[pick] += periodUs;
+      continue;
+    }
+    // Buttons keep their full length: a short frame would read as a release and break the gesture
+    if ((g_cfg.faults & FAULT_SHORT_DLC) && id != CFG::ID_SWBTN && (g_sourceSent[pick] + 1) % SHORT_DLC_EVERY == 0) {
+      f.can_dlc = 1;
+    }
+    if (start + frameUs(w, f.can_dlc) > g_nowUs) {
+      return;
+    }
+    g_sourceNextUs[pick] += periodUs;
+    g_sourceSent[pick]++;
+    Vehicle v;
+    vehicleAt(start, v);
+    encode(id, v, f);
+    transmit(bus, f, start);
+  }
+}
+
+void startLevel(unsigned long nowMs) {
+  g_levelStartMs = nowMs;
+  g_levelStartUs = g_nowUs;
+  memset(g_hist, 0, sizeof(g_hist));
+  g_histCount = 0;
+  g_run = {};
+  g_run.loadPct = LEVELS[g_level];
+  setLoad(g_run.loadPct);
+}
+
+void noteLoopGap(uint32_t us) {
+  g_hist[bucketOf(us)]++;
+  g_histCount++;
+  if (us > g_run.loopMaxUs) {
+    g_run.loopMaxUs = us;
+  }
+}
+
+void report(const LevelResult& r) {
+  Serial.print("[SIM] load="); Serial.print(r.loadPct);
+  Serial.print("% wire="); Serial.print(r.measuredPct);
+  Serial.print("% frames="); Serial.print(r.frames);
+  Serial.print(" dropped="); Serial.print(r.dropped);
+  Serial.print(" skippedMs="); Serial.println(r.skippedMs);
+  Serial.print("[SIM] loop us p50="); Serial.print(r.loopP50Us);
+  Serial.print(" p95="); Serial.print(r.loopP95Us);
+  Serial.print(" p99="); Serial.print(r.loopP99Us);
+  Serial.print(" max="); Serial.print(r.loopMaxUs);
+  Serial.print(" heap min="); Serial.print(r.minFreeHeap);
+  Serial.print(" block min="); Serial.print(r.minLargestBlock);
+  Serial.print(" stack free="); Serial.println(r.stackFree);
+}
+
+void endLevel(unsigned long nowMs) {
+  const uint64_t span = g_nowUs - g_levelStartUs;
+  g_run.measuredPct = span ? g_wire[BUS_PT].busyUs * 100 / span : 0;
+  g_run.loopP50Us = percentile(50);
+  g_run.loopP95Us = percentile(95);
+  g_run.loopP99Us = percentile(99);
+  g_run.stackFree = uxTaskGetStackHighWaterMark(nullptr);
+  g_last = g_run;
+  g_levelsDone++;
+  report(g_last);
+  g_level = (g_level + 1) % LEVEL_COUNT;
+  startLevel(nowMs);
+}
+
+// First request of a loop pass: the gap since the last one, the heap, and the level clock
+void startPass() {
+  const uint32_t t = micros();
+  if (g_passSeen) {
+    noteLoopGap(t - g_passUs);
+  }
+  g_passUs = t;
+  g_passSeen = true;
+  const HeapMon::Stats& hs = HeapMon::stats();
+  if (!g_run.minFreeHeap || hs.freeBytes < g_run.minFreeHeap) {
+    g_run.minFreeHeap = hs.freeBytes;
+  }
+  if (!g_run.minLargestBlock || hs.largestBlock < g_run.minLargestBlock) {
+    g_run.minLargestBlock = hs.largestBlock;
+  }
+  const unsigned long nowMs = millis();
+  if (nowMs - g_levelStartMs >= LEVEL_MS) {
+    endLevel(nowMs);
+  }
+}
+}  // namespace
+
+namespace BusSim {
+void install(const Config& cfg) {
+  g_cfg = cfg;
+  g_lastMicros = micros();
+  g_nowUs = 0;
+  for (uint8_t b = 0; b < CanBus::MAX_BUSES; b++) {
+    g_wire[b] = {};
+    g_wire[b].bitrate = cfg.bitrate[b];
+    g_wire[b].burstNextUs = BURST_EVERY_US;
+  }
+  for (uint8_t i = 0; i < SOURCE_COUNT; i++) {
+    g_sourceNextUs[i] = i * 137u;   // spread the phases
+    g_sourceSent[i] = 0;
+  }
+  g_level = 0;
+  g_levelsDone = 0;
+  g_empty = CanBus::MAX_BUSES;
+  g_passSeen = false;
+  g_active = true;
+  startLevel(millis());
+  CanBus::setSimSource(read);
+  // The simulated body bus carries the headlights and buttons whether or not a controller answered
+  if (BUS_BODY != BUS_PT) {
+    CanDec::setBodyBus(BUS_BODY);
+  }
+}
+
+bool active() { return g_active; }
+
+bool read(uint8_t bus, can_frame& f) {
+  if (!g_active || bus >= CanBus::MAX_BUSES) {
+    return false;
+  }
+  if (g_empty >= CanBus::MAX_BUSES) {
+    g_empty = 0;
+    startPass();
+  }
+  const uint32_t t = micros();
+  g_nowUs += t - g_lastMicros;
+  g_lastMicros = t;
+  advance(bus);
+  Wire& w = g_wire[bus];
+  if (!w.rxCount) {
+    g_empty++;
+    return false;
+  }
+  g_empty = 0;
+  f = w.rx[w.rxHead];
+  w.rxHead = (w.rxHead + 1) % RX_BUFFERS;
+  w.rxCount--;
+  g_run.frames++;
+  return true;
+}
+
+uint32_t levelsDone() { return g_levelsDone; }
+
+const LevelResult& lastResult() { return g_last; }
+}  // namespace BusSim
@@ -0,0 +1,65 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+#include "CanBus.h"
+
+// Synthetic vehicle bus for load and soak testing on the bench.
+// Every ID in Config.h is generated at its usual period from a looping drive cycle: speed and RPM
+// ramps, shifts through the 0x161 target/current gear and converter lock bytes, EGTs climbing with
+// load, soot building up to a regen on 0x4AB, headlights toggling, and a CANCEL double-tap on 0x402
+// (next screen) now and then. Filler frames bring each bus up to the target load.
+// Frames are laid on a simulated wire in arbitration order, with typical bit stuffing, and arrive
+// through a model of the MCP2515: the acceptance filters in place (CanBus::accepts) and two RX
+// buffers. A frame that completes while both buffers are still unread is lost and counted, as an
+// RXnOVR would be.
+// install() plugs read() into CanBus::setSimSource, so everything after the drain runs unchanged.
+// The loop needs no other hook: CanBus::read() asks every bus in turn, so a run of empty answers
+// from all of them ends a drain, and the next request starts a new loop pass. A drain loop() or
+// the render scheduler makes part-way through a pass counts as one too: the loop latency is the
+// time the RX buffers wait. BusSim times the gap between pass starts, samples the heap there, and
+// steps through LEVELS. At the end of each level it prints two [SIM] lines: frames delivered and
+// dropped, loop latency percentiles, and the heap and stack high-water marks.
+namespace BusSim {
+  constexpr uint8_t LEVELS[] = {30, 50, 70, 90};   // % bus load, then round again
+  constexpr uint8_t LEVEL_COUNT = sizeof(LEVELS);
+  constexpr uint32_t LEVEL_MS = 60000;
+  constexpr uint8_t RX_BUFFERS = 2;
+  constexpr uint32_t CYCLE_MS = 120000;         // drive cycle
+  constexpr uint32_t REGEN_EVERY_MS = 600000;   // soot build-up plus regen
+  constexpr uint32_t REGEN_MS = 120000;
+  constexpr uint32_t MAX_CATCHUP_US = 250000;   // a longer stall skips ahead instead of replaying it
+
+  enum Fault : uint8_t {
+    FAULT_MISSING   = 1 << 0,   // speed (0x141) silent for 5 s out of every 30 s
+    FAULT_SHORT_DLC = 1 << 1,   // every 10th frame of a signal ID arrives with DLC 1
+    FAULT_BURST     = 1 << 2,   // 64 back-to-back filler frames every 10 s
+  };
+
+  struct Config {
+    uint32_t bitrate[CanBus::MAX_BUSES];   // bit/s; 0 leaves the bus silent
+    uint8_t faults;
+  };
+
+  struct LevelResult {
+    uint8_t loadPct;          // target
+    uint8_t measuredPct;      // powertrain wire time actually used
+    uint32_t frames;          // delivered, all buses
+    uint32_t dropped;         // lost to full RX buffers
+    uint32_t skippedMs;       // stalls longer than MAX_CATCHUP_US, not replayed
+    uint32_t loopP50Us;
+    uint32_t loopP95Us;
+    uint32_t loopP99Us;
+    uint32_t loopMaxUs;
+    uint32_t minFreeHeap;
+    uint32_t minLargestBlock;
+    uint32_t stackFree;       // loop task stack high-water mark, bytes
+  };
+
+  // From setup(), after CanBus::begin: takes over CanBus::read() and the body bus assignment
+  void install(const Config& cfg);
+  bool active();
+  // CanBus::SimSource: the next frame the mock controller holds for this bus
+  bool read(uint8_t bus, can_frame& f);
+  uint32_t levelsDone();
+  const LevelResult& lastResult();
+}
@@ -0,0 +1,274 @@
+#include "CanBus.h"
+#include "Trace.h"
+
+namespace {
+using namespace CanBus;
+
+struct Bus {
+  MCP2515* mcp;
+  Config cfg;
+  Stats stats;
+  uint8_t sinceCheck;   // frames read since CANINTF was last looked at
+  uint32_t passing[MAX_ACCEPT];   // the list in the filters now; passingCount 0 = open
+  uint8_t passingCount;
+};
+
+Bus g_bus[MAX_BUSES] = {};
+volatile bool g_irq[MAX_BUSES] = {};
+uint8_t g_next = 0;   // bus served first on the next read()
+SimSource g_sim = nullptr;
+
+void IRAM_ATTR onInt0() { g_irq[0] = true; }
+void IRAM_ATTR onInt1() { g_irq[1] = true; }
+void (*const kIsr[MAX_BUSES])() = {onInt0, onInt1};
+
+static_assert(MAX_BUSES == 2, "one ISR per bus");
+
+// Mask and filters of one RX buffer; unused filter slots repeat the last ID
+void fillFilters(MCP2515& mcp, MCP2515::MASK mask, uint8_t first, uint8_t slots, const uint32_t* ids, uint8_t n, bool ext) {
+  mcp.setFilterMask(mask, ext, ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+  for (uint8_t i = 0; i < slots; i++) {
+    mcp.setFilter(static_cast<MCP2515::RXF>(first + i), ext, ids[i < n ? i : n - 1]);
+  }
+}
+
+void openFilters(MCP2515& mcp) {
+  mcp.setFilterMask(MCP2515::MASK0, false, 0);
+  mcp.setFilterMask(MCP2515::MASK1, false, 0);
+  for (uint8_t i = 0; i < MAX_ACCEPT; i++) {
+    mcp.setFilter(static_cast<MCP2515::RXF>(i), (i & 1) != 0, 0);
+  }
+}
+
+// The filter setters enter config mode; the caller returns to normal mode.
+// A filter only matches frames of its own format (EXIDE), so an open controller needs one
+// standard and one extended filter per buffer. A list mixing both formats gives RXB0 (MASK0,
+// RXF0-1) the standard IDs and RXB1 (MASK1, RXF2-5) the extended ones. A list that does not
+// fit opens the filters (false): passing extra frames is safe, dropping wanted ones is not.
+bool applyFilters(MCP2515& mcp, const uint32_t* ids, uint8_t n) {
+  if (n == 0 || !acceptFits(ids, n)) {
+    openFilters(mcp);
+    return n == 0;
+  }
+  uint32_t sff[MAX_ACCEPT], eff[MAX_ACCEPT];
+  uint8_t ns = 0, ne = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    if (ids[i] & CAN_EFF_FLAG) {
+      eff[ne++] = ids[i] & CAN_EFF_MASK;
+    } else {
+      sff[ns++] = ids[i] & CAN_SFF_MASK;
+    }
+  }
+  if (ns && ne) {
+    fillFilters(mcp, MCP2515::MASK0, 0, MIXED_SFF, sff, ns, false);
+    fillFilters(mcp, MCP2515::MASK1, MIXED_SFF, MIXED_EFF, eff, ne, true);
+    return true;
+  }
+  const bool ext = ne != 0;
+  const uint32_t* list = ext ? eff : sff;
+  fillFilters(mcp, MCP2515::MASK0, 0, 2, list, n, ext);
+  fillFilters(mcp, MCP2515::MASK1, 2, 4, n > 2 ? list + 2 : list, n > 2 ? n - 2 : n, ext);
+  return true;
+}
+
+// ids as the filters compare them: format bit plus the ID bits of that format
+inline uint32_t filterKey(uint32_t id) {
+  return (id & CAN_EFF_FLAG) ? (id & (CAN_EFF_FLAG | CAN_EFF_MASK)) : (id & CAN_SFF_MASK);
+}
+
+void remember(Bus& b, const uint32_t* ids, uint8_t n, bool fits) {
+  b.passingCount = fits ? n : 0;
+  for (uint8_t i = 0; i < b.passingCount; i++) {
+    b.passing[i] = filterKey(ids[i]);
+  }
+}
+
+void rejected(uint8_t bus, uint8_t n) {
+  g_bus[bus].stats.filterRejects++;
+  Trace::log(Trace::TR_CAN_FILTER_OPEN, bus, n);
+}
+
+// Count and clear whatever raised ERRIF/MERRF. Only the overflow bits are cleared:
+// the library's clearRXnOVR() also clears every CANINTF flag, a pending RX buffer included.
+void clearErrors(Bus& b) {
+  const uint8_t eflg = b.mcp->getErrorFlags();
+  b.stats.lastEflg = eflg;
+  if (eflg & (EFLG_RX0OVR | EFLG_RX1OVR)) {
+    b.stats.overflows++;
+    b.mcp->clearRXnOVRFlags();
+  }
+  b.mcp->clearERRIF();
+  b.mcp->clearMERR();
+}
+}  // namespace
+
+namespace CanBus {
+bool begin(uint8_t bus, MCP2515& mcp, const Config& cfg) {
+  if (bus >= MAX_BUSES) {
+    return false;
+  }
+  Bus& b = g_bus[bus];
+  b = {};
+  pinMode(cfg.cs, OUTPUT);
+  digitalWrite(cfg.cs, HIGH);
+  pinMode(cfg.intPin, INPUT_PULLUP);
+  mcp.reset();
+  // setBitrate verifies the switch to config mode, so a missing controller fails here
+  if (mcp.setBitrate(cfg.speed, cfg.clock) != MCP2515::ERROR_OK) {
+    return false;
+  }
+  const bool fits = applyFilters(mcp, cfg.accept, cfg.acceptCount);
+  if (mcp.setNormalMode() != MCP2515::ERROR_OK) {
+    return false;
+  }
+  if (!fits) {
+    rejected(bus, cfg.acceptCount);
+  }
+  b.mcp = &mcp;
+  b.cfg = cfg;
+  remember(b, cfg.accept, cfg.acceptCount, fits);
+  g_irq[bus] = false;
+  setIrq(bus, true);
+  return true;
+}
+
+bool present(uint8_t bus) { return bus < MAX_BUSES && g_bus[bus].mcp; }
+
+uint8_t count() {
+  uint8_t n = 0;
+  for (const Bus& b : g_bus) {
+    n += b.mcp != nullptr;
+  }
+  return n;
+}
+
+MCP2515& controller(uint8_t bus) { return *g_bus[bus].mcp; }
+
+uint8_t csPin(uint8_t bus) { return g_bus[bus].cfg.cs; }
+
+uint32_t bitrate(uint8_t bus) { return present(bus) ? bitsPerSecond(g_bus[bus].cfg.speed) : 0; }
+
+uint32_t bitsPerSecond(CAN_SPEED speed) {
+  switch (speed) {
+    case CAN_5KBPS: return 5000;
+    case CAN_10KBPS: return 10000;
+    case CAN_20KBPS: return 20000;
+    case CAN_31K25BPS: return 31250;
+    case CAN_33KBPS: return 33333;
+    case CAN_40KBPS: return 40000;
+    case CAN_50KBPS: return 50000;
+    case CAN_80KBPS: return 80000;
+    case CAN_83K3BPS: return 83333;
+    case CAN_95KBPS: return 95000;
+    case CAN_100KBPS: return 100000;
+    case CAN_125KBPS: return 125000;
+    case CAN_200KBPS: return 200000;
+    case CAN_250KBPS: return 250000;
+    case CAN_500KBPS: return 500000;
+    case CAN_1000KBPS: return 1000000;
+    default: return 0;
+  }
+}
+
+bool read(can_frame& f, uint8_t& bus) {
+  if (g_sim) {
+    for (uint8_t k = 0; k < MAX_BUSES; k++) {
+      const uint8_t i = (g_next + k) % MAX_BUSES;
+      if (g_sim(i, f)) {
+        g_bus[i].stats.frames++;
+        g_next = (i + 1) % MAX_BUSES;
+        bus = i;
+        return true;
+      }
+    }
+    return false;
+  }
+  for (uint8_t k = 0; k < MAX_BUSES; k++) {
+    const uint8_t i = (g_next + k) % MAX_BUSES;
+    Bus& b = g_bus[i];
+    if (!b.mcp) {
+      continue;
+    }
+    // The edge flag covers a frame that arrived and was half-read; the level covers a frame that
+    // arrived while INT was already low, which raises no new edge
+    if (!g_irq[i] && digitalRead(b.cfg.intPin) == HIGH) {
+      continue;
+    }
+    g_irq[i] = false;
+    if (b.mcp->readMessage(&f) == MCP2515::ERROR_OK) {
+      b.stats.frames++;
+      // A bus that keeps both buffers full never lets INT go high, so the error path below is
+      // never reached; look at ERRIF every so often instead
+      if (++b.sinceCheck >= ERR_CHECK_FRAMES) {
+        b.sinceCheck = 0;
+        if (b.mcp->getInterrupts() & CANINTF_ERRIF) {
+          clearErrors(b);
+        }
+      }
+      g_next = (i + 1) % MAX_BUSES;
+      bus = i;
+      return true;
+    }
+    if (digitalRead(b.cfg.intPin) == LOW) {
+      b.stats.errorIrqs++;
+      clearErrors(b);
+    }
+  }
+  return false;
+}
+
+bool setFilters(uint8_t bus, const uint32_t* ids, uint8_t n) {
+  if (!present(bus)) {
+    return false;
+  }
+  const bool fits = applyFilters(*g_bus[bus].mcp, ids, n);
+  g_bus[bus].mcp->setNormalMode();
+  remember(g_bus[bus], ids, n, fits);
+  if (!fits) {
+    rejected(bus, n);
+  }
+  return fits;
+}
+
+void setAccept(uint8_t bus, const uint32_t* ids, uint8_t n) {
+  if (present(bus)) {
+    g_bus[bus].cfg.accept = ids;
+    g_bus[bus].cfg.acceptCount = n;
+  }
+}
+
+bool accepts(uint8_t bus, uint32_t id) {
+  if (!present(bus) || !g_bus[bus].passingCount) {
+    return true;
+  }
+  const uint32_t key = filterKey(id);
+  for (uint8_t i = 0; i < g_bus[bus].passingCount; i++) {
+    if (g_bus[bus].passing[i] == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void restoreFilters(uint8_t bus) {
+  if (present(bus)) {
+    setFilters(bus, g_bus[bus].cfg.accept, g_bus[bus].cfg.acceptCount);
+  }
+}
+
+void setIrq(uint8_t bus, bool on) {
+  if (!present(bus)) {
+    return;
+  }
+  const uint8_t pin = g_bus[bus].cfg.intPin;
+  if (on) {
+    attachInterrupt(digitalPinToInterrupt(pin), kIsr[bus], FALLING);
+  } else {
+    detachInterrupt(digitalPinToInterrupt(pin));
+  }
+}
+
+const Stats& stats(uint8_t bus) { return g_bus[bus].stats; }
+
+void setSimSource(SimSource src) { g_sim = src; }
+}  // namespace CanBus
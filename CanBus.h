@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+
+// One MCP2515 per CAN bus, all on the shared SPI bus. Each controller's INT line has its own
+// falling-edge ISR; read() only touches controllers whose ISR fired or whose INT is still low,
+// and hands out one frame per bus per turn, so a saturated bus cannot starve the other one of
+// SPI time. INT low with nothing to read is an error interrupt: overflows are counted and the
+// flags cleared here, so INT is released without a per-loop EFLG poll. A bus busy enough to keep
+// INT low throughout gets its ERRIF checked every ERR_CHECK_FRAMES frames instead.
+namespace CanBus {
+  constexpr uint8_t MAX_BUSES = 2;
+  constexpr uint8_t MAX_ACCEPT = 6;   // RXF0..RXF5; 2 standard + 4 extended when mixed
+  constexpr uint8_t MIXED_SFF  = 2;   // RXB0's filters
+  constexpr uint8_t MIXED_EFF  = 4;   // RXB1's filters
+  constexpr uint8_t ERR_CHECK_FRAMES = 16;
+
+  constexpr uint8_t extendedIds(const uint32_t* ids, uint8_t n) {
+    return n == 0 ? 0 : ((ids[n - 1] & CAN_EFF_FLAG) ? 1 : 0) + extendedIds(ids, n - 1);
+  }
+  // Whether the filters can hold exactly this accept list; see applyFilters() in CanBus.cpp
+  constexpr bool acceptFits(const uint32_t* ids, uint8_t n) {
+    return n <= MAX_ACCEPT &&
+           (extendedIds(ids, n) == 0 || extendedIds(ids, n) == n ||
+            (n - extendedIds(ids, n) <= MIXED_SFF && extendedIds(ids, n) <= MIXED_EFF));
+  }
+
+  struct Config {
+    uint8_t cs;
+    uint8_t intPin;
+    CAN_SPEED speed;
+    CAN_CLOCK clock;
+    const uint32_t* accept;   // CAN_EFF_FLAG marks 29-bit IDs; nullptr/0 = pass everything
+    uint8_t acceptCount;
+  };
+
+  struct Stats {
+    uint32_t frames;
+    uint32_t overflows;   // RXnOVR seen: at least one frame lost
+    uint32_t errorIrqs;   // INT low without a frame (ERRIF/MERRF)
+    uint8_t lastEflg;
+    uint32_t filterRejects;   // accept lists that did not fit (acceptFits()); filters left open
+  };
+
+  // Reset, bitrate, filters, normal mode, ISR. False when the controller does not answer; the
+  // bus is then left out and present() reads false. An accept list that does not fit is
+  // handled as in setFilters().
+  bool begin(uint8_t bus, MCP2515& mcp, const Config& cfg);
+  bool present(uint8_t bus);
+  uint8_t count();                  // buses present
+  MCP2515& controller(uint8_t bus); // only valid when present()
+  uint8_t csPin(uint8_t bus);
+  uint32_t bitrate(uint8_t bus);     // bit/s, 0 when absent
+  uint32_t bitsPerSecond(CAN_SPEED speed);
+  // Next frame from the buses that signal one, rotating between them
+  bool read(can_frame& f, uint8_t& bus);
+  // Narrow the filters to these IDs (n = 0 opens them), or back to the configured set.
+  // Both leave the controller in normal mode. A list that does not fit opens the filters
+  // instead of dropping IDs from it: setFilters() then returns false, and it is counted and traced.
+  bool setFilters(uint8_t bus, const uint32_t* ids, uint8_t n);
+  void restoreFilters(uint8_t bus);
+  // Replace the configured set that restoreFilters() applies; ids must stay valid, as Config::accept
+  void setAccept(uint8_t bus, const uint32_t* ids, uint8_t n);
+  // Whether the filters in place pass this ID; true for an open or absent bus
+  bool accepts(uint8_t bus, uint32_t id);
+  void setIrq(uint8_t bus, bool on);
+  const Stats& stats(uint8_t bus);
+  // Bench testing without a vehicle (BusSim): while set, read() takes frames from src, per bus,
+  // instead of the controllers. Filters, IRQs and present() still concern the hardware.
+  using SimSource = bool (*)(uint8_t bus, can_frame& f);
+  void setSimSource(SimSource src);
+}
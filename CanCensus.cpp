@@ -0,0 +1,144 @@
+#include "CanCensus.h"
+
+namespace {
+CanCensus::Entry g_table[CanCensus::MAX_IDS];
+uint8_t g_used = 0;
+uint32_t g_dropped = 0;
+unsigned long g_windowStartMs = 0;
+
+static_assert((CanCensus::MAX_IDS & (CanCensus::MAX_IDS - 1)) == 0, "MAX_IDS must be a power of two");
+
+inline uint8_t hashId(uint32_t id, uint8_t bus) {
+  return static_cast<uint8_t>(((id ^ (static_cast<uint32_t>(bus) << 29)) * 2654435761u) >> 24) & (CanCensus::MAX_IDS - 1);
+}
+
+inline uint64_t packLE(const uint8_t* d, uint8_t dlc) {
+  uint64_t v = 0;
+  for (uint8_t i = 0; i < dlc && i < 8; i++) {
+    v |= static_cast<uint64_t>(d[i]) << (8 * i);
+  }
+  return v;
+}
+
+CanCensus::Entry* lookup(uint32_t id, uint8_t bus, bool insert) {
+  uint8_t h = hashId(id, bus);
+  for (uint8_t p = 0; p < CanCensus::MAX_PROBES; p++) {
+    CanCensus::Entry& e = g_table[(h + p) & (CanCensus::MAX_IDS - 1)];
+    if (e.frames == 0) {
+      if (!insert) {
+        return nullptr;
+      }
+      memset(&e, 0, sizeof(e));
+      e.id = id;
+      e.bus = bus;
+      g_used++;
+      return &e;
+    }
+    if (e.id == id && e.bus == bus) {
+      return &e;
+    }
+  }
+  return nullptr;
+}
+}  // namespace
+
+namespace CanCensus {
+void reset() {
+  memset(g_table, 0, sizeof(g_table));
+  g_used = 0;
+  g_dropped = 0;
+  g_windowStartMs = millis();
+}
+
+void record(const can_frame& f, uint8_t bus, unsigned long nowMs) {
+  Entry* e = lookup(f.can_id, bus, true);
+  if (!e) {
+    g_dropped++;
+    return;
+  }
+  const uint8_t dlc = f.can_dlc > 8 ? 8 : f.can_dlc;
+  uint64_t diff = 0;
+  if (e->frames > 0) {
+    diff = packLE(e->data, e->dlc) ^ packLE(f.data, dlc);
+  }
+  while (diff) {
+    const uint8_t bit = static_cast<uint8_t>(__builtin_ctzll(diff));
+    if (e->toggles[bit] < TOGGLE_MAX) {
+      e->toggles[bit]++;
+    }
+    diff &= diff - 1;
+    e->lastChangeMs = nowMs;
+  }
+  memcpy(e->data, f.data, dlc);
+  e->dlc = dlc;
+  e->frames++;
+  if (e->windowCount < 0xFFFF) {
+    e->windowCount++;
+  }
+  e->lastSeenMs = nowMs;
+}
+
+void tick(unsigned long nowMs) {
+  if (nowMs - g_windowStartMs < WINDOW_MS) {
+    return;
+  }
+  g_windowStartMs = nowMs;
+  for (uint8_t i = 0; i < MAX_IDS; i++) {
+    Entry& e = g_table[i];
+    if (e.frames == 0) {
+      continue;
+    }
+    e.rateHz = e.windowCount;
+    e.windowCount = 0;
+    // Halve toggle activity each window so the heatmap shows recent change, not history
+    for (uint8_t b = 0; b < 64; b++) {
+      e.toggles[b] >>= 1;
+    }
+  }
+}
+
+uint8_t count() { return g_used; }
+
+uint32_t droppedIds() { return g_dropped; }
+
+const Entry* find(uint32_t id, uint8_t bus) { return lookup(id, bus, false); }
+
+const Entry* slot(uint8_t idx) {
+  if (idx >= MAX_IDS || g_table[idx].frames == 0) {
+    return nullptr;
+  }
+  return &g_table[idx];
+}
+
+uint8_t sorted(SortMode mode, uint8_t* outSlots, uint8_t maxOut) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < MAX_IDS && n < maxOut; i++) {
+    if (g_table[i].frames > 0) {
+      outSlots[n++] = i;
+    }
+  }
+  auto before = [mode](const Entry& a, const Entry& b) {
+    if (mode == SORT_RECENT && a.lastChangeMs != b.lastChangeMs) {
+      return a.lastChangeMs > b.lastChangeMs;
+    }
+    if (a.rateHz != b.rateHz) {
+      return a.rateHz > b.rateHz;
+    }
+    if (a.id != b.id) {
+      return a.id < b.id;
+    }
+    return a.bus < b.bus;
+  };
+  // Insertion sort: n <= MAX_IDS and this only runs at UI refresh rate
+  for (uint8_t i = 1; i < n; i++) {
+    uint8_t s = outSlots[i];
+    int8_t j = static_cast<int8_t>(i) - 1;
+    while (j >= 0 && before(g_table[s], g_table[outSlots[j]])) {
+      outSlots[j + 1] = outSlots[j];
+      j--;
+    }
+    outSlots[j + 1] = s;
+  }
+  return n;
+}
+}  // namespace CanCensus
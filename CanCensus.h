@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+
+// Bus-wide CAN ID census for the sniffer.
+// Every received frame is folded into a fixed open-addressing table keyed by (bus, can_id).
+// record() is O(1) per frame (one hash probe sequence + one pass over the changed bits),
+// so it is safe to call from the CAN drain. Sorting / rate rollover happen in tick()/sorted(),
+// which belong to the UI stage.
+namespace CanCensus {
+  constexpr uint8_t  MAX_IDS     = 128;   // power of two
+  constexpr uint8_t  MAX_PROBES  = 16;    // bounded probe length keeps record() O(1)
+  constexpr uint32_t WINDOW_MS   = 1000;  // rate window
+  constexpr uint8_t  TOGGLE_MAX  = 255;
+
+  struct Entry {
+    uint32_t id;                 // can_id as received (EFF flag preserved)
+    uint32_t frames;             // total frames since reset
+    uint16_t rateHz;             // frames in the last completed window
+    uint16_t windowCount;        // frames in the current window
+    uint8_t  dlc;
+    uint8_t  bus;                // CanBus index the frames came in on
+    uint8_t  data[8];
+    unsigned long lastSeenMs;
+    unsigned long lastChangeMs;  // last time any payload bit toggled
+    uint8_t  toggles[64];        // per-bit toggle activity, LE bit numbering (data[0] = bits 0..7)
+  };
+
+  enum SortMode : uint8_t { SORT_RATE = 0, SORT_RECENT = 1 };
+
+  void reset();
+  void record(const can_frame& f, uint8_t bus, unsigned long nowMs);
+  // Roll rate windows and decay toggle activity. Call from loop(), not the CAN drain.
+  void tick(unsigned long nowMs);
+
+  uint8_t count();
+  uint32_t droppedIds();
+  const Entry* find(uint32_t id, uint8_t bus);
+  // Fills outSlots with table slots ordered by mode; returns number written.
+  uint8_t sorted(SortMode mode, uint8_t* outSlots, uint8_t maxOut);
+  const Entry* slot(uint8_t idx);
+}
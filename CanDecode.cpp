@@ -1,7 +1,10 @@
 #include "CanDecode.h"
 #include "Config.h"
+#include "J1939.h"
 
 namespace {
+uint8_t g_bodyBus = CFG::CAN_BUS_PT;
+
 uint16_t CD_be16(const uint8_t* d) { return static_cast<uint16_t>(d[0]) << 8 | d[1]; }
 
 float CD_clampf(float v, float lo, float hi) {
@@ -238,10 +241,8 @@ void h_401_headlights(const can_frame& f) {
     headlightsOn = (f.data[1] & 0x50) != 0;
   }
 }
-}  // namespace
 
-namespace CanDec {
-void decodeFrame(const can_frame& f) {
+void decodePowertrain(const can_frame& f) {
   switch (f.can_id) {
     case CFG::ID_SPEED:
       h_141_speed(f);
@@ -286,6 +287,13 @@ void decodeFrame(const can_frame& f) {
     case CFG::ID_ACTUATOR:
       h_4CD_actuator(f);
       break;
+    default:
+      break;
+  }
+}
+
+void decodeBody(const can_frame& f) {
+  switch (f.can_id) {
     case CFG::ID_HEADLIGHTS:
       h_401_headlights(f);
       break;
@@ -295,4 +303,23 @@ void decodeFrame(const can_frame& f) {
       break;
   }
 }
+}  // namespace
+
+namespace CanDec {
+void setBodyBus(uint8_t bus) { g_bodyBus = bus; }
+
+uint8_t bodyBus() { return g_bodyBus; }
+
+void decodeFrame(const can_frame& f, uint8_t bus) {
+  if (J1939::isExtended(f)) {
+    J1939::onFrame(f, millis());   // 29-bit IDs never collide with the 11-bit tables
+    return;
+  }
+  if (bus == CFG::CAN_BUS_PT) {
+    decodePowertrain(f);
+  }
+  if (bus == g_bodyBus) {
+    decodeBody(f);
+  }
+}
 }  // namespace CanDec
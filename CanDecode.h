@@ -27,6 +27,11 @@ enum TCState : uint8_t {
 extern volatile TCState g_tcState;
 
 // --- Public entrypoint: call this from your loop() for every frame ---
+// Powertrain IDs decode from bus CFG::CAN_BUS_PT, body IDs (headlights) from the body bus.
+// Extended (29-bit) frames from either bus go to the J1939 decoder.
 namespace CanDec {
-  void decodeFrame(const can_frame& f);
+  // CFG::CAN_BUS_BODY when the second controller is fitted, CFG::CAN_BUS_PT (the default) otherwise
+  void setBodyBus(uint8_t bus);
+  uint8_t bodyBus();
+  void decodeFrame(const can_frame& f, uint8_t bus);
 }
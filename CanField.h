@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+// Bit-field extraction shared by the sniffer and signal discovery.
+// Both byte orders use the same sequential bit numbering so a field can be
+// described as (from, to, order):
+//   LE (Intel):    lane = data[0] | data[1]<<8 | ...; bit 0 = LSB of data[0]
+//   BE (Motorola): lane = data[0]<<56 | data[1]<<48 | ...; bit 0 = MSB of data[0]
+// e.g. 0x141 speed (data[1]<<8 | data[2]) is BE bits 8..23.
+namespace CanField {
+  enum Order : uint8_t { ORDER_LE = 0, ORDER_BE = 1 };
+
+  inline uint64_t packLE(const uint8_t* d, uint8_t dlc) {
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < dlc && i < 8; i++) v |= static_cast<uint64_t>(d[i]) << (8 * i);
+    return v;
+  }
+
+  inline uint64_t packBE(const uint8_t* d, uint8_t dlc) {
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < dlc && i < 8; i++) v |= static_cast<uint64_t>(d[i]) << (56 - 8 * i);
+    return v;
+  }
+
+  // Raw value of bits from..to (inclusive, width clamped to 32). Caller checks from <= to.
+  inline uint32_t extract(uint64_t lane, uint8_t from, uint8_t to, Order order) {
+    uint8_t width = static_cast<uint8_t>(to - from + 1);
+    if (width > 32) width = 32;
+    const uint64_t mask = (static_cast<uint64_t>(1) << width) - 1;
+    const uint8_t shift = (order == ORDER_BE) ? static_cast<uint8_t>(63 - to) : from;
+    return static_cast<uint32_t>((lane >> shift) & mask);
+  }
+
+  inline uint64_t pack(const uint8_t* d, uint8_t dlc, Order order) {
+    return (order == ORDER_BE) ? packBE(d, dlc) : packLE(d, dlc);
+  }
+}
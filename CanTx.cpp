@@ -0,0 +1,224 @@
+#include "CanTx.h"
+#include "McpRegs.h"
+
+namespace {
+using namespace CanTx;
+
+struct Slot {
+  can_frame f;
+  uint32_t seq;           // enqueue order; oldest eligible frame of a class goes first
+  uint32_t enqMs;
+  uint32_t notBeforeMs;   // retry back-off
+  uint16_t tag;
+  uint8_t attempts;
+  uint8_t ctrl;
+  Prio prio;
+  bool used;
+  bool inFlight;
+};
+
+struct Buffer {
+  int8_t slot;            // -1 = idle (as far as this queue knows)
+  uint32_t loadedMs;
+};
+
+struct Rate {
+  uint32_t id;
+  uint32_t lastMs;
+  uint16_t minMs;         // 0 = free slot
+  bool sent;
+};
+
+MCP2515* g_mcp = nullptr;
+uint8_t g_cs = 0;
+Slot g_slots[QUEUE_LEN];
+Buffer g_buf[PRIO__COUNT] = {{-1, 0}, {-1, 0}, {-1, 0}};
+Rate g_rates[RATE_SLOTS];
+Event g_events[EVENT_LEN];
+uint8_t g_evHead = 0;
+uint8_t g_evTail = 0;
+uint32_t g_seq = 0;
+Stats g_stats = {};
+
+static_assert((EVENT_LEN & (EVENT_LEN - 1)) == 0, "EVENT_LEN must be a power of two");
+
+inline bool reached(uint32_t nowMs, uint32_t atMs) { return static_cast<int32_t>(nowMs - atMs) >= 0; }
+
+Rate* rateFor(uint32_t id) {
+  for (Rate& r : g_rates) {
+    if (r.minMs && r.id == id) {
+      return &r;
+    }
+  }
+  return nullptr;
+}
+
+void postEvent(const Slot& s, EventKind kind) {
+  if (static_cast<uint8_t>(g_evHead - g_evTail) >= EVENT_LEN) {
+    g_stats.eventOverflows++;
+    return;
+  }
+  g_events[g_evHead & (EVENT_LEN - 1)] = {s.f.can_id, s.tag, kind, s.attempts, s.ctrl};
+  g_evHead++;
+}
+
+uint8_t used() {
+  uint8_t n = 0;
+  for (const Slot& s : g_slots) {
+    n += s.used;
+  }
+  return n;
+}
+
+void complete(Slot& s, unsigned long nowMs) {
+  const uint32_t lat = nowMs - s.enqMs;
+  if (lat > g_stats.maxLatencyMs) {
+    g_stats.maxLatencyMs = lat;
+  }
+  g_stats.sent++;
+  postEvent(s, EV_SENT);
+  s.used = false;
+}
+
+void retryOrFail(Slot& s, uint8_t ctrl, unsigned long nowMs) {
+  s.inFlight = false;
+  s.ctrl = ctrl;
+  if (s.attempts >= MAX_ATTEMPTS) {
+    g_stats.failed++;
+    postEvent(s, EV_FAILED);
+    s.used = false;
+    return;
+  }
+  g_stats.retries++;
+  s.notBeforeMs = nowMs + (BACKOFF_MS << (s.attempts - 1));
+}
+
+// Oldest frame of this class whose back-off and rate limit allow it now
+Slot* pick(Prio p, unsigned long nowMs) {
+  Slot* best = nullptr;
+  for (Slot& s : g_slots) {
+    if (!s.used || s.inFlight || s.prio != p || !reached(nowMs, s.notBeforeMs)) {
+      continue;
+    }
+    if (best && static_cast<int32_t>(s.seq - best->seq) > 0) {
+      continue;
+    }
+    const Rate* r = rateFor(s.f.can_id);
+    if (r && r->sent && nowMs - r->lastMs < r->minMs) {
+      g_stats.rateHeld++;
+      continue;
+    }
+    best = &s;
+  }
+  return best;
+}
+
+void load(uint8_t b, Slot& s, unsigned long nowMs) {
+  s.attempts++;
+  if (g_mcp->sendMessage(static_cast<MCP2515::TXBn>(b), &s.f) != MCP2515::ERROR_OK) {
+    retryOrFail(s, McpRegs::read(g_cs, McpRegs::txbCtrl(b)), nowMs);
+    return;
+  }
+  s.inFlight = true;
+  g_buf[b] = {static_cast<int8_t>(&s - g_slots), static_cast<uint32_t>(nowMs)};
+  if (Rate* r = rateFor(s.f.can_id)) {
+    r->lastMs = nowMs;
+    r->sent = true;
+  }
+}
+}  // namespace
+
+namespace CanTx {
+void begin(MCP2515& mcp, uint8_t csPin) {
+  g_mcp = &mcp;
+  g_cs = csPin;
+}
+
+Result send(const can_frame& f, Prio prio, uint16_t tag) {
+  if (f.can_dlc > 8 || prio >= PRIO__COUNT) {
+    return TX_BAD_FRAME;
+  }
+  for (Slot& s : g_slots) {
+    if (s.used) {
+      continue;
+    }
+    s = {};
+    s.f = f;
+    s.seq = g_seq++;
+    s.enqMs = s.notBeforeMs = millis();
+    s.tag = tag;
+    s.prio = prio;
+    s.used = true;
+    g_stats.queued++;
+    const uint8_t d = used();
+    if (d > g_stats.maxDepth) {
+      g_stats.maxDepth = d;
+    }
+    return TX_QUEUED;
+  }
+  g_stats.full++;
+  return TX_FULL;
+}
+
+bool setRateLimit(uint32_t id, uint16_t minIntervalMs) {
+  Rate* r = rateFor(id);
+  if (!r && minIntervalMs) {
+    for (Rate& free : g_rates) {
+      if (!free.minMs) {
+        r = &free;
+        *r = {id, 0, 0, false};
+        break;
+      }
+    }
+  }
+  if (!r) {
+    return minIntervalMs == 0;
+  }
+  r->minMs = minIntervalMs;
+  return true;
+}
+
+void service(unsigned long nowMs) {
+  if (!g_mcp) {
+    return;
+  }
+  const uint8_t status = g_mcp->getStatus();
+  for (uint8_t b = 0; b < PRIO__COUNT; b++) {
+    Buffer& buf = g_buf[b];
+    const bool busy = status & McpRegs::statusTxReq(b);
+    if (buf.slot >= 0) {
+      Slot& s = g_slots[buf.slot];
+      if (busy) {
+        if (nowMs - buf.loadedMs >= TX_TIMEOUT_MS) {
+          // Reloaded on a later pass, once the abort has settled and TXREQ reads clear
+          McpRegs::bitModify(g_cs, McpRegs::txbCtrl(b), McpRegs::TXB_TXREQ, 0);
+          retryOrFail(s, McpRegs::read(g_cs, McpRegs::txbCtrl(b)), nowMs);
+          buf.slot = -1;
+        }
+        continue;
+      }
+      complete(s, nowMs);
+      buf.slot = -1;
+    }
+    if (busy) {
+      continue;
+    }
+    if (Slot* s = pick(static_cast<Prio>(b), nowMs)) {
+      load(b, *s, nowMs);
+    }
+  }
+}
+
+bool pollEvent(Event& out) {
+  if (g_evHead == g_evTail) {
+    return false;
+  }
+  out = g_events[g_evTail & (EVENT_LEN - 1)];
+  g_evTail++;
+  return true;
+}
+
+uint8_t depth() { return used(); }
+
+const Stats& stats() { return g_stats; }
+}  // namespace CanTx
@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+
+// Non-blocking CAN transmit queue.
+// Callers enqueue and return; service() runs once per loop() and owns the MCP2515's three TX
+// buffers. Each priority has its own buffer, high in TXB2, normal in TXB1, low in TXB0, so with
+// equal TXP bits the controller itself sends the higher class first and a slow low-priority
+// frame never holds up a beep. The controller retries lost arbitration on its own; a frame whose
+// TXREQ is still set after TX_TIMEOUT_MS (no ACK, error passive, bus-off) is aborted and retried
+// with doubling back-off until MAX_ATTEMPTS. Per-ID rate limits hold a frame in the queue until
+// its ID may go again. Results come back as events, tagged with the caller's tag.
+namespace CanTx {
+  constexpr uint8_t QUEUE_LEN      = 16;
+  constexpr uint8_t EVENT_LEN      = 8;    // power of two
+  constexpr uint8_t RATE_SLOTS     = 8;
+  constexpr uint8_t MAX_ATTEMPTS   = 4;
+  constexpr uint32_t TX_TIMEOUT_MS = 50;
+  constexpr uint32_t BACKOFF_MS    = 10;   // 10, 20, 40 ms between attempts
+
+  enum Prio : uint8_t { PRIO_LOW, PRIO_NORMAL, PRIO_HIGH, PRIO__COUNT };   // = TX buffer index
+
+  enum Result : uint8_t { TX_QUEUED, TX_FULL, TX_BAD_FRAME };
+
+  enum EventKind : uint8_t {
+    EV_SENT,     // acknowledged on the bus
+    EV_FAILED,   // gave up after MAX_ATTEMPTS
+  };
+
+  struct Event {
+    uint32_t id;
+    uint16_t tag;
+    EventKind kind;
+    uint8_t attempts;
+    uint8_t ctrl;        // TXBnCTRL at the last abort (ABTF/MLOA/TXERR), 0 when sent first time
+  };
+
+  struct Stats {
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t retries;
+    uint32_t full;          // send() refused, queue full
+    uint32_t rateHeld;      // service passes a frame waited on its ID's rate limit
+    uint32_t eventOverflows;
+    uint8_t maxDepth;
+    uint32_t maxLatencyMs;  // send() -> acknowledged
+  };
+
+  void begin(MCP2515& mcp, uint8_t csPin);
+  Result send(const can_frame& f, Prio prio, uint16_t tag = 0);
+  // Minimum spacing between frames with this ID; 0 removes the limit. False when all slots are used.
+  bool setRateLimit(uint32_t id, uint16_t minIntervalMs);
+  void service(unsigned long nowMs);
+  bool pollEvent(Event& out);
+  uint8_t depth();
+  const Stats& stats();
+}
@@ -0,0 +1,217 @@
+#include "ChannelTraits.h"
+#include <math.h>
+#include "CanDecode.h"
+#include "UserChannels.h"
+#include "DerivedChannels.h"
+#include "TripComputer.h"
+
+extern uint8_t g_uPressure, g_uTemp, g_uSpeed, g_uLambda;
+extern float speedTrimPct;
+
+namespace {
+constexpr uint8_t PBW = CHF_PILL | CHF_BAR | CHF_WARN;
+constexpr uint8_t PB  = CHF_PILL | CHF_BAR;
+
+constexpr ChannelTraits fromFloat(Channel ch, const char* label, UnitClass u, Range r, uint8_t dec,
+                                  MinMaxMode mm, uint8_t flags, const float* src) {
+  return {ch, label, u, r, dec, mm, flags, SRC_FLOAT, src, nullptr, nullptr};
+}
+constexpr ChannelTraits fromU8(Channel ch, const char* label, UnitClass u, Range r, uint8_t flags, const uint8_t* src) {
+  return {ch, label, u, r, 0, MINMAX_MAX, flags, SRC_U8, nullptr, src, nullptr};
+}
+constexpr ChannelTraits fromVictron(Channel ch, const char* label, UnitClass u, Range r, uint8_t dec,
+                                    MinMaxMode mm, uint8_t flags, float VictronReadings::* src) {
+  return {ch, label, u, r, dec, mm, static_cast<uint8_t>(flags | CHF_VICTRON), SRC_VICTRON, nullptr, nullptr, src};
+}
+// Gear / converter / headlights: not a float, drawn specially by the renderer
+constexpr ChannelTraits fromState(Channel ch, const char* label, uint8_t flags) {
+  return {ch, label, UC_NONE, {0, 1}, 0, MINMAX_NONE, flags, SRC_STATE, nullptr, nullptr, nullptr};
+}
+constexpr ChannelTraits user(Channel ch, const char* label) {
+  return {ch, label, UC_CUSTOM, {0, 100}, 0, MINMAX_MAX, PBW, SRC_USER, nullptr, nullptr, nullptr};
+}
+constexpr ChannelTraits derived(Channel ch, const char* label) {
+  return {ch, label, UC_CUSTOM, {0, 100}, 0, MINMAX_MAX, PBW, SRC_DERIVED, nullptr, nullptr, nullptr};
+}
+constexpr ChannelTraits trip(Channel ch, const char* label, UnitClass u, uint8_t dec) {
+  return {ch, label, u, {0, 1000}, dec, MINMAX_NONE, CHF_PILL, SRC_TRIP, nullptr, nullptr, nullptr};
+}
+
+// One row per Channel, in enum order (checked below)
+constexpr ChannelTraits kTraits[] = {
+  fromFloat(CH_SOOT,      "Soot %",      UC_PERCENT,  {0, 100},    0, MINMAX_MAX, PBW, &soot_pct),
+  fromFloat(CH_SPEED,     "Speed",       UC_SPEED,    {0, 200},    0, MINMAX_MAX, PBW, &speed_kmh),
+  fromFloat(CH_RPM,       "RPM",         UC_NONE,     {0, 5000},   0, MINMAX_MAX, PBW, &rpm),
+  fromFloat(CH_COOLANT,   "Coolant",     UC_TEMP,     {40, 110},   0, MINMAX_MAX, PBW, &coolantC),
+  fromFloat(CH_TRANS1,    "Trans 1",     UC_TEMP,     {40, 130},   0, MINMAX_MAX, PBW, &trans1C),
+  fromFloat(CH_TRANS2,    "Trans 2",     UC_TEMP,     {40, 130},   0, MINMAX_MAX, PBW, &trans2C),
+  fromFloat(CH_OIL,       "Oil",         UC_PRESSURE, {0, 600},    0, MINMAX_MAX, CHF_LABEL_UNIT, &oil_kPa),
+  fromFloat(CH_BATTV,     "Battery",     UC_VOLT,     {10, 15},    1, MINMAX_MAX, PBW, &battV),
+  fromState(CH_GEAR,      "Gear",        CHF_PILL),
+  fromState(CH_LOCKUP,    "Converter",   CHF_PILL),
+  fromFloat(CH_TORQUE,    "Torque",      UC_NM,       {-200, 600}, 0, MINMAX_MAX, PBW, &torqueNm),
+  fromFloat(CH_PEDAL,     "Pedal %",     UC_PERCENT,  {0, 100},    0, MINMAX_MAX, PBW, &pedalPct),
+  fromFloat(CH_TQ_DEMAND, "TQ Demand %", UC_PERCENT,  {0, 100},    0, MINMAX_MAX, PBW, &tqDemandPct),
+  fromFloat(CH_EGT1,      "EGT 1",       UC_TEMP,     {0, 1000},   0, MINMAX_MAX, PBW, &egt1C),
+  fromFloat(CH_EGT2,      "EGT 2",       UC_TEMP,     {0, 1000},   0, MINMAX_MAX, PBW, &egt2C),
+  fromFloat(CH_BOOST,     "Boost",       UC_PRESSURE, {0, 250},    0, MINMAX_MAX, PBW, &boost_kPa),
+  fromFloat(CH_MANIFOLD,  "Manifold 2",  UC_TEMP,     {0, 150},    0, MINMAX_MAX, PBW, &manifoldC),
+  fromFloat(CH_TURBO_OUT, "Manifold 1",  UC_TEMP,     {0, 200},    0, MINMAX_MAX, PBW, &turboOutC),
+  fromFloat(CH_LAMBDA,    "Lambda",      UC_LAMBDA,   {0, 2},      2, MINMAX_MIN, PBW, &lambdaVal),
+  fromFloat(CH_IAT,       "Intake T",    UC_TEMP,     {0, 80},     0, MINMAX_MAX, PBW, &iatC),
+  fromFloat(CH_FUELT,     "Fuel T",      UC_TEMP,     {0, 100},    0, MINMAX_MAX, PBW, &fuelC),
+  fromU8   (CH_ACTUATOR,  "Turbo %",     UC_NONE,     {0, 255},    PB, &turboActRaw),
+  fromState(CH_HEADLIGHTS,"Headlights",  CHF_PILL),
+  fromVictron(CH_BATT_SOC,   "Aux Batt %", UC_PERCENT, {0, 100},    0, MINMAX_MIN,  PBW, &VictronReadings::battSocPct),
+  fromVictron(CH_BATT_CURR,  "Aux Batt A", UC_AMP,     {-300, 300}, 1, MINMAX_MAX,  PB,  &VictronReadings::battCurrentA),
+  fromVictron(CH_BATT_TTG,   "Time Rem",   UC_MINUTES, {0, 1440},   0, MINMAX_NONE, PB,  &VictronReadings::battTimeMin),
+  fromVictron(CH_BATTV2,     "Aux Batt V", UC_VOLT,    {10, 15},    2, MINMAX_MAX,  PB,  &VictronReadings::battV2),
+  fromVictron(CH_DCDC_OUT_A, "DCDC Out A", UC_AMP,     {0, 200},    1, MINMAX_MAX,  PB,  &VictronReadings::dcdcOutA),
+  fromVictron(CH_DCDC_OUT_V, "DCDC Out V", UC_VOLT,    {0, 60},     2, MINMAX_MAX,  PB,  &VictronReadings::dcdcOutV),
+  fromVictron(CH_DCDC_IN_V,  "DCDC In V",  UC_VOLT,    {0, 60},     2, MINMAX_MAX,  PB,  &VictronReadings::dcdcInV),
+  fromVictron(CH_PV_WATTS,   "PV Watts",   UC_WATT,    {0, 2000},   0, MINMAX_MAX,  PB,  &VictronReadings::pvWatts),
+  fromVictron(CH_PV_AMPS,    "PV Amps",    UC_AMP,     {0, 100},    1, MINMAX_MAX,  PB,  &VictronReadings::pvAmps),
+  fromVictron(CH_PV_YIELD,   "PV Yield",   UC_KWH,     {0, 20},     2, MINMAX_MAX,  PB,  &VictronReadings::pvYieldKwh),
+  user(CH_USER1, "User 1"), user(CH_USER2, "User 2"), user(CH_USER3, "User 3"), user(CH_USER4, "User 4"),
+  user(CH_USER5, "User 5"), user(CH_USER6, "User 6"), user(CH_USER7, "User 7"), user(CH_USER8, "User 8"),
+  derived(CH_CALC1, "Calc 1"), derived(CH_CALC2, "Calc 2"), derived(CH_CALC3, "Calc 3"), derived(CH_CALC4, "Calc 4"),
+  trip(CH_TRIP_A_DIST,  "Trip A",      UC_DISTANCE,      1),
+  trip(CH_TRIP_A_AVG,   "Trip A avg",  UC_SPEED_TRIMMED, 0),
+  trip(CH_TRIP_A_TIME,  "Trip A time", UC_HOURS,         1),
+  trip(CH_TRIP_A_FUEL,  "Trip A fuel", UC_LITRES,        1),
+  trip(CH_TRIP_B_DIST,  "Trip B",      UC_DISTANCE,      1),
+  trip(CH_TRIP_B_AVG,   "Trip B avg",  UC_SPEED_TRIMMED, 0),
+  trip(CH_ODO,          "Odometer",    UC_DISTANCE,      0),
+  trip(CH_ENGINE_HOURS, "Engine hrs",  UC_HOURS,         1),
+};
+
+constexpr size_t kTraitCount = sizeof(kTraits) / sizeof(kTraits[0]);
+constexpr bool rowsInOrder(size_t i) {
+  return i >= kTraitCount || (kTraits[i].ch == static_cast<Channel>(i) && rowsInOrder(i + 1));
+}
+static_assert(kTraitCount == CH__COUNT, "kTraits must have one row per Channel");
+static_assert(rowsInOrder(0), "kTraits rows must follow the Channel enum order");
+
+// Unit-dependent conversion for one unit class
+struct UnitView {
+  const char* unit;
+  float factor, offset;
+  int8_t decimals;  // -1 = keep the channel's own
+};
+
+const char* fixedUnit(UnitClass u) {
+  switch (u) {
+    case UC_PERCENT: return "%";
+    case UC_VOLT: return "V";
+    case UC_AMP: return "A";
+    case UC_MINUTES: return "min";
+    case UC_WATT: return "W";
+    case UC_KWH: return "kWh";
+    case UC_NM: return "Nm";
+    case UC_HOURS: return "h";
+    case UC_LITRES: return "L";
+    default: return "";
+  }
+}
+
+UnitView unitView(UnitClass u) {
+  switch (u) {
+    case UC_SPEED: {
+      float pct = speedTrimPct;
+      if (!isfinite(pct)) pct = 0.0f;
+      if (pct < -50.0f) pct = -50.0f;
+      if (pct > 50.0f) pct = 50.0f;
+      const float trim = 1.0f + pct / 100.0f;
+      return (g_uSpeed == U_S_kmh) ? UnitView{"km/h", trim, 0, -1} : UnitView{"mph", trim * 0.62137119f, 0, -1};
+    }
+    case UC_DISTANCE:
+      return (g_uSpeed == U_S_kmh) ? UnitView{"km", 1, 0, -1} : UnitView{"mi", 0.62137119f, 0, -1};
+    case UC_SPEED_TRIMMED:
+      return (g_uSpeed == U_S_kmh) ? UnitView{"km/h", 1, 0, -1} : UnitView{"mph", 0.62137119f, 0, -1};
+    case UC_TEMP:
+      return (g_uTemp == U_T_C) ? UnitView{"C", 1, 0, -1} : UnitView{"F", 9.0f / 5.0f, 32.0f, -1};
+    case UC_PRESSURE:
+      return (g_uPressure == U_P_kPa) ? UnitView{"kPa", 1, 0, -1} : UnitView{"psi", 0.1450377f, 0, -1};
+    case UC_LAMBDA:
+      return (g_uLambda == U_L_lambda) ? UnitView{"λ", 1, 0, 2} : UnitView{"AFR", 14.5f, 0, 1};
+    default:
+      return UnitView{fixedUnit(u), 1, 0, -1};
+  }
+}
+
+const float kPow10[] = {1.0f, 10.0f, 100.0f, 1000.0f};
+
+struct UnitsKey {
+  uint8_t p, t, s, l;
+  float trim;
+  bool operator!=(const UnitsKey& o) const { return p != o.p || t != o.t || s != o.s || l != o.l || trim != o.trim; }
+};
+UnitsKey g_builtFor{0xFF, 0xFF, 0xFF, 0xFF, NAN};
+}  // namespace
+
+namespace Channels {
+ChannelRuntime g_runtime[CH__COUNT];
+
+const ChannelTraits& traits(Channel ch) { return kTraits[ch < CH__COUNT ? ch : 0]; }
+
+void rebuild() {
+  g_builtFor = {g_uPressure, g_uTemp, g_uSpeed, g_uLambda, speedTrimPct};
+  for (uint8_t i = 0; i < CH__COUNT; i++) {
+    const ChannelTraits& t = kTraits[i];
+    ChannelRuntime& r = g_runtime[i];
+    const UnitView uv = unitView(t.unit);
+    uint8_t dec = (uv.decimals >= 0) ? static_cast<uint8_t>(uv.decimals) : t.decimals;
+    Range range = t.base;
+    const char* label = t.label;
+    r.unit = uv.unit;
+
+    if (t.source == SRC_USER) {
+      const UserChannelDef& d = UserCh::def(userChannelIndex(t.ch));
+      if (d.label[0]) label = d.label;
+      r.unit = d.unit;
+      dec = d.decimals;
+      range = {d.rangeMin, d.rangeMax};
+    } else if (t.source == SRC_DERIVED) {
+      const DerivedChannelDef& d = Derived::def(derivedChannelIndex(t.ch));
+      if (d.label[0]) label = d.label;
+      r.unit = d.unit;
+      dec = d.decimals;
+      range = {d.rangeMin, d.rangeMax};
+    }
+    if (dec > 3) dec = 3;
+
+    if (t.flags & CHF_LABEL_UNIT) {
+      snprintf(r.label, sizeof(r.label), "%s %s", label, r.unit);
+    } else {
+      snprintf(r.label, sizeof(r.label), "%s", label);
+    }
+    r.factor = uv.factor;
+    r.offset = uv.offset;
+    r.decimals = dec;
+    r.keyScale = kPow10[dec];
+    r.step = 1.0f / kPow10[dec];
+    r.range = {range.mn * uv.factor + uv.offset, range.mx * uv.factor + uv.offset};
+    if (r.range.mx <= r.range.mn) r.range.mx = r.range.mn + 1;
+  }
+}
+
+void sync() {
+  const UnitsKey now{g_uPressure, g_uTemp, g_uSpeed, g_uLambda, speedTrimPct};
+  if (now != g_builtFor) {
+    rebuild();
+  }
+}
+
+float raw(Channel ch) {
+  const ChannelTraits& t = kTraits[ch];
+  switch (t.source) {
+    case SRC_FLOAT: return *t.f;
+    case SRC_U8: return static_cast<float>(*t.u8);
+    case SRC_VICTRON: return victronReadings().*(t.victron);
+    case SRC_USER: return UserCh::value(userChannelIndex(ch));
+    case SRC_DERIVED: return Derived::value(derivedChannelIndex(ch));
+    case SRC_TRIP: return Trip::channelValue(ch);
+    default: return NAN;
+  }
+}
+}  // namespace Channels
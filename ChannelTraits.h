@@ -0,0 +1,68 @@
+#pragma once
+#include <Arduino.h>
+#include "DashTypes.h"
+#include "VictronBle.h"
+
+// Per-channel knowledge in one place.
+// ChannelTraits is the constexpr description of each channel (base units); ChannelRuntime
+// is the unit-dependent view (label, unit, display range, conversion, decimals) that the
+// UI reads on the hot path. The runtime table is rebuilt by Channels::sync() only when the
+// unit selection or speed trim changes, or explicitly via Channels::rebuild() after the
+// user/derived channel definitions change.
+// Adding a channel: one enum value in DashTypes.h + one row in kTraits (ChannelTraits.cpp).
+
+enum UnitClass : uint8_t {
+  UC_NONE, UC_PERCENT, UC_SPEED, UC_TEMP, UC_PRESSURE, UC_LAMBDA,
+  UC_VOLT, UC_AMP, UC_MINUTES, UC_WATT, UC_KWH, UC_NM, UC_CUSTOM,
+  UC_DISTANCE, UC_SPEED_TRIMMED, UC_HOURS, UC_LITRES   // trip computer (values already trimmed)
+};
+
+enum ChannelFlag : uint8_t {
+  CHF_PILL       = 1 << 0,  // selectable as a pill
+  CHF_BAR        = 1 << 1,  // selectable as the bar
+  CHF_WARN       = 1 << 2,  // warning-eligible
+  CHF_VICTRON    = 1 << 3,  // hidden while Victron is disabled
+  CHF_LABEL_UNIT = 1 << 4,  // label is "<label> <unit>"
+};
+
+enum SourceKind : uint8_t { SRC_FLOAT, SRC_U8, SRC_VICTRON, SRC_USER, SRC_DERIVED, SRC_STATE, SRC_TRIP };
+
+struct ChannelTraits {
+  Channel ch;
+  const char* label;
+  UnitClass unit;
+  Range base;
+  uint8_t decimals;       // display decimals (lambda: from the unit table)
+  MinMaxMode minMax;
+  uint8_t flags;          // ChannelFlag
+  SourceKind source;
+  const float* f;                     // SRC_FLOAT
+  const uint8_t* u8;                  // SRC_U8
+  float VictronReadings::* victron;   // SRC_VICTRON
+};
+
+struct ChannelRuntime {
+  char label[16];
+  const char* unit;
+  Range range;            // display units
+  float factor, offset;   // display = base * factor + offset
+  float step;             // editor step (display units)
+  float keyScale;         // redraw key = round(display * keyScale)
+  uint8_t decimals;
+};
+
+namespace Channels {
+  const ChannelTraits& traits(Channel ch);
+
+  extern ChannelRuntime g_runtime[CH__COUNT];
+  inline const ChannelRuntime& rt(Channel ch) { return g_runtime[ch]; }
+
+  // Rebuild the runtime table if units/speed trim changed since the last build
+  void sync();
+  void rebuild();
+
+  float raw(Channel ch);
+  inline float toDisplay(Channel ch, float base) { return base * g_runtime[ch].factor + g_runtime[ch].offset; }
+  inline float fromDisplay(Channel ch, float v) { return (v - g_runtime[ch].offset) / g_runtime[ch].factor; }
+  inline float display(Channel ch) { return toDisplay(ch, raw(ch)); }
+}
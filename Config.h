@@ -12,6 +12,15 @@ namespace CFG {
   constexpr uint8_t BACKLIGHT_PWM=D0;
   constexpr CAN_SPEED CAN_SPEED_SEL = CAN_500KBPS;
   constexpr CAN_CLOCK CAN_CLOCK_SEL = MCP_16MHZ;
+
+  // Second MCP2515 on the body/comfort bus; left out at boot when nothing answers on CAN_CS2.
+  // Bus 0 is always the powertrain bus. Body frames (headlights, steering buttons) are decoded
+  // from bus 1 when it is fitted, from bus 0 otherwise.
+  constexpr bool CAN2_ENABLED = true;
+  constexpr uint8_t CAN_CS2= D4, CAN_INT2= D5;
+  constexpr CAN_SPEED CAN2_SPEED_SEL = CAN_125KBPS;
+  constexpr CAN_CLOCK CAN2_CLOCK_SEL = MCP_16MHZ;
+  constexpr uint8_t CAN_BUS_PT = 0, CAN_BUS_BODY = 1;
   
   // Core frames
   constexpr uint32_t ID_SPEED=0x141, ID_RPM_SPEED=0x160, ID_TRANS_T=0x050, ID_GEAR_LOCK=0x161;
@@ -27,7 +36,15 @@ namespace CFG {
   constexpr uint32_t ID_ACTUATOR=0x4CD;    // byte 3 (raw)
   constexpr uint32_t ID_HEADLIGHTS=0x401;  // byte 1 (0x50 on)
 
-  constexpr uint32_t SCREEN_REFRESH_MS=16.66;
+  // Hardware acceptance filters per bus (up to 6 IDs, empty = pass everything). The body bus is
+  // busy with frames the dash never reads; only what it decodes gets through, with the IDs of
+  // user channels set to that bus added at runtime. The sniffer and GVRET open the filters.
+  constexpr uint32_t CAN2_ACCEPT[] = { ID_HEADLIGHTS, ID_SWBTN };
+
+  // Render scheduler: frame tick in µs (60 Hz) and the per-frame drawing budget.
+  // Dirty widgets that do not fit the budget carry over to the next frame.
+  constexpr uint32_t SCREEN_REFRESH_US=16667;
+  constexpr uint32_t RENDER_BUDGET_US=8000;
 
   // Soot scaling (no learning)
   constexpr float SOOT_DIV = 14.1f;
@@ -18,9 +18,37 @@ enum Channel : uint8_t {
   CH_BATT_SOC, CH_BATT_CURR, CH_BATT_TTG, CH_BATTV2,
   CH_DCDC_OUT_A, CH_DCDC_OUT_V, CH_DCDC_IN_V,
   CH_PV_WATTS, CH_PV_AMPS, CH_PV_YIELD,
+  CH_USER1, CH_USER2, CH_USER3, CH_USER4, CH_USER5, CH_USER6, CH_USER7, CH_USER8,
+  CH_CALC1, CH_CALC2, CH_CALC3, CH_CALC4,
+  CH_TRIP_A_DIST, CH_TRIP_A_AVG, CH_TRIP_A_TIME, CH_TRIP_A_FUEL,
+  CH_TRIP_B_DIST, CH_TRIP_B_AVG, CH_ODO, CH_ENGINE_HOURS,
   CH__COUNT
 };
 
+// User-defined CAN channels (decoded from UserChannelDef in the persisted config)
+constexpr uint8_t USER_CHANNEL_COUNT = CH_CALC1 - CH_USER1;
+inline bool isUserChannel(Channel ch){ return ch >= CH_USER1 && ch < CH_CALC1; }
+inline uint8_t userChannelIndex(Channel ch){ return (uint8_t)(ch - CH_USER1); }
+
+// Derived channels (expressions over other channels, see DerivedChannels.h)
+constexpr uint8_t DERIVED_CHANNEL_COUNT = CH_CALC4 + 1 - CH_CALC1;
+inline bool isDerivedChannel(Channel ch){ return ch >= CH_CALC1 && ch <= CH_CALC4; }
+inline uint8_t derivedChannelIndex(Channel ch){ return (uint8_t)(ch - CH_CALC1); }
+
+// Screen layout templates (cell geometry in Layout.cpp)
+enum LayoutTemplate : uint8_t {
+  LT_BAR_QUAD,   // bar + 2x2 pills (the original fixed screen)
+  LT_BIG,        // one big number
+  LT_ONE_TWO,    // one large pill over two
+  LT_GRID_3X2,
+  LT_GRID_3X3,   // compact
+  LT_TWO_BARS,
+  LT_BAR_SIX,    // bar + 3x2 pills
+  LT_TWO_DIALS,  // two round dials over two pills
+  LT_DIAL_THREE, // large dial + three pills
+  LT__COUNT
+};
+
 // Units selection
 enum UnitsPressure : uint8_t { U_P_kPa=0, U_P_psi=1 };
 enum UnitsTemp     : uint8_t { U_T_C=0,   U_T_F=1   };
@@ -48,4 +76,5 @@ enum MenuState : uint8_t {
   MENU_SPEED_TRIM, 
   MENU_OBD2,
   MENU_OBD2_ACTION,
+  MENU_REGEN,              // DPF regen history / soot prediction
 };
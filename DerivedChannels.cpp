@@ -0,0 +1,385 @@
+#include "DerivedChannels.h"
+#include <math.h>
+#include <string.h>
+#include "ValueConversion.h"
+
+namespace {
+enum Op : uint8_t {
+  OP_CONST,  // + const index
+  OP_INPUT,  // + input slot
+  OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_NEG,
+  OP_ABS, OP_SQRT, OP_MIN, OP_MAX
+};
+
+struct Program {
+  uint8_t code[Derived::MAX_CODE];
+  uint8_t codeLen;
+  float consts[Derived::MAX_CONSTS];
+  uint8_t constCount;
+  Channel inputs[Derived::MAX_INPUTS];
+  uint8_t inputCount;
+};
+
+struct Slot {
+  DerivedChannelDef def;
+  Program prog;
+  bool ok;
+  bool evaluated;
+  float inputCache[Derived::MAX_INPUTS];
+  float value;
+  char error[32];
+};
+
+Slot g_slots[DERIVED_CHANNEL_COUNT];
+uint32_t g_evals = 0;
+uint32_t g_skipped = 0;
+
+struct NameEntry { const char* name; Channel ch; };
+const NameEntry kNames[] = {
+  {"soot", CH_SOOT}, {"speed", CH_SPEED}, {"rpm", CH_RPM}, {"coolant", CH_COOLANT},
+  {"trans1", CH_TRANS1}, {"trans2", CH_TRANS2}, {"oil", CH_OIL}, {"battv", CH_BATTV},
+  {"torque", CH_TORQUE}, {"pedal", CH_PEDAL}, {"tqdemand", CH_TQ_DEMAND},
+  {"egt1", CH_EGT1}, {"egt2", CH_EGT2}, {"boost", CH_BOOST}, {"manifold", CH_MANIFOLD},
+  {"turboout", CH_TURBO_OUT}, {"lambda", CH_LAMBDA}, {"iat", CH_IAT}, {"fuel", CH_FUELT},
+  {"soc", CH_BATT_SOC}, {"batt_a", CH_BATT_CURR}, {"ttg", CH_BATT_TTG}, {"battv2", CH_BATTV2},
+  {"dcdc_a", CH_DCDC_OUT_A}, {"dcdc_v", CH_DCDC_OUT_V}, {"dcdc_in_v", CH_DCDC_IN_V},
+  {"pv_w", CH_PV_WATTS}, {"pv_a", CH_PV_AMPS}, {"pv_yield", CH_PV_YIELD},
+  {"user1", CH_USER1}, {"user2", CH_USER2}, {"user3", CH_USER3}, {"user4", CH_USER4},
+  {"user5", CH_USER5}, {"user6", CH_USER6}, {"user7", CH_USER7}, {"user8", CH_USER8},
+};
+
+// Recursive-descent compiler emitting postfix bytecode
+class Compiler {
+ public:
+  Compiler(const char* src, Program& out, char* err, size_t errLen)
+      : p_(src), src_(src), prog_(out), err_(err), errLen_(errLen) {}
+
+  bool run() {
+    memset(&prog_, 0, sizeof(prog_));
+    depth_ = 0;
+    maxDepth_ = 0;
+    nest_ = 0;
+    skipWs();
+    if (!*p_) {
+      return fail("empty");
+    }
+    if (!expr()) {
+      return false;
+    }
+    skipWs();
+    if (*p_) {
+      return fail("unexpected");
+    }
+    return true;
+  }
+
+ private:
+  const char* p_;
+  const char* src_;
+  Program& prog_;
+  char* err_;
+  size_t errLen_;
+  int8_t depth_;
+  int8_t maxDepth_;
+  uint8_t nest_;
+  bool failed_ = false;
+
+  bool fail(const char* what) {
+    if (!failed_) {
+      snprintf(err_, errLen_, "%s at %d", what, static_cast<int>(p_ - src_));
+      failed_ = true;
+    }
+    return false;
+  }
+
+  void skipWs() {
+    while (*p_ == ' ' || *p_ == '\t') {
+      p_++;
+    }
+  }
+
+  bool emit(uint8_t b) {
+    if (prog_.codeLen >= Derived::MAX_CODE) {
+      return fail("too long");
+    }
+    prog_.code[prog_.codeLen++] = b;
+    return true;
+  }
+
+  // Track stack depth: push (+1) / binary op (-1)
+  bool stack(int8_t delta) {
+    depth_ += delta;
+    if (depth_ > maxDepth_) {
+      maxDepth_ = depth_;
+    }
+    return (maxDepth_ <= Derived::MAX_STACK) || fail("too deep");
+  }
+
+  // One nesting level around a recursive step; callers pair it with leave()
+  bool enter() {
+    return ++nest_ <= Derived::MAX_NEST || fail("too deep");
+  }
+
+  bool leave(bool ok) {
+    nest_--;
+    return ok;
+  }
+
+  bool expr() {
+    if (!term()) {
+      return false;
+    }
+    for (;;) {
+      skipWs();
+      const char c = *p_;
+      if (c != '+' && c != '-') {
+        return true;
+      }
+      p_++;
+      if (!term() || !emit(c == '+' ? OP_ADD : OP_SUB) || !stack(-1)) {
+        return false;
+      }
+    }
+  }
+
+  bool term() {
+    if (!unary()) {
+      return false;
+    }
+    for (;;) {
+      skipWs();
+      const char c = *p_;
+      if (c != '*' && c != '/') {
+        return true;
+      }
+      p_++;
+      if (!unary() || !emit(c == '*' ? OP_MUL : OP_DIV) || !stack(-1)) {
+        return false;
+      }
+    }
+  }
+
+  bool unary() {
+    skipWs();
+    if (*p_ == '-') {
+      p_++;
+      return leave(enter() && unary() && emit(OP_NEG));
+    }
+    return primary();
+  }
+
+  bool primary() {
+    skipWs();
+    if (*p_ == '(') {
+      p_++;
+      return leave(enter() && group());
+    }
+    if (isdigit(static_cast<unsigned char>(*p_)) || *p_ == '.') {
+      char* end = nullptr;
+      const float v = strtof(p_, &end);
+      if (end == p_) {
+        return fail("bad number");
+      }
+      p_ = end;
+      return pushConst(v);
+    }
+    if (isalpha(static_cast<unsigned char>(*p_)) || *p_ == '_') {
+      char name[16];
+      uint8_t n = 0;
+      while ((isalnum(static_cast<unsigned char>(*p_)) || *p_ == '_') && n < sizeof(name) - 1) {
+        name[n++] = static_cast<char>(tolower(static_cast<unsigned char>(*p_++)));
+      }
+      name[n] = '\0';
+      skipWs();
+      if (*p_ == '(') {
+        return leave(enter() && call(name));
+      }
+      return pushInput(name);
+    }
+    return fail("unexpected");
+  }
+
+  // '(' expr ')' after the opening bracket
+  bool group() {
+    if (!expr()) {
+      return false;
+    }
+    skipWs();
+    if (*p_ != ')') {
+      return fail("missing )");
+    }
+    p_++;
+    return true;
+  }
+
+  bool call(const char* name) {
+    uint8_t op;
+    uint8_t argc;
+    if (!strcmp(name, "abs")) {
+      op = OP_ABS; argc = 1;
+    } else if (!strcmp(name, "sqrt")) {
+      op = OP_SQRT; argc = 1;
+    } else if (!strcmp(name, "min")) {
+      op = OP_MIN; argc = 2;
+    } else if (!strcmp(name, "max")) {
+      op = OP_MAX; argc = 2;
+    } else {
+      return fail("unknown fn");
+    }
+    p_++;  // '('
+    for (uint8_t i = 0; i < argc; i++) {
+      if (i > 0) {
+        skipWs();
+        if (*p_ != ',') {
+          return fail("expected ,");
+        }
+        p_++;
+      }
+      if (!expr()) {
+        return false;
+      }
+    }
+    skipWs();
+    if (*p_ != ')') {
+      return fail("missing )");
+    }
+    p_++;
+    return emit(op) && stack(static_cast<int8_t>(1 - argc));
+  }
+
+  bool pushConst(float v) {
+    uint8_t idx = prog_.constCount;
+    for (uint8_t i = 0; i < prog_.constCount; i++) {
+      if (prog_.consts[i] == v) {
+        idx = i;
+      }
+    }
+    if (idx == prog_.constCount) {
+      if (prog_.constCount >= Derived::MAX_CONSTS) {
+        return fail("too many consts");
+      }
+      prog_.consts[prog_.constCount++] = v;
+    }
+    return emit(OP_CONST) && emit(idx) && stack(+1);
+  }
+
+  bool pushInput(const char* name) {
+    const NameEntry* found = nullptr;
+    for (const NameEntry& e : kNames) {
+      if (!strcmp(e.name, name)) {
+        found = &e;
+        break;
+      }
+    }
+    if (!found) {
+      return fail("unknown name");
+    }
+    uint8_t slot = prog_.inputCount;
+    for (uint8_t i = 0; i < prog_.inputCount; i++) {
+      if (prog_.inputs[i] == found->ch) {
+        slot = i;
+      }
+    }
+    if (slot == prog_.inputCount) {
+      if (prog_.inputCount >= Derived::MAX_INPUTS) {
+        return fail("too many inputs");
+      }
+      prog_.inputs[prog_.inputCount++] = found->ch;
+    }
+    return emit(OP_INPUT) && emit(slot) && stack(+1);
+  }
+};
+
+float run(const Program& prog, const float* in) {
+  float st[Derived::MAX_STACK];
+  int8_t sp = -1;
+  for (uint8_t pc = 0; pc < prog.codeLen;) {
+    switch (prog.code[pc++]) {
+      case OP_CONST: st[++sp] = prog.consts[prog.code[pc++]]; break;
+      case OP_INPUT: st[++sp] = in[prog.code[pc++]]; break;
+      case OP_ADD: sp--; st[sp] = st[sp] + st[sp + 1]; break;
+      case OP_SUB: sp--; st[sp] = st[sp] - st[sp + 1]; break;
+      case OP_MUL: sp--; st[sp] = st[sp] * st[sp + 1]; break;
+      case OP_DIV: sp--; st[sp] = (st[sp + 1] != 0.0f) ? st[sp] / st[sp + 1] : NAN; break;
+      case OP_NEG: st[sp] = -st[sp]; break;
+      case OP_ABS: st[sp] = fabsf(st[sp]); break;
+      case OP_SQRT: st[sp] = (st[sp] >= 0.0f) ? sqrtf(st[sp]) : NAN; break;
+      case OP_MIN: sp--; st[sp] = fminf(st[sp], st[sp + 1]); break;
+      case OP_MAX: sp--; st[sp] = fmaxf(st[sp], st[sp + 1]); break;
+      default: return NAN;
+    }
+  }
+  return sp == 0 ? st[0] : NAN;
+}
+
+// Same value, treating NAN == NAN so missing inputs don't force re-evaluation
+inline bool sameValue(float a, float b) {
+  return (a == b) || (isnan(a) && isnan(b));
+}
+}  // namespace
+
+namespace Derived {
+void configure(const DerivedChannelDef* defs, uint8_t count) {
+  for (uint8_t i = 0; i < DERIVED_CHANNEL_COUNT; i++) {
+    Slot& s = g_slots[i];
+    memset(&s, 0, sizeof(s));
+    if (i < count) {
+      s.def = defs[i];
+    }
+    s.def.expr[DERIVED_EXPR_LEN] = '\0';
+    s.value = NAN;
+    if (!s.def.enabled) {
+      continue;
+    }
+    Compiler c(s.def.expr, s.prog, s.error, sizeof(s.error));
+    s.ok = c.run();
+  }
+}
+
+void update() {
+  for (uint8_t i = 0; i < DERIVED_CHANNEL_COUNT; i++) {
+    Slot& s = g_slots[i];
+    if (!s.ok) {
+      continue;
+    }
+    bool changed = !s.evaluated;
+    for (uint8_t k = 0; k < s.prog.inputCount; k++) {
+      const float v = valueRawBase(s.prog.inputs[k]);
+      if (!sameValue(v, s.inputCache[k])) {
+        s.inputCache[k] = v;
+        changed = true;
+      }
+    }
+    if (!changed) {
+      g_skipped++;
+      continue;
+    }
+    s.value = run(s.prog, s.inputCache);
+    s.evaluated = true;
+    g_evals++;
+  }
+}
+
+const DerivedChannelDef& def(uint8_t idx) { return g_slots[idx < DERIVED_CHANNEL_COUNT ? idx : 0].def; }
+
+bool enabled(uint8_t idx) { return idx < DERIVED_CHANNEL_COUNT && g_slots[idx].ok; }
+
+float value(uint8_t idx) { return idx < DERIVED_CHANNEL_COUNT ? g_slots[idx].value : NAN; }
+
+const char* error(uint8_t idx) { return idx < DERIVED_CHANNEL_COUNT ? g_slots[idx].error : ""; }
+
+uint8_t codeSize(uint8_t idx) { return idx < DERIVED_CHANNEL_COUNT ? g_slots[idx].prog.codeLen : 0; }
+
+const char* channelName(Channel ch) {
+  for (const NameEntry& e : kNames) {
+    if (e.ch == ch) {
+      return e.name;
+    }
+  }
+  return nullptr;
+}
+
+uint32_t evaluations() { return g_evals; }
+
+uint32_t skipped() { return g_skipped; }
+}  // namespace Derived
@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include "DashTypes.h"
+#include "Persist.h"
+
+// Derived channels (CH_CALC1..CH_CALC4): small arithmetic expressions over other channels,
+// e.g. "torque * rpm / 9549" (kW) or "egt1 - egt2".
+//
+// Grammar:  expr := term (('+'|'-') term)*      term := unary (('*'|'/') unary)*
+//           unary := '-' unary | primary         primary := number | name | fn '(' args ')' | '(' expr ')'
+//           fn: abs(x) sqrt(x) min(a,b) max(a,b)
+// Names are the channel names listed by channelName() (base units). Derived channels
+// cannot reference each other.
+//
+// configure() compiles each expression once into stack bytecode. update() snapshots
+// each program's inputs and re-evaluates only when one of them changed.
+namespace Derived {
+  constexpr uint8_t MAX_CODE   = 48;
+  constexpr uint8_t MAX_CONSTS = 8;
+  constexpr uint8_t MAX_INPUTS = 6;
+  constexpr uint8_t MAX_STACK  = 8;
+  constexpr uint8_t MAX_NEST   = 8;   // '(' / function call / unary minus levels; bounds the compiler's recursion
+
+  void configure(const DerivedChannelDef* defs, uint8_t count);
+  void update();
+
+  const DerivedChannelDef& def(uint8_t idx);
+  bool enabled(uint8_t idx);        // enabled and compiled
+  float value(uint8_t idx);         // NAN until first evaluation / on math error
+  const char* error(uint8_t idx);   // compile error, "" when ok
+  uint8_t codeSize(uint8_t idx);
+
+  // Expression name for a channel (nullptr if not usable as an input)
+  const char* channelName(Channel ch);
+
+  uint32_t evaluations();
+  uint32_t skipped();               // update() passes with unchanged inputs
+}
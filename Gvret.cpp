@@ -0,0 +1,384 @@
+#include "Gvret.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include "CanBus.h"
+#include "CanTx.h"
+
+namespace {
+using namespace Gvret;
+
+// Host -> device
+constexpr uint8_t GV_BINARY   = 0xE7;   // sent twice: switch to binary mode
+constexpr uint8_t GV_CMD      = 0xF1;
+constexpr uint8_t GV_FRAME    = 0x00;   // also device -> host for received frames
+constexpr uint8_t GV_TIME     = 0x01;
+constexpr uint8_t GV_DIG_IN   = 0x02;
+constexpr uint8_t GV_ANA_IN   = 0x03;
+constexpr uint8_t GV_DIG_OUT  = 0x04;
+constexpr uint8_t GV_SETUP    = 0x05;
+constexpr uint8_t GV_BUSES    = 0x06;
+constexpr uint8_t GV_INFO     = 0x07;
+constexpr uint8_t GV_SWCAN    = 0x08;
+constexpr uint8_t GV_KEEP     = 0x09;
+constexpr uint8_t GV_SYSTYPE  = 0x0A;
+constexpr uint8_t GV_ECHO     = 0x0B;
+constexpr uint8_t GV_NBUSES   = 0x0C;
+constexpr uint8_t GV_EXT      = 0x0D;
+constexpr uint8_t GV_SET_EXT  = 0x0E;
+
+constexpr uint16_t BUILD_NUM  = 618;    // what SavvyCAN expects from ESP32RET-era firmware
+constexpr uint8_t  MAX_RECORD = 12 + 8; // F1 00 ts(4) id(4) len|bus data(8) chk
+
+static_assert((RING_LEN & (RING_LEN - 1)) == 0, "RING_LEN must be a power of two");
+
+struct Rec {
+  uint32_t us;
+  uint32_t id;
+  uint8_t bus;
+  uint8_t dlc;
+  uint8_t data[8];
+};
+
+enum ParseState : uint8_t { PS_IDLE, PS_CMD, PS_FRAME, PS_SKIP };
+
+WiFiServer g_server(PORT);
+WiFiClient g_client;
+bool g_running = false;
+bool g_streaming = false;     // client connected and in binary mode
+uint16_t g_txTag = 0;
+
+Rec g_ring[RING_LEN];
+uint16_t g_head = 0;
+uint16_t g_tail = 0;
+
+uint8_t g_batch[BATCH_BYTES];
+uint16_t g_batchLen = 0;
+uint16_t g_batchSent = 0;     // bytes of g_batch already accepted by the socket
+unsigned long g_batchStartMs = 0;
+
+ParseState g_ps = PS_IDLE;
+uint8_t g_cmd = 0;
+uint8_t g_step = 0;
+uint8_t g_skip = 0;
+uint8_t g_binaryMarks = 0;
+can_frame g_rxFrame;
+uint8_t g_rxBus = 0;
+
+uint32_t g_rateCount = 0;
+unsigned long g_rateStartMs = 0;
+Stats g_stats = {};
+
+inline void put32(uint8_t* p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+void resetClientState() {
+  g_head = g_tail = 0;
+  g_batchLen = g_batchSent = 0;
+  g_ps = PS_IDLE;
+  g_binaryMarks = 0;
+  g_streaming = false;
+}
+
+// Command replies share the batch buffer, so they stay in order with the frame stream
+bool reserve(uint8_t n, unsigned long nowMs) {
+  if (g_batchLen + n > BATCH_BYTES) {
+    return false;
+  }
+  if (g_batchLen == 0) {
+    g_batchStartMs = nowMs;
+  }
+  return true;
+}
+
+void reply(const uint8_t* d, uint8_t n, unsigned long nowMs) {
+  if (reserve(n, nowMs)) {
+    memcpy(&g_batch[g_batchLen], d, n);
+    g_batchLen += n;
+  }
+}
+
+void encode(const Rec& r) {
+  uint8_t* p = &g_batch[g_batchLen];
+  p[0] = GV_CMD;
+  p[1] = GV_FRAME;
+  put32(&p[2], r.us);
+  put32(&p[6], r.id);
+  p[10] = r.dlc | (r.bus << 4);
+  memcpy(&p[11], r.data, r.dlc);
+  p[11 + r.dlc] = 0;
+  g_batchLen += 12 + r.dlc;
+}
+
+void replyBuses(unsigned long nowMs) {
+  uint8_t r[12] = {GV_CMD, GV_BUSES};
+  for (uint8_t b = 0; b < 2; b++) {
+    r[2 + 5 * b] = CanBus::present(b) ? 1 : 0;   // enabled, not listen-only
+    put32(&r[3 + 5 * b], CanBus::bitrate(b));
+  }
+  reply(r, sizeof(r), nowMs);
+}
+
+void finishFrame(unsigned long nowMs) {
+  if (g_cmd == GV_ECHO) {
+    if (reserve(MAX_RECORD, nowMs)) {
+      Rec r = {static_cast<uint32_t>(micros()), g_rxFrame.can_id & CAN_EFF_MASK, g_rxBus, g_rxFrame.can_dlc, {}};
+      if (g_rxFrame.can_id & CAN_EFF_FLAG) {
+        r.id |= 1UL << 31;
+      }
+      memcpy(r.data, g_rxFrame.data, r.dlc);
+      encode(r);
+    }
+    return;
+  }
+  // CanTx drives the powertrain controller only
+  if (g_rxBus != 0 || CanTx::send(g_rxFrame, CanTx::PRIO_LOW, g_txTag) != CanTx::TX_QUEUED) {
+    g_stats.txRejected++;
+    return;
+  }
+  g_stats.txQueued++;
+}
+
+// F1 00/0B: id(4, bit 31 = extended) bus len data[len] checksum
+void frameByte(uint8_t c, unsigned long nowMs) {
+  if (g_step < 4) {
+    const uint32_t v = static_cast<uint32_t>(c) << (8 * g_step);
+    g_rxFrame.can_id = g_step ? g_rxFrame.can_id | v : v;
+  } else if (g_step == 4) {
+    g_rxBus = c;
+    const uint32_t raw = g_rxFrame.can_id;
+    g_rxFrame.can_id = (raw & (1UL << 31)) ? ((raw & CAN_EFF_MASK) | CAN_EFF_FLAG) : (raw & CAN_SFF_MASK);
+  } else if (g_step == 5) {
+    g_rxFrame.can_dlc = c & 0x0F;
+    if (g_rxFrame.can_dlc > 8) {
+      g_rxFrame.can_dlc = 8;
+    }
+  } else if (g_step < 6 + g_rxFrame.can_dlc) {
+    g_rxFrame.data[g_step - 6] = c;
+  } else {
+    finishFrame(nowMs);   // checksum byte, unused by GVRET
+    g_ps = PS_IDLE;
+    return;
+  }
+  g_step++;
+}
+
+void command(uint8_t c, unsigned long nowMs) {
+  g_cmd = c;
+  g_step = 0;
+  g_ps = PS_IDLE;
+  switch (c) {
+    case GV_FRAME:
+    case GV_ECHO:
+      g_rxFrame = {};
+      g_ps = PS_FRAME;
+      break;
+    case GV_TIME: {
+      uint8_t r[6] = {GV_CMD, GV_TIME};
+      put32(&r[2], micros());
+      reply(r, sizeof(r), nowMs);
+    } break;
+    case GV_DIG_IN: {
+      const uint8_t r[] = {GV_CMD, GV_DIG_IN, 0, 0};
+      reply(r, sizeof(r), nowMs);
+    } break;
+    case GV_ANA_IN: {
+      const uint8_t r[] = {GV_CMD, GV_ANA_IN, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+      reply(r, sizeof(r), nowMs);
+    } break;
+    case GV_BUSES:
+      replyBuses(nowMs);
+      break;
+    case GV_INFO: {
+      const uint8_t r[] = {GV_CMD, GV_INFO, BUILD_NUM & 0xFF, BUILD_NUM >> 8, 0x20, 0, 0, 0};
+      reply(r, sizeof(r), nowMs);
+    } break;
+    case GV_KEEP: {
+      const uint8_t r[] = {GV_CMD, GV_KEEP, 0xDE, 0xAD};
+      reply(r, sizeof(r), nowMs);
+    } break;
+    case GV_NBUSES: {
+      const uint8_t r[] = {GV_CMD, GV_NBUSES, CanBus::count()};
+      reply(r, sizeof(r), nowMs);
+    } break;
+    case GV_EXT: {
+      uint8_t r[17] = {GV_CMD, GV_EXT};   // no buses beyond the first two
+      reply(r, sizeof(r), nowMs);
+    } break;
+    // Settings the dash keeps fixed: read the payload and drop it
+    case GV_DIG_OUT:
+    case GV_SWCAN:
+    case GV_SYSTYPE:
+      g_skip = 1;
+      g_ps = PS_SKIP;
+      break;
+    case GV_SETUP:
+      g_skip = 8;
+      g_ps = PS_SKIP;
+      break;
+    case GV_SET_EXT:
+      g_skip = 12;
+      g_ps = PS_SKIP;
+      break;
+    default:
+      break;
+  }
+}
+
+void parse(uint8_t c, unsigned long nowMs) {
+  switch (g_ps) {
+    case PS_IDLE:
+      if (c == GV_CMD) {
+        g_ps = PS_CMD;
+      } else if (c == GV_BINARY) {
+        if (++g_binaryMarks >= 2) {
+          g_streaming = true;
+        }
+        return;
+      }
+      break;
+    case PS_CMD:
+      command(c, nowMs);
+      break;
+    case PS_FRAME:
+      frameByte(c, nowMs);
+      break;
+    case PS_SKIP:
+      if (--g_skip == 0) {
+        g_ps = PS_IDLE;
+      }
+      break;
+  }
+  g_binaryMarks = 0;
+}
+
+void accept() {
+  if (!g_server.hasClient()) {
+    return;
+  }
+  WiFiClient c = g_server.available();
+  if (g_client && g_client.connected()) {
+    c.stop();   // one bridge client at a time
+    return;
+  }
+  g_client = c;
+  g_client.setNoDelay(true);
+  resetClientState();
+  g_stats.clients++;
+}
+
+// False when the socket would block; the rest of the batch goes on the next pass
+bool flush() {
+  while (g_batchSent < g_batchLen) {
+    const ssize_t n = send(g_client.fd(), &g_batch[g_batchSent], g_batchLen - g_batchSent, MSG_DONTWAIT);
+    if (n <= 0) {
+      if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        g_client.stop();
+      }
+      g_stats.stalls++;
+      return false;
+    }
+    g_batchSent += n;
+  }
+  g_stats.batches++;
+  g_batchLen = g_batchSent = 0;
+  return true;
+}
+}  // namespace
+
+namespace Gvret {
+void begin(uint16_t txTag) {
+  if (g_running) {
+    return;
+  }
+  g_txTag = txTag;
+  g_server.begin();
+  g_server.setNoDelay(true);
+  g_running = true;
+  g_rateStartMs = millis();
+}
+
+void end() {
+  if (!g_running) {
+    return;
+  }
+  if (g_client) {
+    g_client.stop();
+  }
+  g_server.end();
+  resetClientState();
+  g_running = false;
+  g_stats.framesPerSec = 0;
+}
+
+bool connected() { return g_running && g_client && g_client.connected(); }
+
+void capture(const can_frame& f, uint8_t bus, uint32_t rxUs) {
+  if (!g_streaming) {
+    return;
+  }
+  if (static_cast<uint16_t>(g_head - g_tail) >= RING_LEN) {
+    g_tail++;   // drop the oldest
+    g_stats.dropped++;
+  }
+  Rec& r = g_ring[g_head & (RING_LEN - 1)];
+  r.us = rxUs;
+  r.id = f.can_id & CAN_EFF_MASK;
+  if (f.can_id & CAN_EFF_FLAG) {
+    r.id |= 1UL << 31;
+  }
+  r.bus = bus;
+  r.dlc = f.can_dlc > 8 ? 8 : f.can_dlc;
+  memcpy(r.data, f.data, r.dlc);
+  g_head++;
+  g_stats.captured++;
+}
+
+void service(unsigned long nowMs) {
+  if (!g_running) {
+    return;
+  }
+  if (nowMs - g_rateStartMs >= 1000) {
+    g_stats.framesPerSec = g_rateCount;
+    g_rateCount = 0;
+    g_rateStartMs = nowMs;
+  }
+  accept();
+  if (!g_client || !g_client.connected()) {
+    if (g_streaming) {
+      resetClientState();
+    }
+    return;
+  }
+  for (int n = g_client.available(); n > 0; n--) {
+    const int c = g_client.read();
+    if (c < 0) {
+      break;
+    }
+    parse(static_cast<uint8_t>(c), nowMs);
+  }
+  for (uint8_t b = 0; b < MAX_BATCHES; b++) {
+    if (g_batchSent && !flush()) {
+      return;   // previous batch still going out
+    }
+    while (g_head != g_tail && reserve(MAX_RECORD, nowMs)) {
+      encode(g_ring[g_tail & (RING_LEN - 1)]);
+      g_tail++;
+      g_stats.sent++;
+      g_rateCount++;
+    }
+    const bool full = g_batchLen + MAX_RECORD > BATCH_BYTES;
+    if (!g_batchLen || (!full && nowMs - g_batchStartMs < FLUSH_MS)) {
+      return;
+    }
+    if (!flush()) {
+      return;
+    }
+  }
+}
+
+const Stats& stats() { return g_stats; }
+}  // namespace Gvret
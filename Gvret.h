@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+
+// CAN-over-TCP bridge speaking GVRET (SavvyCAN "Network" connection, ESP32RET compatible) on
+// the config AP. The CAN drain only copies each frame into a fixed ring (capture()); service()
+// runs once per loop() and turns the ring into batches of up to BATCH_BYTES, sent with a
+// non-blocking socket write so a slow client never stalls the dash. When the client falls
+// behind, the ring drops its oldest frames. Frames from the client go out through CanTx at low
+// priority, behind the dash's own traffic. One client at a time; bus bitrates are fixed by
+// Config.h and setup commands from the client are acknowledged but ignored.
+namespace Gvret {
+  constexpr uint16_t PORT        = 23;
+  constexpr uint16_t RING_LEN    = 256;    // frames, power of two
+  constexpr uint16_t BATCH_BYTES = 1436;   // one TCP segment on the AP
+  constexpr uint32_t FLUSH_MS    = 20;     // a partial batch waits at most this long
+  constexpr uint8_t  MAX_BATCHES = 2;      // per service() pass
+
+  struct Stats {
+    uint32_t captured;
+    uint32_t sent;
+    uint32_t dropped;      // overwritten in the ring before they could be sent
+    uint32_t batches;
+    uint32_t stalls;       // socket buffer full, batch held for the next pass
+    uint32_t txQueued;     // client frames handed to CanTx
+    uint32_t txRejected;   // CanTx full, or a bus CanTx does not drive
+    uint32_t clients;
+    uint16_t framesPerSec; // sent over the link in the last second
+  };
+
+  // txTag is passed to CanTx::send with every client frame
+  void begin(uint16_t txTag);
+  void end();
+  bool connected();
+  // CAN drain: one ring slot copy, nothing when no client is streaming
+  void capture(const can_frame& f, uint8_t bus, uint32_t rxUs);
+  void service(unsigned long nowMs);
+  const Stats& stats();
+}
@@ -0,0 +1,98 @@
+#include "HeapMon.h"
+#include <stdlib.h>
+#include "Trace.h"
+
+namespace {
+using namespace HeapMon;
+
+Stats g_stats = {};
+unsigned long g_lastSampleMs = 0;
+bool g_exempt = false;
+bool g_started = false;
+
+#if DEBUG_HEAP
+TaskHandle_t g_loopTask = nullptr;
+volatile uint32_t g_passAllocs = 0;
+#endif
+
+void sample() {
+  g_stats.freeBytes = ESP.getFreeHeap();
+  g_stats.minFreeBytes = ESP.getMinFreeHeap();
+  g_stats.largestBlock = ESP.getMaxAllocHeap();
+  if (!g_stats.minLargestBlock || g_stats.largestBlock < g_stats.minLargestBlock) {
+    g_stats.minLargestBlock = g_stats.largestBlock;
+    const uint32_t kb = g_stats.freeBytes / 1024;
+    Trace::log(Trace::TR_HEAP_LOW, kb > 0xFFFF ? 0xFFFF : kb, g_stats.largestBlock);
+  }
+}
+}  // namespace
+
+#if DEBUG_HEAP
+static inline void IRAM_ATTR countAlloc() {
+  if (g_loopTask && xTaskGetCurrentTaskHandle() == g_loopTask) {
+    g_passAllocs++;
+#if HEAP_ABORT_ON_ALLOC
+    if (g_started && !g_exempt) {
+      abort();
+    }
+#endif
+  }
+}
+
+#if defined(CONFIG_HEAP_USE_HOOKS)
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void*, size_t, uint32_t) { countAlloc(); }
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void*) {}
+#else
+// Without the IDF heap hooks only C++ allocations are seen (std::string, std::vector, new);
+// Arduino String goes through malloc directly.
+void* operator new(size_t n) {
+  countAlloc();
+  void* p = malloc(n);
+  if (!p) {
+    abort();
+  }
+  return p;
+}
+
+void* operator new[](size_t n) { return operator new(n); }
+#endif
+#endif
+
+namespace HeapMon {
+void begin() {
+#if DEBUG_HEAP
+  g_loopTask = xTaskGetCurrentTaskHandle();
+#endif
+  g_lastSampleMs = millis();
+  sample();
+}
+
+void tick(unsigned long nowMs) {
+#if DEBUG_HEAP
+  const uint32_t n = g_passAllocs;
+  g_passAllocs = 0;
+  if (g_started) {
+    if (g_exempt) {
+      g_stats.exemptPasses++;
+    } else {
+      g_stats.passes++;
+      if (n) {
+        g_stats.allocPasses++;
+        g_stats.allocs += n;
+        Trace::log(Trace::TR_HEAP_ALLOC, n > 0xFFFF ? 0xFFFF : n, g_stats.allocPasses);
+      }
+    }
+  }
+#endif
+  g_started = true;
+  g_exempt = false;
+  if (nowMs - g_lastSampleMs >= SAMPLE_MS) {
+    g_lastSampleMs = nowMs;
+    sample();
+  }
+}
+
+void exemptPass() { g_exempt = true; }
+
+const Stats& stats() { return g_stats; }
+}  // namespace HeapMon
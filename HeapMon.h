@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+
+// 1 counts allocations made on the loop task and traces every loop pass that made one
+#ifndef DEBUG_HEAP
+  #define DEBUG_HEAP 0
+#endif
+
+// With DEBUG_HEAP, 1 aborts at the first allocation in a pass that is not exempt, so the panic
+// backtrace names the caller. For bench and soak runs, never for the car.
+#ifndef HEAP_ABORT_ON_ALLOC
+  #define HEAP_ABORT_ON_ALLOC 0
+#endif
+
+// Heap watch.
+// After setup() the loop is meant to allocate nothing: buffers are fixed and the config page
+// streams through HtmlOut. Once a second tick() samples free heap, its low-water mark and the
+// largest free block; fragmentation shows as that block shrinking while free heap holds, and each
+// new low is traced. With DEBUG_HEAP, operator new (and malloc, when the core is built with
+// CONFIG_HEAP_USE_HOOKS) is counted on the loop task, and a pass that allocated is traced as
+// TR_HEAP_ALLOC. Deliberate reconfiguration (WiFi page, web requests, parking) marks its pass
+// with exemptPass(), before it allocates.
+namespace HeapMon {
+  constexpr uint32_t SAMPLE_MS = 1000;
+
+  struct Stats {
+    uint32_t freeBytes;
+    uint32_t minFreeBytes;       // low-water mark since boot
+    uint32_t largestBlock;
+    uint32_t minLargestBlock;
+    uint32_t passes;             // loop passes checked (DEBUG_HEAP)
+    uint32_t allocPasses;        // ... that allocated
+    uint32_t allocs;             // allocations in those passes
+    uint32_t exemptPasses;
+  };
+
+  // From setup(), on the loop task
+  void begin();
+  // First thing in loop(): closes the pass that just ended
+  void tick(unsigned long nowMs);
+  void exemptPass();
+  const Stats& stats();
+}
@@ -0,0 +1,107 @@
+#include "HtmlOut.h"
+#include <string.h>
+
+HtmlOut::HtmlOut(WebServer& s, int code, const char* contentType) : server(s) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, contentType, "");
+}
+
+void HtmlOut::put(const char* s, size_t n) {
+  while (n) {
+    size_t take = CHUNK - len;
+    if (take > n) {
+      take = n;
+    }
+    memcpy(buf + len, s, take);
+    len += take;
+    s += take;
+    n -= take;
+    if (len == CHUNK) {
+      flush();
+    }
+  }
+}
+
+void HtmlOut::flush() {
+  if (!len) {
+    return;
+  }
+  server.sendContent(buf, len);
+  total += len;
+  len = 0;
+}
+
+HtmlOut& HtmlOut::operator+=(const char* s) {
+  if (s) {
+    put(s, strlen(s));
+  }
+  return *this;
+}
+
+HtmlOut& HtmlOut::operator+=(const __FlashStringHelper* s) { return *this += reinterpret_cast<const char*>(s); }
+
+HtmlOut& HtmlOut::operator+=(char c) {
+  put(&c, 1);
+  return *this;
+}
+
+HtmlOut& HtmlOut::operator+=(unsigned char v) { return *this += static_cast<unsigned int>(v); }
+
+HtmlOut& HtmlOut::operator+=(int v) { return *this += static_cast<long>(v); }
+
+HtmlOut& HtmlOut::operator+=(unsigned int v) { return *this += static_cast<unsigned long>(v); }
+
+HtmlOut& HtmlOut::operator+=(long v) {
+  char b[24];
+  put(b, snprintf(b, sizeof(b), "%ld", v));
+  return *this;
+}
+
+HtmlOut& HtmlOut::operator+=(unsigned long v) {
+  char b[24];
+  put(b, snprintf(b, sizeof(b), "%lu", v));
+  return *this;
+}
+
+HtmlOut& HtmlOut::operator+=(float v) {
+  number(v, 2);
+  return *this;
+}
+
+HtmlOut& HtmlOut::operator+=(double v) {
+  number(static_cast<float>(v), 2);
+  return *this;
+}
+
+void HtmlOut::escaped(const char* s) {
+  if (!s) {
+    return;
+  }
+  const char* run = s;
+  for (; *s; s++) {
+    const char* rep;
+    switch (*s) {
+      case '&': rep = "&amp;"; break;
+      case '<': rep = "&lt;"; break;
+      case '>': rep = "&gt;"; break;
+      case '"': rep = "&quot;"; break;
+      case '\'': rep = "&#39;"; break;
+      default: continue;
+    }
+    put(run, s - run);
+    *this += rep;
+    run = s + 1;
+  }
+  put(run, s - run);
+}
+
+void HtmlOut::number(float v, uint8_t decimals) {
+  char b[24];
+  const int n = snprintf(b, sizeof(b), "%.*f", decimals, static_cast<double>(v));
+  put(b, n < 0 ? 0 : (n < static_cast<int>(sizeof(b)) ? n : sizeof(b) - 1));
+}
+
+void HtmlOut::end() {
+  flush();
+  server.sendContent("", 0);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Chunked HTML response for the config page.
+// Appends go into a fixed buffer that is sent as one HTTP chunk each time it fills, so a page of
+// any size costs CHUNK bytes of stack instead of one large heap String. The += overloads format
+// the way Arduino String does (integers in decimal, floats to two places), so page code that used
+// to build a String reads the same.
+class HtmlOut {
+public:
+  static constexpr size_t CHUNK = 1024;
+
+  // Sends the status line and headers; the body follows as chunks
+  HtmlOut(WebServer& server, int code, const char* contentType);
+  HtmlOut(const HtmlOut&) = delete;
+  HtmlOut& operator=(const HtmlOut&) = delete;
+
+  HtmlOut& operator+=(const char* s);
+  HtmlOut& operator+=(const __FlashStringHelper* s);
+  HtmlOut& operator+=(char c);
+  HtmlOut& operator+=(unsigned char v);
+  HtmlOut& operator+=(int v);
+  HtmlOut& operator+=(unsigned int v);
+  HtmlOut& operator+=(long v);
+  HtmlOut& operator+=(unsigned long v);
+  HtmlOut& operator+=(float v);
+  HtmlOut& operator+=(double v);
+
+  // Text with & < > " ' escaped, for values inside attributes and cells
+  void escaped(const char* s);
+  void number(float v, uint8_t decimals);
+  // Sends what is buffered and the closing empty chunk
+  void end();
+  size_t sent() const { return total; }
+
+private:
+  void put(const char* s, size_t n);
+  void flush();
+
+  WebServer& server;
+  char buf[CHUNK];
+  size_t len = 0;
+  size_t total = 0;
+};
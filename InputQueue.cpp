@@ -0,0 +1,46 @@
+#include "InputQueue.h"
+
+namespace {
+InputQueue::Event g_ring[InputQueue::CAPACITY];
+uint8_t g_head = 0;   // next write
+uint8_t g_tail = 0;   // next read
+InputQueue::Stats g_stats = {};
+
+static_assert((InputQueue::CAPACITY & (InputQueue::CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+// Free-running indices; the difference is the depth
+inline uint8_t used() { return static_cast<uint8_t>(g_head - g_tail); }
+}  // namespace
+
+namespace InputQueue {
+bool post(const Event& e) {
+  if (used() >= CAPACITY) {
+    g_stats.overflows++;
+    return false;
+  }
+  g_ring[g_head & (CAPACITY - 1)] = e;
+  g_head++;
+  g_stats.posted++;
+  if (used() > g_stats.maxDepth) {
+    g_stats.maxDepth = used();
+  }
+  return true;
+}
+
+bool pop(Event& out, unsigned long nowMs) {
+  if (used() == 0) {
+    return false;
+  }
+  out = g_ring[g_tail & (CAPACITY - 1)];
+  g_tail++;
+  const uint32_t lat = nowMs - out.tMs;
+  if (lat > g_stats.maxLatencyMs) {
+    g_stats.maxLatencyMs = lat;
+  }
+  return true;
+}
+
+uint8_t depth() { return used(); }
+
+const Stats& stats() { return g_stats; }
+}  // namespace InputQueue
@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+#include "DashTypes.h"
+
+// Fixed-size input/UI event queue between the CAN drain and the UI stage.
+// The drain only decodes and posts; loop() pops after the drain and does all handling and
+// drawing there. Events carry the receive time of the frame that produced them, so gesture
+// timing (holds, double taps, repeat) is independent of how late the UI gets to them.
+// Both ends run in loop(): no locking.
+namespace InputQueue {
+  constexpr uint8_t CAPACITY = 32;   // power of two
+
+  enum Kind : uint8_t { EV_PRESS, EV_RELEASE };
+
+  struct Event {
+    uint32_t tMs;    // millis() when the source frame was drained
+    Kind kind;
+    Btn btn;
+  };
+
+  struct Stats {
+    uint32_t posted;
+    uint32_t overflows;     // posts refused because the queue was full
+    uint8_t maxDepth;
+    uint32_t maxLatencyMs;  // worst post -> pop delay
+  };
+
+  // False when full; the caller keeps its edge pending and retries on the next frame
+  bool post(const Event& e);
+  bool pop(Event& out, unsigned long nowMs);
+  uint8_t depth();
+  const Stats& stats();
+}
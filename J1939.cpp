@@ -0,0 +1,476 @@
+#include "J1939.h"
+#include "CanDecode.h"
+
+namespace {
+using namespace J1939;
+
+// TP.CM control bytes
+constexpr uint8_t CM_RTS   = 16;
+constexpr uint8_t CM_CTS   = 17;
+constexpr uint8_t CM_EOMA  = 19;
+constexpr uint8_t CM_BAM   = 32;
+constexpr uint8_t CM_ABORT = 255;
+
+constexpr uint8_t INDEX_SIZE = 32;   // power of two, at least twice the handler count
+
+static_assert((INDEX_SIZE & (INDEX_SIZE - 1)) == 0, "INDEX_SIZE must be a power of two");
+static_assert((MAX_MESSAGE + 6) / 7 <= 64, "packet mask is 64 bits");
+
+struct Session {
+  uint8_t buf[MAX_MESSAGE];
+  uint64_t got;          // bit n = packet n+1 received
+  uint32_t pgn;
+  unsigned long lastMs;
+  uint16_t size;
+  uint8_t packets;
+  uint8_t received;
+  uint8_t sa;
+  uint8_t da;
+  bool bam;
+  bool used;
+};
+
+struct Source {
+  unsigned long lastMs;
+  uint8_t sa;
+  bool used;
+};
+
+// An announcement that was seen but not followed (unknown PGN, too long, no free slot), so its
+// data packets are expected rather than orphaned
+struct Skipped {
+  unsigned long lastMs;
+  uint8_t sa;
+  uint8_t da;
+  bool bam;
+  bool used;
+};
+
+typedef void (*Handler)(const uint8_t* d, uint16_t len, uint8_t sa, unsigned long nowMs);
+
+Session g_sessions[MAX_SESSIONS];
+Skipped g_skipped[MAX_SESSIONS];
+uint8_t g_skipNext = 0;
+Source g_sources[MAX_SOURCES];
+Dtc g_dtcs[MAX_DTCS];
+uint8_t g_dtcUsed = 0;
+uint16_t g_dtcGen = 0;
+int8_t g_index[INDEX_SIZE];
+Stats g_stats = {};
+
+inline uint16_t le16(const uint8_t* d) { return static_cast<uint16_t>(d[0]) | static_cast<uint16_t>(d[1]) << 8; }
+inline uint32_t le24(const uint8_t* d) { return le16(d) | static_cast<uint32_t>(d[2]) << 16; }
+
+// J1939 reserves the top of each range: 0xFB..0xFF / 0xFB00..0xFFFF mean error or not available
+inline bool valid8(uint8_t v) { return v < 0xFB; }
+inline bool valid16(uint16_t v) { return v < 0xFB00; }
+
+// ---- SPN decoders (J1939-71 scaling) ----
+void d_eec1(const uint8_t* d, uint16_t len, uint8_t, unsigned long) {
+  if (len >= 5 && valid16(le16(&d[3]))) {
+    rpm = le16(&d[3]) * 0.125f;
+  }
+}
+
+void d_at1s(const uint8_t* d, uint16_t len, uint8_t, unsigned long) {
+  if (len >= 1 && valid8(d[0])) {
+    soot_pct = d[0];
+  }
+}
+
+void d_et1(const uint8_t* d, uint16_t len, uint8_t, unsigned long) {
+  if (len >= 1 && valid8(d[0])) {
+    coolantC = d[0] - 40.0f;
+  }
+}
+
+void d_eflp1(const uint8_t* d, uint16_t len, uint8_t, unsigned long) {
+  if (len >= 4 && valid8(d[3])) {
+    oil_kPa = d[3] * 4.0f;
+  }
+}
+
+void d_ccvs(const uint8_t* d, uint16_t len, uint8_t, unsigned long) {
+  if (len >= 3 && valid16(le16(&d[1]))) {
+    speed_kmh = le16(&d[1]) / 256.0f;
+  }
+}
+
+void d_ic1(const uint8_t* d, uint16_t len, uint8_t, unsigned long) {
+  if (len >= 2 && valid8(d[1])) {
+    boost_kPa = d[1] * 2.0f;   // SPN 102 is gauge pressure, as boost_kPa is
+  }
+  if (len >= 3 && valid8(d[2])) {
+    manifoldC = d[2] - 40.0f;
+  }
+}
+
+void d_trf1(const uint8_t* d, uint16_t len, uint8_t, unsigned long) {
+  if (len >= 6 && valid16(le16(&d[4]))) {
+    trans1C = le16(&d[4]) * 0.03125f - 273.0f;
+  }
+}
+
+Source* sourceFor(uint8_t sa, unsigned long nowMs) {
+  Source* stale = nullptr;
+  for (Source& s : g_sources) {
+    if (s.used && s.sa == sa) {
+      return &s;
+    }
+    if (!stale && (!s.used || nowMs - s.lastMs >= DM1_STALE_MS)) {
+      stale = &s;
+    }
+  }
+  return stale;
+}
+
+bool fresh(uint8_t sa, unsigned long nowMs) {
+  for (const Source& s : g_sources) {
+    if (s.used && s.sa == sa) {
+      return nowMs - s.lastMs < DM1_STALE_MS;
+    }
+  }
+  return false;
+}
+
+void dropDtcs(uint8_t sa) {
+  uint8_t w = 0;
+  for (uint8_t r = 0; r < g_dtcUsed; r++) {
+    if (g_dtcs[r].sa != sa) {
+      g_dtcs[w++] = g_dtcs[r];
+    }
+  }
+  g_dtcUsed = w;
+}
+
+// Two lamp bytes, then 4 bytes per DTC (SPN conversion method 4). A single all-zero DTC means none.
+void d_dm1(const uint8_t* d, uint16_t len, uint8_t sa, unsigned long nowMs) {
+  Source* src = sourceFor(sa, nowMs);
+  if (!src) {
+    return;
+  }
+  if (!src->used || src->sa != sa) {
+    if (src->used) {
+      dropDtcs(src->sa);   // reusing a stale ECU's slot
+    }
+    *src = {nowMs, sa, true};
+  }
+  src->lastMs = nowMs;
+  Dtc next[MAX_DTCS];
+  uint8_t n = 0;
+  for (uint16_t i = 2; i + 4 <= len && n < MAX_DTCS; i += 4) {
+    const uint32_t spn = d[i] | static_cast<uint32_t>(d[i + 1]) << 8 | static_cast<uint32_t>(d[i + 2] & 0xE0) << 11;
+    const uint8_t fmi = d[i + 2] & 0x1F;
+    if (spn == 0 && fmi == 0) {
+      continue;
+    }
+    if (spn == 0x7FFFF) {   // padding in a single-frame DM1
+      continue;
+    }
+    next[n++] = {spn, fmi, static_cast<uint8_t>(d[i + 3] & 0x7F), sa};
+  }
+  // Only bump the generation on a real change: DM1 repeats every second
+  uint8_t k = 0;
+  bool same = true;
+  for (uint8_t r = 0; r < g_dtcUsed && same; r++) {
+    if (g_dtcs[r].sa != sa) {
+      continue;
+    }
+    const Dtc& o = g_dtcs[r];
+    same = k < n && o.spn == next[k].spn && o.fmi == next[k].fmi && o.oc == next[k].oc;
+    k++;
+  }
+  if (same && k == n) {
+    return;
+  }
+  dropDtcs(sa);
+  for (uint8_t i = 0; i < n && g_dtcUsed < MAX_DTCS; i++) {
+    g_dtcs[g_dtcUsed++] = next[i];
+  }
+  g_dtcGen++;
+}
+
+struct PgnHandler {
+  uint32_t pgn;
+  Handler fn;
+};
+
+const PgnHandler kHandlers[] = {
+  {PGN_EEC1, d_eec1}, {PGN_AT1S, d_at1s}, {PGN_DM1, d_dm1},  {PGN_ET1, d_et1},
+  {PGN_EFLP1, d_eflp1}, {PGN_CCVS, d_ccvs}, {PGN_IC1, d_ic1}, {PGN_TRF1, d_trf1},
+};
+constexpr uint8_t HANDLER_COUNT = sizeof(kHandlers) / sizeof(kHandlers[0]);
+static_assert(HANDLER_COUNT * 2 <= INDEX_SIZE, "PGN index too full for short probes");
+
+inline uint8_t hashPgn(uint32_t pgn) { return static_cast<uint8_t>((pgn * 2654435761u) >> 27) & (INDEX_SIZE - 1); }
+
+Handler lookup(uint32_t pgn) {
+  const uint8_t h = hashPgn(pgn);
+  for (uint8_t p = 0; p <= g_stats.maxProbe; p++) {
+    const int8_t k = g_index[(h + p) & (INDEX_SIZE - 1)];
+    if (k < 0) {
+      return nullptr;
+    }
+    if (kHandlers[k].pgn == pgn) {
+      return kHandlers[k].fn;
+    }
+  }
+  return nullptr;
+}
+
+void dispatch(uint32_t pgn, const uint8_t* d, uint16_t len, uint8_t sa, unsigned long nowMs) {
+  if (Handler fn = lookup(pgn)) {
+    fn(d, len, sa, nowMs);
+    g_stats.decoded++;
+  }
+}
+
+// ---- transport protocol ----
+Session* findSession(uint8_t sa, uint8_t da) {
+  for (Session& s : g_sessions) {
+    if (s.used && s.sa == sa && s.da == da) {
+      return &s;
+    }
+  }
+  return nullptr;
+}
+
+void expireSessions(unsigned long nowMs) {
+  for (Session& s : g_sessions) {
+    if (s.used && nowMs - s.lastMs >= (s.bam ? TP_BAM_MS : TP_RTS_MS)) {
+      s.used = false;
+      g_stats.tpTimeouts++;
+    }
+  }
+}
+
+Skipped* findSkipped(uint8_t sa, uint8_t da, unsigned long nowMs) {
+  for (Skipped& k : g_skipped) {
+    if (k.used && k.sa == sa && k.da == da) {
+      if (nowMs - k.lastMs < (k.bam ? TP_BAM_MS : TP_RTS_MS)) {
+        return &k;
+      }
+      k.used = false;
+    }
+  }
+  return nullptr;
+}
+
+void skipSession(uint8_t sa, uint8_t da, bool bam, unsigned long nowMs) {
+  Skipped* k = findSkipped(sa, da, nowMs);
+  if (!k) {
+    k = &g_skipped[g_skipNext];
+    g_skipNext = (g_skipNext + 1) % MAX_SESSIONS;
+  }
+  *k = {nowMs, sa, da, bam, true};
+}
+
+void openSession(const uint8_t* d, uint8_t sa, uint8_t da, bool bam, unsigned long nowMs) {
+  Session* s = findSession(sa, da);
+  if (s) {
+    // A sender runs one transfer per destination; a new announcement ends the old one
+    s->used = false;
+    g_stats.tpAborted++;
+  }
+  if (Skipped* k = findSkipped(sa, da, nowMs)) {
+    k->used = false;
+  }
+  const uint16_t size = le16(&d[1]);
+  const uint8_t packets = d[3];
+  if (size < 9 || packets == 0 || packets != (size + 6) / 7) {
+    skipSession(sa, da, bam, nowMs);
+    return;
+  }
+  if (size > MAX_MESSAGE) {
+    g_stats.tpTooLong++;
+    skipSession(sa, da, bam, nowMs);
+    return;
+  }
+  const uint32_t pgn = le24(&d[5]);
+  if (!lookup(pgn)) {
+    skipSession(sa, da, bam, nowMs);
+    return;   // nothing would read it; leave the slot free
+  }
+  for (Session& free : g_sessions) {
+    if (!free.used) {
+      free.used = true;
+      free.bam = bam;
+      free.sa = sa;
+      free.da = da;
+      free.pgn = pgn;
+      free.size = size;
+      free.packets = packets;
+      free.received = 0;
+      free.got = 0;
+      free.lastMs = nowMs;
+      g_stats.tpStarted++;
+      return;
+    }
+  }
+  g_stats.tpNoSession++;
+  skipSession(sa, da, bam, nowMs);
+}
+
+void onConnection(const uint8_t* d, uint8_t len, uint8_t sa, uint8_t da, unsigned long nowMs) {
+  if (len < 8) {
+    return;
+  }
+  switch (d[0]) {
+    case CM_BAM:
+      if (da == ADDR_GLOBAL) {
+        openSession(d, sa, da, true, nowMs);
+      }
+      break;
+    case CM_RTS:
+      if (da != ADDR_GLOBAL) {
+        openSession(d, sa, da, false, nowMs);
+      }
+      break;
+    case CM_CTS:
+      // From the receiver: the sender's clock restarts
+      if (Session* s = findSession(da, sa)) {
+        s->lastMs = nowMs;
+      }
+      break;
+    case CM_EOMA:
+      if (Session* s = findSession(da, sa)) {
+        s->used = false;
+      }
+      break;
+    case CM_ABORT:
+      // Either side may abort
+      for (Session& s : g_sessions) {
+        if (s.used && ((s.sa == sa && s.da == da) || (s.sa == da && s.da == sa))) {
+          s.used = false;
+          g_stats.tpAborted++;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void onData(const uint8_t* d, uint8_t len, uint8_t sa, uint8_t da, unsigned long nowMs) {
+  Session* s = findSession(sa, da);
+  if (!s) {
+    if (Skipped* k = findSkipped(sa, da, nowMs)) {
+      k->lastMs = nowMs;
+    } else {
+      g_stats.tpOrphan++;
+    }
+    return;
+  }
+  if (len < 2) {
+    return;
+  }
+  const uint8_t seq = d[0];
+  if (seq == 0 || seq > s->packets) {
+    g_stats.tpBadSeq++;
+    return;
+  }
+  s->lastMs = nowMs;
+  const uint64_t bit = 1ULL << (seq - 1);
+  if (s->got & bit) {
+    return;   // retransmission after a CTS
+  }
+  s->got |= bit;
+  s->received++;
+  const uint16_t at = (seq - 1) * 7;
+  const uint16_t n = s->size - at < 7 ? s->size - at : 7;
+  memcpy(&s->buf[at], &d[1], n < len - 1 ? n : len - 1);
+  if (s->received < s->packets) {
+    return;
+  }
+  s->used = false;
+  g_stats.tpDone++;
+  dispatch(s->pgn, s->buf, s->size, s->sa, nowMs);
+}
+}  // namespace
+
+namespace J1939 {
+Id parse(uint32_t canId) {
+  const uint32_t id = canId & CAN_EFF_MASK;
+  const uint8_t pf = (id >> 16) & 0xFF;
+  const uint8_t ps = (id >> 8) & 0xFF;
+  Id r;
+  r.prio = (id >> 26) & 0x07;
+  r.sa = id & 0xFF;
+  r.pgn = (id >> 8) & 0x3FF00;   // EDP, DP, PF
+  if (pf < 240) {
+    r.da = ps;                    // PDU1: PS is the destination
+  } else {
+    r.pgn |= ps;                  // PDU2: PS is the group extension
+    r.da = ADDR_GLOBAL;
+  }
+  return r;
+}
+
+uint32_t makeId(uint8_t prio, uint32_t pgn, uint8_t sa, uint8_t da) {
+  uint32_t id = static_cast<uint32_t>(prio & 0x07) << 26 | (pgn & 0x3FFFF) << 8 | sa;
+  if (((pgn >> 8) & 0xFF) < 240) {
+    id = (id & ~0xFF00u) | static_cast<uint32_t>(da) << 8;
+  }
+  return id | CAN_EFF_FLAG;
+}
+
+void begin() {
+  memset(g_index, -1, sizeof(g_index));
+  g_stats.maxProbe = 0;
+  for (uint8_t k = 0; k < HANDLER_COUNT; k++) {
+    const uint8_t h = hashPgn(kHandlers[k].pgn);
+    uint8_t p = 0;
+    while (g_index[(h + p) & (INDEX_SIZE - 1)] >= 0) {
+      p++;
+    }
+    g_index[(h + p) & (INDEX_SIZE - 1)] = static_cast<int8_t>(k);
+    if (p > g_stats.maxProbe) {
+      g_stats.maxProbe = p;
+    }
+  }
+}
+
+void onFrame(const can_frame& f, unsigned long nowMs) {
+  g_stats.frames++;
+  const Id id = parse(f.can_id);
+  const uint8_t len = f.can_dlc > 8 ? 8 : f.can_dlc;
+  switch (id.pgn) {
+    case PGN_TP_CM:
+      expireSessions(nowMs);
+      onConnection(f.data, len, id.sa, id.da, nowMs);
+      break;
+    case PGN_TP_DT:
+      expireSessions(nowMs);
+      onData(f.data, len, id.sa, id.da, nowMs);
+      break;
+    default:
+      dispatch(id.pgn, f.data, len, id.sa, nowMs);
+      break;
+  }
+}
+
+uint8_t dtcCount(unsigned long nowMs) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < g_dtcUsed; i++) {
+    n += fresh(g_dtcs[i].sa, nowMs);
+  }
+  return n;
+}
+
+bool dtc(uint8_t idx, unsigned long nowMs, Dtc& out) {
+  for (uint8_t i = 0; i < g_dtcUsed; i++) {
+    if (!fresh(g_dtcs[i].sa, nowMs)) {
+      continue;
+    }
+    if (idx-- == 0) {
+      out = g_dtcs[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+uint16_t dtcGeneration() { return g_dtcGen; }
+
+const Stats& stats() { return g_stats; }
+}  // namespace J1939
@@ -0,0 +1,80 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+
+// SAE J1939 on 29-bit frames.
+// The identifier is split into priority / PGN / destination / source. Single-frame PGNs are
+// looked up in a small open-addressing index built once by begin(), so a frame costs one hash
+// and at most maxProbe compares however many PGNs are decoded; unknown PGNs fall out on the
+// first empty slot. Decoded SPNs write the same globals as the 11-bit tables (CanDecode.h).
+// Multi-packet messages (TP.CM/TP.DT) are reassembled for both BAM broadcasts and RTS/CTS
+// sessions. The dash holds no claimed address, so it never answers an RTS: RTS/CTS sessions
+// between other nodes are followed passively and complete when every packet has been seen.
+// The reassembled payload goes through the same PGN index, which is how DM1 with more than
+// one active DTC arrives.
+namespace J1939 {
+  constexpr uint8_t  ADDR_GLOBAL  = 0xFF;
+
+  constexpr uint32_t PGN_TP_CM    = 0xEC00;   // 60416 transport connection management
+  constexpr uint32_t PGN_TP_DT    = 0xEB00;   // 60160 transport data
+  constexpr uint32_t PGN_EEC1     = 0xF004;   // 61444 engine speed (SPN 190)
+  constexpr uint32_t PGN_AT1S     = 0xFD7B;   // 64891 DPF soot load (SPN 3719)
+  constexpr uint32_t PGN_DM1      = 0xFECA;   // 65226 active DTCs
+  constexpr uint32_t PGN_ET1      = 0xFEEE;   // 65262 coolant (SPN 110)
+  constexpr uint32_t PGN_EFLP1    = 0xFEEF;   // 65263 oil pressure (SPN 100)
+  constexpr uint32_t PGN_CCVS     = 0xFEF1;   // 65265 wheel-based speed (SPN 84)
+  constexpr uint32_t PGN_IC1      = 0xFEF6;   // 65270 boost (SPN 102), manifold temp (SPN 105)
+  constexpr uint32_t PGN_TRF1     = 0xFEF8;   // 65272 transmission oil temp (SPN 177)
+
+  constexpr uint8_t  MAX_SESSIONS = 4;
+  constexpr uint16_t MAX_MESSAGE  = 256;      // DM1 up to 63 DTCs; longer transfers are skipped
+  constexpr uint32_t TP_BAM_MS    = 750;      // T1: gap between BAM data packets
+  constexpr uint32_t TP_RTS_MS    = 1250;     // T2/T3: gap in a peer-to-peer session
+  constexpr uint8_t  MAX_DTCS     = 16;
+  constexpr uint8_t  MAX_SOURCES  = 4;        // ECUs whose DM1 is tracked
+  constexpr uint32_t DM1_STALE_MS = 3000;     // DM1 is sent every second while the ECU is up
+
+  struct Id {
+    uint32_t pgn;
+    uint8_t prio;
+    uint8_t sa;
+    uint8_t da;          // ADDR_GLOBAL for PDU2 PGNs
+  };
+
+  struct Dtc {
+    uint32_t spn;
+    uint8_t fmi;
+    uint8_t oc;          // occurrence count
+    uint8_t sa;
+  };
+
+  struct Stats {
+    uint32_t frames;
+    uint32_t decoded;      // frames or messages that hit the PGN index
+    uint32_t tpStarted;
+    uint32_t tpDone;
+    uint32_t tpAborted;    // connection abort seen, or a BAM/RTS restarted mid-transfer
+    uint32_t tpTimeouts;
+    uint32_t tpNoSession;  // all session slots busy
+    uint32_t tpOrphan;     // TP.DT with no announcement seen (not one that was skipped)
+    uint32_t tpTooLong;    // announced size above MAX_MESSAGE
+    uint32_t tpBadSeq;
+    uint8_t maxProbe;      // longest probe in the PGN index (set by begin())
+  };
+
+  inline bool isExtended(const can_frame& f) { return (f.can_id & CAN_EFF_FLAG) != 0; }
+  Id parse(uint32_t canId);
+  // The 29-bit identifier with CAN_EFF_FLAG set, ready for a can_frame or a filter
+  uint32_t makeId(uint8_t prio, uint32_t pgn, uint8_t sa, uint8_t da = ADDR_GLOBAL);
+
+  void begin();
+  // Extended frames only
+  void onFrame(const can_frame& f, unsigned long nowMs);
+
+  // Active DTCs from every ECU whose DM1 is still current
+  uint8_t dtcCount(unsigned long nowMs);
+  bool dtc(uint8_t idx, unsigned long nowMs, Dtc& out);
+  // Changes whenever a DM1 changes the list, so pages can redraw on change only
+  uint16_t dtcGeneration();
+  const Stats& stats();
+}
@@ -0,0 +1,135 @@
+#include "Layout.h"
+
+namespace {
+using Layout::Cell;
+using Layout::WK_BAR;
+using Layout::WK_DIAL;
+using Layout::WK_PILL;
+
+// Content area is x 12..308, y 44..232 (below the 34 px app bar). Bars keep 20 px above them
+// for tick labels. Pill gaps are 8-10 px like the original 2x2 grid.
+constexpr Cell kBarQuad[] = {
+  {14, 64, 292, 32, WK_BAR},
+  {12, 112, 144, 55, WK_PILL}, {164, 112, 144, 55, WK_PILL},
+  {12, 177, 144, 55, WK_PILL}, {164, 177, 144, 55, WK_PILL},
+};
+constexpr Cell kBig[] = {
+  {12, 44, 296, 188, WK_PILL},
+};
+constexpr Cell kOneTwo[] = {
+  {12, 44, 296, 110, WK_PILL},
+  {12, 164, 144, 68, WK_PILL}, {164, 164, 144, 68, WK_PILL},
+};
+constexpr Cell kGrid3x2[] = {
+  {12, 44, 92, 89, WK_PILL}, {114, 44, 92, 89, WK_PILL}, {216, 44, 92, 89, WK_PILL},
+  {12, 143, 92, 89, WK_PILL}, {114, 143, 92, 89, WK_PILL}, {216, 143, 92, 89, WK_PILL},
+};
+constexpr Cell kGrid3x3[] = {
+  {12, 44, 92, 57, WK_PILL}, {114, 44, 92, 57, WK_PILL}, {216, 44, 92, 57, WK_PILL},
+  {12, 109, 92, 57, WK_PILL}, {114, 109, 92, 57, WK_PILL}, {216, 109, 92, 57, WK_PILL},
+  {12, 174, 92, 58, WK_PILL}, {114, 174, 92, 58, WK_PILL}, {216, 174, 92, 58, WK_PILL},
+};
+constexpr Cell kTwoBars[] = {
+  {14, 64, 292, 56, WK_BAR},
+  {14, 160, 292, 56, WK_BAR},
+};
+constexpr Cell kBarSix[] = {
+  {14, 64, 292, 32, WK_BAR},
+  {12, 108, 92, 58, WK_PILL}, {114, 108, 92, 58, WK_PILL}, {216, 108, 92, 58, WK_PILL},
+  {12, 174, 92, 58, WK_PILL}, {114, 174, 92, 58, WK_PILL}, {216, 174, 92, 58, WK_PILL},
+};
+
+constexpr Cell kTwoDials[] = {
+  {12, 44, 144, 128, WK_DIAL}, {164, 44, 144, 128, WK_DIAL},
+  {12, 180, 144, 52, WK_PILL}, {164, 180, 144, 52, WK_PILL},
+};
+constexpr Cell kDialThree[] = {
+  {12, 44, 188, 188, WK_DIAL},
+  {208, 44, 100, 57, WK_PILL}, {208, 109, 100, 57, WK_PILL}, {208, 174, 100, 58, WK_PILL},
+};
+
+#define LAYOUT_TEMPLATE(name, cells) \
+  { name, static_cast<uint8_t>(sizeof(cells) / sizeof(cells[0])), cells }
+
+// Indexed by LayoutTemplate
+constexpr Layout::Template kTemplates[] = {
+  LAYOUT_TEMPLATE("Bar + 4", kBarQuad),
+  LAYOUT_TEMPLATE("Big number", kBig),
+  LAYOUT_TEMPLATE("1 + 2", kOneTwo),
+  LAYOUT_TEMPLATE("3x2", kGrid3x2),
+  LAYOUT_TEMPLATE("3x3 compact", kGrid3x3),
+  LAYOUT_TEMPLATE("Two bars", kTwoBars),
+  LAYOUT_TEMPLATE("Bar + 6", kBarSix),
+  LAYOUT_TEMPLATE("2 dials + 2", kTwoDials),
+  LAYOUT_TEMPLATE("Dial + 3", kDialThree),
+};
+#undef LAYOUT_TEMPLATE
+
+static_assert(sizeof(kTemplates) / sizeof(kTemplates[0]) == LT__COUNT, "One template per LayoutTemplate");
+
+constexpr bool fitsSlots(size_t i) {
+  return i >= LT__COUNT || (kTemplates[i].count <= LAYOUT_MAX_WIDGETS && fitsSlots(i + 1));
+}
+static_assert(fitsSlots(0), "Template has more cells than LAYOUT_MAX_WIDGETS");
+
+inline int centreX(const Cell& c) { return c.x + c.w / 2; }
+inline int centreY(const Cell& c) { return c.y + c.h / 2; }
+}  // namespace
+
+namespace Layout {
+const Template& get(uint8_t tpl) { return kTemplates[tpl < LT__COUNT ? tpl : static_cast<uint8_t>(LT_BAR_QUAD)]; }
+
+uint8_t titleSlot(uint8_t tpl) {
+  const Template& t = get(tpl);
+  for (uint8_t i = 0; i < t.count; i++) {
+    if (t.cells[i].kind == WK_BAR) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+uint8_t neighbour(uint8_t tpl, uint8_t from, Btn dir) {
+  const Template& t = get(tpl);
+  if (from >= t.count) {
+    return 0;
+  }
+  int dx = 0, dy = 0;
+  switch (dir) {
+    case BTN_LEFT: dx = -1; break;
+    case BTN_RIGHT: dx = 1; break;
+    case BTN_UP: dy = -1; break;
+    case BTN_DOWN: dy = 1; break;
+    default: return from;
+  }
+  const int ax = centreX(t.cells[from]), ay = centreY(t.cells[from]);
+  // Pass 0 looks ahead of the cursor. Pass 1 wraps by measuring from beyond the opposite edge;
+  // the cursor's own cell competes there so a lone cell in that line stays put.
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    const int ox = pass ? ax - dx * 1000 : ax;
+    const int oy = pass ? ay - dy * 1000 : ay;
+    int best = -1;
+    long bestScore = 0;
+    for (uint8_t i = 0; i < t.count; i++) {
+      if (pass == 0 && i == from) {
+        continue;
+      }
+      const int cx = centreX(t.cells[i]), cy = centreY(t.cells[i]);
+      const int along = (cx - ox) * dx + (cy - oy) * dy;
+      if (along <= 0) {
+        continue;
+      }
+      const int across = abs(dx ? (cy - oy) : (cx - ox));
+      const long score = 2L * along + across;
+      if (best < 0 || score < bestScore) {
+        best = i;
+        bestScore = score;
+      }
+    }
+    if (best >= 0) {
+      return static_cast<uint8_t>(best);
+    }
+  }
+  return from;
+}
+}  // namespace Layout
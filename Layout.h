@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+#include "DashTypes.h"
+#include "Persist.h"
+
+// Screen layout templates.
+// A template is a constexpr list of cells in ScreenLayout::ch order. Cell geometry never moves,
+// so it doubles as the static layer: the renderer draws cards/bar outlines once per screen and
+// afterwards only touches widgets whose value, channel or warning state changed.
+namespace Layout {
+  enum WidgetKind : uint8_t { WK_PILL, WK_BAR, WK_DIAL };
+
+  // Bars and dials draw a range, so they only take bar-eligible channels
+  inline bool needsRange(WidgetKind k) { return k != WK_PILL; }
+
+  struct Cell {
+    int16_t x, y, w, h;   // pills/dials: card rect; bars: bar rect (tick labels sit in the 20 px above)
+    WidgetKind kind;
+  };
+
+  struct Template {
+    const char* name;
+    uint8_t count;
+    const Cell* cells;
+  };
+
+  // Out-of-range ids fall back to LT_BAR_QUAD
+  const Template& get(uint8_t tpl);
+  inline uint8_t count(uint8_t tpl) { return get(tpl).count; }
+  inline const Cell& cell(uint8_t tpl, uint8_t slot) { return get(tpl).cells[slot]; }
+  inline PillSpec rect(const Cell& c) { return {c.x, c.y, c.w, c.h}; }
+
+  // Slot whose channel titles the screen: the first bar, else slot 0
+  uint8_t titleSlot(uint8_t tpl);
+  // Nearest cell in the D-pad direction, wrapping at the screen edge (layout editor cursor)
+  uint8_t neighbour(uint8_t tpl, uint8_t from, Btn dir);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <Arduino.h>
+#include <SPI.h>
+
+// Raw MCP2515 register access for the parts the mcp2515 library keeps private: the wake-up
+// interrupt and the TX buffer control registers. Same SPI mode and clock as the library.
+namespace McpRegs {
+  constexpr uint32_t SPI_HZ = 10000000;
+
+  constexpr uint8_t INSTR_READ       = 0x03;
+  constexpr uint8_t INSTR_BIT_MODIFY = 0x05;
+
+  constexpr uint8_t CANINTE = 0x2B;
+  constexpr uint8_t CANINTF = 0x2C;
+  constexpr uint8_t WAKIF   = 0x40;   // same bit as WAKIE in CANINTE
+
+  // TXBnCTRL, n = 0..2
+  inline uint8_t txbCtrl(uint8_t n) { return static_cast<uint8_t>(0x30 + 0x10 * n); }
+  constexpr uint8_t TXB_ABTF  = 0x40;
+  constexpr uint8_t TXB_MLOA  = 0x20;
+  constexpr uint8_t TXB_TXERR = 0x10;
+  constexpr uint8_t TXB_TXREQ = 0x08;
+
+  // READ STATUS (MCP2515::getStatus) TXREQ bits, n = 0..2
+  inline uint8_t statusTxReq(uint8_t n) { return static_cast<uint8_t>(0x04 << (2 * n)); }
+
+  inline uint8_t read(uint8_t cs, uint8_t reg) {
+    SPI.beginTransaction(SPISettings(SPI_HZ, MSBFIRST, SPI_MODE0));
+    digitalWrite(cs, LOW);
+    SPI.transfer(INSTR_READ);
+    SPI.transfer(reg);
+    const uint8_t v = SPI.transfer(0x00);
+    digitalWrite(cs, HIGH);
+    SPI.endTransaction();
+    return v;
+  }
+
+  inline void bitModify(uint8_t cs, uint8_t reg, uint8_t mask, uint8_t data) {
+    SPI.beginTransaction(SPISettings(SPI_HZ, MSBFIRST, SPI_MODE0));
+    digitalWrite(cs, LOW);
+    SPI.transfer(INSTR_BIT_MODIFY);
+    SPI.transfer(reg);
+    SPI.transfer(mask);
+    SPI.transfer(data);
+    digitalWrite(cs, HIGH);
+    SPI.endTransaction();
+  }
+}
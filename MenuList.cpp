@@ -0,0 +1,116 @@
+#include "MenuList.h"
+
+namespace {
+MenuList::DrawRowFn s_draw = nullptr;
+MenuList::ClearRowFn s_clear = nullptr;
+
+// What each slot shows now: 0 = unknown, EMPTY_KEY = cleared, else a content hash
+const MenuList::List* s_shown = nullptr;
+uint32_t s_slotKey[MenuList::ROWS];
+MenuList::Stats s_stats = {};
+
+constexpr uint32_t EMPTY_KEY = 1;
+
+uint32_t fnv(uint32_t h, const char* s) {
+  if (s) {
+    while (*s) {
+      h = (h ^ static_cast<uint8_t>(*s++)) * 16777619u;
+    }
+  }
+  return (h ^ 0xFFu) * 16777619u;   // terminator keeps "ab"+"c" apart from "a"+"bc"
+}
+
+uint32_t rowKey(const MenuList::Row& r, bool sel) {
+  uint32_t h = fnv(fnv(2166136261u, r.left), r.right);
+  h = (h & ~1u) | (sel ? 1u : 0u);
+  return h <= EMPTY_KEY ? h + 2 : h;
+}
+
+void invalidate(const MenuList::List& l) {
+  s_shown = &l;
+  memset(s_slotKey, 0, sizeof(s_slotKey));
+}
+
+uint8_t paint(MenuList::List& l) {
+  if (s_shown != &l) {
+    invalidate(l);
+  }
+  const uint16_t total = l.model->count();
+  uint8_t drawn = 0;
+  for (uint8_t slot = 0; slot < MenuList::ROWS; slot++) {
+    const uint16_t idx = l.top + slot;
+    if (idx >= total) {
+      if (s_slotKey[slot] != EMPTY_KEY) {
+        s_clear(slot);
+        s_slotKey[slot] = EMPTY_KEY;
+      }
+      continue;
+    }
+    const MenuList::Row r = l.model->row(idx);
+    const bool sel = (idx == l.sel);
+    const uint32_t key = rowKey(r, sel);
+    if (key == s_slotKey[slot]) {
+      continue;
+    }
+    s_draw(slot, r.left, r.right, sel);
+    s_slotKey[slot] = key;
+    drawn++;
+  }
+  return drawn;
+}
+}  // namespace
+
+namespace MenuList {
+void begin(DrawRowFn draw, ClearRowFn clear) {
+  s_draw = draw;
+  s_clear = clear;
+}
+
+void focus(List& l, uint16_t idx) {
+  const uint16_t total = l.model->count();
+  l.sel = (total == 0) ? 0 : (idx < total ? idx : total - 1);
+  l.top = (l.sel / ROWS) * ROWS;
+}
+
+void show(List& l) {
+  focus(l, l.sel);   // the model may have shrunk since the list was last open
+  invalidate(l);
+  paint(l);
+}
+
+uint8_t step(List& l, int8_t dir) {
+  const uint16_t total = l.model->count();
+  uint8_t drawn = 0;
+  if (total > 0) {
+    if (dir < 0) {
+      l.sel = (l.sel > 0) ? l.sel - 1 : total - 1;
+    } else {
+      l.sel = (l.sel + 1 < total) ? l.sel + 1 : 0;
+    }
+    l.top = (l.sel / ROWS) * ROWS;
+    drawn = paint(l);
+  }
+  s_stats.keys++;
+  s_stats.rowsDrawn += drawn;
+  s_stats.lastKeyRows = drawn;
+  if (drawn > s_stats.maxKeyRows) {
+    s_stats.maxKeyRows = drawn;
+  }
+  return drawn;
+}
+
+uint8_t refresh(List& l) { return paint(l); }
+
+void buildMap(ChannelMap& m, bool (*eligible)(Channel)) {
+  m.count = 0;
+  for (uint8_t i = 0; i < CH__COUNT; i++) {
+    m.pos[i] = 0;
+    if (eligible(static_cast<Channel>(i))) {
+      m.pos[i] = m.count;
+      m.ch[m.count++] = i;
+    }
+  }
+}
+
+const Stats& stats() { return s_stats; }
+}  // namespace MenuList
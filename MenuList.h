@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+#include "DashTypes.h"
+
+// Windowed settings lists.
+// A list is a model (row count + row text by index) plus a selection and a window. The window
+// always shows the page holding the selection, and each visible slot remembers a hash of what
+// it last drew, so a key press repaints only the slots whose text or highlight changed:
+// two rows inside a page, one page when crossing a page boundary.
+// Drawing goes through the callbacks given to begin(); the sketch owns the menu look.
+namespace MenuList {
+  constexpr uint8_t ROWS = 7;   // visible rows (MENU_PER_PAGE)
+
+  struct Row { const char* left; const char* right; };
+
+  // Row strings only need to live until the row has been drawn
+  struct Model {
+    uint16_t (*count)();
+    Row (*row)(uint16_t idx);
+  };
+
+  struct List {
+    const Model* model;
+    uint16_t sel;
+    uint16_t top;
+  };
+
+  typedef void (*DrawRowFn)(uint8_t slot, const char* left, const char* right, bool sel);
+  typedef void (*ClearRowFn)(uint8_t slot);
+  void begin(DrawRowFn draw, ClearRowFn clear);
+
+  // Select idx (clamped) and move the window to its page. No drawing.
+  void focus(List& l, uint16_t idx);
+  // Paint every visible slot; call after the screen frame has been drawn
+  void show(List& l);
+  // UP/DOWN with wrap-around. Returns the number of rows drawn.
+  uint8_t step(List& l, int8_t dir);
+  // Repaint slots whose text changed without a key press (e.g. "current" moved)
+  uint8_t refresh(List& l);
+
+  // Cached eligible-channel index <-> channel maps, rebuilt when a list is opened
+  struct ChannelMap {
+    uint8_t count;
+    uint8_t ch[CH__COUNT];    // list index -> channel
+    uint8_t pos[CH__COUNT];   // channel -> list index (0 when not listed)
+  };
+  void buildMap(ChannelMap& m, bool (*eligible)(Channel));
+
+  struct Stats {
+    uint32_t keys;          // step() calls
+    uint32_t rowsDrawn;     // rows drawn by step()
+    uint8_t lastKeyRows;
+    uint8_t maxKeyRows;
+  };
+  const Stats& stats();
+}
@@ -1,10 +1,97 @@
 #include "Persist.h"
 
 #include <EEPROM.h>
+#include <stddef.h>
 
 namespace {
   unsigned long g_lastSaveMs = 0;
 
+  // Frozen v1 layout (33 channels, arrays sized by channel count). Do not edit.
+  constexpr uint8_t V1_CH_COUNT = 33;
+  struct PersistStateV1 {
+    uint16_t magic;
+    uint16_t version;
+    uint8_t pillChannel[SCREEN_COUNT][4];
+    uint8_t barChannel[SCREEN_COUNT];
+    uint8_t currentScreen;
+    uint8_t warnMode[V1_CH_COUNT];
+    float   warnT1[V1_CH_COUNT];
+    float   warnT2[V1_CH_COUNT];
+    uint8_t paletteIndex;
+    CustomPalette customPalettes[CUSTOM_PALETTE_COUNT];
+    uint8_t brightOn;
+    uint8_t brightOff;
+    uint8_t uPressure;
+    uint8_t uTemp;
+    uint8_t uSpeed;
+    uint8_t uLambda;
+    float   speedTrimPct;
+    uint8_t victronEnabled;
+    char    wifiSsid[WIFI_SSID_LEN + 1];
+    char    wifiPass[WIFI_PASS_LEN + 1];
+    char    victronBmvMac[VICTRON_MAC_LEN];
+    uint8_t victronBmvKey[16];
+    char    victronMpptMac[VICTRON_MAC_LEN];
+    uint8_t victronMpptKey[16];
+    char    victronOrionMac[VICTRON_MAC_LEN];
+    uint8_t victronOrionKey[16];
+  };
+
+  // From v2 on, versions only append fields. Returns where the fields unknown to
+  // `version` start; everything before that offset is read as stored.
+  size_t appendedFieldsOffset(uint16_t version){
+    switch(version){
+      case 2: return offsetof(PersistState, derivedChannels);
+      case 3: return offsetof(PersistState, layouts);
+      case 4: return offsetof(PersistState, filters);
+      case 5: return offsetof(PersistState, regenLog);
+      case 6: return offsetof(PersistState, tripLog);
+      case 7: return offsetof(PersistState, nightPalette);
+      case 8: return offsetof(PersistState, parkedMonitorMin);
+      case 9: return sizeof(PersistState);   // v10 only fills UserChannelDef padding
+      default: return sizeof(PersistState);
+    }
+  }
+
+  // v1 -> v2: copy every v1 field over the v2 defaults (new fields keep their defaults)
+  void migrateFromV1(const PersistStateV1& v1, PersistState& state){
+    memcpy(state.pillChannel, v1.pillChannel, sizeof(v1.pillChannel));
+    memcpy(state.barChannel, v1.barChannel, sizeof(v1.barChannel));
+    state.currentScreen = v1.currentScreen;
+    memcpy(state.warnMode, v1.warnMode, sizeof(v1.warnMode));
+    memcpy(state.warnT1, v1.warnT1, sizeof(v1.warnT1));
+    memcpy(state.warnT2, v1.warnT2, sizeof(v1.warnT2));
+    state.paletteIndex = v1.paletteIndex;
+    memcpy(state.customPalettes, v1.customPalettes, sizeof(v1.customPalettes));
+    state.brightOn = v1.brightOn;
+    state.brightOff = v1.brightOff;
+    state.uPressure = v1.uPressure;
+    state.uTemp = v1.uTemp;
+    state.uSpeed = v1.uSpeed;
+    state.uLambda = v1.uLambda;
+    state.speedTrimPct = v1.speedTrimPct;
+    state.victronEnabled = v1.victronEnabled;
+    memcpy(state.wifiSsid, v1.wifiSsid, sizeof(v1.wifiSsid));
+    memcpy(state.wifiPass, v1.wifiPass, sizeof(v1.wifiPass));
+    memcpy(state.victronBmvMac, v1.victronBmvMac, sizeof(v1.victronBmvMac));
+    memcpy(state.victronBmvKey, v1.victronBmvKey, sizeof(v1.victronBmvKey));
+    memcpy(state.victronMpptMac, v1.victronMpptMac, sizeof(v1.victronMpptMac));
+    memcpy(state.victronMpptKey, v1.victronMpptKey, sizeof(v1.victronMpptKey));
+    memcpy(state.victronOrionMac, v1.victronOrionMac, sizeof(v1.victronOrionMac));
+    memcpy(state.victronOrionKey, v1.victronOrionKey, sizeof(v1.victronOrionKey));
+  }
+
+  // v1-v3 -> v4: the fixed bar + 2x2 screen becomes LT_BAR_QUAD (slot 0 = bar, 1..4 = pills).
+  // Slots 5.. keep their defaults.
+  void migrateLegacyLayouts(PersistState& state){
+    for(uint8_t s = 0; s < SCREEN_COUNT; s++){
+      ScreenLayout& l = state.layouts[s];
+      l.tpl = LT_BAR_QUAD;
+      l.ch[0] = state.barChannel[s];
+      for(uint8_t i = 0; i < 4; i++) l.ch[1 + i] = state.pillChannel[s][i];
+    }
+  }
+
   void applyHeader(PersistState& state){
     state.magic = Persist::EEPROM_MAGIC;
     state.version = Persist::SCHEMA_VERSION;
@@ -17,6 +104,28 @@ void loadPersist(PersistState& state, const PersistState& defaults){
   EEPROM.get(Persist::EEPROM_ADDR, stored);
   if(stored.magic == Persist::EEPROM_MAGIC && stored.version == Persist::SCHEMA_VERSION){
     state = stored;
+  } else if(stored.magic == Persist::EEPROM_MAGIC && stored.version >= 2 && stored.version < Persist::SCHEMA_VERSION){
+    const size_t off = appendedFieldsOffset(stored.version);
+    state = stored;
+    memcpy(reinterpret_cast<uint8_t*>(&state) + off, reinterpret_cast<const uint8_t*>(&defaults) + off,
+           sizeof(PersistState) - off);
+    if(stored.version < 4) migrateLegacyLayouts(state);
+    if(stored.version < 10){
+      // Padding before v10: user gauges read the powertrain bus (0), as on a one-controller dash
+      for(UserChannelDef& u : state.userChannels) u.bus = 0;
+    }
+    applyHeader(state);
+    EEPROM.put(Persist::EEPROM_ADDR, state);
+    EEPROM.commit();
+  } else if(stored.magic == Persist::EEPROM_MAGIC && stored.version == 1){
+    PersistStateV1 v1{};
+    EEPROM.get(Persist::EEPROM_ADDR, v1);
+    state = defaults;
+    migrateFromV1(v1, state);
+    migrateLegacyLayouts(state);
+    applyHeader(state);
+    EEPROM.put(Persist::EEPROM_ADDR, state);
+    EEPROM.commit();
   } else {
     state = defaults;
     applyHeader(state);
@@ -5,8 +5,8 @@
 
 namespace Persist {
   constexpr uint16_t EEPROM_MAGIC = 0x7ADE;
-  constexpr uint16_t SCHEMA_VERSION = 1;
-  constexpr size_t EEPROM_BYTES = 1024;
+  constexpr uint16_t SCHEMA_VERSION = 10;
+  constexpr size_t EEPROM_BYTES = 4096;
   constexpr int EEPROM_ADDR = 0;
   constexpr uint32_t SAVE_MS = 300000;
 }
@@ -20,21 +20,125 @@ struct CustomPalette {
   uint16_t bg;
 };
 
+// One user-defined CAN gauge: display = raw(bits from..to) * scale + bias
+constexpr size_t USER_LABEL_LEN = 11;
+constexpr size_t USER_UNIT_LEN = 7;
+
+struct UserChannelDef {
+  uint32_t canId;
+  uint8_t  enabled;
+  uint8_t  fromBit;    // CanField bit numbering
+  uint8_t  toBit;
+  uint8_t  order;      // CanField::Order
+  uint8_t  isSigned;   // two's complement over the field width
+  uint8_t  decimals;   // 0..3
+  uint8_t  bus;        // v10: CanBus index the ID is read from (was padding)
+  float    scale;
+  float    bias;
+  float    rangeMin;
+  float    rangeMax;
+  char     label[USER_LABEL_LEN + 1];
+  char     unit[USER_UNIT_LEN + 1];
+};
+static_assert(offsetof(UserChannelDef, scale) == 12 && sizeof(UserChannelDef) == 48,
+              "UserChannelDef layout is persisted; bus must stay in the pre-v10 padding");
+
+// One derived gauge: value = expression over other channels (base units)
+constexpr size_t DERIVED_EXPR_LEN = 63;
+
+struct DerivedChannelDef {
+  uint8_t  enabled;
+  uint8_t  decimals;   // 0..3
+  float    rangeMin;
+  float    rangeMax;
+  char     expr[DERIVED_EXPR_LEN + 1];
+  char     label[USER_LABEL_LEN + 1];
+  char     unit[USER_UNIT_LEN + 1];
+};
+
+// One screen: a LayoutTemplate plus one channel per widget slot, in the template's cell order.
+// Slots past the template's widget count keep their channel so switching templates is lossless.
+constexpr uint8_t LAYOUT_MAX_WIDGETS = 9;
+
+struct ScreenLayout {
+  uint8_t tpl;
+  uint8_t ch[LAYOUT_MAX_WIDGETS];
+};
+
+// Per-channel signal conditioning (see SignalFilter.h). Stages run median -> EMA -> slew.
+struct ChannelFilterDef {
+  uint8_t  median;      // 0 = off, 3 or 5 taps
+  uint8_t  flags;       // Filters::FILTER_*
+  uint16_t emaTauMs;    // EMA time constant, 0 = off
+  float    slewPerSec;  // max change per second in base units, 0 = off
+};
+
+// DPF regeneration history (see RegenAnalytics.h). Times are on the engine-hours clock.
+constexpr uint8_t REGEN_HISTORY = 12;
+
+struct RegenEvent {
+  uint32_t startEngineS;   // engine running seconds at regen start
+  uint32_t startOdoM;      // log odometer at regen start
+  uint16_t durationS;
+  uint16_t pausedS;        // time spent in REGEN_PAUSED
+  uint16_t distance10M;    // distance driven during the regen, 10 m units
+  uint16_t sootStartX10;   // soot % x10
+  uint16_t sootEndX10;
+  int16_t  egt1MaxC;
+  int16_t  egt2MaxC;
+  uint8_t  pauses;
+  uint8_t  flags;          // Regen::EV_*
+};
+
+struct RegenLog {
+  uint32_t reserved[2];    // v6 odometer and engine time; Trip's lifetime record replaced them
+  float    sootPerKm;      // learned accumulation rates, valid once rateSamples* > 0
+  float    sootPerHour;
+  uint16_t rateSamplesKm;
+  uint16_t rateSamplesHour;
+  uint16_t total;          // regens recorded, including ones rotated out of events
+  uint8_t  head;           // next slot to write
+  uint8_t  count;
+  RegenEvent events[REGEN_HISTORY];
+};
+
+// Trip computer (see TripComputer.h): trip A, trip B and lifetime, same counters each
+constexpr uint8_t TRIP_RECORDS = 3;
+constexpr uint8_t TRIP_GEAR_SLOTS = 10;    // P, R, N, 1..7
+constexpr uint8_t TRIP_CONV_SLOTS = 5;     // one per TCState
+constexpr uint8_t TRIP_COUNTERS = 5 + TRIP_GEAR_SLOTS + TRIP_CONV_SLOTS;
+
+struct TripRecord {
+  uint32_t c[TRIP_COUNTERS];   // indexed by Trip::Counter
+  uint16_t maxSpeedX10;        // km/h x10, trimmed
+  uint16_t reserved;
+};
+
+struct TripLog {
+  TripRecord rec[TRIP_RECORDS];
+  uint8_t fuelChannel;         // channel giving fuel rate in L/h, CH__COUNT = none
+  uint8_t reserved[3];
+};
+
 constexpr uint8_t CUSTOM_PALETTE_COUNT = 3;
+constexpr uint8_t NIGHT_PALETTE_OFF = 0xFF;
 constexpr uint8_t SCREEN_COUNT = 5;
 constexpr size_t WIFI_SSID_LEN = 32;
 constexpr size_t WIFI_PASS_LEN = 64;
 constexpr size_t VICTRON_MAC_LEN = 18;
+// Per-channel arrays are sized to a fixed capacity so adding channels doesn't shift the layout
+constexpr uint8_t PERSIST_CH_CAPACITY = 64;
+static_assert(CH__COUNT <= PERSIST_CH_CAPACITY, "Raise PERSIST_CH_CAPACITY (and SCHEMA_VERSION)");
 
 struct PersistState {
   uint16_t magic;
   uint16_t version;
-  uint8_t pillChannel[SCREEN_COUNT][4];
+  uint8_t pillChannel[SCREEN_COUNT][4];  // v1-v3 fixed layout, only read to migrate into layouts
   uint8_t barChannel[SCREEN_COUNT];
   uint8_t currentScreen;
-  uint8_t warnMode[CH__COUNT];
-  float   warnT1[CH__COUNT];  // base units
-  float   warnT2[CH__COUNT];  // base units
+  uint8_t warnMode[PERSIST_CH_CAPACITY];
+  float   warnT1[PERSIST_CH_CAPACITY];  // base units
+  float   warnT2[PERSIST_CH_CAPACITY];  // base units
   uint8_t paletteIndex;
   CustomPalette customPalettes[CUSTOM_PALETTE_COUNT];
   // system
@@ -55,6 +159,23 @@ struct PersistState {
   uint8_t victronMpptKey[16];
   char    victronOrionMac[VICTRON_MAC_LEN];
   uint8_t victronOrionKey[16];
+  // v2
+  UserChannelDef userChannels[USER_CHANNEL_COUNT];
+  // v3
+  DerivedChannelDef derivedChannels[DERIVED_CHANNEL_COUNT];
+  // v4
+  ScreenLayout layouts[SCREEN_COUNT];
+  // v5
+  ChannelFilterDef filters[PERSIST_CH_CAPACITY];
+  // v6
+  RegenLog regenLog;
+  // v7
+  TripLog tripLog;
+  // v8
+  uint8_t nightPalette;    // palette while headlights are on; NIGHT_PALETTE_OFF = use paletteIndex
+  // v9
+  uint8_t parkedMonitorMin;   // parked Victron sample period in minutes; 0 = off
+  // v10: UserChannelDef::bus, in what was struct padding
 };
 
 void loadPersist(PersistState& state, const PersistState& defaults);
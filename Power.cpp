@@ -0,0 +1,184 @@
+#include "Power.h"
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#include "Config.h"
+#include "J1939.h"
+
+namespace {
+using namespace Power;
+
+State g_state = PS_ACTIVE;
+Stats g_stats = {};
+uint8_t g_wakePin = 0;
+uint32_t g_monitorMs = 0;
+unsigned long g_lastUpdateMs = 0;
+unsigned long g_stateSinceMs = 0;
+unsigned long g_lastIgnitionMs = 0;
+unsigned long g_lastFrameMs = 0;
+unsigned long g_lastMonitorMs = 0;
+unsigned long g_wakeMs = 0;          // last activity wake; WAKE_CHECK_MS runs from here
+unsigned long g_falseWakeMs = 0;     // last wake that found traffic but no ignition
+unsigned long g_resumeFromMs = 0;    // 0 = not resuming
+bool g_wakeCheck = false;
+bool g_ignition = false;             // ignition frame since the dash started dimming
+
+inline bool isIgnitionId(uint32_t id) {
+  if (id & CAN_EFF_FLAG) {
+    return J1939::parse(id).pgn == J1939::PGN_EEC1;   // J1939 trucks: engine speed from any engine ECU
+  }
+  return id == CFG::ID_SPEED || id == CFG::ID_RPM_SPEED;
+}
+
+Action enter(State s, unsigned long nowMs, Action a) {
+  g_state = s;
+  g_stateSinceMs = nowMs;
+  return a;
+}
+
+bool monitorDue(unsigned long nowMs) { return g_monitorMs && nowMs - g_lastMonitorMs >= g_monitorMs; }
+}  // namespace
+
+namespace Power {
+void begin(uint8_t wakePin) {
+  g_wakePin = wakePin;
+  g_lastUpdateMs = g_stateSinceMs = g_lastIgnitionMs = g_lastFrameMs = millis();
+}
+
+void noteFrame(uint32_t id, uint8_t bus, unsigned long nowMs) {
+  g_lastFrameMs = nowMs;
+  if (bus != CFG::CAN_BUS_PT || !isIgnitionId(id)) {
+    return;
+  }
+  g_lastIgnitionMs = nowMs;
+  if (g_state != PS_ACTIVE && !g_ignition) {
+    g_ignition = true;
+    if (!g_resumeFromMs) {
+      g_resumeFromMs = nowMs;
+    }
+  }
+}
+
+void setMonitorMinutes(uint8_t minutes) { g_monitorMs = minutes * 60000UL; }
+
+Action update(unsigned long nowMs, bool hold) {
+  g_stats.stateMs[g_state] += nowMs - g_lastUpdateMs;
+  g_lastUpdateMs = nowMs;
+  if (g_state != PS_ACTIVE && g_ignition) {
+    g_wakeCheck = false;
+    if (!g_resumeFromMs) {
+      g_resumeFromMs = nowMs;
+    }
+    return enter(PS_ACTIVE, nowMs, PA_RESUME);
+  }
+  switch (g_state) {
+    case PS_ACTIVE:
+      if (hold || nowMs - g_lastIgnitionMs < IGNITION_OFF_MS) {
+        return PA_NONE;
+      }
+      g_ignition = false;
+      return enter(PS_DIMMING, nowMs, PA_DIM);
+    case PS_DIMMING:
+      if (nowMs - g_stateSinceMs < PARK_DIM_MS) {
+        return PA_NONE;
+      }
+      g_stats.parks++;
+      g_lastMonitorMs = nowMs;
+      return enter(PS_PARKED, nowMs, PA_PARK);
+    case PS_PARKED:
+      if (g_wakeCheck) {
+        if (nowMs - g_wakeMs < WAKE_CHECK_MS) {
+          return PA_NONE;
+        }
+        g_wakeCheck = false;
+        g_falseWakeMs = nowMs;
+        g_resumeFromMs = 0;
+        g_stats.falseWakes++;
+      }
+      if (monitorDue(nowMs)) {
+        return enter(PS_MONITOR, nowMs, PA_MONITOR_START);
+      }
+      return PA_SLEEP;
+    case PS_MONITOR:
+      if (nowMs - g_stateSinceMs < MONITOR_WINDOW_MS) {
+        return PA_NONE;
+      }
+      g_lastMonitorMs = nowMs;
+      return enter(PS_PARKED, nowMs, PA_MONITOR_END);
+    default:
+      return PA_NONE;
+  }
+}
+
+State state() { return g_state; }
+
+bool controllerMaySleep(unsigned long nowMs) {
+  // Frames are filtered to the ignition IDs while parked, so silence here only means the bus was
+  // quiet before parking. A false wake proves other traffic: don't bounce on it every second.
+  return nowMs - g_lastFrameMs >= BUS_SILENT_MS && (!g_falseWakeMs || nowMs - g_falseWakeMs >= BUS_RECHECK_MS);
+}
+
+Wake sleep(unsigned long nowMs) {
+  uint32_t ms = SLEEP_MAX_MS;
+  if (g_monitorMs) {
+    const uint32_t since = nowMs - g_lastMonitorMs;
+    const uint32_t left = since >= g_monitorMs ? 1 : g_monitorMs - since;
+    if (left < ms) {
+      ms = left;
+    }
+  }
+  esp_sleep_enable_timer_wakeup(static_cast<uint64_t>(ms) * 1000ULL);
+  // Level wake: a frame already waiting keeps CAN_INT low and the sleep returns at once
+  gpio_wakeup_enable(static_cast<gpio_num_t>(g_wakePin), GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  const uint32_t t0 = micros();
+  const esp_err_t err = esp_light_sleep_start();
+  gpio_wakeup_disable(static_cast<gpio_num_t>(g_wakePin));
+  if (err != ESP_OK) {
+    g_stats.rejects++;
+    delay(SLEEP_REJECT_MS);
+    return WAKE_REJECTED;
+  }
+  g_stats.sleptMs[g_state] += (micros() - t0) / 1000;
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
+    g_stats.canWakes++;
+    g_wakeMs = millis();
+    g_wakeCheck = true;
+    g_resumeFromMs = g_wakeMs;
+    return WAKE_CAN;
+  }
+  g_stats.timerWakes++;
+  return WAKE_TIMER;
+}
+
+void resumed(unsigned long nowMs) {
+  if (!g_resumeFromMs) {
+    return;
+  }
+  g_stats.lastResumeMs = nowMs - g_resumeFromMs;
+  if (g_stats.lastResumeMs > g_stats.maxResumeMs) {
+    g_stats.maxResumeMs = g_stats.lastResumeMs;
+  }
+  g_resumeFromMs = 0;
+}
+
+uint8_t awakePct(State s) {
+  const uint32_t total = g_stats.stateMs[s];
+  if (!total) {
+    return 100;
+  }
+  const uint32_t slept = g_stats.sleptMs[s] < total ? g_stats.sleptMs[s] : total;
+  return static_cast<uint8_t>((static_cast<uint64_t>(total - slept) * 100) / total);
+}
+
+const char* stateName(State s) {
+  switch (s) {
+    case PS_ACTIVE: return "active";
+    case PS_DIMMING: return "dimming";
+    case PS_PARKED: return "parked";
+    case PS_MONITOR: return "monitor";
+    default: return "?";
+  }
+}
+
+const Stats& stats() { return g_stats; }
+}  // namespace Power
@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+
+// Ignition-aware power manager.
+// Ignition is read from the speed/RPM frames, or EEC1 on a J1939 bus: when none has been seen
+// for IGNITION_OFF_MS the dash dims, then parks. Parked, the MCP2515 filters pass only those IDs
+// and the ESP32 light-sleeps with CAN_INT as its wake source, so the first ignition frame both
+// wakes the CPU and is already in an RX buffer when loop() drains. On a silent bus the controller
+// sleeps as well and wakes on bus activity; if no ignition frame follows within WAKE_CHECK_MS it
+// goes back down.
+// update() only decides; the sketch owns the hardware and acts on the returned Action.
+namespace Power {
+  constexpr uint32_t IGNITION_OFF_MS   = 30000;
+  constexpr uint32_t PARK_DIM_MS       = 1500;     // backlight ramp before parking; ignition aborts it
+  constexpr uint32_t BUS_SILENT_MS     = 5000;     // no frame of any ID: the controller may sleep too
+  constexpr uint32_t BUS_RECHECK_MS    = 300000;   // after a wake with no ignition, keep the controller up
+  constexpr uint32_t WAKE_CHECK_MS     = 1000;     // awake after an activity wake, waiting for ignition
+  constexpr uint32_t MONITOR_WINDOW_MS = 10000;    // parked monitor: BLE scan time per sample
+  constexpr uint32_t SLEEP_MAX_MS      = 60000;    // timer cap so housekeeping still runs
+  constexpr uint32_t SLEEP_REJECT_MS   = 50;       // back-off when light sleep is refused
+  constexpr uint32_t PARKED_IDLE_MS    = 20;       // loop() pause per pass while parked but awake
+  constexpr uint8_t  MONITOR_MAX_MIN   = 120;
+
+  enum State : uint8_t { PS_ACTIVE, PS_DIMMING, PS_PARKED, PS_MONITOR, PS__COUNT };
+
+  enum Action : uint8_t {
+    PA_NONE,
+    PA_DIM,             // start the backlight ramp to 0 over PARK_DIM_MS
+    PA_PARK,            // ramp done: narrow CAN filters, stop BLE, panel off
+    PA_SLEEP,           // parked and nothing pending: call sleep()
+    PA_MONITOR_START,   // parked monitor sample: scan BLE
+    PA_MONITOR_END,
+    PA_RESUME,          // ignition is back: undo PA_PARK, repaint, light, then call resumed()
+  };
+
+  enum Wake : uint8_t { WAKE_CAN, WAKE_TIMER, WAKE_REJECTED };
+
+  struct Stats {
+    uint32_t stateMs[PS__COUNT];   // time spent in each state ...
+    uint32_t sleptMs[PS__COUNT];   // ... and how much of it in light sleep
+    uint32_t parks;
+    uint32_t canWakes;
+    uint32_t falseWakes;           // activity wakes that timed out without an ignition frame
+    uint32_t timerWakes;
+    uint32_t rejects;
+    uint32_t lastResumeMs;         // wake (or first ignition frame) to first complete frame
+    uint32_t maxResumeMs;
+  };
+
+  void begin(uint8_t wakePin);
+  // Every drained frame; ignition IDs count on the powertrain bus only
+  void noteFrame(uint32_t id, uint8_t bus, unsigned long nowMs);
+  // Parked monitor period in minutes, 0 = off
+  void setMonitorMinutes(uint8_t minutes);
+  // hold keeps the dash awake (boot, config page, a palette cross-fade)
+  Action update(unsigned long nowMs, bool hold);
+  State state();
+  // Parked on a silent bus: the sketch may put the controller to sleep before sleep()
+  bool controllerMaySleep(unsigned long nowMs);
+  // Light sleep until CAN_INT goes low or the timer (monitor due / SLEEP_MAX_MS) fires
+  Wake sleep(unsigned long nowMs);
+  void resumed(unsigned long nowMs);
+  // Awake share of the time spent in a state, the current-draw proxy
+  uint8_t awakePct(State s);
+  const char* stateName(State s);
+  const Stats& stats();
+}
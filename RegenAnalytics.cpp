@@ -0,0 +1,197 @@
+#include "RegenAnalytics.h"
+#include "CanDecode.h"
+#include "TripComputer.h"
+
+namespace {
+RegenLog* g_log = nullptr;
+RegenLog g_scratch{};            // used until attach()
+
+uint32_t g_lastSaveOdoM = 0;
+
+// Current accumulation segments (RAM only; restart after every regen and at boot)
+bool g_segValid = false;
+uint32_t g_segOdoM = 0, g_segEngineS = 0;
+float g_segSootKm = 0, g_segSootHour = 0;
+
+// Open event
+bool g_inEvent = false;
+RegenState g_lastState = REGEN_IDLE;
+RegenEvent g_ev{};
+unsigned long g_evStartMs = 0, g_pauseStartMs = 0;
+uint32_t g_pausedMs = 0;
+
+float g_trigger = Regen::TRIGGER_DEFAULT;
+
+inline RegenLog& L() { return g_log ? *g_log : g_scratch; }
+
+// The lifetime record behind Trip::distanceKm / engineHours, in whole metres and seconds
+inline uint32_t odoM() { return Trip::record(Trip::LIFETIME).c[Trip::DIST_M]; }
+inline uint32_t engineS() { return Trip::record(Trip::LIFETIME).c[Trip::ENGINE_S]; }
+
+inline uint16_t pctX10(float v) {
+  if (!isfinite(v) || v < 0) return 0;
+  return v > 6553.0f ? 65530 : static_cast<uint16_t>(lroundf(v * 10));
+}
+inline int16_t clampC(float v) {
+  if (!isfinite(v)) return INT16_MIN;
+  return static_cast<int16_t>(v > 32767.0f ? 32767 : (v < -32767.0f ? -32767 : lroundf(v)));
+}
+
+void recomputeTrigger() {
+  const RegenLog& l = L();
+  uint32_t sum = 0;
+  for (uint8_t i = 0; i < l.count; i++) sum += l.events[i].sootStartX10;
+  g_trigger = l.count ? (sum / 10.0f) / l.count : Regen::TRIGGER_DEFAULT;
+}
+
+void restartSegments() {
+  g_segValid = isfinite(soot_pct);
+  g_segOdoM = odoM();
+  g_segEngineS = engineS();
+  g_segSootKm = g_segSootHour = soot_pct;
+}
+
+inline void ewma(float& rate, uint16_t& samples, float sample) {
+  rate = samples ? rate + Regen::RATE_ALPHA * (sample - rate) : sample;
+  if (samples < 0xFFFF) samples++;
+}
+
+// Between regens soot only accumulates (passive regen shows as a lower rate)
+void learn() {
+  if (!isfinite(soot_pct)) { g_segValid = false; return; }
+  if (!g_segValid) { restartSegments(); return; }
+  RegenLog& l = L();
+  const uint32_t m = odoM(), sec = engineS();
+  if (m - g_segOdoM >= Regen::SEGMENT_M) {
+    const float km = (m - g_segOdoM) / 1000.0f;
+    ewma(l.sootPerKm, l.rateSamplesKm, (soot_pct - g_segSootKm) / km);
+    g_segOdoM = m;
+    g_segSootKm = soot_pct;
+  }
+  if (sec - g_segEngineS >= Regen::SEGMENT_S) {
+    const float h = (sec - g_segEngineS) / 3600.0f;
+    ewma(l.sootPerHour, l.rateSamplesHour, (soot_pct - g_segSootHour) / h);
+    g_segEngineS = sec;
+    g_segSootHour = soot_pct;
+  }
+}
+
+void openEvent(unsigned long nowMs) {
+  g_inEvent = true;
+  g_ev = RegenEvent{};
+  g_ev.startEngineS = engineS();
+  g_ev.startOdoM = odoM();
+  g_ev.sootStartX10 = pctX10(soot_pct);
+  g_ev.egt1MaxC = clampC(egt1C);
+  g_ev.egt2MaxC = clampC(egt2C);
+  g_evStartMs = nowMs;
+  g_pausedMs = 0;
+}
+
+void closeEvent(unsigned long nowMs) {
+  RegenLog& l = L();
+  if (g_lastState == REGEN_PAUSED) {
+    g_pausedMs += nowMs - g_pauseStartMs;
+    g_ev.flags |= Regen::EV_INCOMPLETE;
+  }
+  const uint32_t durS = (nowMs - g_evStartMs) / 1000;
+  g_ev.durationS = static_cast<uint16_t>(durS > 0xFFFF ? 0xFFFF : durS);
+  const uint32_t pausedS = g_pausedMs / 1000;
+  g_ev.pausedS = static_cast<uint16_t>(pausedS > 0xFFFF ? 0xFFFF : pausedS);
+  const uint32_t d10 = (odoM() - g_ev.startOdoM) / 10;
+  g_ev.distance10M = static_cast<uint16_t>(d10 > 0xFFFF ? 0xFFFF : d10);
+  g_ev.sootEndX10 = pctX10(soot_pct);
+
+  l.events[l.head] = g_ev;
+  l.head = static_cast<uint8_t>((l.head + 1) % REGEN_HISTORY);
+  if (l.count < REGEN_HISTORY) l.count++;
+  if (l.total < 0xFFFF) l.total++;
+  g_inEvent = false;
+  recomputeTrigger();
+  restartSegments();
+}
+
+void trackEvent(RegenState st, unsigned long nowMs) {
+  const int16_t e1 = clampC(egt1C), e2 = clampC(egt2C);
+  if (e1 > g_ev.egt1MaxC) g_ev.egt1MaxC = e1;
+  if (e2 > g_ev.egt2MaxC) g_ev.egt2MaxC = e2;
+  if (st == REGEN_PAUSED && g_lastState != REGEN_PAUSED) {
+    g_pauseStartMs = nowMs;
+    if (g_ev.pauses < 0xFF) g_ev.pauses++;
+  } else if (st != REGEN_PAUSED && g_lastState == REGEN_PAUSED) {
+    g_pausedMs += nowMs - g_pauseStartMs;
+  }
+}
+}  // namespace
+
+namespace Regen {
+void attach(RegenLog& log) {
+  g_log = &log;
+  if (log.count > REGEN_HISTORY) log.count = REGEN_HISTORY;
+  if (log.head >= REGEN_HISTORY) log.head = 0;
+  if (!isfinite(log.sootPerKm)) { log.sootPerKm = 0; log.rateSamplesKm = 0; }
+  if (!isfinite(log.sootPerHour)) { log.sootPerHour = 0; log.rateSamplesHour = 0; }
+  g_lastSaveOdoM = odoM();
+  g_segValid = false;
+  recomputeTrigger();
+}
+
+bool update(RegenState st, unsigned long nowMs) {
+  bool save = false;
+  if (st != REGEN_IDLE && !g_inEvent) openEvent(nowMs);
+  if (g_inEvent) {
+    if (st == REGEN_IDLE) {
+      closeEvent(nowMs);
+      save = true;
+    } else {
+      trackEvent(st, nowMs);
+    }
+  } else {
+    learn();
+  }
+  g_lastState = st;
+
+  const uint32_t m = odoM();
+  if (m - g_lastSaveOdoM >= SAVE_EVERY_M) {
+    g_lastSaveOdoM = m;
+    save = true;
+  }
+  return save;
+}
+
+void clearHistory() {
+  RegenLog& l = L();
+  l.count = l.head = 0;
+  l.total = 0;
+  l.sootPerKm = l.sootPerHour = 0;
+  l.rateSamplesKm = l.rateSamplesHour = 0;
+  g_segValid = false;
+  recomputeTrigger();
+}
+
+const RegenLog& log() { return L(); }
+bool inEvent() { return g_inEvent; }
+
+const RegenEvent& event(uint8_t idx) {
+  const RegenLog& l = L();
+  return l.events[(l.head + REGEN_HISTORY - 1 - idx) % REGEN_HISTORY];
+}
+
+float sootPerKm() { return L().rateSamplesKm ? L().sootPerKm : NAN; }
+float sootPerHour() { return L().rateSamplesHour ? L().sootPerHour : NAN; }
+float triggerPct() { return g_trigger; }
+
+float kmToNext() {
+  const float r = sootPerKm();
+  if (!isfinite(r) || r <= 0 || !isfinite(soot_pct)) return NAN;
+  const float left = g_trigger - soot_pct;
+  return left > 0 ? left / r : 0;
+}
+
+float hoursToNext() {
+  const float r = sootPerHour();
+  if (!isfinite(r) || r <= 0 || !isfinite(soot_pct)) return NAN;
+  const float left = g_trigger - soot_pct;
+  return left > 0 ? left / r : 0;
+}
+}  // namespace Regen
@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include "DashTypes.h"
+#include "Persist.h"
+
+// DPF regeneration analytics.
+// update() follows regenState: it records one RegenEvent per regen into the persisted ring
+// (PersistState::regenLog), and learns the soot accumulation rate between regens as an EWMA
+// over fixed distance / engine-time segments. Distance and engine time are the trip
+// computer's lifetime counters, so both modules agree on one odometer. Every step is O(1);
+// the trigger level (mean soot at regen start) is recomputed only when an event closes.
+namespace Regen {
+  constexpr uint32_t SEGMENT_M        = 2000;     // soot/km sample length
+  constexpr uint32_t SEGMENT_S        = 600;      // soot/hour sample length (engine time)
+  constexpr float    RATE_ALPHA       = 0.2f;     // EWMA weight of a new segment
+  constexpr float    TRIGGER_DEFAULT  = 100.0f;   // soot % assumed to trigger a regen until history exists
+  constexpr uint32_t SAVE_EVERY_M     = 5000;     // ask for a save this often while driving
+
+  enum EventFlag : uint8_t {
+    EV_INCOMPLETE = 1 << 0,  // ended while paused
+  };
+
+  // The log lives in the persisted state and is updated in place
+  void attach(RegenLog& log);
+  // Call once per loop after updateRegenState(); true when the log should be saved
+  bool update(RegenState st, unsigned long nowMs);
+  void clearHistory();
+
+  const RegenLog& log();
+  bool inEvent();
+  // Newest first, idx < log().count
+  const RegenEvent& event(uint8_t idx);
+
+  float sootPerKm();      // NAN until learned
+  float sootPerHour();    // NAN until learned
+  float triggerPct();
+  float kmToNext();       // NAN without a rate or soot reading
+  float hoursToNext();
+}
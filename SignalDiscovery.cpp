@@ -0,0 +1,183 @@
+#include "SignalDiscovery.h"
+#include "CanCensus.h"
+
+namespace {
+// Streaming regression state for one candidate (Welford, centred moments)
+struct Stats {
+  uint32_t n;
+  float mx, my;
+  float m2x, m2y, cxy;
+};
+
+struct Watch {
+  uint32_t id;
+  uint8_t bus;
+  bool used;
+  uint8_t dlc;
+  unsigned long lastSampleMs;
+  Stats c[SignalDiscovery::CANDS_PER_ID];
+};
+
+const uint8_t kWidths[SignalDiscovery::WIDTH_COUNT] = {8, 12, 16};
+
+Watch g_watch[SignalDiscovery::MAX_IDS];
+bool g_active = false;
+uint8_t g_ref = 0;
+uint32_t g_sampled = 0;
+
+// Candidate index layout: ((startByte * WIDTH_COUNT) + widthIdx) * 2 + order
+inline void decodeIndex(uint8_t idx, uint8_t& from, uint8_t& to, CanField::Order& order) {
+  order = static_cast<CanField::Order>(idx & 1);
+  const uint8_t w = kWidths[(idx >> 1) % SignalDiscovery::WIDTH_COUNT];
+  from = static_cast<uint8_t>(((idx >> 1) / SignalDiscovery::WIDTH_COUNT) * 8);
+  to = static_cast<uint8_t>(from + w - 1);
+}
+
+Watch* watchFor(uint32_t id, uint8_t bus, bool adopt) {
+  Watch* freeSlot = nullptr;
+  for (uint8_t i = 0; i < SignalDiscovery::MAX_IDS; i++) {
+    if (g_watch[i].used) {
+      if (g_watch[i].id == id && g_watch[i].bus == bus) {
+        return &g_watch[i];
+      }
+    } else if (!freeSlot) {
+      freeSlot = &g_watch[i];
+    }
+  }
+  if (!adopt || !freeSlot) {
+    return nullptr;
+  }
+  memset(freeSlot, 0, sizeof(*freeSlot));
+  freeSlot->id = id;
+  freeSlot->bus = bus;
+  freeSlot->used = true;
+  return freeSlot;
+}
+
+inline void update(Stats& s, float x, float y) {
+  s.n++;
+  const float inv = 1.0f / static_cast<float>(s.n);
+  const float dx = x - s.mx;
+  const float dy = y - s.my;
+  s.mx += dx * inv;
+  s.my += dy * inv;
+  s.m2x += dx * (x - s.mx);
+  s.m2y += dy * (y - s.my);
+  s.cxy += dx * (y - s.my);
+}
+}  // namespace
+
+namespace SignalDiscovery {
+void start(uint8_t ref) {
+  memset(g_watch, 0, sizeof(g_watch));
+  g_ref = ref;
+  g_sampled = 0;
+  uint8_t slots[CanCensus::MAX_IDS];
+  const uint8_t n = CanCensus::sorted(CanCensus::SORT_RATE, slots, CanCensus::MAX_IDS);
+  for (uint8_t i = 0; i < n && i < MAX_IDS; i++) {
+    const CanCensus::Entry* e = CanCensus::slot(slots[i]);
+    watchFor(e->id, e->bus, true);
+  }
+  g_active = true;
+}
+
+void stop() { g_active = false; }
+
+bool active() { return g_active; }
+
+uint8_t reference() { return g_ref; }
+
+void record(const can_frame& f, uint8_t bus, float refValue, unsigned long nowMs) {
+  if (!g_active || !isfinite(refValue)) {
+    return;
+  }
+  Watch* w = watchFor(f.can_id, bus, true);
+  if (!w) {
+    return;
+  }
+  if (w->lastSampleMs != 0 && nowMs - w->lastSampleMs < SAMPLE_MS) {
+    return;
+  }
+  w->lastSampleMs = nowMs;
+  w->dlc = f.can_dlc > 8 ? 8 : f.can_dlc;
+  g_sampled++;
+
+  const uint64_t lanes[2] = {CanField::packLE(f.data, w->dlc), CanField::packBE(f.data, w->dlc)};
+  const uint8_t bits = static_cast<uint8_t>(w->dlc * 8);
+  for (uint8_t i = 0; i < CANDS_PER_ID; i++) {
+    uint8_t from, to;
+    CanField::Order order;
+    decodeIndex(i, from, to, order);
+    // Single-byte fields read the same in both orders; only the LE copy is kept
+    if (to >= bits || (order == CanField::ORDER_BE && to - from == 7)) {
+      continue;
+    }
+    const float x = static_cast<float>(CanField::extract(lanes[order], from, to, order));
+    update(w->c[i], x, refValue);
+  }
+}
+
+uint8_t top(Candidate* out, uint8_t maxOut) {
+  uint8_t n = 0;
+  for (uint8_t wi = 0; wi < MAX_IDS; wi++) {
+    const Watch& w = g_watch[wi];
+    if (!w.used) {
+      continue;
+    }
+    for (uint8_t i = 0; i < CANDS_PER_ID; i++) {
+      const Stats& s = w.c[i];
+      if (s.n < MIN_SAMPLES || s.m2x <= 0.0f || s.m2y <= 0.0f) {
+        continue;
+      }
+      Candidate c;
+      c.id = w.id;
+      c.bus = w.bus;
+      decodeIndex(i, c.fromBit, c.toBit, c.order);
+      c.samples = s.n;
+      c.r = s.cxy / sqrtf(s.m2x * s.m2y);
+      c.scale = s.cxy / s.m2x;
+      c.offset = s.my - c.scale * s.mx;
+      const float resid = s.m2y - s.cxy * c.scale;
+      c.rmse = resid > 0.0f ? sqrtf(resid / static_cast<float>(s.n)) : 0.0f;
+
+      auto better = [](const Candidate& a, const Candidate& b) {
+        const float ra = fabsf(a.r), rb = fabsf(b.r);
+        if (fabsf(ra - rb) > 1e-4f) {
+          return ra > rb;
+        }
+        if (a.rmse != b.rmse) {
+          return a.rmse < b.rmse;
+        }
+        return (a.toBit - a.fromBit) < (b.toBit - b.fromBit);
+      };
+      // Bounded insertion into the caller's top-N list
+      int8_t pos = static_cast<int8_t>(n);
+      while (pos > 0 && better(c, out[pos - 1])) {
+        pos--;
+      }
+      if (pos >= maxOut) {
+        continue;
+      }
+      const uint8_t last = (n < maxOut) ? n : static_cast<uint8_t>(maxOut - 1);
+      for (int8_t j = static_cast<int8_t>(last); j > pos; j--) {
+        out[j] = out[j - 1];
+      }
+      out[pos] = c;
+      if (n < maxOut) {
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+uint8_t watchedIds() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < MAX_IDS; i++) {
+    n += g_watch[i].used ? 1 : 0;
+  }
+  return n;
+}
+
+uint32_t sampledFrames() { return g_sampled; }
+}  // namespace SignalDiscovery
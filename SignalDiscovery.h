@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+#include "CanField.h"
+
+// Automatic signal discovery: correlates candidate bit-fields against a reference value.
+// Watches are keyed by (bus, can_id) like the census, so one ID on two buses is two sources.
+// For each watched ID every byte-aligned start, 8/12/16-bit width and both byte orders is
+// a candidate; each keeps a streaming (Welford) linear regression against the reference,
+// so memory is fixed and each sampled frame costs one pass over its candidates.
+// Ranking (top()) is done on demand from the UI, never in the CAN drain.
+namespace SignalDiscovery {
+  constexpr uint8_t  MAX_IDS        = 16;
+  constexpr uint8_t  WIDTH_COUNT    = 3;                      // 8, 12, 16 bits
+  constexpr uint8_t  CANDS_PER_ID   = 8 * WIDTH_COUNT * 2;    // start byte x width x order
+  constexpr uint32_t SAMPLE_MS      = 50;                     // per-ID sample spacing (20 Hz)
+  constexpr uint32_t MIN_SAMPLES    = 100;                    // before a candidate is ranked
+
+  struct Candidate {
+    uint32_t id;
+    uint8_t  bus;
+    uint8_t  fromBit, toBit;    // CanField numbering
+    CanField::Order order;
+    uint32_t samples;
+    float    r;                 // Pearson correlation with the reference
+    float    scale, offset;     // reference ~= raw * scale + offset
+    float    rmse;              // residual of that fit, in reference units
+  };
+
+  // Begin a new session against reference channel `ref` (opaque to this module).
+  // Watched IDs are seeded from the CAN census (highest rate first); free slots are
+  // filled by IDs as they are first seen.
+  void start(uint8_t ref);
+  void stop();
+  bool active();
+  uint8_t reference();
+
+  // Called from the CAN drain for every frame while active(); refValue is the
+  // current reference value in base units.
+  void record(const can_frame& f, uint8_t bus, float refValue, unsigned long nowMs);
+
+  // Best candidates by |r| (ties: lower rmse, then narrower field). Returns number written.
+  uint8_t top(Candidate* out, uint8_t maxOut);
+
+  uint8_t  watchedIds();
+  uint32_t sampledFrames();
+}
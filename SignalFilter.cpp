@@ -0,0 +1,195 @@
+#include "SignalFilter.h"
+#include "ChannelTraits.h"
+
+namespace {
+constexpr int8_t MAX_FRAC = 16;
+constexpr float HEADROOM = 4.0f;   // readings may run past the configured range
+
+struct State {
+  int32_t hist[5];     // median window, oldest overwritten first
+  int32_t ema;
+  int32_t out;
+  int32_t slewStep;    // Q16.16 per tick, 0 = off
+  uint8_t alpha;       // Q8 weight of the new sample, 0 = EMA off
+  uint8_t taps;        // 0, 3 or 5
+  uint8_t fill;        // samples in hist
+  uint8_t head;
+  uint8_t frac;        // fractional bits of this channel's fixed point
+  bool valid;
+  int rawKey, key;
+};
+
+ChannelFilterDef g_defs[CH__COUNT];
+State g_state[CH__COUNT];
+uint8_t g_active[CH__COUNT];
+uint8_t g_activeCount = 0;
+unsigned long g_lastTickMs = 0;
+Filters::Stats g_stats{};
+unsigned long g_windowStartMs = 0;
+uint16_t g_windowRaw = 0, g_windowFiltered = 0;
+
+inline int32_t toQ(float v, uint8_t frac) {
+  const float lim = ldexpf(1.0f, Filters::Q_BITS - frac);
+  if (v > lim) v = lim;
+  if (v < -lim) v = -lim;
+  return static_cast<int32_t>(lroundf(ldexpf(v, frac)));
+}
+inline float fromQ(int32_t q, uint8_t frac) { return ldexpf(static_cast<float>(q), -frac); }
+
+// Most fractional bits that still leave HEADROOM x the channel's range; -1 when none do
+int8_t fracBitsFor(Channel ch) {
+  const Range& r = Channels::rt(ch).range;
+  const float lo = Channels::fromDisplay(ch, r.mn), hi = Channels::fromDisplay(ch, r.mx);
+  const float need = HEADROOM * fmaxf(1.0f, fmaxf(fabsf(lo), fabsf(hi)));
+  if (!isfinite(need)) return -1;
+  for (int8_t f = MAX_FRAC; f >= 0; f--) {
+    if (ldexpf(1.0f, Filters::Q_BITS - f) >= need) return f;
+  }
+  return -1;
+}
+
+inline void swapIfGreater(int32_t& a, int32_t& b) {
+  if (a > b) {
+    const int32_t t = a;
+    a = b;
+    b = t;
+  }
+}
+
+// Sorting network over a copy; fill < taps (startup) falls back to the newest sample
+int32_t median(const State& s, int32_t newest) {
+  if (s.fill < s.taps) return newest;
+  int32_t v[5];
+  memcpy(v, s.hist, sizeof(v));
+  if (s.taps == 3) {
+    swapIfGreater(v[0], v[1]);
+    swapIfGreater(v[1], v[2]);
+    swapIfGreater(v[0], v[1]);
+    return v[1];
+  }
+  swapIfGreater(v[0], v[1]);
+  swapIfGreater(v[3], v[4]);
+  swapIfGreater(v[0], v[3]);
+  swapIfGreater(v[1], v[4]);
+  swapIfGreater(v[1], v[2]);
+  swapIfGreater(v[2], v[3]);
+  swapIfGreater(v[1], v[2]);
+  return v[2];
+}
+
+int displayKey(Channel ch, float base) {
+  if (!isfinite(base)) return INT32_MIN;
+  const ChannelRuntime& r = Channels::rt(ch);
+  return static_cast<int>(lroundf(Channels::toDisplay(ch, base) * r.keyScale));
+}
+
+void step(Channel ch, State& s) {
+  const float raw = Channels::raw(ch);
+  if (!isfinite(raw)) {
+    s.valid = false;
+    s.fill = 0;
+    return;
+  }
+  const int32_t x = toQ(raw, s.frac);
+  if (!s.valid) {
+    s.ema = s.out = x;
+    s.fill = 0;
+    s.head = 0;
+    s.valid = true;
+  }
+
+  int32_t y = x;
+  if (s.taps) {
+    s.hist[s.head] = x;
+    s.head = static_cast<uint8_t>((s.head + 1) % s.taps);
+    if (s.fill < s.taps) s.fill++;
+    y = median(s, x);
+  }
+  if (s.alpha) {
+    s.ema += static_cast<int32_t>((static_cast<int64_t>(y - s.ema) * s.alpha) >> 8);
+    y = s.ema;
+  }
+  if (s.slewStep) {
+    const int32_t d = y - s.out;
+    if (d > s.slewStep) y = s.out + s.slewStep;
+    else if (d < -s.slewStep) y = s.out - s.slewStep;
+  }
+  s.out = y;
+
+  const int rk = displayKey(ch, raw), k = displayKey(ch, fromQ(y, s.frac));
+  if (rk != s.rawKey) { g_windowRaw++; s.rawKey = rk; }
+  if (k != s.key) { g_windowFiltered++; s.key = k; }
+}
+}  // namespace
+
+namespace Filters {
+void configure(const ChannelFilterDef* defs, uint8_t count) {
+  memset(g_defs, 0, sizeof(g_defs));
+  memset(g_state, 0, sizeof(g_state));
+  g_activeCount = 0;
+  for (uint8_t i = 0; i < CH__COUNT && i < count; i++) {
+    const ChannelFilterDef& d = defs[i];
+    const int8_t frac = fracBitsFor(static_cast<Channel>(i));
+    if (frac < 0) continue;
+    g_defs[i] = d;
+    State& s = g_state[i];
+    s.frac = static_cast<uint8_t>(frac);
+    s.taps = (d.median == 3 || d.median == 5) ? d.median : 0;
+    // alpha = dt / (tau + dt): the usual discrete first-order low-pass
+    if (d.emaTauMs) {
+      const uint32_t a = (256u * TICK_MS + (d.emaTauMs + TICK_MS) / 2) / (d.emaTauMs + TICK_MS);
+      s.alpha = static_cast<uint8_t>(a < 1 ? 1 : (a > 255 ? 255 : a));
+    }
+    if (isfinite(d.slewPerSec) && d.slewPerSec > 0) {
+      const int32_t q = toQ(d.slewPerSec * TICK_MS / 1000.0f, s.frac);
+      s.slewStep = q < 1 ? 1 : q;
+    }
+    s.rawKey = s.key = INT32_MIN;
+    if (s.taps || s.alpha || s.slewStep) g_active[g_activeCount++] = i;
+  }
+  g_lastTickMs = millis();
+}
+
+void update(unsigned long nowMs) {
+  if (nowMs - g_lastTickMs >= TICK_MS) {
+    uint8_t n = 0;
+    while (nowMs - g_lastTickMs >= TICK_MS && n < MAX_CATCHUP_TICKS) {
+      g_lastTickMs += TICK_MS;
+      for (uint8_t i = 0; i < g_activeCount; i++) {
+        step(static_cast<Channel>(g_active[i]), g_state[g_active[i]]);
+      }
+      g_stats.ticks++;
+      n++;
+    }
+    if (nowMs - g_lastTickMs >= TICK_MS) g_lastTickMs = nowMs;
+  }
+  if (nowMs - g_windowStartMs >= 1000) {
+    g_stats.rawKeyChangesPerSec = g_windowRaw;
+    g_stats.keyChangesPerSec = g_windowFiltered;
+    g_windowRaw = g_windowFiltered = 0;
+    g_windowStartMs = nowMs;
+  }
+}
+
+bool supports(Channel ch) { return ch < CH__COUNT && fracBitsFor(ch) >= 0; }
+
+bool active(Channel ch) {
+  if (ch >= CH__COUNT) return false;
+  const State& s = g_state[ch];
+  return s.taps || s.alpha || s.slewStep;
+}
+
+float value(Channel ch) {
+  if (ch >= CH__COUNT) return NAN;
+  if (!active(ch)) return Channels::raw(ch);
+  const State& s = g_state[ch];
+  return s.valid ? fromQ(s.out, s.frac) : Channels::raw(ch);
+}
+
+float warnValue(Channel ch) {
+  if (ch < CH__COUNT && (g_defs[ch].flags & FILTER_WARN_RAW)) return Channels::raw(ch);
+  return value(ch);
+}
+
+const Stats& stats() { return g_stats; }
+}  // namespace Filters
@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include "DashTypes.h"
+#include "Persist.h"
+
+// Per-channel signal conditioning between decode and display.
+// Each configured channel runs median (3/5 taps) -> EMA -> slew limit on a fixed TICK_MS
+// sample clock, so the settings mean the same thing at any loop rate. State is fixed point in
+// static tables, scaled per channel so that four times its range (base units) fits in Q_BITS
+// with at most 16 fractional bits; a channel too wide for that is not filtered (supports()).
+// configure() builds the list of filtered channels so update() never touches the others. Channels::raw() stays unfiltered for logging and
+// derived inputs; warnings use the filtered value unless FILTER_WARN_RAW is set.
+namespace Filters {
+  constexpr uint32_t TICK_MS = 20;
+  constexpr uint8_t  MAX_CATCHUP_TICKS = 5;   // longer stalls resync instead of replaying ticks
+  constexpr uint8_t  FILTER_WARN_RAW = 1 << 0;
+  constexpr uint8_t  Q_BITS = 30;             // magnitude bits, so differences stay in int32
+
+  void configure(const ChannelFilterDef* defs, uint8_t count);
+  void update(unsigned long nowMs);
+
+  // The channel's range (after Channels::rebuild()) fits the fixed-point state
+  bool supports(Channel ch);
+  bool active(Channel ch);
+  // Filtered value (base units); raw when the channel has no filter
+  float value(Channel ch);
+  // Value the warning check should use
+  float warnValue(Channel ch);
+
+  // Display-key changes per second over filtered channels, before and after filtering:
+  // the pill value redraws the filters saved
+  struct Stats {
+    uint16_t rawKeyChangesPerSec;
+    uint16_t keyChangesPerSec;
+    uint32_t ticks;
+  };
+  const Stats& stats();
+}
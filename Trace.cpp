@@ -0,0 +1,118 @@
+#include "Trace.h"
+#include <atomic>
+#include <string.h>
+
+namespace {
+using namespace Trace;
+
+constexpr uint32_t kCategory[TR__COUNT] = {
+#define TRACE_CATEGORY(name, cat, fmt) cat,
+  TRACE_EVENTS(TRACE_CATEGORY)
+#undef TRACE_CATEGORY
+};
+
+static_assert((RING_LEN & (RING_LEN - 1)) == 0, "RING_LEN must be a power of two");
+
+Record g_ring[RING_LEN];
+std::atomic<uint16_t> g_head{0};   // written by loop() only
+std::atomic<uint16_t> g_tail{0};   // written by the drain task only
+volatile uint32_t g_mask = TC_TRACE;
+uint32_t g_lost = 0;               // dropped since the last TR_DROPPED made it into the ring
+uint8_t g_seq = 0;
+Stats g_stats = {};
+char g_cmd[12];
+uint8_t g_cmdLen = 0;
+
+// Host command: "T<hex mask>\n". Anything else is ignored up to the newline.
+void pollCommand() {
+  while (Serial.available() > 0) {
+    const char c = static_cast<char>(Serial.read());
+    if (c != '\n' && c != '\r') {
+      if (g_cmdLen < sizeof(g_cmd) - 1) {
+        g_cmd[g_cmdLen++] = c;
+      }
+      continue;
+    }
+    g_cmd[g_cmdLen] = 0;
+    if (g_cmdLen > 1 && (g_cmd[0] == 'T' || g_cmd[0] == 't')) {
+      setMask(strtoul(g_cmd + 1, nullptr, 16));
+    }
+    g_cmdLen = 0;
+  }
+}
+
+void drainTask(void*) {
+  uint8_t frame[FRAME_LEN];
+  for (;;) {
+    pollCommand();
+    const uint16_t tail = g_tail.load(std::memory_order_relaxed);
+    const uint16_t head = g_head.load(std::memory_order_acquire);
+    if (head == tail) {
+      vTaskDelay(pdMS_TO_TICKS(DRAIN_IDLE_MS));
+      continue;
+    }
+    if (!Serial) {
+      // No host on the USB port: keep the ring empty so the writer never drops while detached
+      g_stats.discarded += static_cast<uint16_t>(head - tail);
+      g_tail.store(head, std::memory_order_release);
+      continue;
+    }
+    if (Serial.availableForWrite() < FRAME_LEN) {
+      vTaskDelay(1);
+      continue;
+    }
+    frame[0] = SYNC0;
+    frame[1] = SYNC1;
+    memcpy(frame + 2, &g_ring[tail & (RING_LEN - 1)], sizeof(Record));
+    g_tail.store(tail + 1, std::memory_order_release);
+    uint8_t x = 0;
+    for (uint8_t i = 2; i < FRAME_LEN - 1; i++) {
+      x ^= frame[i];
+    }
+    frame[FRAME_LEN - 1] = x;
+    Serial.write(frame, FRAME_LEN);
+    g_stats.sent++;
+  }
+}
+
+inline bool push(Event e, uint16_t a, uint32_t b) {
+  const uint16_t head = g_head.load(std::memory_order_relaxed);
+  const uint16_t depth = head - g_tail.load(std::memory_order_acquire);
+  if (depth >= RING_LEN) {
+    return false;
+  }
+  g_ring[head & (RING_LEN - 1)] = {static_cast<uint32_t>(micros()), e, g_seq++, a, b};
+  g_head.store(head + 1, std::memory_order_release);
+  g_stats.written++;
+  if (depth + 1 > g_stats.maxDepth) {
+    g_stats.maxDepth = depth + 1;
+  }
+  return true;
+}
+}  // namespace
+
+namespace Trace {
+bool begin(uint32_t mask) {
+  setMask(mask);
+  return xTaskCreate(drainTask, "trace", 2048, nullptr, tskIDLE_PRIORITY + 1, nullptr) == pdPASS;
+}
+
+void log(Event e, uint16_t a, uint32_t b) {
+  if (!(g_mask & kCategory[e])) {
+    return;
+  }
+  if (g_lost && push(TR_DROPPED, 0, g_lost)) {
+    g_lost = 0;
+  }
+  if (g_lost || !push(e, a, b)) {
+    g_lost++;
+    g_stats.dropped++;
+  }
+}
+
+void setMask(uint32_t mask) { g_mask = mask | TC_TRACE; }
+
+uint32_t mask() { return g_mask; }
+
+const Stats& stats() { return g_stats; }
+}  // namespace Trace
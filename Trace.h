@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+#include "TraceEvents.h"
+
+// Binary trace log.
+// A trace point writes one 12-byte record (micros, event ID, two small args) into a RAM ring and
+// returns: no formatting, no Serial call, no lock. The ring has one writer, loop(), and one
+// reader, a low-priority task that frames records onto Serial only while the port has room, so a
+// slow or absent host costs dropped records (counted, and reported in-band) rather than loop time.
+// Events are listed once in TraceEvents.h, which tools/trace_decode.py reads as its dictionary.
+// Categories switch at runtime: the host sends "T<hex mask>\n".
+namespace Trace {
+  constexpr uint16_t RING_LEN      = 256;   // power of two
+  constexpr uint8_t  SYNC0         = 0xA5;  // never in the ASCII text sharing the port
+  constexpr uint8_t  SYNC1         = 0x5A;
+  constexpr uint8_t  FRAME_LEN     = 15;    // sync, sync, 12-byte record, XOR of the record
+  constexpr uint32_t DRAIN_IDLE_MS = 5;
+
+  enum Category : uint32_t {
+    TC_TRACE   = 1u << 0,   // the log's own events, always on
+    TC_CAN     = 1u << 1,
+    TC_BUTTONS = 1u << 2,
+    TC_MENU    = 1u << 3,
+    TC_HEAP    = 1u << 4,
+  };
+
+  enum Event : uint8_t {
+#define TRACE_ENUM(name, cat, fmt) name,
+    TRACE_EVENTS(TRACE_ENUM)
+#undef TRACE_ENUM
+    TR__COUNT
+  };
+
+  // Little-endian on the wire, as laid out here
+  struct Record {
+    uint32_t us;
+    uint8_t event;
+    uint8_t seq;      // per record written; a gap means records were discarded with no host attached
+    uint16_t a;
+    uint32_t b;
+  };
+  static_assert(sizeof(Record) == 12, "Record is the wire format");
+
+  struct Stats {
+    uint32_t written;
+    uint32_t dropped;     // ring full
+    uint32_t sent;
+    uint32_t discarded;   // drained while no host was attached
+    uint16_t maxDepth;
+  };
+
+  // Starts the drain task; mask selects the categories logged until the host changes it
+  bool begin(uint32_t mask);
+  // loop() only: the ring has a single writer
+  void log(Event e, uint16_t a = 0, uint32_t b = 0);
+  void setMask(uint32_t mask);
+  uint32_t mask();
+  const Stats& stats();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Trace event dictionary: X(name, category, "format").
+// The position in this list is the event's wire ID, so only ever append. tools/trace_decode.py
+// parses this file as its dictionary: keep one entry per line. In a format, {a} and {b} are the
+// 16- and 32-bit args, {alo}/{ahi} the two bytes of a; ":x" prints hex, ":btn" a DashTypes Btn name.
+#define TRACE_EVENTS(X) \
+  X(TR_DROPPED,          TC_TRACE,   "ring full, {b} records lost") \
+  X(TR_CAN_OVERFLOW,     TC_CAN,     "bus{alo} RX overflow count={b} eflg=0x{ahi:x}") \
+  X(TR_CANTX_FAILED,     TC_CAN,     "TX failed id=0x{b:x} attempts={alo} ctrl=0x{ahi:x}") \
+  X(TR_CANTX_TROUBLE,    TC_CAN,     "TX retries={b} full={a}") \
+  X(TR_J1939_TP_ABORT,   TC_CAN,     "J1939 TP aborted count={b}") \
+  X(TR_J1939_TP_TIMEOUT, TC_CAN,     "J1939 TP timeout count={b}") \
+  X(TR_J1939_TP_ORPHAN,  TC_CAN,     "J1939 TP data without session count={b}") \
+  X(TR_J1939_TP_LONG,    TC_CAN,     "J1939 TP message too long count={b}") \
+  X(TR_J1939_TP_SEQ,     TC_CAN,     "J1939 TP bad sequence count={b}") \
+  X(TR_BTN_PRESS,        TC_BUTTONS, "press {a:btn} menuState={b}") \
+  X(TR_BTN_RELEASE,      TC_BUTTONS, "release {a:btn} menuState={b}") \
+  X(TR_BTN_HANDLE,       TC_BUTTONS, "handle {a:btn} menuState={b}") \
+  X(TR_BTN_SETTINGS,     TC_BUTTONS, "cancel hold -> toggle settings") \
+  X(TR_BTN_NEXT_SCREEN,  TC_BUTTONS, "cancel double-tap -> screen {b}") \
+  X(TR_BTN_MINMAX_ON,    TC_BUTTONS, "enter hold -> min/max on") \
+  X(TR_BTN_MINMAX_OFF,   TC_BUTTONS, "enter release -> min/max off") \
+  X(TR_BTN_MINMAX_RESET, TC_BUTTONS, "enter triple-tap -> reset min/max") \
+  X(TR_BTN_QUEUE_FULL,   TC_BUTTONS, "event queue overflows={b} maxDepth={a}") \
+  X(TR_MENU_KEY,         TC_MENU,    "rows drawn={a} max/key={b}") \
+  X(TR_HEAP_ALLOC,       TC_HEAP,    "loop pass allocated {a} times ({b} such passes)") \
+  X(TR_HEAP_LOW,         TC_HEAP,    "largest free block down to {b} bytes, {a} KB free") \
+  X(TR_CAN_FILTER_OPEN,  TC_CAN,     "bus{alo} accept list of {b} IDs does not fit the filters, left open")
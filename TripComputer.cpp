@@ -0,0 +1,196 @@
+#include "TripComputer.h"
+#include "Config.h"
+#include "CanDecode.h"
+#include "ChannelTraits.h"
+
+extern float speedTrimPct;
+
+namespace {
+// One integration clock per source frame (fuel runs on the loop clock)
+enum Clock : uint8_t { CLK_SPEED, CLK_RPM, CLK_GEAR, CLK_EGT, CLK_FUEL, CLOCK_COUNT };
+
+TripLog* g_log = nullptr;
+TripLog g_scratch{};
+
+uint32_t g_lastUs[CLOCK_COUNT];
+bool g_have[CLOCK_COUNT];
+float g_prevSpeed = 0;       // trimmed km/h at the previous speed frame
+float g_prevRpm = 0;
+int g_prevGear = 0;
+uint8_t g_prevConv = 0;
+float g_prevEgt = NAN;
+uint32_t g_carryUs[TRIP_COUNTERS];
+float g_distCarryMm = 0, g_fuelCarryMl = 0;
+
+bool g_running = false;
+unsigned long g_lastCommitMs = 0;
+bool g_pending = false;
+
+inline TripLog& L() { return g_log ? *g_log : g_scratch; }
+
+inline void addAll(uint8_t c, uint32_t n) {
+  for (TripRecord& r : L().rec) r.c[c] += n;
+}
+
+// Whole seconds go to every record; the remainder waits in g_carryUs
+void addTime(uint8_t c, uint32_t us) {
+  g_carryUs[c] += us;
+  if (g_carryUs[c] >= 1000000) {
+    addAll(c, g_carryUs[c] / 1000000);
+    g_carryUs[c] %= 1000000;
+  }
+  g_pending = true;
+}
+
+// Interval since this source's last frame, 0 when the clock has to (re)start
+uint32_t interval(Clock s, uint32_t nowUs) {
+  const uint32_t dt = nowUs - g_lastUs[s];
+  const bool ok = g_have[s] && dt <= Trip::MAX_GAP_US;
+  g_lastUs[s] = nowUs;
+  g_have[s] = true;
+  return ok ? dt : 0;
+}
+
+inline float trimmedSpeed() {
+  float pct = isfinite(speedTrimPct) ? speedTrimPct : 0.0f;
+  if (pct < -50.0f) pct = -50.0f;
+  if (pct > 50.0f) pct = 50.0f;
+  return isfinite(speed_kmh) ? speed_kmh * (1.0f + pct / 100.0f) : 0.0f;
+}
+
+int gearSlot(int g) {
+  if (g >= -3 && g <= -1) return g + 3;          // P, R, N
+  if (g >= 1 && g <= TRIP_GEAR_SLOTS - 3) return g + 2;
+  return -1;
+}
+
+void onSpeed(uint32_t dt) {
+  const float v = trimmedSpeed();
+  if (dt) {
+    // Trapezoid between frames: mm = km/h * us / 3600
+    g_distCarryMm += (g_prevSpeed + v) * 0.5f * dt / 3600.0f;
+    if (g_distCarryMm >= 1000.0f) {
+      const uint32_t m = static_cast<uint32_t>(g_distCarryMm / 1000.0f);
+      addAll(Trip::DIST_M, m);
+      g_distCarryMm -= m * 1000.0f;
+    }
+    if (g_prevSpeed > Trip::MOVING_KMH) addTime(Trip::MOVING_S, dt);
+  }
+  const uint16_t x10 = static_cast<uint16_t>(v * 10.0f > 65535.0f ? 65535 : v * 10.0f);
+  for (TripRecord& r : L().rec) {
+    if (x10 > r.maxSpeedX10) r.maxSpeedX10 = x10;
+  }
+  g_prevSpeed = v;
+}
+
+void onRpm(uint32_t dt) {
+  if (dt && g_prevRpm > Trip::RUN_RPM) addTime(Trip::ENGINE_S, dt);
+  g_prevRpm = isfinite(rpm) ? rpm : 0;
+}
+
+void onGear(uint32_t dt) {
+  if (dt && g_prevRpm > Trip::RUN_RPM) {
+    const int slot = gearSlot(g_prevGear);
+    if (slot >= 0) addTime(Trip::GEAR_S0 + slot, dt);
+    if (g_prevConv < TRIP_CONV_SLOTS) addTime(Trip::CONV_S0 + g_prevConv, dt);
+  }
+  g_prevGear = gear;
+  g_prevConv = static_cast<uint8_t>(g_tcState);
+}
+
+void onEgt(uint32_t dt) {
+  if (dt && isfinite(g_prevEgt) && g_prevEgt >= Trip::HIGH_EGT_C) addTime(Trip::HIGH_EGT_S, dt);
+  const float e1 = isfinite(egt1C) ? egt1C : -1000.0f, e2 = isfinite(egt2C) ? egt2C : -1000.0f;
+  g_prevEgt = e1 > e2 ? e1 : e2;
+}
+}  // namespace
+
+namespace Trip {
+void attach(TripLog& log) {
+  g_log = &log;
+  if (log.fuelChannel > CH__COUNT) log.fuelChannel = CH__COUNT;
+  memset(g_have, 0, sizeof(g_have));
+  memset(g_carryUs, 0, sizeof(g_carryUs));
+  g_distCarryMm = g_fuelCarryMl = 0;
+  g_lastCommitMs = millis();
+  g_pending = false;
+}
+
+void onFrame(const can_frame& f, uint32_t rxUs) {
+  switch (f.can_id) {
+    case CFG::ID_SPEED: onSpeed(interval(CLK_SPEED, rxUs)); break;
+    case CFG::ID_RPM_SPEED: onRpm(interval(CLK_RPM, rxUs)); break;
+    case CFG::ID_GEAR_LOCK: onGear(interval(CLK_GEAR, rxUs)); break;
+    case CFG::ID_EGT1: onEgt(interval(CLK_EGT, rxUs)); break;
+    default: break;
+  }
+}
+
+SaveHint update(unsigned long nowMs) {
+  TripLog& l = L();
+  // Fuel rate comes from a channel, not a frame: integrate it on the loop clock
+  const uint32_t nowUs = micros();
+  const uint32_t dt = interval(CLK_FUEL, nowUs);
+  if (dt && l.fuelChannel < CH__COUNT) {
+    const float lph = Channels::raw(static_cast<Channel>(l.fuelChannel));
+    if (isfinite(lph) && lph > 0) {
+      g_fuelCarryMl += lph * dt / 3600000.0f;   // L/h * us -> mL
+      if (g_fuelCarryMl >= 1.0f) {
+        const uint32_t ml = static_cast<uint32_t>(g_fuelCarryMl);
+        addAll(FUEL_ML, ml);
+        g_fuelCarryMl -= ml;
+        g_pending = true;
+      }
+    }
+  }
+
+  const bool running = isfinite(rpm) && rpm > RUN_RPM;
+  const bool stopped = g_running && !running;
+  g_running = running;
+  if (stopped && g_pending) {
+    g_pending = false;
+    g_lastCommitMs = nowMs;
+    return SAVE_NOW;
+  }
+  if (g_pending && nowMs - g_lastCommitMs >= COMMIT_MS) {
+    g_pending = false;
+    g_lastCommitMs = nowMs;
+    return SAVE_BATCH;
+  }
+  return SAVE_NONE;
+}
+
+void reset(Record r) {
+  L().rec[r] = TripRecord{};
+  g_pending = true;
+}
+
+const TripRecord& record(Record r) { return L().rec[r]; }
+float distanceKm(Record r) { return L().rec[r].c[DIST_M] / 1000.0f; }
+float engineHours(Record r) { return L().rec[r].c[ENGINE_S] / 3600.0f; }
+float avgSpeedKmh(Record r) {
+  const TripRecord& t = L().rec[r];
+  return t.c[MOVING_S] ? t.c[DIST_M] * 3.6f / t.c[MOVING_S] : NAN;
+}
+float maxSpeedKmh(Record r) { return L().rec[r].maxSpeedX10 / 10.0f; }
+float fuelLitres(Record r) { return L().rec[r].c[FUEL_ML] / 1000.0f; }
+
+const char* gearSlotName(uint8_t slot) {
+  static const char* const kNames[TRIP_GEAR_SLOTS] = {"P", "R", "N", "1", "2", "3", "4", "5", "6", "7"};
+  return slot < TRIP_GEAR_SLOTS ? kNames[slot] : "";
+}
+
+float channelValue(Channel ch) {
+  switch (ch) {
+    case CH_TRIP_A_DIST: return distanceKm(TRIP_A);
+    case CH_TRIP_A_AVG: return avgSpeedKmh(TRIP_A);
+    case CH_TRIP_A_TIME: return engineHours(TRIP_A);
+    case CH_TRIP_A_FUEL: return L().fuelChannel < CH__COUNT ? fuelLitres(TRIP_A) : NAN;
+    case CH_TRIP_B_DIST: return distanceKm(TRIP_B);
+    case CH_TRIP_B_AVG: return avgSpeedKmh(TRIP_B);
+    case CH_ODO: return distanceKm(LIFETIME);
+    case CH_ENGINE_HOURS: return engineHours(LIFETIME);
+    default: return NAN;
+  }
+}
+}  // namespace Trip
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+#include "DashTypes.h"
+#include "Persist.h"
+
+// Trip computer: trip A, trip B and lifetime counters.
+// Integration is driven by CAN frame timestamps (onFrame() from the drain), one clock per
+// source frame, holding each value over the interval until its next frame. UI stalls
+// therefore cannot drop or duplicate distance; a gap longer than MAX_GAP_US (bus silent,
+// ignition off) is skipped instead of integrated. Sub-unit remainders stay in RAM; the
+// persisted TripLog is updated in place and committed in batches (see update()).
+namespace Trip {
+  enum Record : uint8_t { TRIP_A, TRIP_B, LIFETIME };
+
+  enum Counter : uint8_t {
+    DIST_M, ENGINE_S, MOVING_S, HIGH_EGT_S, FUEL_ML,
+    GEAR_S0,                                   // P, R, N, 1..7
+    CONV_S0 = GEAR_S0 + TRIP_GEAR_SLOTS,       // per TCState
+    COUNTER_COUNT = CONV_S0 + TRIP_CONV_SLOTS
+  };
+  static_assert(COUNTER_COUNT == TRIP_COUNTERS, "TRIP_COUNTERS out of step with Trip::Counter");
+
+  constexpr float    RUN_RPM        = 400.0f;
+  constexpr float    MOVING_KMH     = 1.0f;
+  constexpr float    HIGH_EGT_C     = 650.0f;
+  constexpr uint32_t MAX_GAP_US     = 1000000;
+  constexpr uint32_t COMMIT_MS      = 600000;   // batch: at most one save per 10 min while running
+
+  enum SaveHint : uint8_t { SAVE_NONE, SAVE_BATCH, SAVE_NOW };
+
+  void attach(TripLog& log);
+  // Per received frame, after the decoders; rxUs = micros() when the frame was read
+  void onFrame(const can_frame& f, uint32_t rxUs);
+  // Once per loop: fuel-rate integration and commit batching. SAVE_NOW on engine stop.
+  SaveHint update(unsigned long nowMs);
+  void reset(Record r);
+
+  const TripRecord& record(Record r);
+  float distanceKm(Record r);
+  float engineHours(Record r);
+  float avgSpeedKmh(Record r);     // NAN before the first moving second
+  float maxSpeedKmh(Record r);
+  float fuelLitres(Record r);
+  const char* gearSlotName(uint8_t slot);
+
+  // Base value for the CH_TRIP_* / CH_ODO / CH_ENGINE_HOURS pills
+  float channelValue(Channel ch);
+}
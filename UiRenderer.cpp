@@ -4,23 +4,24 @@
 #include <Adafruit_ILI9341.h>
 #include <Fonts/FreeSans9pt7b.h>
 #include <Fonts/FreeSans12pt7b.h>
+#include <Fonts/FreeSans18pt7b.h>
+#include <Fonts/FreeSans24pt7b.h>
 #include <math.h>
 #include <string.h>
 
 #include "DashTypes.h"
 #include "ValueConversion.h"
+#include "Layout.h"
+#include "ArcGauge.h"
+#include "ChannelTraits.h"
+#include "Persist.h"
+#include "Config.h"
 
 enum TCState : uint8_t;
 
 extern const int APPBAR_H;
-extern const int BAR_X;
-extern const int BAR_Y;
-extern const int BAR_W;
-extern const int BAR_H;
 extern const int BAR_R;
 
-extern uint8_t g_uLambda;
-extern float battV;
 extern int gear;
 extern int targetgear;
 extern bool headlightsOn;
@@ -30,14 +31,13 @@ extern bool uiWarnBlinkOn;
 extern uint8_t uiHighestWarnLevel;
 extern Channel uiHighestWarnCh;
 extern RegenState regenState;
+extern PersistState persist;
 
-extern Channel currentBarChannel();
-extern Channel currentPillChannel(uint8_t slot);
+extern const ScreenLayout& currentLayout();
 
 extern const char* labelText(Channel ch);
 extern const char* unitLabel(Channel ch);
 extern Range rangeFor(Channel c);
-extern PillSpec pillSpec(int idx);
 extern const char* minMaxSuffixFor(Channel ch);
 extern MinMaxMode minMaxModeFor(Channel ch);
 extern float minMaxDisplayValue(Channel ch);
@@ -50,9 +50,6 @@ extern uint16_t barFillColor();
 extern float clampf(float v,float lo,float hi);
 extern void clearRegion(int x,int y,int w,int h,uint16_t col);
 extern void drawPillFrame(const PillSpec& p, bool sel, Channel ch);
-extern void drawPillLabelForChannel(const PillSpec& p, Channel ch);
-extern void clearPillValue(const PillSpec& p);
-extern void drawValueInPill(const PillSpec& p, const char* num, const char* unit);
 static const char* gearText(int g){
   switch(g){
     case -3: return "P";
@@ -79,12 +76,52 @@ extern uint16_t COL_RED();
 
 static Adafruit_ILI9341* s_tft = nullptr;
 static const Palette* s_palette = nullptr;
-
-static Channel prevBarChannel = CH__COUNT;
-static int prevBarFillW = -1;
-static int prevPillValueKey[4] = {INT32_MIN,INT32_MIN,INT32_MIN,INT32_MIN};
-static Channel prevPillChannel[4] = {CH__COUNT,CH__COUNT,CH__COUNT,CH__COUNT};
-static uint8_t prevPillWarnLevel[4] = {0,0,0,0};
+static void (*s_service)() = nullptr;   // setRenderService()
+
+// One entry per cell of the active layout template. Fonts and the value baseline are fitted
+// when the widget's channel is assigned; the prev* fields hold what is currently on screen.
+struct Widget {
+  PillSpec r;
+  Layout::WidgetKind kind;
+  Channel ch;
+  const GFXfont* labelFont;   // nullptr = built-in 6x8 font
+  const GFXfont* valueFont;
+  const GFXfont* unitFont;
+  uint8_t valueSize;          // text size multiplier for valueFont
+  int16_t baseY;              // value baseline
+  int16_t vx, vy, vw, vh;     // value box; text is left-aligned in pills, centred in dials
+  int16_t labelY;             // dial label baseline
+  ArcGauge::Geometry dial;
+  int prevKey;
+  int prevAux;                // gear: target gear drawn
+  int prevValueX;
+  int prevValueW;             // width of the drawn value text, -1 = unknown (clear whole box)
+  int prevFillW;              // bar fill width, -1 = not drawn
+  uint16_t prevFillCol;
+  int16_t prevStep;           // dial needle step, ArcGauge::NO_NEEDLE = not drawn
+  uint8_t prevWarn;
+  uint8_t dirty;
+};
+
+enum : uint8_t { DIRTY_FRAME = 1, DIRTY_LABEL = 2, DIRTY_VALUE = 4 };
+
+static Widget s_widgets[LAYOUT_MAX_WIDGETS];
+static uint8_t s_widgetCount = 0;
+static uint8_t s_tpl = LT__COUNT;
+static uint8_t s_titleSlot = 0;
+
+// Channel watch: the key/warning level each channel had when its dependents were last marked.
+// A channel that changes marks only the widgets in s_chWidgets[ch] (and the title when it is
+// shown there), so an idle frame is one compare per channel and no SPI traffic.
+static_assert(LAYOUT_MAX_WIDGETS <= 16, "s_chWidgets holds one bit per widget slot");
+static int s_chKey[CH__COUNT];
+static uint8_t s_chWarn[CH__COUNT];
+static uint16_t s_chWidgets[CH__COUNT];
+static bool s_titleDirty = true;
+static uint8_t s_resumeSlot = 0;      // first slot tried next frame, so deferred work is not starved
+static RenderStats s_stats{};
+static uint32_t s_windowStartMs = 0;
+static uint16_t s_windowFrames = 0, s_windowTicks = 0, s_windowWidgets = 0;
 
 static char g_prevTitle[64] = "";
 static uint16_t g_prevTitleColor = 0;
@@ -157,267 +194,596 @@ static void setTitleWithSuffixIfChanged(const char* text, const char* suffix, ui
   s_tft->setFont();
 }
 
-static void drawBarStatic(bool sel){
-  Channel ch = currentBarChannel();
-  uint16_t fc = sel ? COL_YELLOW() : COL_FRAME();
-  s_tft->fillRoundRect(BAR_X-2,BAR_Y-2,BAR_W+4,BAR_H+4,BAR_R+2,COL_CARD());
-  s_tft->drawRoundRect(BAR_X,BAR_Y,BAR_W,BAR_H,BAR_R,fc);
-  auto tick=[&](int x,float v,const char* u){ char b[24];
-    if(ch==CH_BATTV) snprintf(b,sizeof(b),"%.1f",v);
-    else if(ch==CH_BATTV2 || ch==CH_DCDC_OUT_V || ch==CH_DCDC_IN_V) snprintf(b,sizeof(b),"%.2f",v);
-    else if(u&&u[0]=='V') snprintf(b,sizeof(b),"%.2f",v);
-    else if(ch==CH_LAMBDA){
-      if(g_uLambda==U_L_lambda) snprintf(b,sizeof(b),"%.2f",v);
-      else snprintf(b,sizeof(b),"%.1f",v);
-    }
-    else if(u && (u[0]=='k' || u[0]=='p')) snprintf(b,sizeof(b),"%.0f",v);
-    else snprintf(b,sizeof(b),"%.0f",v);
-    s_tft->setFont(&FreeSans12pt7b); s_tft->setTextColor(COL_TICKS(),COL_BG()); s_tft->setCursor(x,BAR_Y-6); s_tft->print(b); s_tft->setFont(); };
-  Range r=rangeFor(ch); float mid=(r.mn+r.mx)/2; clearRegion(0,BAR_Y-20,320,18,COL_BG());
-  char tmp[16]; if(ch==CH_LAMBDA && g_uLambda==U_L_lambda) snprintf(tmp,sizeof(tmp),"%.2f", mid); else snprintf(tmp,sizeof(tmp),"%.0f", mid);
-  int16_t x1,y1; uint16_t w,h; s_tft->setFont(&FreeSans12pt7b); s_tft->getTextBounds(tmp,0,0,&x1,&y1,&w,&h); s_tft->setFont();
-  tick(BAR_X,r.mn,unitLabel(ch)); tick(BAR_X+BAR_W/2-(int)w/2,mid,unitLabel(ch));
-  if(ch==CH_LAMBDA && g_uLambda==U_L_lambda) snprintf(tmp,sizeof(tmp),"%.2f", r.mx); else snprintf(tmp,sizeof(tmp),"%.0f", r.mx);
-  s_tft->setFont(&FreeSans12pt7b); s_tft->getTextBounds(tmp,0,0,&x1,&y1,&w,&h); s_tft->setFont();
-  tick(BAR_X+BAR_W-(int)w-4,r.mx,unitLabel(ch)); prevBarFillW=-1;
-}
-
-static void drawGridStatic(){
-  for(int i=0;i<4;i++){
-    PillSpec p = pillSpec(i);
-    s_tft->fillRoundRect(p.x, p.y, p.w, p.h, 10, COL_CARD());
+static constexpr int PILL_VALUE_TOP = 25;   // value area starts below the label line
+
+struct FontChoice { const GFXfont* font; uint8_t size; };
+// Largest first; x2 scaling of the 24pt face is only reachable by the big-number cells
+static const FontChoice kValueFonts[] = {
+  {&FreeSans24pt7b, 2}, {&FreeSans24pt7b, 1}, {&FreeSans18pt7b, 1}, {&FreeSans12pt7b, 1}, {&FreeSans9pt7b, 1},
+};
+
+static int textWidth(const GFXfont* f, const char* s){
+  if(!f) return 6 * (int)strlen(s);
+  int w = 0;
+  for(; *s; s++){
+    uint8_t c = (uint8_t)*s;
+    if(c < f->first || c > f->last) continue;
+    w += f->glyph[c - f->first].xAdvance;
+  }
+  return w;
+}
+static int digitHeight(const GFXfont* f){ return f->glyph['8' - f->first].height; }
+static const GFXfont* unitFontFor(const GFXfont* valueFont){
+  return (valueFont == &FreeSans9pt7b) ? &FreeSans9pt7b : &FreeSans12pt7b;
+}
+static int unitGap(const GFXfont* valueFont){ return (valueFont == &FreeSans9pt7b) ? 4 : 8; }
+
+// Widest value text the channel is expected to show
+static void sampleText(Channel ch, char* out, size_t n){
+  switch(ch){
+    case CH_GEAR: snprintf(out, n, "8>8"); return;
+    case CH_LOCKUP: snprintf(out, n, "Changing"); return;
+    case CH_HEADLIGHTS: snprintf(out, n, "Off"); return;
+    default: break;
   }
+  Range r = rangeFor(ch);
+  char lo[16], hi[16];
+  formatDisplayValue(ch, r.mn, lo, sizeof(lo));
+  formatDisplayValue(ch, r.mx, hi, sizeof(hi));
+  snprintf(out, n, "%s", strlen(lo) > strlen(hi) ? lo : hi);
+}
 
-  for(int i=0;i<4;i++){
-    Channel ch = currentPillChannel(i);
-    drawPillFrame(pillSpec(i), false, ch);
-    drawPillLabelForChannel(pillSpec(i), ch);
-    prevPillChannel[i]  = ch;
-    prevPillValueKey[i] = INT32_MIN;
-    prevPillWarnLevel[i]= 0;
+static bool hasUnit(Channel ch){ return ch != CH_GEAR && ch != CH_LOCKUP && ch != CH_HEADLIGHTS; }
+
+static int valueWidth(const FontChoice& fc, const char* sample, const char* unit){
+  int width = textWidth(fc.font, sample) * fc.size;
+  if(unit[0]) width += unitGap(fc.font) + textWidth(unitFontFor(fc.font), unit);
+  return width;
+}
+
+static void applyFont(Widget& w, const FontChoice& fc){
+  w.valueFont = fc.font;
+  w.valueSize = fc.size;
+  w.unitFont  = unitFontFor(fc.font);
+}
+
+static const FontChoice& smallestFont(){ return kValueFonts[sizeof(kValueFonts)/sizeof(kValueFonts[0]) - 1]; }
+
+// Dials: label at the bottom of the opening, value in the wedge above it. The wedge is the
+// 120 degree gap the needle never enters (|dx| < dy * tan 60), so value redraws never touch it.
+static void fitDial(Widget& w, const char* sample, const char* unit){
+  const PillSpec& p = w.r;
+  ArcGauge::Geometry& d = w.dial;
+  d = ArcGauge::geometryFor(p.x, p.y, p.w, p.h);
+
+  w.labelFont = (textWidth(&FreeSans9pt7b, labelText(w.ch)) <= d.r + d.r / 2) ? &FreeSans9pt7b : nullptr;
+  w.labelY = (int16_t)min(d.cy + d.r * 9 / 10, p.y + p.h - 6);
+  const int labelTop = w.labelY - (w.labelFont ? 13 : 0);
+  const int bottom = labelTop - 3 - d.cy;          // value box must end above this (offset from cy)
+  const int maxHalf = d.r - 30;                    // keep clear of the min/max tick labels
+
+  const FontChoice* pick = &smallestFont();
+  int top = d.hub + 4, width = valueWidth(*pick, sample, unit);
+  for(const FontChoice& fc : kValueFonts){
+    const int wdt = valueWidth(fc, sample, unit);
+    const int half = wdt / 2 + 3;
+    const int t = max(d.hub + 4, (half * 100 + 172) / 173);
+    if(half <= maxHalf && t + digitHeight(fc.font) * fc.size <= bottom){ pick = &fc; top = t; width = wdt; break; }
   }
+  applyFont(w, *pick);
+  const int dh = digitHeight(pick->font) * pick->size;
+  w.vx = (int16_t)(d.cx - width / 2 - 2);
+  w.vw = (int16_t)(width + 4);
+  w.vy = (int16_t)(d.cy + top);
+  w.vh = (int16_t)(dh + 2);
+  w.baseY = (int16_t)(d.cy + top + dh);
+}
 
-  prevBarChannel = currentBarChannel();
-  prevBarFillW   = -1;
-  drawBarStatic(false);
+// Pick label/value fonts and the value box for the widget's cell and channel
+static void fitWidget(Widget& w){
+  w.prevValueW = -1;
+  if(w.kind == Layout::WK_BAR) return;
+
+  char sample[24]; sampleText(w.ch, sample, sizeof(sample));
+  const char* unit = hasUnit(w.ch) ? unitLabel(w.ch) : "";
+  if(w.kind == Layout::WK_DIAL){ fitDial(w, sample, unit); return; }
+
+  const char* suffix = uiMinMaxActive ? minMaxSuffixFor(w.ch) : "";
+  int labelW = textWidth(&FreeSans9pt7b, labelText(w.ch));
+  if(suffix[0]) labelW += 4 + textWidth(&FreeSans9pt7b, suffix);
+  w.labelFont = (labelW <= w.r.w - 16) ? &FreeSans9pt7b : nullptr;
+
+  w.vx = (int16_t)(w.r.x + 6);
+  w.vy = (int16_t)(w.r.y + PILL_VALUE_TOP);
+  w.vw = (int16_t)(w.r.w - 12);
+  w.vh = (int16_t)(w.r.h - PILL_VALUE_TOP - 4);
+  const int maxW = w.r.w - 20;
+  const FontChoice* pick = &smallestFont();
+  for(const FontChoice& fc : kValueFonts){
+    if(digitHeight(fc.font) * fc.size <= w.vh - 4 && valueWidth(fc, sample, unit) <= maxW){ pick = &fc; break; }
+  }
+  applyFont(w, *pick);
+  const int dh = digitHeight(pick->font) * pick->size;
+  const int centred = w.vy + (w.vh + dh) / 2;
+  w.baseY = (int16_t)min(centred, w.r.y + w.r.h - 10);
 }
 
-static void fmtValueForTitle(Channel ch, char* out, size_t n){
-  if(ch==CH_BATTV) {
-    snprintf(out, n, "%.1f %s", battV, unitLabel(ch));
-  } else if(ch==CH_LAMBDA){
-    float v = valueDisplay(CH_LAMBDA);
-    if(g_uLambda==U_L_lambda) snprintf(out,n,"%.2f %s", v, unitLabel(ch));
-    else snprintf(out,n,"%.1f %s", v, unitLabel(ch));
+static void drawLabel(const Widget& w){
+  const PillSpec& p = w.r;
+  const char* label = labelText(w.ch);
+  const char* suffix = uiMinMaxActive ? minMaxSuffixFor(w.ch) : "";
+  clearRegion(p.x+6, p.y+4, p.w-12, PILL_VALUE_TOP-4, COL_CARD());
+  s_tft->setTextColor(COL_TXT(), COL_CARD());
+  if(w.labelFont){
+    s_tft->setFont(w.labelFont);
+    s_tft->setCursor(p.x+10, p.y+17);
+    s_tft->print(label);
+    if(suffix[0]){
+      s_tft->setCursor(p.x+10 + textWidth(w.labelFont, label) + 4, p.y+16);
+      s_tft->print(suffix);
+    }
   } else {
-    float vv = valueDisplay(ch);
-    if(isfinite(vv)) {
-      if(ch==CH_BATTV) snprintf(out,n,"%.2f %s", vv, unitLabel(ch));
-      else snprintf(out, n, "%.0f %s", vv, unitLabel(ch));
-    } else snprintf(out, n, "--");
+    s_tft->setFont();
+    s_tft->setCursor(p.x+8, p.y+9);
+    s_tft->print(label);
+    if(suffix[0] && textWidth(nullptr, label) + 6 + textWidth(nullptr, suffix) <= p.w - 16){
+      s_tft->print(' ');
+      s_tft->print(suffix);
+    }
   }
+  s_tft->setFont();
 }
 
-static void refreshPillsDynamic(){
-  static int prevRenderedTargetGear[4] = {INT32_MIN,INT32_MIN,INT32_MIN,INT32_MIN};
+// Clears only the extent of the previously drawn text, so cost follows the text, not the cell
+static void drawValueText(Widget& w, const char* num, const char* unit, uint16_t col){
+  const bool centred = (w.kind == Layout::WK_DIAL);
+  int width = textWidth(w.valueFont, num) * w.valueSize;
+  if(unit && unit[0]) width += unitGap(w.valueFont) + textWidth(w.unitFont, unit);
 
-  for(int i=0;i<4;i++){
-    PillSpec p = pillSpec(i);
-    Channel ch = currentPillChannel(i);
+  int cx0 = w.vx, cx1 = w.vx + w.vw;
+  if(w.prevValueW >= 0){
+    cx0 = max(cx0, w.prevValueX - 4);
+    cx1 = min(cx1, w.prevValueX + w.prevValueW + 4);
+  }
+  clearRegion(cx0, w.vy, cx1 - cx0, w.vh, COL_CARD());
+
+  const int x = centred ? (w.vx + (w.vw - width) / 2) : (w.vx + 4);
+  s_tft->setFont(w.valueFont);
+  s_tft->setTextSize(w.valueSize);
+  s_tft->setTextColor(col, COL_CARD());
+  s_tft->setCursor(x, w.baseY);
+  s_tft->print(num);
+  s_tft->setTextSize(1);
+  if(unit && unit[0]){
+    s_tft->setFont(w.unitFont);
+    s_tft->setCursor(x + textWidth(w.valueFont, num) * w.valueSize + unitGap(w.valueFont), w.baseY);
+    s_tft->print(unit);
+  }
+  s_tft->setFont();
+  w.prevValueX = x;
+  w.prevValueW = width;
+}
 
-    if(ch!=prevPillChannel[i]){
-      clearRegion(p.x+6,p.y+4,p.w-12,24,COL_CARD());
-      drawPillLabelForChannel(p, ch);
-      prevPillChannel[i]=ch;
-      prevPillValueKey[i]=INT32_MIN;
-      prevRenderedTargetGear[i]=INT32_MIN;
-      drawPillFrame(p,false,ch);
-    }
+static int pillKey(Channel ch){
+  if(uiMinMaxActive && minMaxModeFor(ch) != MINMAX_NONE) return valueKeyForDisplay(ch, minMaxDisplayValue(ch));
+  return valueKey(ch);
+}
 
-    int key = valueKey(ch);
+static void drawPillValue(Widget& w){
+  const Channel ch = w.ch;
+  char nb[16];
+  const char* unit = "";
+  uint16_t col = COL_TXT();
+  if(uiMinMaxActive && minMaxModeFor(ch) != MINMAX_NONE){
+    formatDisplayValue(ch, minMaxDisplayValue(ch), nb, sizeof(nb));
+    unit = unitLabel(ch);
+  } else if(ch == CH_GEAR){
+    if(gear>0 && gear<=9 && targetgear>0 && targetgear<=9 && gear!=targetgear) snprintf(nb, sizeof(nb), "%d>%d", gear, targetgear);
+    else snprintf(nb, sizeof(nb), "%s", gearText(gear));
+    w.prevAux = targetgear;
+  } else if(ch == CH_LOCKUP){
+    snprintf(nb, sizeof(nb), "%s", tcStateText(g_tcState));
+    col = tcStateColor(g_tcState);
+  } else if(ch == CH_HEADLIGHTS){
+    snprintf(nb, sizeof(nb), "%s", headlightsOn ? "On" : "Off");
+  } else {
+    formatDisplayValue(ch, valueDisplay(ch), nb, sizeof(nb));
+    unit = unitLabel(ch);
+  }
+  drawValueText(w, nb, unit, col);
+}
 
-    if(uiMinMaxActive && minMaxModeFor(ch) != MINMAX_NONE){
-      float dispValue = minMaxDisplayValue(ch);
-      int mmKey = valueKeyForDisplay(ch, dispValue);
-      if(mmKey == prevPillValueKey[i]) continue;
+static void drawBarStatic(Widget& w, bool sel){
+  const PillSpec& r = w.r;
+  const Channel ch = w.ch;
+  uint16_t fc = sel ? COL_YELLOW() : COL_FRAME();
+  s_tft->fillRoundRect(r.x-2,r.y-2,r.w+4,r.h+4,BAR_R+2,COL_CARD());
+  s_tft->drawRoundRect(r.x,r.y,r.w,r.h,BAR_R,fc);
+
+  Range rg = rangeFor(ch);
+  char lo[16], mid[16], hi[16];
+  formatDisplayValue(ch, rg.mn, lo, sizeof(lo));
+  formatDisplayValue(ch, (rg.mn + rg.mx) / 2, mid, sizeof(mid));
+  formatDisplayValue(ch, rg.mx, hi, sizeof(hi));
+  clearRegion(r.x-2, r.y-20, r.w+4, 18, COL_BG());
+  s_tft->setFont(&FreeSans12pt7b);
+  s_tft->setTextColor(COL_TICKS(), COL_BG());
+  auto tick = [&](int x, const char* s){ s_tft->setCursor(x, r.y-6); s_tft->print(s); };
+  tick(r.x, lo);
+  tick(r.x + r.w/2 - textWidth(&FreeSans12pt7b, mid)/2, mid);
+  tick(r.x + r.w - textWidth(&FreeSans12pt7b, hi) - 4, hi);
+  s_tft->setFont();
+  w.prevFillW = -1;
+}
 
-      char nb[16];
-      formatDisplayValue(ch, dispValue, nb, sizeof(nb));
-      drawValueInPill(p, nb, unitLabel(ch));
+static float gaugeValue(Channel ch){ return uiMinMaxActive ? minMaxDisplayValue(ch) : valueDisplay(ch); }
+
+// Bars redraw only the strip between the old and new fill edge
+static void updateBar(Widget& w, uint8_t lvl){
+  const uint16_t col = (lvl == 2) ? COL_RED() : (lvl == 1) ? COL_ORANGE() : barFillColor();
+  Range r = rangeFor(w.ch); if (r.mx <= r.mn) r.mx = r.mn + 1;
+  float v = gaugeValue(w.ch);
+  float t = clampf((v - r.mn) / (r.mx - r.mn), 0, 1);
+  int innerW = w.r.w - 4, innerH = w.r.h - 4, x0 = w.r.x + 2, y0 = w.r.y + 2;
+  int fillW = (int)roundf(t * innerW);
+  if (fillW < 0) fillW = 0; else if (fillW > innerW) fillW = innerW;
+
+  if (w.prevFillW < 0) {
+    s_tft->fillRect(x0, y0, innerW, innerH, COL_CARD());
+    if (fillW > 0) s_tft->fillRect(x0, y0, fillW, innerH, col);
+  } else {
+    if (fillW > w.prevFillW) s_tft->fillRect(x0 + w.prevFillW, y0, fillW - w.prevFillW, innerH, col);
+    else if (fillW < w.prevFillW) s_tft->fillRect(x0 + fillW, y0, w.prevFillW - fillW, innerH, COL_CARD());
+    if (col != w.prevFillCol && fillW > 0) s_tft->fillRect(x0, y0, fillW, innerH, col);
+  }
+  w.prevFillW = fillW;
+  w.prevFillCol = col;
+}
 
-      prevPillValueKey[i] = mmKey;
-      continue;
-    }
+static uint16_t warnColour(uint8_t lvl, uint16_t normal){
+  return (lvl == 2) ? COL_RED() : (lvl == 1) ? COL_ORANGE() : normal;
+}
 
-    if(ch==CH_GEAR){
-      bool targetChanged = (targetgear != prevRenderedTargetGear[i]);
-      if(!targetChanged && key==prevPillValueKey[i]){
-      } else {
-        clearPillValue(p);
-        s_tft->setFont(&FreeSans12pt7b);
-        s_tft->setTextColor(COL_TXT(),COL_CARD());
-        s_tft->setCursor(p.x+10,p.y+p.h-10);
-        if(gear>0 && gear<=9 && targetgear>0 && targetgear<=9 && gear!=targetgear){
-          char b[8]; snprintf(b,sizeof(b), "%d>%d", gear, targetgear); s_tft->print(b);
-        }else{
-          s_tft->print(gearText(gear));
-        }
-        s_tft->setFont();
-
-        prevPillValueKey[i]        = key;
-        prevRenderedTargetGear[i]  = targetgear;
-      }
-      continue;
-    }
+static uint16_t dialStep(Channel ch){
+  Range r = rangeFor(ch); if (r.mx <= r.mn) r.mx = r.mn + 1;
+  return ArcGauge::stepFor((gaugeValue(ch) - r.mn) / (r.mx - r.mn));
+}
 
-    if(key==prevPillValueKey[i]) continue;
+// Warning thresholds as thin rings inside the band (thresholds are stored in base units)
+static void drawDialZones(const Widget& w){
+  const uint8_t mode = persist.warnMode[w.ch];
+  if(mode == CFG::WARN_OFF) return;
+  Range r = rangeFor(w.ch); if (r.mx <= r.mn) r.mx = r.mn + 1;
+  auto step = [&](float base){ return ArcGauge::stepFor((Channels::toDisplay(w.ch, base) - r.mn) / (r.mx - r.mn)); };
+  const uint16_t s1 = step(persist.warnT1[w.ch]), s2 = step(persist.warnT2[w.ch]);
+  const ArcGauge::Geometry& d = w.dial;
+  if(mode == CFG::WARN_HIGH){
+    ArcGauge::fillArc(*s_tft, d, d.zoneIn, d.bandIn - 1, s1, s2, COL_ORANGE());
+    ArcGauge::fillArc(*s_tft, d, d.zoneIn, d.bandIn - 1, s2, ArcGauge::SWEEP_STEPS, COL_RED());
+  } else {
+    ArcGauge::fillArc(*s_tft, d, d.zoneIn, d.bandIn - 1, 0, s2, COL_RED());
+    ArcGauge::fillArc(*s_tft, d, d.zoneIn, d.bandIn - 1, s2, s1, COL_ORANGE());
+  }
+}
 
-    if (ch == CH_LOCKUP) {
-      clearPillValue(p);
-      s_tft->setFont(&FreeSans12pt7b);
-      s_tft->setTextColor(tcStateColor(g_tcState), COL_CARD());
-      s_tft->setCursor(p.x + 10, p.y + p.h - 10);
-      s_tft->print(tcStateText(g_tcState));
-      s_tft->setFont();
-    }
+// Everything except the needle and value: drawn once per channel/layout change
+static void drawDialStatic(Widget& w, bool sel){
+  const PillSpec& p = w.r;
+  const ArcGauge::Geometry& d = w.dial;
+  s_tft->fillRoundRect(p.x, p.y, p.w, p.h, 10, COL_CARD());
+  drawPillFrame(p, sel, w.ch);
+
+  w.prevWarn = warnLevelFor(w.ch);
+  ArcGauge::fillArc(*s_tft, d, d.bandIn, d.r, 0, ArcGauge::SWEEP_STEPS, warnColour(w.prevWarn, barFillColor()));
+  drawDialZones(w);
+  ArcGauge::drawTicks(*s_tft, d, 4, COL_TICKS());
+  ArcGauge::drawHub(*s_tft, d, COL_TXT());
+
+  Range rg = rangeFor(w.ch);
+  char lo[16], hi[16];
+  formatDisplayValue(w.ch, rg.mn, lo, sizeof(lo));
+  formatDisplayValue(w.ch, rg.mx, hi, sizeof(hi));
+  const int tickY = d.cy + d.r / 2 + 4;
+  s_tft->setFont();
+  s_tft->setTextColor(COL_TICKS(), COL_CARD());
+  s_tft->setCursor(d.cx - d.r + 2, tickY); s_tft->print(lo);
+  s_tft->setCursor(d.cx + d.r - 2 - textWidth(nullptr, hi), tickY); s_tft->print(hi);
+
+  const char* label = labelText(w.ch);
+  s_tft->setTextColor(COL_TXT(), COL_CARD());
+  if(w.labelFont){
+    s_tft->setFont(w.labelFont);
+    s_tft->setCursor(d.cx - textWidth(w.labelFont, label) / 2, w.labelY);
+  } else {
+    s_tft->setCursor(d.cx - textWidth(nullptr, label) / 2, w.labelY - 8);
+  }
+  s_tft->print(label);
+  s_tft->setFont();
 
-    else if(ch==CH_HEADLIGHTS){
-      clearPillValue(p);
-      s_tft->setFont(&FreeSans12pt7b);
-      s_tft->setTextColor(COL_TXT(),COL_CARD());
-      s_tft->setCursor(p.x+10,p.y+p.h-10);
-      s_tft->print(headlightsOn?"On":"Off");
-      s_tft->setFont();
-    }
-    else{
-      float v = valueDisplay(ch);
-      char nb[16];
-      formatDisplayValue(ch, v, nb, sizeof(nb));
-      drawValueInPill(p,nb,unitLabel(ch));
-    }
+  w.prevStep = ArcGauge::NO_NEEDLE;
+  w.prevValueW = -1;
+}
 
-    prevPillValueKey[i] = key;
+// Needle moves by spans; a warning change repaints only the band
+static void updateDial(Widget& w, uint8_t lvl){
+  if(lvl != w.prevWarn){
+    ArcGauge::fillArc(*s_tft, w.dial, w.dial.bandIn, w.dial.r, 0, ArcGauge::SWEEP_STEPS, warnColour(lvl, barFillColor()));
+    w.prevWarn = lvl;
   }
+  const uint16_t step = dialStep(w.ch);
+  if((int16_t)step != w.prevStep){
+    ArcGauge::moveNeedle(*s_tft, w.dial, w.prevStep, step, COL_TXT(), COL_CARD());
+    w.prevStep = (int16_t)step;
+  }
+}
 
-  Channel barCh = currentBarChannel();
-  if (barCh != prevBarChannel) { drawBarStatic(false); prevBarChannel = barCh; }
-
-  static uint16_t s_prevBarColor = 0;
-  {
-    uint8_t barLvl = warnLevelFor(barCh);
-    uint16_t barCol =
-      (barLvl == 2) ? COL_RED() :
-      (barLvl == 1) ? COL_ORANGE() :
-                     barFillColor();
-
-    Range r = rangeFor(barCh); if (r.mx <= r.mn) r.mx = r.mn + 1;
-    float v = uiMinMaxActive ? minMaxDisplayValue(barCh) : valueDisplay(barCh);
-    float t = clampf((v - r.mn) / (r.mx - r.mn), 0, 1);
-    int innerW = BAR_W - 4, innerH = BAR_H - 4, x0 = BAR_X + 2, y0 = BAR_Y + 2;
-    int fillW = (int)roundf(t * innerW);
-    if (fillW < 0) fillW = 0; else if (fillW > innerW) fillW = innerW;
-
-    if (prevBarFillW < 0) {
-      s_tft->fillRect(x0, y0, innerW, innerH, COL_CARD());
-      if (fillW > 0) s_tft->fillRect(x0, y0, fillW, innerH, barCol);
-      prevBarFillW = fillW;
-      s_prevBarColor = barCol;
-    } else {
-      if (fillW > prevBarFillW) {
-        int dx = fillW - prevBarFillW;
-        if (dx > 0) s_tft->fillRect(x0 + prevBarFillW, y0, dx, innerH, barCol);
-      }
-      else if (fillW < prevBarFillW) {
-        int dx = prevBarFillW - fillW;
-        if (dx > 0) s_tft->fillRect(x0 + fillW, y0, dx, innerH, COL_CARD());
-      }
-
-      if (barCol != s_prevBarColor && fillW > 0) {
-        s_tft->fillRect(x0, y0, fillW, innerH, barCol);
-      }
-
-      prevBarFillW = fillW;
-      s_prevBarColor = barCol;
-    }
+static void initWidget(Widget& w, const Layout::Cell& c, Channel ch){
+  w.r = Layout::rect(c);
+  w.kind = c.kind;
+  w.ch = ch;
+  fitWidget(w);
+  w.prevKey = INT32_MIN;
+  w.prevAux = INT32_MIN;
+  w.prevFillW = -1;
+  w.prevFillCol = 0;
+  w.prevStep = ArcGauge::NO_NEEDLE;
+  w.prevWarn = 0;
+  w.dirty = DIRTY_FRAME | DIRTY_LABEL | DIRTY_VALUE;
+}
+
+static void buildWidgets(const ScreenLayout& l){
+  const Layout::Template& t = Layout::get(l.tpl);
+  s_tpl = l.tpl;
+  s_widgetCount = t.count;
+  s_titleSlot = Layout::titleSlot(l.tpl);
+  for(uint8_t i=0;i<t.count;i++) initWidget(s_widgets[i], t.cells[i], (Channel)l.ch[i]);
+}
+
+// Cards and bar outlines/ticks; frames, labels and values follow from the dirty pass
+static void drawStaticLayer(){
+  for(uint8_t i=0;i<s_widgetCount;i++){
+    Widget& w = s_widgets[i];
+    if(w.kind == Layout::WK_BAR) drawBarStatic(w, false);
+    else if(w.kind == Layout::WK_DIAL) drawDialStatic(w, false);
+    else s_tft->fillRoundRect(w.r.x, w.r.y, w.r.w, w.r.h, 10, COL_CARD());
   }
+}
+
+static void fmtValueForTitle(Channel ch, char* out, size_t n){
+  char nb[16];
+  formatDisplayValue(ch, valueDisplay(ch), nb, sizeof(nb));
+  snprintf(out, n, "%s %s", nb, unitLabel(ch));
+}
+
+// Warning round-robin state; the warning set itself comes from the channel watch
+static_assert(CH__COUNT <= 64, "warning sets hold one bit per channel");
+static uint64_t s_critSet = 0, s_warnSet = 0;
+static uint8_t s_warnTotal = 0;
+static uint8_t s_rrIndex = 0;
+static unsigned long s_rrCycleMs = 0;
+static constexpr unsigned long WARN_CYCLE_MS = 1500;
 
+static void refreshTitle(Channel titleCh){
   if(uiMinMaxActive){
-    setTitleWithSuffixIfChanged(labelText(barCh), minMaxSuffixFor(barCh), COL_TXT());
-  } else {
-    uiHighestWarnLevel = 0;
-    uiHighestWarnCh    = CH__COUNT;
+    setTitleWithSuffixIfChanged(labelText(titleCh), minMaxSuffixFor(titleCh), COL_TXT());
+    return;
+  }
+  uiHighestWarnCh = CH__COUNT;
+
+  uint8_t critList[CH__COUNT];  uint8_t critCnt = 0;
+  uint8_t warnList[CH__COUNT];  uint8_t warnCnt = 0;
+  for (int ch = 0; ch < CH__COUNT; ++ch) {
+    if (s_chWarn[ch] == 2) critList[critCnt++] = (uint8_t)ch;
+    else if (s_chWarn[ch] == 1) warnList[warnCnt++] = (uint8_t)ch;
+  }
 
-    uint8_t critList[CH__COUNT];  uint8_t critCnt = 0;
-    uint8_t warnList[CH__COUNT];  uint8_t warnCnt = 0;
+  const uint8_t total = critCnt + warnCnt;
+  unsigned long now = millis();
 
-    uint64_t critMask = 0, warnMask = 0;
+  if (total > 0) {
+    if (now - s_rrCycleMs >= WARN_CYCLE_MS) { s_rrCycleMs = now; ++s_rrIndex; }
+    uint8_t i = s_rrIndex % total;
 
-    for (int ch = 0; ch < CH__COUNT; ++ch) {
-      uint8_t lvl = warnLevelFor((Channel)ch);
-      if (!lvl) continue;
+    uint8_t showChIdx, showLvl;
+    if (i < critCnt) { showChIdx = critList[i];           showLvl = 2; }
+    else             { showChIdx = warnList[i - critCnt]; showLvl = 1; }
 
-      if (lvl == 2) { critList[critCnt++] = (uint8_t)ch; critMask |= (1ULL << ch); }
-      else          { warnList[warnCnt++] = (uint8_t)ch; warnMask |= (1ULL << ch); }
+    uiHighestWarnCh = (Channel)showChIdx;
 
-      if (lvl > uiHighestWarnLevel) uiHighestWarnLevel = lvl;
+    char val[24]; fmtValueForTitle((Channel)uiHighestWarnCh, val, sizeof(val));
+    char ttl[64];
+    snprintf(ttl, sizeof(ttl), "WARNING: %s %s",
+             labelText((Channel)uiHighestWarnCh), val);
+
+    setTitleIfChanged(ttl, (showLvl == 2) ? COL_RED() : COL_ORANGE());
+  }
+  else {
+    if (regenState == REGEN_PAUSED) {
+      setTitleIfChanged("REGEN INCOMPLETE", COL_TXT());
+    } else if (regenState == REGEN_ACTIVE) {
+      setTitleIfChanged("REGEN ACTIVE", COL_TXT());
+    } else {
+      setTitleIfChanged(labelText(titleCh), COL_TXT());
     }
+  }
+}
 
-    const uint8_t total = critCnt + warnCnt;
+static Channel titleChannel(){ return s_widgetCount ? s_widgets[s_titleSlot].ch : CH_SOOT; }
 
-    unsigned long now = millis();
-    uint64_t sig = (critMask << 32) ^ warnMask;
-    static uint8_t rrIndex = 0;
-    static unsigned long lastCycleMs = 0;
-    static uint64_t prevSig = 0;
-    if (sig != prevSig) { prevSig = sig; rrIndex = 0; lastCycleMs = now; }
+static void rebuildDependents(){
+  memset(s_chWidgets, 0, sizeof(s_chWidgets));
+  for(uint8_t i=0;i<s_widgetCount;i++) s_chWidgets[s_widgets[i].ch] |= (uint16_t)(1u << i);
+}
 
-    if (total > 0) {
-      if (now - lastCycleMs >= 1500) { lastCycleMs = now; ++rrIndex; }
-      uint8_t i = rrIndex % total;
+static void markWidgets(uint16_t slots, uint8_t flags){
+  for(uint8_t i=0; slots; i++, slots >>= 1){
+    if(slots & 1) s_widgets[i].dirty |= flags;
+  }
+}
 
-      uint8_t showChIdx, showLvl;
-      if (i < critCnt) { showChIdx = critList[i];           showLvl = 2; }
-      else             { showChIdx = warnList[i - critCnt]; showLvl = 1; }
+// Compare every channel against the watch and mark dependents. Warning levels are needed for
+// all channels (title banner); value keys only for channels something on screen shows.
+static void scanChannels(){
+  const Channel titleCh = titleChannel();
+  uint64_t critMask = 0, warnMask = 0;
+  uint8_t highest = 0, total = 0;
+  for(uint8_t c=0;c<CH__COUNT;c++){
+    const Channel ch = (Channel)c;
+    const uint8_t lvl = warnLevelFor(ch);
+    if(lvl == 2) critMask |= (1ULL << c);
+    else if(lvl == 1) warnMask |= (1ULL << c);
+    if(lvl){ total++; if(lvl > highest) highest = lvl; }
+
+    const uint16_t deps = s_chWidgets[c];
+    if(lvl != s_chWarn[c]){
+      markWidgets(deps, DIRTY_FRAME);
+      s_chWarn[c] = lvl;
+    }
+    if(!deps && !lvl && ch != titleCh) continue;
+    const int key = pillKey(ch);
+    if(key != s_chKey[c]){
+      markWidgets(deps, DIRTY_VALUE);
+      if(lvl) s_titleDirty = true;       // banner shows the warned value
+      s_chKey[c] = key;
+    }
+  }
+  uiHighestWarnLevel = highest;
 
-      uiHighestWarnCh = (Channel)showChIdx;
+  const unsigned long now = millis();
+  if(critMask != s_critSet || warnMask != s_warnSet){
+    s_critSet = critMask; s_warnSet = warnMask;
+    s_rrIndex = 0; s_rrCycleMs = now; s_titleDirty = true;
+  }
+  if(total > 1 && now - s_rrCycleMs >= WARN_CYCLE_MS) s_titleDirty = true;
+  s_warnTotal = total;
+}
 
-      char val[24]; fmtValueForTitle((Channel)uiHighestWarnCh, val, sizeof(val));
-      char ttl[64];
-      snprintf(ttl, sizeof(ttl), "WARNING: %s %s",
-               labelText((Channel)uiHighestWarnCh), val);
+// Template/channel assignment changes and blink/regen flips that are not channel updates
+static void syncLayout(){
+  const ScreenLayout& l = currentLayout();
+  if(l.tpl != s_tpl){
+    // Template changed underneath us (e.g. saved from the web page): new static layer
+    clearRegion(0, APPBAR_H+1, 320, 240-APPBAR_H-1, COL_BG());
+    buildWidgets(l);
+    drawStaticLayer();
+    rebuildDependents();
+    s_titleDirty = true;
+  }
 
-      setTitleIfChanged(ttl, (showLvl == 2) ? COL_RED() : COL_ORANGE());
+  bool remap = false;
+  for(uint8_t i=0;i<s_widgetCount;i++){
+    Widget& w = s_widgets[i];
+    const Channel ch = (Channel)l.ch[i];
+    if(ch == w.ch) continue;
+    w.ch = ch;
+    fitWidget(w);
+    if(w.kind == Layout::WK_BAR) drawBarStatic(w, false);
+    else if(w.kind == Layout::WK_DIAL) drawDialStatic(w, false);
+    w.prevKey = INT32_MIN;
+    w.prevAux = INT32_MIN;
+    w.dirty |= DIRTY_FRAME | DIRTY_LABEL | DIRTY_VALUE;
+    if(i == s_titleSlot) s_titleDirty = true;
+    remap = true;
+  }
+  if(remap) rebuildDependents();
+
+  static bool lastBlink = true;
+  if(lastBlink != uiWarnBlinkOn){
+    lastBlink = uiWarnBlinkOn;
+    for(uint8_t i=0;i<s_widgetCount;i++){
+      Widget& w = s_widgets[i];
+      if(w.kind == Layout::WK_PILL && s_chWarn[w.ch]) w.dirty |= DIRTY_FRAME;
     }
-    else {
-      if (regenState == REGEN_PAUSED) {
-        setTitleIfChanged("REGEN INCOMPLETE", COL_TXT());
-      } else if (regenState == REGEN_ACTIVE) {
-        setTitleIfChanged("REGEN ACTIVE", COL_TXT());
-      } else {
-        setTitleIfChanged(labelText(barCh), COL_TXT());
-      }
+  }
+
+  static RegenState lastRegen = REGEN_IDLE;
+  if(regenState != lastRegen){ lastRegen = regenState; s_titleDirty = true; }
+}
+
+static void drawWidget(Widget& w){
+  const uint8_t lvl = s_chWarn[w.ch];
+  if(w.kind == Layout::WK_BAR){
+    updateBar(w, lvl);
+  } else if(w.kind == Layout::WK_DIAL){
+    updateDial(w, lvl);
+    const int key = pillKey(w.ch);
+    if(key != w.prevKey){ drawPillValue(w); w.prevKey = key; }
+  } else {
+    if(w.dirty & DIRTY_LABEL) drawLabel(w);
+    if(w.dirty & DIRTY_VALUE){
+      const int key = pillKey(w.ch);
+      if(key != w.prevKey || (w.ch == CH_GEAR && targetgear != w.prevAux)){ drawPillValue(w); w.prevKey = key; }
+    }
+    if(w.dirty & DIRTY_FRAME){
+      if(lvl > 0 && uiWarnBlinkOn) overlayPillWarnOutlineThick(w.r, (lvl == 2) ? COL_RED() : COL_ORANGE());
+      else drawPillFrame(w.r, false, w.ch);
+      w.prevWarn = lvl;
     }
   }
+  w.dirty = 0;
+}
+
+// 0 = warning transitions and critical values, 1 = warned values, 2 = everything else
+static uint8_t widgetPriority(const Widget& w){
+  const uint8_t lvl = s_chWarn[w.ch];
+  if(lvl == 2 || ((w.dirty & DIRTY_FRAME) && lvl != w.prevWarn)) return 0;
+  return lvl ? 1 : 2;
+}
+
+static void rollStats(uint16_t drawn, uint32_t frameUs, bool overrun){
+  s_stats.frames++;
+  s_stats.widgetsDrawn += drawn;
+  if(overrun) s_stats.overruns++;
+  if(drawn > s_stats.maxWidgetsPerFrame) s_stats.maxWidgetsPerFrame = drawn;
+  if(frameUs > s_stats.maxFrameUs) s_stats.maxFrameUs = frameUs;
+
+  s_windowTicks++;
+  if(drawn){ s_windowFrames++; s_windowWidgets += drawn; }
+  const uint32_t now = millis();
+  if(now - s_windowStartMs >= 1000){
+    s_stats.fps = s_windowFrames;
+    s_stats.ticksPerSec = s_windowTicks;
+    s_stats.widgetsPerSec = s_windowWidgets;
+    s_windowFrames = s_windowTicks = s_windowWidgets = 0;
+    s_windowStartMs = now;
+  }
+}
 
-  static bool lastBlinkPill = true;
-  for (int i = 0; i < 4; i++) {
-    Channel ch = currentPillChannel(i);
-    uint8_t lvl = warnLevelFor(ch);
-
-    if (lvl != prevPillWarnLevel[i] || lastBlinkPill != uiWarnBlinkOn) {
-      if (lvl > 0 && uiWarnBlinkOn) {
-        overlayPillWarnOutlineThick(
-          pillSpec(i),
-          (lvl == 2) ? COL_RED() : COL_ORANGE()
-        );
-      }
-      else {
-        drawPillFrame(pillSpec(i), false, ch);
-      }
-      prevPillWarnLevel[i] = lvl;
+// Draw dirty widgets highest priority first until budgetUs is spent. At least one item is
+// drawn per frame so a single slow widget cannot stall the screen; the rest carry over.
+// s_service runs before every item: the budget spans ~20 CAN frame times at 500 kbit/s and
+// the MCP2515 holds two.
+static bool runFrame(uint32_t budgetUs){
+  const uint32_t t0 = micros();
+  syncLayout();
+  scanChannels();
+
+  uint16_t drawn = 0;
+  bool deferred = false;
+  const uint8_t titlePrio = s_warnTotal ? 0 : 2;
+  for(uint8_t prio=0; prio<3 && !deferred; prio++){
+    for(uint8_t k=0; k<s_widgetCount; k++){
+      const uint8_t i = (uint8_t)((s_resumeSlot + k) % s_widgetCount);
+      Widget& w = s_widgets[i];
+      if(!w.dirty || widgetPriority(w) != prio) continue;
+      if(drawn && micros() - t0 >= budgetUs){ s_resumeSlot = i; deferred = true; break; }
+      if(s_service) s_service();
+      drawWidget(w);
+      drawn++;
+    }
+    if(!deferred && s_titleDirty && prio == titlePrio){
+      if(drawn && micros() - t0 >= budgetUs){ deferred = true; break; }
+      if(s_service) s_service();
+      refreshTitle(titleChannel());
+      s_titleDirty = false;
+      drawn++;
     }
   }
-  lastBlinkPill = uiWarnBlinkOn;
+
+  const uint32_t frameUs = micros() - t0;
+  if(deferred) s_stats.deferred++;
+  rollStats(drawn, frameUs, deferred || frameUs > budgetUs);
+  return deferred;
 }
 
 void initUi(Adafruit_ILI9341& tft, const Palette* palette){
@@ -425,22 +791,60 @@ void initUi(Adafruit_ILI9341& tft, const Palette* palette){
   s_palette = palette;
   (void)s_palette;
   resetTitleCache();
-  prevBarChannel = CH__COUNT;
-  prevBarFillW = -1;
-  for(int i=0;i<4;i++){
-    prevPillChannel[i] = CH__COUNT;
-    prevPillValueKey[i] = INT32_MIN;
-    prevPillWarnLevel[i] = 0;
-  }
+  s_tpl = LT__COUNT;
+  s_widgetCount = 0;
 }
 
+void setRenderService(void (*fn)()){ s_service = fn; }
+
 void renderStatic(){
   if(!s_tft) return;
   resetTitleCache();
-  drawGridStatic();
+  buildWidgets(currentLayout());
+  drawStaticLayer();
+  rebuildDependents();
+  s_titleDirty = true;
 }
 
 void renderDynamic(){
   if(!s_tft) return;
-  refreshPillsDynamic();
-}
\ No newline at end of file
+  runFrame(UINT32_MAX);
+}
+
+bool renderFrame(uint32_t budgetUs){
+  if(!s_tft) return false;
+  return runFrame(budgetUs);
+}
+
+const RenderStats& renderStats(){ return s_stats; }
+
+void renderLayoutPreview(const ScreenLayout& l, uint8_t selSlot){
+  if(!s_tft) return;
+  // Separate widgets so the live screen's cache is untouched
+  const Layout::Template& t = Layout::get(l.tpl);
+  for(uint8_t i=0;i<t.count;i++){
+    Widget w;
+    initWidget(w, t.cells[i], (Channel)l.ch[i]);
+    if(w.kind == Layout::WK_BAR){
+      drawBarStatic(w, i == selSlot);
+      continue;
+    }
+    if(w.kind == Layout::WK_DIAL){
+      drawDialStatic(w, i == selSlot);
+      ArcGauge::moveNeedle(*s_tft, w.dial, ArcGauge::NO_NEEDLE, 0, COL_TXT(), COL_CARD());
+      drawValueText(w, "--", hasUnit(w.ch) ? unitLabel(w.ch) : "", COL_TXT());
+      continue;
+    }
+    s_tft->fillRoundRect(w.r.x, w.r.y, w.r.w, w.r.h, 10, COL_CARD());
+    drawPillFrame(w.r, i == selSlot, w.ch);
+    drawLabel(w);
+    drawValueText(w, "--", hasUnit(w.ch) ? unitLabel(w.ch) : "", COL_TXT());
+  }
+}
+
+void renderLayoutSelection(const ScreenLayout& l, uint8_t slot, bool sel){
+  if(!s_tft || slot >= Layout::count(l.tpl)) return;
+  const Layout::Cell& c = Layout::cell(l.tpl, slot);
+  if(c.kind == Layout::WK_BAR) s_tft->drawRoundRect(c.x, c.y, c.w, c.h, BAR_R, sel ? COL_YELLOW() : COL_FRAME());
+  else drawPillFrame(Layout::rect(c), sel, (Channel)l.ch[slot]);
+}
@@ -1,8 +1,33 @@
 #pragma once
 
+#include <stdint.h>
+
 class Adafruit_ILI9341;
 struct Palette;
+struct ScreenLayout;
+
+// Scheduler counters. fps counts frames that drew something; ticks include idle frames.
+struct RenderStats {
+  uint16_t fps;
+  uint16_t ticksPerSec;
+  uint16_t widgetsPerSec;       // widgets (and title) drawn in the last second
+  uint16_t maxWidgetsPerFrame;
+  uint32_t maxFrameUs;
+  uint32_t frames;
+  uint32_t widgetsDrawn;
+  uint32_t overruns;            // frames that exceeded the budget
+  uint32_t deferred;            // frames that carried dirty widgets over
+};
 
 void initUi(Adafruit_ILI9341& tft, const Palette* palette);
+// Called before each widget is drawn, so the CAN controllers are read during a long frame
+void setRenderService(void (*fn)());
 void renderStatic();
+// Draw everything that is dirty now, ignoring the budget (screen entry, forced refresh)
 void renderDynamic();
+// One scheduler frame: draw dirty widgets by priority within budgetUs; true if work was deferred
+bool renderFrame(uint32_t budgetUs);
+const RenderStats& renderStats();
+// Layout editor: draw a screen's layout with placeholder values / move the selection frame
+void renderLayoutPreview(const ScreenLayout& l, uint8_t selSlot);
+void renderLayoutSelection(const ScreenLayout& l, uint8_t slot, bool sel);
@@ -0,0 +1,104 @@
+#include "UserChannels.h"
+#include "CanField.h"
+
+namespace {
+struct Route {
+  uint32_t id;
+  uint8_t bus;
+  uint8_t mask;  // bit i = user channel i decodes from this ID; 0 = empty slot
+};
+
+UserChannelDef g_defs[USER_CHANNEL_COUNT];
+float g_values[USER_CHANNEL_COUNT];
+Route g_routes[UserCh::DISPATCH_SLOTS];
+uint8_t g_routeCount = 0;
+
+static_assert((UserCh::DISPATCH_SLOTS & (UserCh::DISPATCH_SLOTS - 1)) == 0, "DISPATCH_SLOTS must be a power of two");
+static_assert(USER_CHANNEL_COUNT <= 8, "Route::mask holds 8 channels");
+
+inline uint8_t hashKey(uint32_t id, uint8_t bus) {
+  return static_cast<uint8_t>(((id * 2654435761u) >> 24) + bus) & (UserCh::DISPATCH_SLOTS - 1);
+}
+
+Route* route(uint32_t id, uint8_t bus, bool insert) {
+  uint8_t h = hashKey(id, bus);
+  for (uint8_t p = 0; p < UserCh::DISPATCH_SLOTS; p++) {
+    Route& r = g_routes[(h + p) & (UserCh::DISPATCH_SLOTS - 1)];
+    if (r.mask == 0) {
+      if (!insert) {
+        return nullptr;
+      }
+      r.id = id;
+      r.bus = bus;
+      return &r;
+    }
+    if (r.id == id && r.bus == bus) {
+      return &r;
+    }
+  }
+  return nullptr;
+}
+
+float decodeOne(const UserChannelDef& d, const can_frame& f) {
+  const uint8_t dlc = f.can_dlc > 8 ? 8 : f.can_dlc;
+  if (d.toBit >= dlc * 8) {
+    return NAN;
+  }
+  const CanField::Order order = static_cast<CanField::Order>(d.order);
+  const uint32_t raw = CanField::extract(CanField::pack(f.data, dlc, order), d.fromBit, d.toBit, order);
+  float v = static_cast<float>(raw);
+  const uint8_t width = static_cast<uint8_t>(d.toBit - d.fromBit + 1);
+  if (d.isSigned && width < 32 && (raw & (1u << (width - 1)))) {
+    v = static_cast<float>(static_cast<int32_t>(raw | ~((1u << width) - 1)));
+  } else if (d.isSigned && width >= 32) {
+    v = static_cast<float>(static_cast<int32_t>(raw));
+  }
+  return v * d.scale + d.bias;
+}
+}  // namespace
+
+namespace UserCh {
+void configure(const UserChannelDef* defs, uint8_t count) {
+  memset(g_routes, 0, sizeof(g_routes));
+  g_routeCount = 0;
+  for (uint8_t i = 0; i < USER_CHANNEL_COUNT; i++) {
+    if (i < count) {
+      g_defs[i] = defs[i];
+    } else {
+      memset(&g_defs[i], 0, sizeof(g_defs[i]));
+    }
+    g_values[i] = NAN;
+    const UserChannelDef& d = g_defs[i];
+    if (!d.enabled || d.fromBit > d.toBit || d.toBit > 63 || d.toBit - d.fromBit > 31) {
+      continue;
+    }
+    Route* r = route(d.canId, d.bus, true);
+    if (r) {
+      if (r->mask == 0) {
+        g_routeCount++;
+      }
+      r->mask |= static_cast<uint8_t>(1u << i);
+    }
+  }
+}
+
+void decodeFrame(const can_frame& f, uint8_t bus) {
+  if (g_routeCount == 0) {
+    return;
+  }
+  const Route* r = route(f.can_id, bus, false);
+  if (!r) {
+    return;
+  }
+  for (uint8_t m = r->mask; m; m &= static_cast<uint8_t>(m - 1)) {
+    const uint8_t i = static_cast<uint8_t>(__builtin_ctz(m));
+    g_values[i] = decodeOne(g_defs[i], f);
+  }
+}
+
+const UserChannelDef& def(uint8_t idx) { return g_defs[idx < USER_CHANNEL_COUNT ? idx : 0]; }
+
+bool enabled(uint8_t idx) { return idx < USER_CHANNEL_COUNT && g_defs[idx].enabled; }
+
+float value(uint8_t idx) { return idx < USER_CHANNEL_COUNT ? g_values[idx] : NAN; }
+}  // namespace UserCh
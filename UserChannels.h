@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h>
+#include <mcp2515.h>
+#include "DashTypes.h"
+#include "Persist.h"
+
+// User-defined CAN channels (CH_USER1..CH_USER8).
+// configure() copies the definitions and builds a dispatch table keyed on (bus, ID), so
+// decodeFrame() costs one hash probe for frames no user channel listens to.
+// A channel only decodes its ID from UserChannelDef::bus.
+namespace UserCh {
+  constexpr uint8_t DISPATCH_SLOTS = 16;   // power of two, >= 2 * USER_CHANNEL_COUNT
+
+  void configure(const UserChannelDef* defs, uint8_t count);
+  void decodeFrame(const can_frame& f, uint8_t bus);
+
+  const UserChannelDef& def(uint8_t idx);
+  bool enabled(uint8_t idx);
+  // Latest decoded value (NAN until the first matching frame)
+  float value(uint8_t idx);
+}
@@ -3,4 +3,6 @@
 #include "DashTypes.h"
 
 float valueRawBase(Channel ch);
+// Filtered base value (what the pills show); equals valueRawBase() for unfiltered channels
+float valueBase(Channel ch);
 float valueDisplay(Channel ch);
@@ -25,8 +25,6 @@ const uint8_t kOrionKey[16] = {
 };
 }
 
-extern bool wifiPageActive();
-
 extern bool victronConfigEnabled();
 extern const char* victronConfigBmvMac();
 extern const uint8_t* victronConfigBmvKey();
@@ -39,8 +37,24 @@ namespace {
 constexpr uint16_t kVictronCompanyId = 0x02E1;
 constexpr uint8_t kVictronRecordInstant = 0x10;
 constexpr uint32_t kVictronStaleMs = 20000;
-constexpr uint16_t kBleScanInterval = 160;
-constexpr uint16_t kBleScanWindow = 120;
+
+// Scan duty per RadioCoex (ms). Windows never exceed ~40 ms once the AP is up so a 102 ms beacon
+// period always finds a gap; Victron devices advertise every ~100 ms, so even the HTTP profile
+// still catches a record from each one well inside kVictronStaleMs.
+struct ScanDuty {
+  uint16_t intervalMs;
+  uint16_t windowMs;
+};
+constexpr ScanDuty kScanDuty[COEX__COUNT] = {
+  {160, 120},   // COEX_BLE_ONLY  75%
+  {160, 40},    // COEX_AP_IDLE   25%
+  {320, 40},    // COEX_AP_CLIENT 12.5%
+  {640, 30},    // COEX_HTTP      ~5%
+};
+// Relaxing to a higher duty waits this long so a page load's follow-up requests don't each
+// bounce the scanner through a stop/start
+constexpr uint32_t kCoexRelaxDwellMs = 1500;
+constexpr uint32_t kAdvertRateWindowMs = 1000;
 
 struct VictronDevCfg {
   const char* name;
@@ -49,6 +63,14 @@ struct VictronDevCfg {
 };
 
 NimBLEScan* victronScan = nullptr;
+// Written only by the NimBLE host task, read by loop()
+volatile uint32_t g_advertsDecoded = 0;
+VictronScanStats g_scanStats = {0, 0, kScanDuty[COEX_BLE_ONLY].intervalMs, kScanDuty[COEX_BLE_ONLY].windowMs, 0, COEX_BLE_ONLY};
+RadioCoex g_coexWant = COEX_BLE_ONLY;
+bool g_scanSuspended = false;
+unsigned long g_coexChangedMs = 0;
+uint32_t g_rateWindowAdverts = 0;
+unsigned long g_rateWindowStartMs = 0;
 VictronReadings g_readings = {
   NAN, NAN, NAN, NAN,
   NAN, NAN, NAN,
@@ -128,22 +150,60 @@ static void aesCtrDecrypt(const uint8_t key[16], const uint8_t iv[16], const uin
   mbedtls_aes_free(&ctx);
 }
 
-static bool matchDevice(const std::string& macStr, VictronDevCfg& out){
-  if(macStr == victronConfigBmvMac()){
+static inline int hexNibble(char c){
+  if(c >= '0' && c <= '9') return c - '0';
+  if(c >= 'a' && c <= 'f') return 10 + (c - 'a');
+  if(c >= 'A' && c <= 'F') return 10 + (c - 'A');
+  return -1;
+}
+
+// Configured "aa:bb:cc:dd:ee:ff" against the advertiser's address, which NimBLE keeps LSB first
+static bool macMatches(const uint8_t* addr, const char* mac){
+  if(!mac) return false;
+  for(int i=5;i>=0;i--){
+    const int hi = hexNibble(mac[0]);
+    const int lo = hi < 0 ? -1 : hexNibble(mac[1]);
+    if(lo < 0 || addr[i] != ((hi << 4) | lo)) return false;
+    mac += 2;
+    if(i && *mac++ != ':') return false;
+  }
+  return *mac == '\0';
+}
+
+static bool matchDevice(const uint8_t* addr, VictronDevCfg& out){
+  if(macMatches(addr, victronConfigBmvMac())){
     out = {"BMV-712", victronConfigBmvMac(), victronConfigBmvKey()};
     return true;
   }
-  if(macStr == victronConfigMpptMac()){
+  if(macMatches(addr, victronConfigMpptMac())){
     out = {"MPPT100/30", victronConfigMpptMac(), victronConfigMpptKey()};
     return true;
   }
-  if(macStr == victronConfigOrionMac()){
+  if(macMatches(addr, victronConfigOrionMac())){
     out = {"OrionXS", victronConfigOrionMac(), victronConfigOrionKey()};
     return true;
   }
   return false;
 }
 
+// Manufacturer-specific AD structure, found in place in the raw advertisement: the library's
+// getManufacturerData() returns a heap-allocated copy per advert
+static bool findManufacturerData(const NimBLEAdvertisedDevice* dev, const uint8_t*& data, size_t& len){
+  const std::vector<uint8_t>& p = dev->getPayload();
+  size_t i = 0;
+  while(i + 1 < p.size()){
+    const uint8_t adLen = p[i];
+    if(adLen == 0 || i + 1 + adLen > p.size()) return false;
+    if(p[i + 1] == 0xFF){
+      data = p.data() + i + 2;
+      len = adLen - 1;
+      return true;
+    }
+    i += 1 + adLen;
+  }
+  return false;
+}
+
 static inline void decodeBMV(const uint8_t* plain, size_t plainLen){
   if(plainLen < 14) return;
   uint16_t ttg_min = (uint16_t)getBitsLE(plain, 0, 16);
@@ -205,15 +265,14 @@ static inline void decodeOrion0F(const uint8_t* plain, size_t plainLen){
 
 class VictronScanCallbacks : public NimBLEScanCallbacks {
   void onResult(const NimBLEAdvertisedDevice* dev) override {
-    if(!dev->haveManufacturerData()) return;
     if(!victronConfigEnabled()) return;
-    const std::string& mfg = dev->getManufacturerData();
-    if(mfg.size() < 12) return;
-    const uint8_t* data = reinterpret_cast<const uint8_t*>(mfg.data());
+    const uint8_t* data = nullptr;
+    size_t mfgLen = 0;
+    if(!findManufacturerData(dev, data, mfgLen) || mfgLen < 12) return;
     if(!(data[0] == (kVictronCompanyId & 0xFF) && data[1] == (kVictronCompanyId >> 8))) return;
     VictronDevCfg cfg{};
-    std::string addr = dev->getAddress().toString();
-    if(!matchDevice(addr, cfg)) return;
+    const NimBLEAddress addr = dev->getAddress();
+    if(!matchDevice(addr.getVal(), cfg)) return;
     const size_t o = 2;
     if(data[o + 0] != kVictronRecordInstant) return;
     const uint8_t recordType = data[o + 4];
@@ -224,8 +283,8 @@ class VictronScanCallbacks : public NimBLEScanCallbacks {
       return;
     }
     const size_t enc_off = o + 8;
-    if(mfg.size() <= enc_off) return;
-    size_t enc_len = mfg.size() - enc_off;
+    if(mfgLen <= enc_off) return;
+    size_t enc_len = mfgLen - enc_off;
     if(enc_len == 0) return;
     uint8_t enc[16] = {0};
     uint8_t plain[16] = {0};
@@ -241,22 +300,57 @@ class VictronScanCallbacks : public NimBLEScanCallbacks {
       case 0x04: decodeDcdc04(plain, take); break;
       case 0x0F: decodeOrion0F(plain, take); break;
       default:
-        break;
+        return;
     }
+    g_advertsDecoded++;
   }
 };
 
 VictronScanCallbacks g_victronCallbacks;
+// Set once victronInit() has configured the scanner (it may run on a boot task)
+volatile bool g_bleReady = false;
 
-static void updateVictronScanState(){
-  if(!victronScan) return;
-  if(wifiPageActive()){
-    if(victronScan->isScanning()){
-      victronScan->stop();
-    }
-    return;
+static void applyScanDuty(RadioCoex mode){
+  victronScan->setInterval(kScanDuty[mode].intervalMs);
+  victronScan->setWindow(kScanDuty[mode].windowMs);
+  g_scanStats.intervalMs = kScanDuty[mode].intervalMs;
+  g_scanStats.windowMs = kScanDuty[mode].windowMs;
+  g_scanStats.coex = mode;
+}
+
+// Scan parameters only apply on start, so a profile change costs one stop/start. Moving to a
+// quieter profile happens at once; moving back waits kCoexRelaxDwellMs after the last change.
+static void scheduleScanDuty(unsigned long nowMs){
+  const RadioCoex want = g_coexWant;
+  if(want == g_scanStats.coex) return;
+  if(want < g_scanStats.coex && nowMs - g_coexChangedMs < kCoexRelaxDwellMs) return;
+  const bool wasScanning = victronScan->isScanning();
+  if(wasScanning){
+    victronScan->stop();
+  }
+  applyScanDuty(want);
+  g_coexChangedMs = nowMs;
+  g_scanStats.dutySwitches++;
+  if(wasScanning){
+    victronScan->start(0, true, true);
   }
-  if(victronConfigEnabled()){
+}
+
+static void updateAdvertRate(unsigned long nowMs){
+  const uint32_t total = g_advertsDecoded;
+  g_scanStats.adverts = total;
+  if(nowMs - g_rateWindowStartMs < kAdvertRateWindowMs) return;
+  const uint32_t elapsed = nowMs - g_rateWindowStartMs;
+  const uint32_t perSec = (total - g_rateWindowAdverts) * 1000UL / elapsed;
+  g_scanStats.advertsPerSec = static_cast<uint16_t>(perSec > 0xFFFF ? 0xFFFF : perSec);
+  g_rateWindowAdverts = total;
+  g_rateWindowStartMs = nowMs;
+}
+
+static void updateVictronScanState(){
+  if(!g_bleReady || !victronScan) return;
+  if(victronConfigEnabled() && !g_scanSuspended){
+    scheduleScanDuty(millis());
     if(!victronScan->isScanning()){
       victronScan->start(0, true, true);
     }
@@ -274,13 +368,41 @@ void victronInit(){
   victronScan->setScanCallbacks(&g_victronCallbacks, true);
   victronScan->setDuplicateFilter(false);
   victronScan->setActiveScan(false);
-  victronScan->setInterval(kBleScanInterval);
-  victronScan->setWindow(kBleScanWindow);
+  applyScanDuty(g_coexWant);
+  g_coexChangedMs = millis();
+  g_bleReady = true;
   updateVictronScanState();
 }
 
+static void victronInitTask(void*){
+  victronInit();
+  vTaskDelete(nullptr);
+}
+
+bool victronInitAsync(){
+  // NimBLE init takes a few hundred ms; run it beside loop() so CAN keeps draining
+  return xTaskCreate(victronInitTask, "bleInit", 6144, nullptr, 1, nullptr) == pdPASS;
+}
+
+bool victronReady(){
+  return g_bleReady;
+}
+
+void victronSetCoex(RadioCoex mode){
+  if(mode < COEX__COUNT) g_coexWant = mode;
+}
+
+const VictronScanStats& victronScanStats(){
+  return g_scanStats;
+}
+
+void victronSuspend(bool suspend){
+  g_scanSuspended = suspend;
+}
+
 VictronReadings victronLoop(){
   clearStaleVictronData();
+  updateAdvertRate(millis());
   updateVictronScanState();
   return g_readings;
 }
@@ -27,6 +27,34 @@ extern const char kOrionMac[];
 extern const uint8_t kOrionKey[16];
 }
 
+// Radio coexistence. WiFi and BLE share one 2.4 GHz radio; the IDF arbiter interleaves them but
+// cannot tell a parked AP from a client loading the config page. The sketch reports which case
+// it is in and the scanner narrows its window accordingly, so beacons and HTTP get the air time.
+enum RadioCoex : uint8_t {
+  COEX_BLE_ONLY,    // AP down: scan at full duty
+  COEX_AP_IDLE,     // AP up, no station associated: leave room for beacons
+  COEX_AP_CLIENT,   // station associated: short windows, long gaps
+  COEX_HTTP,        // request served in the last few seconds: minimal duty
+  COEX__COUNT
+};
+
+struct VictronScanStats {
+  uint32_t adverts;          // Victron records decoded since boot
+  uint16_t advertsPerSec;    // decoded over the last full second
+  uint16_t intervalMs;       // active scan duty
+  uint16_t windowMs;
+  uint16_t dutySwitches;     // scan restarts caused by coexistence changes
+  RadioCoex coex;            // profile in force
+};
+
 void victronInit();
+// Runs victronInit() on a one-shot FreeRTOS task; false if the task could not be created
+bool victronInitAsync();
+bool victronReady();
+// Takes effect on the next victronLoop(); tightening is immediate, relaxing waits out a dwell
+void victronSetCoex(RadioCoex mode);
+const VictronScanStats& victronScanStats();
+// Parked: keep the scanner stopped (applied by the next victronLoop()) even when Victron is enabled
+void victronSuspend(bool suspend);
 VictronReadings victronLoop();
 const VictronReadings& victronReadings();
@@ -19,6 +19,30 @@
 #include "UiRenderer.h"
 #include "ValueConversion.h"
 #include "VictronBle.h"
+#include "CanCensus.h"
+#include "CanField.h"
+#include "SignalDiscovery.h"
+#include "UserChannels.h"
+#include "DerivedChannels.h"
+#include "SignalFilter.h"
+#include "RegenAnalytics.h"
+#include "TripComputer.h"
+#include "InputQueue.h"
+#include "ChannelTraits.h"
+#include "ArcGauge.h"
+#include "Layout.h"
+#include "MenuList.h"
+#include "Backlight.h"
+#include "Power.h"
+#include "McpRegs.h"
+#include "CanTx.h"
+#include "CanBus.h"
+#include "J1939.h"
+#include "Gvret.h"
+#include "Trace.h"
+#include "HtmlOut.h"
+#include "HeapMon.h"
+#include "BusSim.h"
 
 #ifndef IRAM_ATTR
   #define IRAM_ATTR
@@ -32,6 +56,9 @@
 #endif
 
 // ===================== Debug =====================
+// DEBUG_BUTTONS and DEBUG_CAN only pick the trace categories enabled at boot (Trace.h); the trace
+// points are always built in and the host can switch categories at runtime. DEBUG_HEAP is in
+// HeapMon.h, which the modules see as well.
 #ifndef DEBUG_BUTTONS
   #define DEBUG_BUTTONS 1
 #endif
@@ -40,33 +67,63 @@
   #define DEBUG_CAN 1
 #endif
 
+#ifndef DEBUG_RENDER
+  #define DEBUG_RENDER 0
+#endif
+
+#ifndef DEBUG_BOOT
+  #define DEBUG_BOOT 1
+#endif
+
+#ifndef DEBUG_RADIO
+  #define DEBUG_RADIO 0
+#endif
+
+#ifndef DEBUG_POWER
+  #define DEBUG_POWER 1
+#endif
+
+// 1 replaces the CAN controllers with BusSim's synthetic vehicle and steps it through its load
+// levels, printing [SIM] lines per level. Bench only: no frame from the real buses is read.
+// The one hook is BusSim::install() in setup(); it times the loop from inside CanBus::read().
+#ifndef BUS_SIM
+  #define BUS_SIM 0
+#endif
+
 // Forward declarations for functions referenced before their definitions
 void redrawForDimmingChange();
+static void setupWebServer();
+inline void applyBacklight();
+inline void drawAppBar();
+void updateRegenState();
 // ==== CAN Sniffer: forward declarations ====
 void showCanSniff(bool full = true);
 void drawSniffRow(uint8_t row, bool sel, bool blinkHide=false);
 void drawSniffLive();
-void snifferMaybeCapture(const can_frame& f);
-
-#if DEBUG_BUTTONS
-static const char* btnName(Btn b);
-static void logButtonEvent(const char* tag, Btn b);
-static void logButtonFrame(const can_frame& f, bool cancel_now, bool up_now, bool down_now, bool left, bool right, bool enter);
-#endif
+void snifferMaybeCapture(const can_frame& f, uint8_t bus);
+void snifferUiTick(unsigned long now);
 
 //=====================Xiao Can Expansion Board =================
 
 // ===================== Hardware =====================
 Adafruit_ILI9341 tft(CFG::TFT_CS, CFG::TFT_DC, CFG::TFT_RST);
 MCP2515 mcp(CFG::CAN_CS);
-volatile bool can_irq=false; void IRAM_ATTR onCanInt(){ can_irq=true; }
+MCP2515 mcp2(CFG::CAN_CS2);
 WebServer webServer(80);
 static IPAddress g_wifiIp;
 static bool g_wifiActive = false;
 static bool g_wifiPageActive = false;
 static bool g_webServerActive = false;
 
-bool wifiPageActive(){ return g_wifiPageActive; }
+// HTTP handler service time, measured with BLE scanning running alongside the AP
+struct WebStats {
+  uint32_t requests;
+  uint32_t lastUs;
+  uint32_t maxUs;
+  unsigned long lastMs;   // millis() of the last request, drives COEX_HTTP
+};
+static WebStats g_webStats = {};
+constexpr unsigned long WEB_HTTP_HOLD_MS = 3000;
 
 // ===================== Live values (extern targets for CanDecode.h) =====================
 RegenState regenState=REGEN_IDLE;
@@ -88,66 +145,36 @@ static VictronReadings g_victronReadings{};
 static unsigned long lastVictronPollMs = 0;
 constexpr unsigned long kVictronPollIntervalMs = 200;
 
-#if DEBUG_CAN
-static uint32_t g_canOverflowCount = 0;
-static uint32_t g_canOverflowReported = 0;
+#if DEBUG_RADIO
+static unsigned long lastRadioReportMs = 0;
+constexpr unsigned long kRadioReportIntervalMs = 5000;
+#endif
+
+// Last counts traced, so a counter is only logged when it moves (at most once per interval)
+static uint32_t g_canOverflowReported[CanBus::MAX_BUSES] = {};
 static unsigned long lastCanOverflowReportMs = 0;
 constexpr unsigned long kCanOverflowReportIntervalMs = 1000;
+static uint32_t g_canTxTroubleReported = 0;
+static unsigned long lastCanTxReportMs = 0;
+static uint32_t g_j1939TpReported[5] = {};
+static uint32_t g_inputOverflowsReported = 0;
+
+#if DEBUG_RENDER
+static unsigned long lastRenderReportMs = 0;
+constexpr unsigned long kRenderReportIntervalMs = 5000;
 #endif
 
 
 // ===================== Timing =====================
-unsigned long lastMillis=0, lastDraw=0;
+unsigned long lastMillis=0;
+uint32_t lastFrameUs=0;
+// Longest gap between loop() entries, overall and while a backlight cross-fade runs
+uint32_t lastLoopUs=0, loopMaxGapUs=0, fadeLoopMaxGapUs=0;
 
 // ===================== UI state & persistence =====================
 MenuState menuState = UI_MAIN;
 bool inSettings() { return menuState != UI_MAIN; }
 
-#if DEBUG_BUTTONS
-static const char* btnName(Btn b){
-  switch(b){
-    case BTN_UP: return "UP";
-    case BTN_DOWN: return "DOWN";
-    case BTN_LEFT: return "LEFT";
-    case BTN_RIGHT: return "RIGHT";
-    case BTN_ENTER: return "ENTER";
-    case BTN_CANCEL: return "CANCEL";
-    default: return "NONE";
-  }
-}
-
-static void logButtonEvent(const char* tag, Btn b){
-  Serial.print("[BTN] ");
-  Serial.print(tag);
-  Serial.print(" btn=");
-  Serial.print(btnName(b));
-  Serial.print(" menuState=");
-  Serial.println(static_cast<uint8_t>(menuState));
-}
-
-static void logButtonFrame(const can_frame& f, bool cancel_now, bool up_now, bool down_now, bool left, bool right, bool enter){
-  Serial.print("[BTN] frame id=0x");
-  Serial.print(f.can_id, HEX);
-  Serial.print(" data=");
-  for(uint8_t i=0;i<f.can_dlc && i<8;i++){
-    if(i) Serial.print(' ');
-    Serial.print(f.data[i], HEX);
-  }
-  Serial.print(" states c/u/d/l/r/e=");
-  Serial.print(cancel_now);
-  Serial.print('/');
-  Serial.print(up_now);
-  Serial.print('/');
-  Serial.print(down_now);
-  Serial.print('/');
-  Serial.print(left);
-  Serial.print('/');
-  Serial.print(right);
-  Serial.print('/');
-  Serial.println(enter);
-}
-#endif
-
 // ===== Main-UI warnings state & blink =====
 unsigned long uiWarnBlinkMs = 0;
 bool uiWarnBlinkOn = true;
@@ -173,7 +200,6 @@ uint8_t g_lastRootIndex = 0;
 
 // General indices
 uint8_t menuIndex = 0;       // general cursor (root; colours; system; etc.)
-uint8_t menuIndex2 = 0;      // secondary (gauge list)
 uint8_t obd2Sel = 0;         // OBD2 menu selection
 
 // ===== OBD2 scan state =====
@@ -181,6 +207,10 @@ static const uint8_t OBD2_MAX_CODES = 6;
 static char obd2Codes[OBD2_MAX_CODES][6];
 static uint8_t obd2CodeCount = 0;
 static bool obd2Awaiting = false;
+// CanTx event tags
+enum TxTag : uint16_t { TX_TAG_NONE, TX_TAG_BEEP, TX_TAG_OBD2, TX_TAG_GVRET };
+constexpr uint32_t OBD2_FUNCTIONAL_ID = 0x7DF;
+constexpr uint16_t OBD2_TX_MIN_MS = 100;   // let every ECU answer before the next functional request
 static bool obd2TimedOut = false;
 static bool obd2SendOk = true;
 static unsigned long obd2RequestMs = 0;
@@ -189,16 +219,9 @@ static bool obd2ClearDone = false;
 static bool obd2ClearOk = false;
 
 // Layout editor cursor (row=-1 means BAR, rows 0..1, cols 0..1)
-int8_t layoutRow = 0, layoutCol = 0;
+uint8_t layoutSlot = 0;      // cell index within the edited screen's template
 uint8_t layoutScreenSel = 0; // 0..4 – which screen being edited
 
-// Gauge picker paging & selection (latched window)
-int pickerTop = 0;   // first visible eligible index
-
-// Warnings: list paging & selection
-int warnListTop = 0;     // index of first visible eligible item
-int warnListSel = 0;     // selected eligible index
-
 // Warnings: field editor
 uint8_t warnFieldSel   = 0;        // 0=Mode,1=T1,2=T2
 bool    warnFieldEditing = false;  // editing current field?
@@ -208,17 +231,19 @@ unsigned long warnBlinkMs = 0; bool warnBlinkOn = true;
 
 
 // ===================== CAN Sniffer state =====================
-// Standard 11-bit CAN IDs (0x000..0x7FF) → 3 hex digits.
-// If you later want extended 29-bit, set SNF_HEX_DIGITS=8 and remove the clamp.
+// Standard 11-bit CAN IDs (0x000..0x7FF) → 3 hex digits, extended 29-bit IDs (CAN_EFF_FLAG
+// set) → 8. LEFT on the first digit switches between the two.
 static uint32_t snf_id = 0x000;
-static const uint8_t SNF_HEX_DIGITS = 3;
+static uint8_t  snf_bus = CFG::CAN_BUS_PT;   // only selectable (from the census) with two buses
+static inline uint8_t snfHexDigits(){ return (snf_id & CAN_EFF_FLAG) ? 8 : 3; }
 
-static uint8_t  snf_cursor = 0;   // which hex digit (0..SNF_HEX_DIGITS-1) from MSB side
-static uint8_t  snf_sel    = 0;   // row select: 0=Address, 1=From, 2=To, 3=Scale, 4=Bias
+static uint8_t  snf_cursor = 0;   // which hex digit (0..snfHexDigits()-1) from MSB side
+static uint8_t  snf_sel    = 0;   // row select: 0=Address, 1=From, 2=To, 3=Scale, 4=Bias, 5=Byte order
 static bool     snf_editing = false;
 
 static uint8_t  snf_bit_from = 0; // 0..63
 static uint8_t  snf_bit_to   = 7; // 0..63
+static CanField::Order snf_order = CanField::ORDER_LE; // bit numbering, see CanField.h
 
 static uint8_t  snf_data[8] = {0}; // last matching frame payload
 static uint8_t  snf_dlc = 0;
@@ -230,8 +255,22 @@ static float    snf_bias  = 0.0f;
 // Step for editing floats (LEFT/RIGHT multiplies/divides by 10)
 static float    snf_step  = 0.1f;
 
+// Views (LEFT/RIGHT when not editing): detail editor, bus census (by rate / by recent change), bit heatmap
+enum SnfView : uint8_t { SNF_VIEW_DETAIL=0, SNF_VIEW_CENSUS_RATE, SNF_VIEW_CENSUS_RECENT, SNF_VIEW_HEATMAP, SNF_VIEW_DISCOVER, SNF_VIEW_SAVE, SNF_VIEW_COUNT };
+static uint8_t  snf_view = SNF_VIEW_DETAIL;
+static uint32_t snf_censusSelId = 0xFFFFFFFF; // census cursor, anchored to an ID so re-sorting doesn't move it
+static uint8_t  snf_censusSelBus = CFG::CAN_BUS_PT;
+static int      snf_censusTop = 0;
+static bool     snf_liveDirty = false;        // set from the CAN drain, drawn from snifferUiTick()
+static const unsigned long SNF_LIVE_MS    = 50;
+static const unsigned long SNF_CENSUS_MS  = 250;
+static const unsigned long SNF_HEATMAP_MS = 100;
+static const unsigned long SNF_DISCOVER_MS = 500;
+static const uint8_t SNF_ROWS = 6;
+
 // ===== Hold-to-accelerate (shared) =====
 bool up_now=false, down_now=false; // current press states
+unsigned long holdPressMs=0;        // event time of the latest UP/DOWN press
 unsigned long repeatStartMs=0, lastRepeatMs=0; bool repeating=false;
 
 // Progressive hold state
@@ -291,13 +330,8 @@ static inline int basePaletteCount(){
 
 uint8_t paletteIndex = 0;
 
-// ---- Colours page scrolling state ----
-static int coloursSel = 0;   // selected palette index (cursor)
-static int coloursTop = 0;   // first visible row index in window
 static uint8_t customPaletteSel = 0;
 static uint8_t customZoneSel = 0;
-static int customColourSel = 0;
-static int customColourTop = 0;
 
 static inline int paletteCount(){
   return basePaletteCount() + CUSTOM_PALETTE_COUNT;
@@ -358,29 +392,6 @@ static inline void setCustomZoneValue(CustomPalette& palette, uint8_t zone, uint
   }
 }
 
-// Call this when you ENTER the colours page (optional but nice UX)
-static inline void enterColoursPage(){
-  coloursSel = paletteIndex;                            // focus current
-  const int perPage = MENU_PER_PAGE();
-  const int total   = paletteCount();
-  // Center selection if possible; clamp to valid window
-  coloursTop = coloursSel - perPage/2;
-  if (coloursTop < 0) coloursTop = 0;
-  int maxTop = total - perPage; if (maxTop < 0) maxTop = 0;
-  if (coloursTop > maxTop) coloursTop = maxTop;
-}
-
-static inline void setColoursSelection(int index){
-  const int perPage = MENU_PER_PAGE();
-  const int total   = paletteCount();
-  coloursSel = index;
-  int maxTop = total - perPage; if (maxTop < 0) maxTop = 0;
-  if (coloursSel < coloursTop) coloursTop = coloursSel;
-  if (coloursSel >= coloursTop + perPage) coloursTop = coloursSel - perPage + 1;
-  if (coloursTop < 0) coloursTop = 0;
-  if (coloursTop > maxTop) coloursTop = maxTop;
-}
-
 // ===================== System settings (NEW) =====================
 uint8_t brightOn = 0;   // % brightness with headlights ON
 uint8_t brightOff = 0;  // % brightness with headlights OFF
@@ -403,6 +414,10 @@ uint8_t g_uTemp     = U_T_C;
 uint8_t g_uSpeed    = U_S_kmh;
 uint8_t g_uLambda   = U_L_lambda;
 
+// Trip/regen distances follow the speed unit
+static float distInUnit(float km){ return (g_uSpeed == U_S_mph) ? km * 0.62137119f : km; }
+static const char* distUnit(){ return (g_uSpeed == U_S_mph) ? "mi" : "km"; }
+
 bool     unitsEditing=false;
 uint8_t  unitsSel=0;
 unsigned long unitsBlinkMs=0; bool unitsBlinkOn=true;
@@ -411,150 +426,27 @@ PersistState persist{};
 bool dirty=true;
 
 // ===================== UI Layout constants =====================
-extern const int APPBAR_H=34, BAR_X=14, BAR_Y=64, BAR_W=292, BAR_H=32, BAR_R=8;
-extern const int GRID_TOP=112, GRID_LEFT=12, GRID_W=296, GRID_H=120, CELL_GAP_X=8, CELL_GAP_Y=10;
-extern const int CELL_W=(GRID_W-CELL_GAP_X)/2, CELL_H=(GRID_H-CELL_GAP_Y)/2;
-
-Channel currentBarChannel(){ return (Channel)persist.barChannel[persist.currentScreen]; }
-Channel currentPillChannel(uint8_t slot){ return (Channel)persist.pillChannel[persist.currentScreen][slot]; }
-
-// Labels (base)
-static const char* LBL_BASE[CH__COUNT]={
-  "Soot %","Speed","RPM","Coolant","Trans 1","Trans 2","Oil kPa",
-  "Battery","Gear","Converter","Torque","Pedal %","TQ Demand %",
-  "EGT 1","EGT 2","Boost","Manifold 2","Manifold 1","Lambda","Intake T","Fuel T",
-  "Turbo %","Headlights","Aux Batt %","Aux Batt A","Time Rem","Aux Batt V",
-  "DCDC Out A","DCDC Out V","DCDC In V",
-  "PV Watts","PV Amps","PV Yield"
-};
+extern const int APPBAR_H=34, BAR_R=8;   // cell geometry lives in Layout.cpp
 
-// ===== Unit helpers =====
-const char* unitLabel(Channel ch){
-  switch(ch){
-    case CH_BATTV: return "V";
-    case CH_BATTV2: return "V";
-    case CH_BATT_SOC: return "%";
-    case CH_BATT_CURR: return "A";
-    case CH_BATT_TTG: return "min";
-    case CH_DCDC_OUT_A: return "A";
-    case CH_DCDC_OUT_V: return "V";
-    case CH_DCDC_IN_V: return "V";
-    case CH_PV_WATTS: return "W";
-    case CH_PV_AMPS: return "A";
-    case CH_PV_YIELD: return "kWh";
-    case CH_SPEED: return (g_uSpeed==U_S_kmh)?"km/h":"mph";
-    case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-    case CH_MANIFOLD: case CH_TURBO_OUT: case CH_EGT1: case CH_EGT2:
-      return (g_uTemp==U_T_C)?"C":"F";
-    case CH_BOOST: case CH_OIL:
-      return (g_uPressure==U_P_kPa)?"kPa":"psi";
-    case CH_LAMBDA: return (g_uLambda==U_L_lambda)?"λ":"AFR";
-    case CH_TORQUE: return "Nm";
-    case CH_PEDAL: case CH_TQ_DEMAND: case CH_SOOT: return "%";
-    default: return "";
-  }
-}
-const char* labelText(Channel ch){
-  // Change oil label to pressure unit
-  if(ch==CH_OIL)
-    return (g_uPressure==U_P_kPa) ? "Oil kPa" : "Oil psi";
-  if(ch==CH_BOOST)
-    return (g_uPressure==U_P_kPa) ? "Boost" : "Boost";
-  return LBL_BASE[ch];
-}
-
-// Conversions (value in base → display units)
-float toDisplayPressure(float kPa){
-  return (g_uPressure==U_P_kPa)? kPa : (kPa * 0.1450377f);
-}
-float toDisplayTemp(float C){
-  return (g_uTemp==U_T_C)? C : (C*9.0f/5.0f + 32.0f);
-}
-float toDisplaySpeed(float kmh){
-  // ===== PATCH: apply speed trim in BASE before conversion =====
-  // speedTrimPct is a signed percent; clamp huge values just in case:
-  float pct = speedTrimPct;
-  if (!isfinite(pct)) pct = 0.0f;
-  if (pct < -50.0f) pct = -50.0f;  // safety
-  if (pct >  50.0f) pct =  50.0f;
-  float kmhTrimmed = kmh * (1.0f + pct / 100.0f);
-  return (g_uSpeed==U_S_kmh)? kmhTrimmed : (kmhTrimmed * 0.62137119f);
-}
-float toDisplayLambda(float lambda){
-  return (g_uLambda==U_L_lambda)? lambda : (lambda * 14.5f);
-}
-// Reverse (display → base), used in warnings editor
-static inline float fromDisplayPressure(float v){
-  return (g_uPressure==U_P_kPa)? v : (v / 0.1450377f);
-}
-static inline float fromDisplayTemp(float v){
-  return (g_uTemp==U_T_C)? v : ((v - 32.0f) * 5.0f/9.0f);
-}
-static inline float fromDisplaySpeed(float v){
-  return (g_uSpeed==U_S_kmh)? v : (v / 0.62137119f);
-}
-static inline float fromDisplayLambda(float v){
-  return (g_uLambda==U_L_lambda)? v : (v / 14.5f);
-}
-
-// Ranges in base units (unchanged)
-static const Range RNG_BASE[CH__COUNT]={
-  {0,100}, {0,200}, {0,5000}, {40,110}, {40,130}, {40,130}, {0,600},
-  {10,15}, {0,1}, {0,1}, { -200,600 }, {0,100}, {0,100},
-  {0,1000}, {0,1000}, {0,250}, {0,150}, {0,200}, {0,2}, {0,80}, {0,100},
-  {0,255}, {0,1}, {0,100}, {-300,300}, {0,1440}, {10,15},
-  {0,200}, {0,60}, {0,60},
-  {0,2000}, {0,100}, {0,20}
-};
+const ScreenLayout& currentLayout(){ return persist.layouts[persist.currentScreen]; }
+
+// ===== Channel metadata: table lookups (see ChannelTraits.h) =====
+const char* unitLabel(Channel ch){ return Channels::rt(ch).unit; }
+const char* labelText(Channel ch){ return Channels::rt(ch).label; }
+static inline uint8_t decimalsFor(Channel ch){ return Channels::rt(ch).decimals; }
 
 // Range in display units
-Range rangeFor(Channel c){
-  Range r = RNG_BASE[c];
-  switch(c){
-    case CH_BATTV: break;
-    case CH_SPEED: r.mn = toDisplaySpeed(r.mn); r.mx = toDisplaySpeed(r.mx); break;
-    case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-    case CH_MANIFOLD: case CH_TURBO_OUT: case CH_EGT1: case CH_EGT2:
-      r.mn = toDisplayTemp(r.mn); r.mx = toDisplayTemp(r.mx); break;
-    case CH_BOOST: case CH_OIL:
-      r.mn = toDisplayPressure(r.mn); r.mx = toDisplayPressure(r.mx); break;
-    case CH_LAMBDA:
-      r.mn = toDisplayLambda(r.mn); r.mx = toDisplayLambda(r.mx); break;
-    default: break;
-  }
-  if(r.mx <= r.mn) r.mx = r.mn + 1;
-  return r;
+Range rangeFor(Channel c){ return Channels::rt(c).range; }
+// Range in base units (warning thresholds are stored in base)
+static inline Range baseRangeFor(Channel c){
+  const ChannelRuntime& r = Channels::rt(c);
+  float a = Channels::fromDisplay(c, r.range.mn), b = Channels::fromDisplay(c, r.range.mx);
+  return (a <= b) ? Range{a, b} : Range{b, a};
 }
 
-static inline float stepFor(Channel c){
-  if(c==CH_BATTV) return 0.1f;
-  if(c==CH_BATTV2) return 0.01f;
-  if(c==CH_BATT_CURR) return 0.1f;
-  if(c==CH_DCDC_OUT_A || c==CH_PV_AMPS) return 0.1f;
-  if(c==CH_PV_YIELD) return 0.01f;
-  if(c==CH_LAMBDA) return (g_uLambda==U_L_lambda)? 0.01f : 0.1f; // AFR shows tenths
-  return 1.0f;
-}
+static inline float stepFor(Channel c){ return Channels::rt(c).step; }
 
-MinMaxMode minMaxModeFor(Channel ch){
-  switch(ch){
-    case CH_GEAR:
-    case CH_LOCKUP:
-    case CH_HEADLIGHTS:
-    case CH_BATT_TTG:
-      return MINMAX_NONE;
-    case CH_LAMBDA:
-      return MINMAX_MIN;
-    case CH_BATT_SOC:
-      return MINMAX_MIN;
-    case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-    case CH_MANIFOLD: case CH_TURBO_OUT: case CH_EGT1: case CH_EGT2:
-    case CH_BOOST: case CH_OIL:
-      return MINMAX_MAX;
-    default:
-      return MINMAX_MAX;
-  }
-}
+MinMaxMode minMaxModeFor(Channel ch){ return Channels::traits(ch).minMax; }
 // ===== PATCH: Decade acceleration helper for hold-to-repeat (warnings) =====
 // Increase holdStep by ×10 whenever the value crosses a decade boundary in DISPLAY space.
 // baseStep: the channel's display-unit base step (from stepFor).
@@ -581,37 +473,17 @@ inline void maybeEscalateHoldStep(float baseStep, float prevVal, float newVal, i
   }
 }
 // Eligibility
-static inline bool isVictronChannel(Channel ch){
-  switch(ch){
-    case CH_BATT_SOC:
-    case CH_BATT_CURR:
-    case CH_BATT_TTG:
-    case CH_BATTV2:
-    case CH_DCDC_OUT_A:
-    case CH_DCDC_OUT_V:
-    case CH_DCDC_IN_V:
-    case CH_PV_WATTS:
-    case CH_PV_AMPS:
-    case CH_PV_YIELD:
-      return true;
-    default:
-      return false;
-  }
-}
+static inline bool isVictronChannel(Channel ch){ return (Channels::traits(ch).flags & CHF_VICTRON) != 0; }
 static inline bool isGaugeAvailable(Channel ch){
-  if(ch == CH_OIL) return false;
-  if(!persist.victronEnabled && isVictronChannel(ch)) return false;
+  const ChannelTraits& t = Channels::traits(ch);
+  if(!(t.flags & CHF_PILL)) return false;
+  if(!persist.victronEnabled && (t.flags & CHF_VICTRON)) return false;
+  if(t.source == SRC_USER) return UserCh::enabled(userChannelIndex(ch));
+  if(t.source == SRC_DERIVED) return Derived::enabled(derivedChannelIndex(ch));
   return true;
 }
-static inline bool isBarEligible(Channel ch){ return isGaugeAvailable(ch) && !(ch==CH_LOCKUP||ch==CH_GEAR||ch==CH_HEADLIGHTS); }
-// Warnings: exclude Gear/Lockup/Headlights/Actuator
-static inline bool isWarnEligible(Channel ch){
-  if(!persist.victronEnabled && isVictronChannel(ch)) return false;
-  if(ch == CH_BATT_CURR || ch == CH_BATT_TTG || ch == CH_BATTV2) return false;
-  if(ch == CH_DCDC_OUT_A || ch == CH_DCDC_OUT_V || ch == CH_DCDC_IN_V) return false;
-  if(ch == CH_PV_WATTS || ch == CH_PV_AMPS || ch == CH_PV_YIELD) return false;
-  return isGaugeAvailable(ch) && !(ch==CH_GEAR || ch==CH_LOCKUP || ch==CH_HEADLIGHTS || ch==CH_ACTUATOR);
-}
+static inline bool isBarEligible(Channel ch){ return isGaugeAvailable(ch) && (Channels::traits(ch).flags & CHF_BAR); }
+static inline bool isWarnEligible(Channel ch){ return isGaugeAvailable(ch) && (Channels::traits(ch).flags & CHF_WARN); }
 
 // ===== UI brightness via backlight PWM =====
 static inline uint8_t uiBrightnessPct(){
@@ -620,44 +492,49 @@ static inline uint8_t uiBrightnessPct(){
   return pct;
 }
 
-static uint8_t g_lastBacklightPct = 255;
+// Palette on screen: the night palette once a headlight cross-fade has swapped to it
+static bool g_nightTheme = false;
+static inline uint8_t uiPalette(){
+  if(g_nightTheme && persist.nightPalette < paletteCount()) return persist.nightPalette;
+  return paletteIndex;
+}
 
 // Palette accessors
 uint16_t COL_BG(){
-  if (isCustomPaletteIndex(paletteIndex)) return persist.customPalettes[customPaletteSlot(paletteIndex)].bg;
-  return PALETTES[paletteIndex].bg;
+  if (isCustomPaletteIndex(uiPalette())) return persist.customPalettes[customPaletteSlot(uiPalette())].bg;
+  return PALETTES[uiPalette()].bg;
 }
 uint16_t COL_CARD(){
-  if (isCustomPaletteIndex(paletteIndex)) return persist.customPalettes[customPaletteSlot(paletteIndex)].card;
-  return PALETTES[paletteIndex].card;
+  if (isCustomPaletteIndex(uiPalette())) return persist.customPalettes[customPaletteSlot(uiPalette())].card;
+  return PALETTES[uiPalette()].card;
 }
 uint16_t COL_FRAME(){
-  if (isCustomPaletteIndex(paletteIndex)) return persist.customPalettes[customPaletteSlot(paletteIndex)].frame;
-  return PALETTES[paletteIndex].frame;
+  if (isCustomPaletteIndex(uiPalette())) return persist.customPalettes[customPaletteSlot(uiPalette())].frame;
+  return PALETTES[uiPalette()].frame;
 }
 uint16_t COL_TICKS(){
-  if (isCustomPaletteIndex(paletteIndex)) return persist.customPalettes[customPaletteSlot(paletteIndex)].ticks;
-  return PALETTES[paletteIndex].ticks;
+  if (isCustomPaletteIndex(uiPalette())) return persist.customPalettes[customPaletteSlot(uiPalette())].ticks;
+  return PALETTES[uiPalette()].ticks;
 }
 uint16_t COL_TXT(){
-  if (isCustomPaletteIndex(paletteIndex)) return persist.customPalettes[customPaletteSlot(paletteIndex)].text;
-  return PALETTES[paletteIndex].text;
+  if (isCustomPaletteIndex(uiPalette())) return persist.customPalettes[customPaletteSlot(uiPalette())].text;
+  return PALETTES[uiPalette()].text;
 }
 uint16_t COL_ACCENT(){
-  if (isCustomPaletteIndex(paletteIndex)) return persist.customPalettes[customPaletteSlot(paletteIndex)].accent;
-  return PALETTES[paletteIndex].accent;
+  if (isCustomPaletteIndex(uiPalette())) return persist.customPalettes[customPaletteSlot(uiPalette())].accent;
+  return PALETTES[uiPalette()].accent;
 }
 uint16_t COL_YELLOW(){
-  if (isCustomPaletteIndex(paletteIndex)) return ILI9341_YELLOW;
-  return PALETTES[paletteIndex].yellow;
+  if (isCustomPaletteIndex(uiPalette())) return ILI9341_YELLOW;
+  return PALETTES[uiPalette()].yellow;
 }
 uint16_t COL_ORANGE(){
-  if (isCustomPaletteIndex(paletteIndex)) return 0xFD20;
-  return PALETTES[paletteIndex].orange;
+  if (isCustomPaletteIndex(uiPalette())) return 0xFD20;
+  return PALETTES[uiPalette()].orange;
 }
 uint16_t COL_RED(){
-  if (isCustomPaletteIndex(paletteIndex)) return ILI9341_RED;
-  return PALETTES[paletteIndex].red;
+  if (isCustomPaletteIndex(uiPalette())) return ILI9341_RED;
+  return PALETTES[uiPalette()].red;
 }
 
 // ===================== Helpers =====================
@@ -665,7 +542,6 @@ float clampf(float v,float lo,float hi){ if(!isfinite(v)) return lo; return v<lo
 inline uint16_t be16(const uint8_t* d){ return (uint16_t)d[0]<<8 | d[1]; }
 void clearRegion(int x,int y,int w,int h,uint16_t col){ if(w>0&&h>0)tft.fillRect(x,y,w,h,col); }
 uint16_t barFillColor(){ return COL_ACCENT(); }
-PillSpec pillSpec(int idx){ int r=idx/2,c=idx%2; return { GRID_LEFT + c*(CELL_W+CELL_GAP_X), GRID_TOP + r*(CELL_H+CELL_GAP_Y), CELL_W, CELL_H }; }
 const char* tcStateText(TCState s) {
   switch (s) {
     case TC_Applying:  return "Applying";
@@ -684,11 +560,11 @@ uint16_t tcStateColor(TCState s) {
   return RGB565(160,160,160);                              // Unlocked
 }
 
-static inline void copyStringToBuffer(const String& src, char* dest, size_t maxLen){
+static inline void copyStringToBuffer(const char* src, char* dest, size_t maxLen){
   if(maxLen == 0) return;
-  size_t n = src.length();
-  if(n >= maxLen) n = maxLen - 1;
-  memcpy(dest, src.c_str(), n);
+  size_t n = 0;
+  if(src) while(n < maxLen - 1 && src[n]) n++;   // stops at the NUL, never reads past src
+  memcpy(dest, src, n);
   dest[n] = '\0';
 }
 
@@ -699,20 +575,21 @@ static inline int hexNibble(char c){
   return -1;
 }
 
-static inline bool parseHexBytes(String input, uint8_t* out, size_t len){
-  String filtered;
-  filtered.reserve(input.length());
-  for(size_t i=0;i<input.length();i++){
-    char c = input.charAt(i);
-    if(isxdigit((unsigned char)c)) filtered += c;
-  }
-  if(filtered.length() != (int)(len * 2)) return false;
-  for(size_t i=0;i<len;i++){
-    int hi = hexNibble(filtered.charAt(i*2));
-    int lo = hexNibble(filtered.charAt(i*2 + 1));
-    if(hi < 0 || lo < 0) return false;
-    out[i] = (uint8_t)((hi << 4) | lo);
-  }
+// Hex digits anywhere in input (separators ignored) must give exactly len bytes
+static inline bool parseHexBytes(const char* input, uint8_t* out, size_t len){
+  uint8_t tmp[32];
+  if(len > sizeof(tmp)) return false;
+  size_t digits = 0;
+  for(; *input; input++){
+    const int v = hexNibble(*input);
+    if(v < 0) continue;
+    if(digits >= len * 2) return false;
+    if(digits & 1) tmp[digits / 2] |= (uint8_t)v;
+    else tmp[digits / 2] = (uint8_t)(v << 4);
+    digits++;
+  }
+  if(digits != len * 2) return false;
+  memcpy(out, tmp, len);
   return true;
 }
 
@@ -725,64 +602,145 @@ static inline void formatHexKey(const uint8_t* key, size_t len, char* out, size_
   }
 }
 
-static inline void normalizeMacString(String input, char* dest, size_t maxLen){
-  String filtered;
-  filtered.reserve(input.length());
-  for(size_t i=0;i<input.length();i++){
-    char c = input.charAt(i);
-    if(isxdigit((unsigned char)c)) filtered += (char)tolower((unsigned char)c);
+// Twelve hex digits in any notation become "aa:bb:cc:dd:ee:ff"; anything else is kept as typed
+static inline void normalizeMacString(const char* input, char* dest, size_t maxLen){
+  char hex[12];
+  size_t n = 0;
+  for(const char* c = input; *c; c++){
+    if(!isxdigit((unsigned char)*c)) continue;
+    if(n == sizeof(hex)){ n++; break; }
+    hex[n++] = (char)tolower((unsigned char)*c);
   }
-  if(filtered.length() == 12){
-    String formatted;
-    formatted.reserve(17);
+  if(n == sizeof(hex) && maxLen >= 18){
     for(int i=0;i<6;i++){
-      if(i) formatted += ':';
-      formatted += filtered.substring(i*2, i*2 + 2);
+      dest[i*3] = hex[i*2];
+      dest[i*3 + 1] = hex[i*2 + 1];
+      dest[i*3 + 2] = (i < 5) ? ':' : '\0';
     }
-    copyStringToBuffer(formatted, dest, maxLen);
     return;
   }
   copyStringToBuffer(input, dest, maxLen);
 }
 
-static inline String htmlEscape(const String& input){
-  String out;
-  out.reserve(input.length());
-  for(size_t i=0;i<input.length();i++){
-    char c = input.charAt(i);
-    switch(c){
-      case '&': out += F("&amp;"); break;
-      case '<': out += F("&lt;"); break;
-      case '>': out += F("&gt;"); break;
-      case '"': out += F("&quot;"); break;
-      case '\'': out += F("&#39;"); break;
-      default: out += c; break;
-    }
+static inline const char* formatIp(const IPAddress& ip, char* buf, size_t len){
+  snprintf(buf, len, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return buf;
+}
+
+static inline const char* wifiPageUrl(char* buf, size_t len){
+  if(!g_wifiActive) return "WiFi offline";
+  char ip[16];
+  snprintf(buf, len, "http://%s", formatIp(g_wifiIp, ip, sizeof(ip)));
+  return buf;
+}
+
+static inline void sanitizeUserChannels(){
+  for(uint8_t i=0;i<USER_CHANNEL_COUNT;i++){
+    UserChannelDef& u = persist.userChannels[i];
+    u.enabled = u.enabled ? 1 : 0;
+    if(u.toBit > 63) u.toBit = 63;
+    if(u.fromBit > u.toBit) u.fromBit = u.toBit;
+    if(u.toBit - u.fromBit > 31) u.toBit = u.fromBit + 31;   // CanField::extract returns at most 32 bits
+    if(!(u.canId & CAN_EFF_FLAG)) u.canId &= CAN_SFF_MASK;
+    if(u.bus >= CanBus::MAX_BUSES) u.bus = CFG::CAN_BUS_PT;
+    if(u.order > CanField::ORDER_BE) u.order = CanField::ORDER_LE;
+    u.isSigned = u.isSigned ? 1 : 0;
+    if(u.decimals > 3) u.decimals = 3;
+    if(!isfinite(u.scale) || u.scale == 0.0f) u.scale = 1.0f;
+    if(!isfinite(u.bias)) u.bias = 0.0f;
+    if(!isfinite(u.rangeMin)) u.rangeMin = 0.0f;
+    if(!isfinite(u.rangeMax) || u.rangeMax <= u.rangeMin) u.rangeMax = u.rangeMin + 1.0f;
+    u.label[USER_LABEL_LEN] = '\0';
+    u.unit[USER_UNIT_LEN] = '\0';
+  }
+  for(uint8_t i=0;i<DERIVED_CHANNEL_COUNT;i++){
+    DerivedChannelDef& d = persist.derivedChannels[i];
+    d.enabled = d.enabled ? 1 : 0;
+    if(d.decimals > 3) d.decimals = 3;
+    if(!isfinite(d.rangeMin)) d.rangeMin = 0.0f;
+    if(!isfinite(d.rangeMax) || d.rangeMax <= d.rangeMin) d.rangeMax = d.rangeMin + 1.0f;
+    d.expr[DERIVED_EXPR_LEN] = '\0';
+    d.label[USER_LABEL_LEN] = '\0';
+    d.unit[USER_UNIT_LEN] = '\0';
+  }
+}
+
+// ===================== CAN acceptance filters =====================
+// The body bus passes CFG::CAN2_ACCEPT plus the IDs of the enabled user channels read from it;
+// a list the controller cannot hold opens its filters instead (CanBus::setFilters). The sniffer
+// and the GVRET bridge want every frame on both buses, so the filters stay open while either is up.
+static uint32_t g_bodyAccept[sizeof(CFG::CAN2_ACCEPT) / sizeof(CFG::CAN2_ACCEPT[0]) + USER_CHANNEL_COUNT];
+static bool g_canFiltersOpen = false;
+
+static uint8_t buildBodyAccept(){
+  uint8_t n = 0;
+  for(uint32_t id : CFG::CAN2_ACCEPT) g_bodyAccept[n++] = id;
+  for(uint8_t i=0;i<USER_CHANNEL_COUNT;i++){
+    const UserChannelDef& u = persist.userChannels[i];
+    if(!u.enabled || u.bus != CFG::CAN_BUS_BODY) continue;
+    bool dup = false;
+    for(uint8_t k=0;k<n && !dup;k++) dup = g_bodyAccept[k] == u.canId;
+    if(!dup) g_bodyAccept[n++] = u.canId;
+  }
+  return n;
+}
+
+// After the user channels change. While open, the new list waits for the sniffer or bridge to close.
+static void applyBodyAccept(){
+  if(!CanBus::present(CFG::CAN_BUS_BODY)) return;
+  CanBus::setAccept(CFG::CAN_BUS_BODY, g_bodyAccept, buildBodyAccept());
+  if(!g_canFiltersOpen) CanBus::restoreFilters(CFG::CAN_BUS_BODY);
+}
+
+static void serviceCanFilters(){
+  const bool open = menuState == MENU_CAN_SNIFF || Gvret::connected();
+  if(open == g_canFiltersOpen) return;
+  g_canFiltersOpen = open;
+  for(uint8_t b=0;b<CanBus::MAX_BUSES;b++){
+    if(open) CanBus::setFilters(b, nullptr, 0);
+    else CanBus::restoreFilters(b);
+  }
+}
+
+static inline void sanitizeFilters(){
+  for(uint8_t i=0;i<CH__COUNT;i++){
+    ChannelFilterDef& f = persist.filters[i];
+    if(f.median != 3 && f.median != 5) f.median = 0;
+    f.flags &= Filters::FILTER_WARN_RAW;
+    if(f.emaTauMs > 10000) f.emaTauMs = 10000;
+    if(!isfinite(f.slewPerSec) || f.slewPerSec < 0) f.slewPerSec = 0;
+    const SourceKind src = Channels::traits((Channel)i).source;
+    if(src == SRC_STATE || src == SRC_TRIP || !Filters::supports((Channel)i)) f = ChannelFilterDef{};
   }
-  return out;
 }
 
-static inline String wifiPageUrl(){
-  if(!g_wifiActive) return String("WiFi offline");
-  return String("http://") + g_wifiIp.toString();
+// Any numeric non-trip channel can supply the fuel rate (L/h), typically a user or derived gauge
+static inline bool isTripFuelSource(uint8_t c){
+  if(c >= CH__COUNT) return false;
+  const SourceKind src = Channels::traits((Channel)c).source;
+  return src != SRC_STATE && src != SRC_TRIP;
 }
 
 static inline void sanitizeLayout(){
   for(int s=0;s<SCREEN_COUNT;s++){
-    for(int i=0;i<4;i++) {
-      if(persist.pillChannel[s][i]>=CH__COUNT) persist.pillChannel[s][i]=CH_SOOT;
-      if(!isGaugeAvailable((Channel)persist.pillChannel[s][i])) persist.pillChannel[s][i]=CH_BOOST;
+    ScreenLayout& l = persist.layouts[s];
+    if(l.tpl >= LT__COUNT) l.tpl = LT_BAR_QUAD;
+    const uint8_t n = Layout::count(l.tpl);
+    // All slots stay valid so switching templates never exposes a stale channel
+    for(uint8_t i=0;i<LAYOUT_MAX_WIDGETS;i++){
+      const bool bar = (i < n) && Layout::needsRange(Layout::cell(l.tpl, i).kind);
+      if(l.ch[i]>=CH__COUNT) l.ch[i]=CH_SOOT;
+      if(bar ? !isBarEligible((Channel)l.ch[i]) : !isGaugeAvailable((Channel)l.ch[i])) l.ch[i] = bar ? CH_SOOT : CH_BOOST;
     }
-    if(persist.barChannel[s]>=CH__COUNT || !isBarEligible((Channel)persist.barChannel[s])) persist.barChannel[s]=CH_SOOT;
   }
 }
 
 static inline void ensureWifiDefaults(){
   if(persist.wifiSsid[0] == '\0'){
-    copyStringToBuffer(String(CFG::WIFI_DEFAULT_SSID), persist.wifiSsid, sizeof(persist.wifiSsid));
+    copyStringToBuffer(CFG::WIFI_DEFAULT_SSID, persist.wifiSsid, sizeof(persist.wifiSsid));
   }
   if(strlen(persist.wifiPass) < CFG::WIFI_MIN_PASS_LEN){
-    copyStringToBuffer(String(CFG::WIFI_DEFAULT_PASS), persist.wifiPass, sizeof(persist.wifiPass));
+    copyStringToBuffer(CFG::WIFI_DEFAULT_PASS, persist.wifiPass, sizeof(persist.wifiPass));
   }
 }
 
@@ -801,9 +759,9 @@ static inline bool isMacBlank(const char* mac){
 }
 
 static inline void ensureVictronDefaults(){
-  if(isMacBlank(persist.victronBmvMac)) copyStringToBuffer(String(VictronBle::kBmvMac), persist.victronBmvMac, sizeof(persist.victronBmvMac));
-  if(isMacBlank(persist.victronMpptMac)) copyStringToBuffer(String(VictronBle::kMpptMac), persist.victronMpptMac, sizeof(persist.victronMpptMac));
-  if(isMacBlank(persist.victronOrionMac)) copyStringToBuffer(String(VictronBle::kOrionMac), persist.victronOrionMac, sizeof(persist.victronOrionMac));
+  if(isMacBlank(persist.victronBmvMac)) copyStringToBuffer(VictronBle::kBmvMac, persist.victronBmvMac, sizeof(persist.victronBmvMac));
+  if(isMacBlank(persist.victronMpptMac)) copyStringToBuffer(VictronBle::kMpptMac, persist.victronMpptMac, sizeof(persist.victronMpptMac));
+  if(isMacBlank(persist.victronOrionMac)) copyStringToBuffer(VictronBle::kOrionMac, persist.victronOrionMac, sizeof(persist.victronOrionMac));
   if(isKeyBlank(persist.victronBmvKey, sizeof(persist.victronBmvKey))) memcpy(persist.victronBmvKey, VictronBle::kBmvKey, sizeof(persist.victronBmvKey));
   if(isKeyBlank(persist.victronMpptKey, sizeof(persist.victronMpptKey))) memcpy(persist.victronMpptKey, VictronBle::kMpptKey, sizeof(persist.victronMpptKey));
   if(isKeyBlank(persist.victronOrionKey, sizeof(persist.victronOrionKey))) memcpy(persist.victronOrionKey, VictronBle::kOrionKey, sizeof(persist.victronOrionKey));
@@ -833,19 +791,31 @@ static void stopWifiAp(){
   g_wifiActive = false;
 }
 
+// Which share of the radio BLE scanning may take this poll (see RadioCoex)
+static RadioCoex radioCoexMode(unsigned long now){
+  if(!g_wifiActive) return COEX_BLE_ONLY;
+  if(Gvret::connected()) return COEX_HTTP;   // a bridge client streams continuously
+  if(g_webStats.requests && now - g_webStats.lastMs < WEB_HTTP_HOLD_MS) return COEX_HTTP;
+  return WiFi.softAPgetStationNum() > 0 ? COEX_AP_CLIENT : COEX_AP_IDLE;
+}
+
 static void enterWifiPage(){
   if(g_wifiPageActive) return;
+  HeapMon::exemptPass();
   g_wifiPageActive = true;
   startWifiAp();
   if(!g_webServerActive){
     setupWebServer();
     g_webServerActive = true;
   }
+  Gvret::begin(TX_TAG_GVRET);
 }
 
 static void exitWifiPage(){
   if(!g_wifiPageActive) return;
+  HeapMon::exemptPass();
   g_wifiPageActive = false;
+  Gvret::end();
   if(g_webServerActive){
     webServer.stop();
     g_webServerActive = false;
@@ -853,29 +823,28 @@ static void exitWifiPage(){
   stopWifiAp();
 }
 
-static void appendOption(String& html, int value, int current, const String& label){
+static void appendOption(HtmlOut& html, int value, int current, const char* label){
   html += F("<option value=\"");
   html += value;
   html += F("\"");
   if(value == current) html += F(" selected");
   html += F(">");
-  html += label;
+  html.escaped(label);   // user gauge labels and units come from the form
   html += F("</option>");
 }
 
-static inline String htmlColorFrom565(uint16_t color){
+static inline const char* htmlColorFrom565(uint16_t color, char (&buf)[8]){
   uint8_t r = (color >> 11) & 0x1F;
   uint8_t g = (color >> 5) & 0x3F;
   uint8_t b = color & 0x1F;
   r = (r * 255 + 15) / 31;
   g = (g * 255 + 31) / 63;
   b = (b * 255 + 15) / 31;
-  char buf[8];
   snprintf(buf, sizeof(buf), "#%02X%02X%02X", r, g, b);
-  return String(buf);
+  return buf;
 }
 
-static void appendPaletteOption(String& html, int idx, int current){
+static void appendPaletteOption(HtmlOut& html, int idx, int current){
   uint16_t card;
   uint16_t frame;
   uint16_t ticks;
@@ -899,55 +868,353 @@ static void appendPaletteOption(String& html, int idx, int current){
     accent = palette.accent;
     bg = palette.bg;
   }
+  char col[8];
   html += F("<option value=\"");
   html += idx;
   html += F("\"");
   if(idx == current) html += F(" selected");
   html += F(" data-card=\"");
-  html += htmlColorFrom565(card);
+  html += htmlColorFrom565(card, col);
   html += F("\" data-frame=\"");
-  html += htmlColorFrom565(frame);
+  html += htmlColorFrom565(frame, col);
   html += F("\" data-ticks=\"");
-  html += htmlColorFrom565(ticks);
+  html += htmlColorFrom565(ticks, col);
   html += F("\" data-text=\"");
-  html += htmlColorFrom565(text);
+  html += htmlColorFrom565(text, col);
   html += F("\" data-accent=\"");
-  html += htmlColorFrom565(accent);
+  html += htmlColorFrom565(accent, col);
   html += F("\" data-bg=\"");
-  html += htmlColorFrom565(bg);
+  html += htmlColorFrom565(bg, col);
   html += F("\">");
   html += paletteNameForIndex(idx);
   html += F("</option>");
 }
 
-static void appendChannelOptions(String& html, uint8_t current, bool barEligible){
+// n-th pill of the current screen for the palette preview (falls back to the stored slot)
+// The layout's n-th pill, or CH__COUNT when it has fewer
+static Channel previewPillChannel(uint8_t n){
+  const ScreenLayout& l = currentLayout();
+  for(uint8_t i=0;i<Layout::count(l.tpl);i++){
+    if(Layout::cell(l.tpl, i).kind != Layout::WK_PILL) continue;
+    if(n-- == 0) return (Channel)l.ch[i];
+  }
+  return CH__COUNT;
+}
+
+static void appendChannelOptions(HtmlOut& html, uint8_t current, bool barEligible){
   for(uint8_t i=0;i<CH__COUNT;i++){
     Channel ch = (Channel)i;
     if(barEligible && !isBarEligible(ch)) continue;
     if(!barEligible && !isGaugeAvailable(ch)) continue;
-    String label = String(labelText(ch));
-    String unit = String(unitLabel(ch));
-    if(unit.length() > 0){
-      label += " (";
-      label += unit;
-      label += ")";
-    }
+    const char* unit = unitLabel(ch);
+    char label[40];
+    if(unit && unit[0]) snprintf(label, sizeof(label), "%.15s (%.20s)", labelText(ch), unit);
+    else copyStringToBuffer(labelText(ch), label, sizeof(label));
     appendOption(html, i, current, label);
   }
 }
 
-static inline void appendPreviewValue(String& html, Channel ch){
+static inline void appendPreviewValue(HtmlOut& html, Channel ch){
   html += F("0");
   const char* unit = unitLabel(ch);
   if(unit && unit[0]){
     html += F(" ");
-    html += unit;
+    html.escaped(unit);
+  }
+}
+
+// Pills the layout does not have are left out; the palette script skips missing ids
+static void appendPreviewPill(HtmlOut& html, uint8_t n, const char* pos){
+  const Channel ch = previewPillChannel(n);
+  if(ch >= CH__COUNT) return;
+  char head[96];
+  snprintf(head, sizeof(head), "<div class=\"dash-pill\" id=\"palettePreviewPill%u\" style=\"%s\">", (unsigned)(n + 1), pos);
+  html += head;
+  html += F("<div class=\"dash-pill-label\">");
+  html.escaped(labelText(ch));
+  html += F("</div>");
+  html += F("<div class=\"dash-pill-value\">");
+  appendPreviewValue(html, ch);
+  html += F("</div>");
+  html += F("</div>");
+}
+
+static void appendUserChannelInput(HtmlOut& html, uint8_t i, const char* field, const char* value, const char* attrs){
+  html += F("<td><input name=\"uc");
+  html += i;
+  html += F("_");
+  html += field;
+  html += F("\" value=\"");
+  html.escaped(value);
+  html += F("\" ");
+  html += attrs;
+  html += F("></td>");
+}
+
+static void appendUserChannelRow(HtmlOut& html, uint8_t i){
+  const UserChannelDef& u = persist.userChannels[i];
+  char idBuf[12];
+  snprintf(idBuf, sizeof(idBuf), "%lX", (unsigned long)(u.canId & CAN_EFF_MASK));
+  html += F("<tr><td><input type=\"checkbox\" name=\"uc");
+  html += i;
+  html += F("_en\" value=\"1\"");
+  if(u.enabled) html += F(" checked");
+  html += F("> ");
+  html += Channels::traits((Channel)(CH_USER1 + i)).label;
+  html += F("</td>");
+  char num[16];
+  appendUserChannelInput(html, i, "label", u.label, "maxlength=\"11\" size=\"8\"");
+  appendUserChannelInput(html, i, "unit", u.unit, "maxlength=\"7\" size=\"4\"");
+  appendUserChannelInput(html, i, "id", idBuf, "size=\"8\"");
+  html += F("<td><input type=\"checkbox\" name=\"uc");
+  html += i;
+  html += F("_ext\" value=\"1\"");
+  if(u.canId & CAN_EFF_FLAG) html += F(" checked");
+  html += F("></td><td><select name=\"uc");
+  html += i;
+  html += F("_bus\">");
+  appendOption(html, CFG::CAN_BUS_PT, u.bus, "PT");
+  appendOption(html, CFG::CAN_BUS_BODY, u.bus, "Body");
+  html += F("</select></td>");
+  snprintf(num, sizeof(num), "%u", (unsigned)u.fromBit);
+  appendUserChannelInput(html, i, "from", num, "type=\"number\" min=\"0\" max=\"63\"");
+  snprintf(num, sizeof(num), "%u", (unsigned)u.toBit);
+  appendUserChannelInput(html, i, "to", num, "type=\"number\" min=\"0\" max=\"63\"");
+  html += F("<td><select name=\"uc");
+  html += i;
+  html += F("_order\">");
+  appendOption(html, CanField::ORDER_LE, u.order, "LE");
+  appendOption(html, CanField::ORDER_BE, u.order, "BE");
+  html += F("</select></td><td><input type=\"checkbox\" name=\"uc");
+  html += i;
+  html += F("_signed\" value=\"1\"");
+  if(u.isSigned) html += F(" checked");
+  html += F("></td>");
+  snprintf(num, sizeof(num), "%.6f", u.scale);
+  appendUserChannelInput(html, i, "scale", num, "size=\"6\"");
+  snprintf(num, sizeof(num), "%.3f", u.bias);
+  appendUserChannelInput(html, i, "bias", num, "size=\"6\"");
+  snprintf(num, sizeof(num), "%.2f", u.rangeMin);
+  appendUserChannelInput(html, i, "min", num, "size=\"5\"");
+  snprintf(num, sizeof(num), "%.2f", u.rangeMax);
+  appendUserChannelInput(html, i, "max", num, "size=\"5\"");
+  snprintf(num, sizeof(num), "%u", (unsigned)u.decimals);
+  appendUserChannelInput(html, i, "dec", num, "type=\"number\" min=\"0\" max=\"3\"");
+  html += F("</tr>");
+}
+
+static void appendDerivedChannelRow(HtmlOut& html, uint8_t i){
+  const DerivedChannelDef& d = persist.derivedChannels[i];
+  html += F("<tr><td><input type=\"checkbox\" name=\"dc");
+  html += i;
+  html += F("_en\" value=\"1\"");
+  if(d.enabled) html += F(" checked");
+  html += F("> ");
+  html += Channels::traits((Channel)(CH_CALC1 + i)).label;
+  html += F("</td>");
+  auto input = [&](const char* field, const char* value, const char* attrs){
+    html += F("<td><input name=\"dc");
+    html += i;
+    html += '_';
+    html += field;
+    html += F("\" value=\"");
+    html.escaped(value);
+    html += F("\" ");
+    html += attrs;
+    html += F("></td>");
+  };
+  char num[16];
+  input("label", d.label, "maxlength=\"11\" size=\"8\"");
+  input("unit", d.unit, "maxlength=\"7\" size=\"4\"");
+  input("expr", d.expr, "maxlength=\"63\" size=\"28\"");
+  snprintf(num, sizeof(num), "%.2f", d.rangeMin);
+  input("min", num, "size=\"5\"");
+  snprintf(num, sizeof(num), "%.2f", d.rangeMax);
+  input("max", num, "size=\"5\"");
+  snprintf(num, sizeof(num), "%u", (unsigned)d.decimals);
+  input("dec", num, "type=\"number\" min=\"0\" max=\"3\"");
+  html += F("<td>");
+  if(!d.enabled) html += F("off");
+  else if(Derived::enabled(i)){ html += F("ok, "); html += Derived::codeSize(i); html += F(" bytes"); }
+  else html.escaped(Derived::error(i));
+  html += F("</td></tr>");
+}
+
+static void appendFilterRow(HtmlOut& html, Channel ch){
+  const SourceKind src = Channels::traits(ch).source;
+  if(src == SRC_STATE || src == SRC_TRIP || !isGaugeAvailable(ch)) return;
+  html += F("<tr><td>");
+  html.escaped(labelText(ch));
+  if(!Filters::supports(ch)){ html += F("</td><td colspan=\"4\">range too wide to filter</td></tr>"); return; }
+  const ChannelFilterDef& f = persist.filters[ch];
+  char pre[12];
+  snprintf(pre, sizeof(pre), "flt%d_", (int)ch);
+  html += F("</td><td><select name=\"");
+  html += pre;
+  html += F("med\">");
+  appendOption(html, 0, f.median, "Off");
+  appendOption(html, 3, f.median, "3");
+  appendOption(html, 5, f.median, "5");
+  html += F("</select></td><td><input name=\"");
+  html += pre;
+  html += F("tau\" type=\"number\" min=\"0\" max=\"10000\" value=\"");
+  html += f.emaTauMs;
+  html += F("\"></td><td><input name=\"");
+  html += pre;
+  html += F("slew\" size=\"6\" value=\"");
+  html.number(f.slewPerSec, 2);
+  html += F("\"></td><td><input type=\"checkbox\" name=\"");
+  html += pre;
+  html += F("raw\" value=\"1\"");
+  if(f.flags & Filters::FILTER_WARN_RAW) html += F(" checked");
+  html += F("></td></tr>");
+}
+
+static void appendRegenSection(HtmlOut& html){
+  const RegenLog& lg = Regen::log();
+  char buf[96];
+  html += F("<section><h2>DPF Regens</h2><p>");
+  const float km = Regen::sootPerKm(), h = Regen::sootPerHour(), toKm = Regen::kmToNext();
+  snprintf(buf, sizeof(buf), "Soot %.1f%%, regen expected at %.0f%%. ", soot_pct, Regen::triggerPct());
+  html += buf;
+  if(isfinite(km)){ snprintf(buf, sizeof(buf), "%.2f%% per 100 %s, ", km * 100.0f / distInUnit(1.0f), distUnit()); html += buf; }
+  if(isfinite(h)){ snprintf(buf, sizeof(buf), "%.2f%% per engine hour. ", h); html += buf; }
+  if(isfinite(toKm)){ snprintf(buf, sizeof(buf), "Next regen in about %.0f %s. ", distInUnit(toKm), distUnit()); html += buf; }
+  snprintf(buf, sizeof(buf), "Logged %.0f %s, %.1f engine hours, %u regens.", distInUnit(Trip::distanceKm(Trip::LIFETIME)), distUnit(),
+           Trip::engineHours(Trip::LIFETIME), (unsigned)lg.total);
+  html += buf;
+  html += F("</p><table><tr><th>#</th><th>Engine h</th><th>Duration</th><th>Paused</th><th>Distance</th>"
+            "<th>Soot start</th><th>Soot end</th><th>EGT1 max</th><th>EGT2 max</th><th>Result</th></tr>");
+  for(uint8_t i=0;i<lg.count;i++){
+    const RegenEvent& e = Regen::event(i);
+    snprintf(buf, sizeof(buf), "<tr><td>%u</td><td>%.1f</td><td>%u:%02u</td><td>%u&times; %us</td><td>%.1f %s</td>",
+             (unsigned)(lg.total - i), e.startEngineS / 3600.0f, (unsigned)(e.durationS / 60), (unsigned)(e.durationS % 60),
+             (unsigned)e.pauses, (unsigned)e.pausedS, distInUnit(e.distance10M / 100.0f), distUnit());
+    html += buf;
+    snprintf(buf, sizeof(buf), "<td>%.1f%%</td><td>%.1f%%</td><td>%d</td><td>%d</td><td>%s</td></tr>",
+             e.sootStartX10 / 10.0f, e.sootEndX10 / 10.0f, (int)e.egt1MaxC, (int)e.egt2MaxC,
+             (e.flags & Regen::EV_INCOMPLETE) ? "incomplete" : "complete");
+    html += buf;
+  }
+  html += F("</table><label><input type=\"checkbox\" name=\"regenClear\" value=\"1\"> Clear regen history and learned rates</label></section>");
+}
+
+static void appendPowerSection(HtmlOut& html){
+  static const uint8_t kMonitorMin[] = {0, 5, 15, 30, 60};
+  const Power::Stats& ps = Power::stats();
+  char buf[128];
+  html += F("<section><h2>Parked</h2>");
+  snprintf(buf, sizeof(buf), "<p>Sleeps %lu s after the last speed/RPM frame, wakes on the next one.</p>",
+           (unsigned long)(Power::IGNITION_OFF_MS / 1000));
+  html += buf;
+  html += F("<label>Victron sample while parked <select name=\"parkMonitor\">");
+  for(uint8_t m : kMonitorMin){
+    if(m) snprintf(buf, sizeof(buf), "Every %u min", (unsigned)m);
+    else snprintf(buf, sizeof(buf), "Off");
+    appendOption(html, m, persist.parkedMonitorMin, buf);
+  }
+  html += F("</select></label>");
+  html += F("<table><tr><th>State</th><th>Time</th><th>Awake</th></tr>");
+  for(uint8_t i=0;i<Power::PS__COUNT;i++){
+    const Power::State st = (Power::State)i;
+    snprintf(buf, sizeof(buf), "<tr><td>%s</td><td>%lu s</td><td>%u%%</td></tr>", Power::stateName(st),
+             (unsigned long)(ps.stateMs[i] / 1000), (unsigned)Power::awakePct(st));
+    html += buf;
+  }
+  html += F("</table>");
+  snprintf(buf, sizeof(buf), "<p>Parks %lu, CAN wakes %lu (false %lu), resume %lu ms (max %lu)</p>",
+           (unsigned long)ps.parks, (unsigned long)ps.canWakes, (unsigned long)ps.falseWakes,
+           (unsigned long)ps.lastResumeMs, (unsigned long)ps.maxResumeMs);
+  html += buf;
+  html += F("</section>");
+}
+
+static void appendBridgeSection(HtmlOut& html){
+  const Gvret::Stats& gs = Gvret::stats();
+  char buf[128];
+  html += F("<section><h2>CAN bridge</h2>");
+  char ip[16];
+  snprintf(buf, sizeof(buf), "<p>GVRET on %s port %u (SavvyCAN: Network, GVRET). %s</p>", formatIp(g_wifiIp, ip, sizeof(ip)),
+           (unsigned)Gvret::PORT, Gvret::connected() ? "Client connected." : "No client.");
+  html += buf;
+  snprintf(buf, sizeof(buf), "<p>%u frames/s, sent %lu, dropped %lu, stalls %lu, TX %lu (rejected %lu)</p>",
+           (unsigned)gs.framesPerSec, (unsigned long)gs.sent, (unsigned long)gs.dropped, (unsigned long)gs.stalls,
+           (unsigned long)gs.txQueued, (unsigned long)gs.txRejected);
+  html += buf;
+  html += F("</section>");
+}
+
+static void appendMemorySection(HtmlOut& html){
+  const HeapMon::Stats& hs = HeapMon::stats();
+  char buf[160];
+  html += F("<section><h2>Memory</h2>");
+  snprintf(buf, sizeof(buf), "<p>Free heap %lu bytes (lowest %lu), largest free block %lu (lowest %lu).</p>",
+           (unsigned long)hs.freeBytes, (unsigned long)hs.minFreeBytes, (unsigned long)hs.largestBlock,
+           (unsigned long)hs.minLargestBlock);
+  html += buf;
+#if DEBUG_HEAP
+  snprintf(buf, sizeof(buf), "<p>Loop passes %lu, %lu allocated (%lu allocations), %lu exempt.</p>",
+           (unsigned long)hs.passes, (unsigned long)hs.allocPasses, (unsigned long)hs.allocs,
+           (unsigned long)hs.exemptPasses);
+  html += buf;
+#endif
+  html += F("</section>");
+}
+
+static void appendTripSection(HtmlOut& html){
+  static const char* const kRecordNames[TRIP_RECORDS] = {"Trip A", "Trip B", "Lifetime"};
+  static const char* const kConvNames[TRIP_CONV_SLOTS] = {"Unlocked", "Applying", "Releasing", "Flex", "Full"};
+  const char* du = distUnit();
+  const char* su = (g_uSpeed == U_S_mph) ? "mph" : "km/h";
+  char buf[128];
+  html += F("<section><h2>Trip Computer</h2><table><tr><th></th><th>Distance</th><th>Engine h</th><th>Avg speed</th>"
+            "<th>Max speed</th><th>EGT &ge; 650C</th><th>Fuel</th><th>Gears</th><th>Converter</th></tr>");
+  for(uint8_t r=0;r<TRIP_RECORDS;r++){
+    const Trip::Record rec = (Trip::Record)r;
+    const TripRecord& t = Trip::record(rec);
+    const float avg = Trip::avgSpeedKmh(rec);
+    snprintf(buf, sizeof(buf), "<tr><td>%s</td><td>%.1f %s</td><td>%.1f</td>", kRecordNames[r],
+             distInUnit(Trip::distanceKm(rec)), du, Trip::engineHours(rec));
+    html += buf;
+    if(isfinite(avg)) snprintf(buf, sizeof(buf), "<td>%.0f %s</td>", distInUnit(avg), su);
+    else snprintf(buf, sizeof(buf), "<td>--</td>");
+    html += buf;
+    snprintf(buf, sizeof(buf), "<td>%.0f %s</td><td>%u min</td><td>%.1f L</td><td>", distInUnit(Trip::maxSpeedKmh(rec)), su,
+             (unsigned)(t.c[Trip::HIGH_EGT_S] / 60), Trip::fuelLitres(rec));
+    html += buf;
+    // Share of driving time per gear / converter state
+    uint32_t total = 0;
+    for(uint8_t g=0;g<TRIP_GEAR_SLOTS;g++) total += t.c[Trip::GEAR_S0 + g];
+    for(uint8_t g=0;g<TRIP_GEAR_SLOTS && total;g++){
+      const uint32_t v = t.c[Trip::GEAR_S0 + g];
+      if(!v) continue;
+      snprintf(buf, sizeof(buf), "%s %u%% ", Trip::gearSlotName(g), (unsigned)((v * 100 + total / 2) / total));
+      html += buf;
+    }
+    html += F("</td><td>");
+    total = 0;
+    for(uint8_t c=0;c<TRIP_CONV_SLOTS;c++) total += t.c[Trip::CONV_S0 + c];
+    for(uint8_t c=0;c<TRIP_CONV_SLOTS && total;c++){
+      const uint32_t v = t.c[Trip::CONV_S0 + c];
+      if(!v) continue;
+      snprintf(buf, sizeof(buf), "%s %u%% ", kConvNames[c], (unsigned)((v * 100 + total / 2) / total));
+      html += buf;
+    }
+    html += F("</td></tr>");
+  }
+  html += F("</table><label>Fuel rate source (L/h) <select name=\"tripFuel\">");
+  appendOption(html, CH__COUNT, persist.tripLog.fuelChannel, "None");
+  for(uint8_t i=0;i<CH__COUNT;i++){
+    if(!isTripFuelSource(i) || !isGaugeAvailable((Channel)i)) continue;
+    appendOption(html, i, persist.tripLog.fuelChannel, labelText((Channel)i));
   }
+  html += F("</select></label>");
+  html += F("<label><input type=\"checkbox\" name=\"tripResetA\" value=\"1\"> Reset trip A</label>");
+  html += F("<label><input type=\"checkbox\" name=\"tripResetB\" value=\"1\"> Reset trip B</label></section>");
 }
 
 static void handleWebConfigPage(){
-  String html;
-  html.reserve(40000);
+  HtmlOut html(webServer, 200, "text/html");
   html += F("<!doctype html><html><head><meta charset=\"utf-8\">");
   html += F("<meta name=\"viewport\" content=\"width=device-width,initial-scale=1\">");
   html += F("<title>Xiao Dash WiFi Config</title>");
@@ -977,18 +1244,19 @@ static void handleWebConfigPage(){
   html += F("<div class=\"app\">");
   html += F("<div class=\"header\"><h1>Xiao Dash Configuration</h1>");
   html += F("<p class=\"intro\">Connect to <strong>");
-  html += htmlEscape(persist.wifiSsid);
+  html.escaped(persist.wifiSsid);
   html += F("</strong> and open <strong>");
-  html += wifiPageUrl();
+  char url[32];
+  html += wifiPageUrl(url, sizeof(url));
   html += F("</strong>.</p></div>");
   html += F("<form method=\"post\" action=\"/save\">");
 
   html += F("<section><h2>WiFi</h2>");
   html += F("<label>SSID <input name=\"ssid\" value=\"");
-  html += htmlEscape(String(persist.wifiSsid));
+  html.escaped(persist.wifiSsid);
   html += F("\"></label>");
   html += F("<label>Password <input name=\"pass\" value=\"");
-  html += htmlEscape(String(persist.wifiPass));
+  html.escaped(persist.wifiPass);
   html += F("\"></label>");
   html += F("</section>");
 
@@ -1012,7 +1280,9 @@ static void handleWebConfigPage(){
   html += F("\"></label>");
   html += F("<label>Current Screen <select name=\"currentScreen\">");
   for(uint8_t i=0;i<SCREEN_COUNT;i++){
-    appendOption(html, i, persist.currentScreen, String(i + 1));
+    char num[4];
+    snprintf(num, sizeof(num), "%d", i + 1);
+    appendOption(html, i, persist.currentScreen, num);
   }
   html += F("</select></label>");
 
@@ -1040,11 +1310,17 @@ static void handleWebConfigPage(){
     appendPaletteOption(html, i, paletteIndex);
   }
   html += F("</select></label>");
+  html += F("<label>Night palette (headlights on) <select name=\"nightPalette\">");
+  appendOption(html, NIGHT_PALETTE_OFF, persist.nightPalette, "Same as day");
+  for(int i=0;i<paletteCount();i++){
+    appendOption(html, i, persist.nightPalette, paletteNameForIndex(i));
+  }
+  html += F("</select></label>");
   html += F("<div class=\"palette-preview\">");
   html += F("<div class=\"dash-preview\">");
   html += F("<div class=\"dash-screen\" id=\"palettePreviewScreen\">");
   html += F("<div class=\"dash-title\" id=\"palettePreviewTitle\">");
-  html += labelText((Channel)persist.barChannel[persist.currentScreen]);
+  html.escaped(labelText((Channel)currentLayout().ch[Layout::titleSlot(currentLayout().tpl)]));
   html += F("</div>");
   html += F("<div class=\"dash-ticks\" id=\"palettePreviewTicks\">");
   html += F("<span>0</span><span>50</span><span>100</span>");
@@ -1052,48 +1328,19 @@ static void handleWebConfigPage(){
   html += F("<div class=\"dash-bar\" id=\"palettePreviewBar\">");
   html += F("<div class=\"dash-bar-fill\" id=\"palettePreviewBarFill\"></div>");
   html += F("</div>");
-  html += F("<div class=\"dash-pill\" id=\"palettePreviewPill1\" style=\"left:12px;top:112px;\">");
-  html += F("<div class=\"dash-pill-label\">");
-  html += labelText((Channel)persist.pillChannel[persist.currentScreen][0]);
-  html += F("</div>");
-  html += F("<div class=\"dash-pill-value\">");
-  appendPreviewValue(html, (Channel)persist.pillChannel[persist.currentScreen][0]);
-  html += F("</div>");
-  html += F("</div>");
-  html += F("<div class=\"dash-pill\" id=\"palettePreviewPill2\" style=\"left:164px;top:112px;\">");
-  html += F("<div class=\"dash-pill-label\">");
-  html += labelText((Channel)persist.pillChannel[persist.currentScreen][1]);
-  html += F("</div>");
-  html += F("<div class=\"dash-pill-value\">");
-  appendPreviewValue(html, (Channel)persist.pillChannel[persist.currentScreen][1]);
-  html += F("</div>");
-  html += F("</div>");
-  html += F("<div class=\"dash-pill\" id=\"palettePreviewPill3\" style=\"left:12px;top:177px;\">");
-  html += F("<div class=\"dash-pill-label\">");
-  html += labelText((Channel)persist.pillChannel[persist.currentScreen][2]);
-  html += F("</div>");
-  html += F("<div class=\"dash-pill-value\">");
-  appendPreviewValue(html, (Channel)persist.pillChannel[persist.currentScreen][2]);
-  html += F("</div>");
-  html += F("</div>");
-  html += F("<div class=\"dash-pill\" id=\"palettePreviewPill4\" style=\"left:164px;top:177px;\">");
-  html += F("<div class=\"dash-pill-label\">");
-  html += labelText((Channel)persist.pillChannel[persist.currentScreen][3]);
-  html += F("</div>");
-  html += F("<div class=\"dash-pill-value\">");
-  appendPreviewValue(html, (Channel)persist.pillChannel[persist.currentScreen][3]);
-  html += F("</div>");
-  html += F("</div>");
+  static const char* const kPillPos[] = { "left:12px;top:112px;", "left:164px;top:112px;",
+                                          "left:12px;top:177px;", "left:164px;top:177px;" };
+  for(uint8_t n=0;n<4;n++) appendPreviewPill(html, n, kPillPos[n]);
   html += F("</div></div></div>");
   html += F("<h3>Custom Palette Editor</h3>");
   html += F("<label>Custom Palette <select name=\"customPaletteSlot\" id=\"customPaletteSlot\">");
   for(uint8_t p=0;p<CUSTOM_PALETTE_COUNT;p++){
-    appendOption(html, p, customPaletteSel, String(CUSTOM_PALETTE_NAMES[p]));
+    appendOption(html, p, customPaletteSel, CUSTOM_PALETTE_NAMES[p]);
   }
   html += F("</select></label>");
   html += F("<label>Zone <select name=\"customZone\" id=\"customZone\">");
   for(uint8_t z=0;z<CUSTOM_ZONE_COUNT;z++){
-    appendOption(html, z, customZoneSel, String(CUSTOM_ZONE_LABELS[z]));
+    appendOption(html, z, customZoneSel, CUSTOM_ZONE_LABELS[z]);
   }
   html += F("</select></label>");
   html += F("<select id=\"customZoneValue\" style=\"display:none\">");
@@ -1127,20 +1374,23 @@ static void handleWebConfigPage(){
     html += F("<h3>Screen ");
     html += (s + 1);
     html += F("</h3>");
-    html += F("<label>Bar <select name=\"bar_s");
+    const ScreenLayout& l = persist.layouts[s];
+    html += F("<label>Template <select name=\"tpl_s");
     html += s;
     html += F("\">");
-    appendChannelOptions(html, persist.barChannel[s], true);
+    for(uint8_t t=0;t<LT__COUNT;t++) appendOption(html, t, l.tpl, Layout::get(t).name);
     html += F("</select></label>");
-    for(uint8_t i=0;i<4;i++){
-      html += F("<label>Pill ");
+    for(uint8_t i=0;i<Layout::count(l.tpl);i++){
+      const Layout::WidgetKind kind = Layout::cell(l.tpl, i).kind;
+      const bool bar = Layout::needsRange(kind);
+      html += (kind == Layout::WK_BAR) ? F("<label>Bar ") : (kind == Layout::WK_DIAL) ? F("<label>Dial ") : F("<label>Pill ");
       html += (i + 1);
-      html += F(" <select name=\"pill_s");
+      html += F(" <select name=\"w_s");
       html += s;
       html += F("_");
       html += i;
       html += F("\">");
-      appendChannelOptions(html, persist.pillChannel[s][i], false);
+      appendChannelOptions(html, l.ch[i], bar);
       html += F("</select></label>");
     }
   }
@@ -1152,7 +1402,7 @@ static void handleWebConfigPage(){
     Channel ch = (Channel)i;
     if(!isWarnEligible(ch)) continue;
     html += F("<tr><td>");
-    html += labelText(ch);
+    html.escaped(labelText(ch));
     html += F("</td><td><select name=\"warnMode_");
     html += i;
     html += F("\">");
@@ -1171,28 +1421,82 @@ static void handleWebConfigPage(){
   }
   html += F("</table></section>");
 
+  html += F("<section><h2>User CAN Gauges</h2>");
+  html += F("<p>value = raw(bits from..to) &times; scale + bias. ID in hex, Ext for a 29-bit ID; Bus is the controller it arrives on. The field spans at most 32 bits.</p>");
+  html += F("<table><tr><th>On</th><th>Label</th><th>Unit</th><th>ID</th><th>Ext</th><th>Bus</th><th>From</th><th>To</th><th>Order</th><th>Signed</th>"
+            "<th>Scale</th><th>Bias</th><th>Min</th><th>Max</th><th>Dec</th></tr>");
+  for(uint8_t i=0;i<USER_CHANNEL_COUNT;i++) appendUserChannelRow(html, i);
+  html += F("</table></section>");
+
+  html += F("<section><h2>Derived Gauges</h2>");
+  html += F("<p>Operators + - * / ( ), abs() sqrt() min(a,b) max(a,b). Converter slip needs the turbine speed"
+            " from a user gauge: rpm - user1. Names:");
+  for(uint8_t c=0;c<CH__COUNT;c++){
+    const char* n = Derived::channelName((Channel)c);
+    if(!n) continue;
+    html += F(" ");
+    html += n;
+  }
+  html += F("</p><table><tr><th>On</th><th>Label</th><th>Unit</th><th>Expression</th><th>Min</th><th>Max</th><th>Dec</th><th>Status</th></tr>");
+  for(uint8_t i=0;i<DERIVED_CHANNEL_COUNT;i++) appendDerivedChannelRow(html, i);
+  html += F("</table></section>");
+
+  html += F("<section><h2>Signal Filters</h2>");
+  html += F("<p>Median, then smoothing (time constant), then max change per second in base units. 0 = off. "
+            "Raw warn checks thresholds against the unfiltered value. Display changes/s, raw &rarr; filtered: ");
+  html += Filters::stats().rawKeyChangesPerSec;
+  html += F(" &rarr; ");
+  html += Filters::stats().keyChangesPerSec;
+  html += F("</p><table><tr><th>Channel</th><th>Median</th><th>Smoothing ms</th><th>Max change/s</th><th>Raw warn</th></tr>");
+  for(uint8_t i=0;i<CH__COUNT;i++) appendFilterRow(html, (Channel)i);
+  html += F("</table></section>");
+
+  appendRegenSection(html);
+  appendTripSection(html);
+  appendPowerSection(html);
+  appendBridgeSection(html);
+  appendMemorySection(html);
+
   html += F("<section><h2>Victron</h2>");
   html += F("<label><input type=\"checkbox\" name=\"victronEnabled\" value=\"1\"");
   if(persist.victronEnabled) html += F(" checked");
   html += F("> Enable Victron Gauges</label>");
+  {
+    const VictronScanStats& vs = victronScanStats();
+    html += F("<p>Radio: ");
+    html += vs.advertsPerSec;
+    html += F(" adverts/s, scan ");
+    html += vs.windowMs;
+    html += '/';
+    html += vs.intervalMs;
+    html += F(" ms");
+    if(g_webStats.requests){
+      html += F(", last page ");
+      html += g_webStats.lastUs / 1000;
+      html += F(" ms (max ");
+      html += g_webStats.maxUs / 1000;
+      html += F(" ms)");
+    }
+    html += F("</p>");
+  }
   char keyBuf[33];
   formatHexKey(persist.victronBmvKey, sizeof(persist.victronBmvKey), keyBuf, sizeof(keyBuf));
   html += F("<label>BMV MAC <input name=\"bmvMac\" value=\"");
-  html += htmlEscape(String(persist.victronBmvMac));
+  html.escaped(persist.victronBmvMac);
   html += F("\"></label>");
   html += F("<label>BMV Key (32 hex) <input name=\"bmvKey\" value=\"");
   html += keyBuf;
   html += F("\"></label>");
   formatHexKey(persist.victronMpptKey, sizeof(persist.victronMpptKey), keyBuf, sizeof(keyBuf));
   html += F("<label>MPPT MAC <input name=\"mpptMac\" value=\"");
-  html += htmlEscape(String(persist.victronMpptMac));
+  html.escaped(persist.victronMpptMac);
   html += F("\"></label>");
   html += F("<label>MPPT Key (32 hex) <input name=\"mpptKey\" value=\"");
   html += keyBuf;
   html += F("\"></label>");
   formatHexKey(persist.victronOrionKey, sizeof(persist.victronOrionKey), keyBuf, sizeof(keyBuf));
   html += F("<label>Orion MAC <input name=\"orionMac\" value=\"");
-  html += htmlEscape(String(persist.victronOrionMac));
+  html.escaped(persist.victronOrionMac);
   html += F("\"></label>");
   html += F("<label>Orion Key (32 hex) <input name=\"orionKey\" value=\"");
   html += keyBuf;
@@ -1276,7 +1580,15 @@ static void handleWebConfigPage(){
   html += F("syncCustomRgbFromValue();");
   html += F("refreshCustomColor();");
   html += F("</script></div></body></html>");
-  webServer.send(200, "text/html", html);
+  html.end();
+}
+
+// Form field name in a fixed buffer, e.g. formKey("uc", 3, "_scale"). The WebServer API still
+// takes and returns String: one short-lived copy per lookup, only while a form is being saved.
+static const char* formKey(const char* pre, unsigned idx, const char* field){
+  static char key[24];
+  snprintf(key, sizeof(key), "%s%u%s", pre, idx, field);
+  return key;
 }
 
 static void handleWebConfigSave(){
@@ -1285,7 +1597,7 @@ static void handleWebConfigSave(){
     String s = webServer.arg("ssid");
     s.trim();
     if(s.length() > 0){
-      copyStringToBuffer(s, persist.wifiSsid, sizeof(persist.wifiSsid));
+      copyStringToBuffer(s.c_str(), persist.wifiSsid, sizeof(persist.wifiSsid));
       wifiChanged = true;
     }
   }
@@ -1293,7 +1605,7 @@ static void handleWebConfigSave(){
     String s = webServer.arg("pass");
     s.trim();
     if(s.length() >= CFG::WIFI_MIN_PASS_LEN){
-      copyStringToBuffer(s, persist.wifiPass, sizeof(persist.wifiPass));
+      copyStringToBuffer(s.c_str(), persist.wifiPass, sizeof(persist.wifiPass));
       wifiChanged = true;
     }
   }
@@ -1334,6 +1646,10 @@ static void handleWebConfigSave(){
     int idx = webServer.arg("paletteIndex").toInt();
     if(idx >= 0 && idx < paletteCount()) paletteIndex = idx;
   }
+  if(webServer.hasArg("nightPalette")){
+    int idx = webServer.arg("nightPalette").toInt();
+    persist.nightPalette = (idx >= 0 && idx < paletteCount()) ? (uint8_t)idx : NIGHT_PALETTE_OFF;
+  }
   if(webServer.hasArg("customPaletteSlot") && webServer.hasArg("customZone") && webServer.hasArg("customColorValue")){
     int slot = webServer.arg("customPaletteSlot").toInt();
     int zone = webServer.arg("customZone").toInt();
@@ -1344,16 +1660,18 @@ static void handleWebConfigSave(){
   }
 
   for(uint8_t s=0;s<SCREEN_COUNT;s++){
-    String barName = String("bar_s") + String(s);
-    if(webServer.hasArg(barName)){
-      int v = webServer.arg(barName).toInt();
-      if(v >= 0 && v < CH__COUNT) persist.barChannel[s] = (uint8_t)v;
+    ScreenLayout& l = persist.layouts[s];
+    const char* tplName = formKey("tpl_s", s, "");
+    if(webServer.hasArg(tplName)){
+      int v = webServer.arg(tplName).toInt();
+      if(v >= 0 && v < LT__COUNT) l.tpl = (uint8_t)v;
     }
-    for(uint8_t i=0;i<4;i++){
-      String pillName = String("pill_s") + String(s) + "_" + String(i);
-      if(webServer.hasArg(pillName)){
-        int v = webServer.arg(pillName).toInt();
-        if(v >= 0 && v < CH__COUNT) persist.pillChannel[s][i] = (uint8_t)v;
+    for(uint8_t i=0;i<LAYOUT_MAX_WIDGETS;i++){
+      char slotName[16];
+      snprintf(slotName, sizeof(slotName), "w_s%u_%u", (unsigned)s, (unsigned)i);
+      if(webServer.hasArg(slotName)){
+        int v = webServer.arg(slotName).toInt();
+        if(v >= 0 && v < CH__COUNT) l.ch[i] = (uint8_t)v;
       }
     }
   }
@@ -1361,21 +1679,81 @@ static void handleWebConfigSave(){
   for(uint8_t i=0;i<CH__COUNT;i++){
     Channel ch = (Channel)i;
     if(!isWarnEligible(ch)) continue;
-    String modeName = String("warnMode_") + String(i);
-    String t1Name = String("warnT1_") + String(i);
-    String t2Name = String("warnT2_") + String(i);
-    if(webServer.hasArg(modeName)) persist.warnMode[i] = (uint8_t)webServer.arg(modeName).toInt();
-    if(webServer.hasArg(t1Name)) persist.warnT1[i] = webServer.arg(t1Name).toFloat();
-    if(webServer.hasArg(t2Name)) persist.warnT2[i] = webServer.arg(t2Name).toFloat();
+    if(webServer.hasArg(formKey("warnMode_", i, ""))) persist.warnMode[i] = (uint8_t)webServer.arg(formKey("warnMode_", i, "")).toInt();
+    if(webServer.hasArg(formKey("warnT1_", i, ""))) persist.warnT1[i] = webServer.arg(formKey("warnT1_", i, "")).toFloat();
+    if(webServer.hasArg(formKey("warnT2_", i, ""))) persist.warnT2[i] = webServer.arg(formKey("warnT2_", i, "")).toFloat();
+  }
+
+  for(uint8_t i=0;i<USER_CHANNEL_COUNT;i++){
+    UserChannelDef& u = persist.userChannels[i];
+    if(!webServer.hasArg(formKey("uc", i, "_id"))) continue;   // section not on the submitted form
+    u.enabled = webServer.hasArg(formKey("uc", i, "_en")) ? 1 : 0;
+    u.isSigned = webServer.hasArg(formKey("uc", i, "_signed")) ? 1 : 0;
+    uint32_t id = (uint32_t)strtoul(webServer.arg(formKey("uc", i, "_id")).c_str(), nullptr, 16);
+    if(webServer.hasArg(formKey("uc", i, "_ext"))){
+      if(id <= CAN_EFF_MASK) u.canId = id | CAN_EFF_FLAG;
+    } else if(id <= CAN_SFF_MASK){
+      u.canId = id;
+    }   // an ID too wide for its frame format keeps the previous one
+    if(webServer.hasArg(formKey("uc", i, "_bus"))) u.bus = (uint8_t)webServer.arg(formKey("uc", i, "_bus")).toInt();
+    if(webServer.hasArg(formKey("uc", i, "_from"))) u.fromBit = (uint8_t)clampf(webServer.arg(formKey("uc", i, "_from")).toInt(), 0, 63);
+    if(webServer.hasArg(formKey("uc", i, "_to"))) u.toBit = (uint8_t)clampf(webServer.arg(formKey("uc", i, "_to")).toInt(), 0, 63);
+    if(webServer.hasArg(formKey("uc", i, "_order"))) u.order = (uint8_t)webServer.arg(formKey("uc", i, "_order")).toInt();
+    if(webServer.hasArg(formKey("uc", i, "_scale"))) u.scale = webServer.arg(formKey("uc", i, "_scale")).toFloat();
+    if(webServer.hasArg(formKey("uc", i, "_bias"))) u.bias = webServer.arg(formKey("uc", i, "_bias")).toFloat();
+    if(webServer.hasArg(formKey("uc", i, "_min"))) u.rangeMin = webServer.arg(formKey("uc", i, "_min")).toFloat();
+    if(webServer.hasArg(formKey("uc", i, "_max"))) u.rangeMax = webServer.arg(formKey("uc", i, "_max")).toFloat();
+    if(webServer.hasArg(formKey("uc", i, "_dec"))) u.decimals = (uint8_t)clampf(webServer.arg(formKey("uc", i, "_dec")).toInt(), 0, 3);
+    if(webServer.hasArg(formKey("uc", i, "_label"))) copyStringToBuffer(webServer.arg(formKey("uc", i, "_label")).c_str(), u.label, sizeof(u.label));
+    if(webServer.hasArg(formKey("uc", i, "_unit"))) copyStringToBuffer(webServer.arg(formKey("uc", i, "_unit")).c_str(), u.unit, sizeof(u.unit));
+  }
+  for(uint8_t i=0;i<DERIVED_CHANNEL_COUNT;i++){
+    DerivedChannelDef& d = persist.derivedChannels[i];
+    if(!webServer.hasArg(formKey("dc", i, "_expr"))) continue;
+    d.enabled = webServer.hasArg(formKey("dc", i, "_en")) ? 1 : 0;
+    copyStringToBuffer(webServer.arg(formKey("dc", i, "_expr")).c_str(), d.expr, sizeof(d.expr));
+    if(webServer.hasArg(formKey("dc", i, "_label"))) copyStringToBuffer(webServer.arg(formKey("dc", i, "_label")).c_str(), d.label, sizeof(d.label));
+    if(webServer.hasArg(formKey("dc", i, "_unit"))) copyStringToBuffer(webServer.arg(formKey("dc", i, "_unit")).c_str(), d.unit, sizeof(d.unit));
+    if(webServer.hasArg(formKey("dc", i, "_min"))) d.rangeMin = webServer.arg(formKey("dc", i, "_min")).toFloat();
+    if(webServer.hasArg(formKey("dc", i, "_max"))) d.rangeMax = webServer.arg(formKey("dc", i, "_max")).toFloat();
+    if(webServer.hasArg(formKey("dc", i, "_dec"))) d.decimals = (uint8_t)clampf(webServer.arg(formKey("dc", i, "_dec")).toInt(), 0, 3);
+  }
+  sanitizeUserChannels();
+  UserCh::configure(persist.userChannels, USER_CHANNEL_COUNT);
+  applyBodyAccept();
+  Derived::configure(persist.derivedChannels, DERIVED_CHANNEL_COUNT);
+  Channels::rebuild();
+
+  for(uint8_t i=0;i<CH__COUNT;i++){
+    ChannelFilterDef& f = persist.filters[i];
+    if(!webServer.hasArg(formKey("flt", i, "_tau"))) continue;
+    f.median = (uint8_t)webServer.arg(formKey("flt", i, "_med")).toInt();
+    f.emaTauMs = (uint16_t)clampf(webServer.arg(formKey("flt", i, "_tau")).toInt(), 0, 10000);
+    if(webServer.hasArg(formKey("flt", i, "_slew"))) f.slewPerSec = webServer.arg(formKey("flt", i, "_slew")).toFloat();
+    f.flags = webServer.hasArg(formKey("flt", i, "_raw")) ? Filters::FILTER_WARN_RAW : 0;
+  }
+  sanitizeFilters();
+  Filters::configure(persist.filters, CH__COUNT);
+  if(webServer.hasArg("regenClear")) Regen::clearHistory();
+  if(webServer.hasArg("tripFuel")){
+    const uint8_t c = (uint8_t)webServer.arg("tripFuel").toInt();
+    persist.tripLog.fuelChannel = isTripFuelSource(c) ? c : static_cast<uint8_t>(CH__COUNT);
+  }
+  if(webServer.hasArg("tripResetA")) Trip::reset(Trip::TRIP_A);
+  if(webServer.hasArg("tripResetB")) Trip::reset(Trip::TRIP_B);
+  if(webServer.hasArg("parkMonitor")){
+    const int m = webServer.arg("parkMonitor").toInt();
+    persist.parkedMonitorMin = (uint8_t)(m < 0 ? 0 : m > Power::MONITOR_MAX_MIN ? Power::MONITOR_MAX_MIN : m);
+    Power::setMonitorMinutes(persist.parkedMonitorMin);
   }
 
   persist.victronEnabled = webServer.hasArg("victronEnabled") ? 1 : 0;
-  if(webServer.hasArg("bmvMac")) normalizeMacString(webServer.arg("bmvMac"), persist.victronBmvMac, sizeof(persist.victronBmvMac));
-  if(webServer.hasArg("mpptMac")) normalizeMacString(webServer.arg("mpptMac"), persist.victronMpptMac, sizeof(persist.victronMpptMac));
-  if(webServer.hasArg("orionMac")) normalizeMacString(webServer.arg("orionMac"), persist.victronOrionMac, sizeof(persist.victronOrionMac));
-  if(webServer.hasArg("bmvKey")) parseHexBytes(webServer.arg("bmvKey"), persist.victronBmvKey, sizeof(persist.victronBmvKey));
-  if(webServer.hasArg("mpptKey")) parseHexBytes(webServer.arg("mpptKey"), persist.victronMpptKey, sizeof(persist.victronMpptKey));
-  if(webServer.hasArg("orionKey")) parseHexBytes(webServer.arg("orionKey"), persist.victronOrionKey, sizeof(persist.victronOrionKey));
+  if(webServer.hasArg("bmvMac")) normalizeMacString(webServer.arg("bmvMac").c_str(), persist.victronBmvMac, sizeof(persist.victronBmvMac));
+  if(webServer.hasArg("mpptMac")) normalizeMacString(webServer.arg("mpptMac").c_str(), persist.victronMpptMac, sizeof(persist.victronMpptMac));
+  if(webServer.hasArg("orionMac")) normalizeMacString(webServer.arg("orionMac").c_str(), persist.victronOrionMac, sizeof(persist.victronOrionMac));
+  if(webServer.hasArg("bmvKey")) parseHexBytes(webServer.arg("bmvKey").c_str(), persist.victronBmvKey, sizeof(persist.victronBmvKey));
+  if(webServer.hasArg("mpptKey")) parseHexBytes(webServer.arg("mpptKey").c_str(), persist.victronMpptKey, sizeof(persist.victronMpptKey));
+  if(webServer.hasArg("orionKey")) parseHexBytes(webServer.arg("orionKey").c_str(), persist.victronOrionKey, sizeof(persist.victronOrionKey));
 
   sanitizeLayout();
   applyBacklight();
@@ -1395,9 +1773,27 @@ static void handleWebConfigSave(){
   webServer.send(303);
 }
 
+// Wraps a handler: drops the scanner to COEX_HTTP and records how long the response took
+static void serveTimed(void (*handler)()){
+  victronSetCoex(COEX_HTTP);
+  const uint32_t t0 = micros();
+  handler();
+  const uint32_t us = micros() - t0;
+  g_webStats.requests++;
+  g_webStats.lastUs = us;
+  if(us > g_webStats.maxUs) g_webStats.maxUs = us;
+  g_webStats.lastMs = millis();
+}
+
+// Routes are added once: the server keeps its handler list across stop(), so adding them on
+// every WiFi page visit would leak a handler pair each time
 static void setupWebServer(){
-  webServer.on("/", HTTP_GET, handleWebConfigPage);
-  webServer.on("/save", HTTP_POST, handleWebConfigSave);
+  static bool routesAdded = false;
+  if(!routesAdded){
+    webServer.on("/", HTTP_GET, [](){ serveTimed(handleWebConfigPage); });
+    webServer.on("/save", HTTP_POST, [](){ serveTimed(handleWebConfigSave); });
+    routesAdded = true;
+  }
   webServer.begin();
 }
 
@@ -1416,6 +1812,15 @@ static PersistState buildDefaultPersistState(){
   for(int s=0;s<SCREEN_COUNT;s++) for(int i=0;i<4;i++) def.pillChannel[s][i]=defP[s][i];
   def.barChannel[0]=CH_SOOT; def.barChannel[1]=CH_BOOST; def.barChannel[2]=CH_RPM;
   def.barChannel[3]=CH_SOOT; def.barChannel[4]=CH_BOOST;
+  // Slots 5.. are only shown by the larger templates
+  const uint8_t defExtra[LAYOUT_MAX_WIDGETS - 5] = {CH_RPM, CH_TRANS1, CH_OIL, CH_LAMBDA};
+  for(int s=0;s<SCREEN_COUNT;s++){
+    ScreenLayout& l = def.layouts[s];
+    l.tpl = LT_BAR_QUAD;
+    l.ch[0] = def.barChannel[s];
+    for(int i=0;i<4;i++) l.ch[1+i] = defP[s][i];
+    for(int i=5;i<LAYOUT_MAX_WIDGETS;i++) l.ch[i] = defExtra[i-5];
+  }
   def.currentScreen=0;
   for(int i=0;i<CH__COUNT;i++){ def.warnMode[i]=CFG::WARN_OFF; def.warnT1[i]=0; def.warnT2[i]=0; }
   def.warnMode[CH_SOOT]=CFG::WARN_HIGH; def.warnT1[CH_SOOT]=95; def.warnT2[CH_SOOT]=100;
@@ -1425,6 +1830,8 @@ static PersistState buildDefaultPersistState(){
   def.warnMode[CH_TRANS2]=CFG::WARN_HIGH; def.warnT1[CH_TRANS2]=115; def.warnT2[CH_TRANS2]=120;
   def.warnMode[CH_RPM]=CFG::WARN_HIGH; def.warnT1[CH_RPM]=3300; def.warnT2[CH_RPM]=3600;
   def.paletteIndex=0;
+  def.nightPalette=NIGHT_PALETTE_OFF;
+  def.parkedMonitorMin=0;
   for(uint8_t i=0;i<CUSTOM_PALETTE_COUNT;i++){
     const Palette& src = PALETTES[min<int>(i, basePaletteCount()-1)];
     def.customPalettes[i] = { src.card, src.frame, src.ticks, src.text, src.accent, src.bg };
@@ -1433,23 +1840,54 @@ static PersistState buildDefaultPersistState(){
   def.uPressure = U_P_kPa; def.uTemp = U_T_C; def.uSpeed = U_S_kmh; def.uLambda = U_L_lambda;
   def.speedTrimPct = 0.0f;
   def.victronEnabled = 1;
-  copyStringToBuffer(String(CFG::WIFI_DEFAULT_SSID), def.wifiSsid, sizeof(def.wifiSsid));
-  copyStringToBuffer(String(CFG::WIFI_DEFAULT_PASS), def.wifiPass, sizeof(def.wifiPass));
-  copyStringToBuffer(String(VictronBle::kBmvMac), def.victronBmvMac, sizeof(def.victronBmvMac));
-  copyStringToBuffer(String(VictronBle::kMpptMac), def.victronMpptMac, sizeof(def.victronMpptMac));
-  copyStringToBuffer(String(VictronBle::kOrionMac), def.victronOrionMac, sizeof(def.victronOrionMac));
+  copyStringToBuffer(CFG::WIFI_DEFAULT_SSID, def.wifiSsid, sizeof(def.wifiSsid));
+  copyStringToBuffer(CFG::WIFI_DEFAULT_PASS, def.wifiPass, sizeof(def.wifiPass));
+  copyStringToBuffer(VictronBle::kBmvMac, def.victronBmvMac, sizeof(def.victronBmvMac));
+  copyStringToBuffer(VictronBle::kMpptMac, def.victronMpptMac, sizeof(def.victronMpptMac));
+  copyStringToBuffer(VictronBle::kOrionMac, def.victronOrionMac, sizeof(def.victronOrionMac));
   memcpy(def.victronBmvKey, VictronBle::kBmvKey, sizeof(def.victronBmvKey));
   memcpy(def.victronMpptKey, VictronBle::kMpptKey, sizeof(def.victronMpptKey));
   memcpy(def.victronOrionKey, VictronBle::kOrionKey, sizeof(def.victronOrionKey));
+  for(uint8_t i=0;i<USER_CHANNEL_COUNT;i++){
+    UserChannelDef& u = def.userChannels[i];
+    u.enabled = 0; u.fromBit = 0; u.toBit = 7; u.order = CanField::ORDER_LE;
+    u.scale = 1.0f; u.bias = 0.0f; u.rangeMin = 0.0f; u.rangeMax = 255.0f;
+  }
+  def.tripLog.fuelChannel = CH__COUNT;
+  // Filters for the signals that flicker at full CAN rate
+  def.filters[CH_BOOST].emaTauMs = 150;
+  def.filters[CH_TORQUE].median = 3;
+  def.filters[CH_TORQUE].emaTauMs = 100;
+  def.filters[CH_LAMBDA].emaTauMs = 200;
+  // Derived presets, disabled until switched on in the web config
+  struct DerivedPreset { const char* label; const char* unit; const char* expr; float mn, mx; uint8_t dec; };
+  static const DerivedPreset kDerivedPresets[DERIVED_CHANNEL_COUNT] = {
+    { "Power",     "kW",  "torque * rpm / 9549",        0, 300, 0 },
+    { "Boost PR",  "",    "(boost + 101.3) / 101.3",    0, 4,   2 },   // boost is gauge kPa
+    { "EGT Delta", "C",   "egt1 - egt2",             -200, 200, 0 },
+    { "Net Batt",  "A",   "batt_a - pv_a",           -100, 100, 1 },
+  };
+  for(uint8_t i=0;i<DERIVED_CHANNEL_COUNT;i++){
+    DerivedChannelDef& d = def.derivedChannels[i];
+    const DerivedPreset& p = kDerivedPresets[i];
+    d.enabled = 0; d.decimals = p.dec; d.rangeMin = p.mn; d.rangeMax = p.mx;
+    snprintf(d.expr, sizeof(d.expr), "%s", p.expr);
+    snprintf(d.label, sizeof(d.label), "%s", p.label);
+    snprintf(d.unit, sizeof(d.unit), "%s", p.unit);
+  }
   return def;
 }
 
 static void loadPersistState(){
   PersistState defaults = buildDefaultPersistState();
   loadPersist(persist, defaults);
+  sanitizeUserChannels();
+  UserCh::configure(persist.userChannels, USER_CHANNEL_COUNT);   // before sanitizeLayout: user pills depend on it
+  Derived::configure(persist.derivedChannels, DERIVED_CHANNEL_COUNT);
   sanitizeLayout();
   persist.currentScreen = (persist.currentScreen>=SCREEN_COUNT)?0:persist.currentScreen;
   paletteIndex = (persist.paletteIndex >= paletteCount()) ? 0 : persist.paletteIndex;
+  if(persist.nightPalette >= paletteCount()) persist.nightPalette = NIGHT_PALETTE_OFF;
 
   // apply persisted brightness to RAM (clamped)
   brightOn  = max<uint8_t>(persist.brightOn,  MIN_BRIGHT);
@@ -1462,31 +1900,93 @@ static void loadPersistState(){
   g_uLambda   = (persist.uLambda>1)?U_L_lambda:persist.uLambda;
   if (!isfinite(persist.speedTrimPct)) persist.speedTrimPct = 0.0f;
   speedTrimPct = persist.speedTrimPct;
+  Channels::rebuild();   // after units/trim and user/derived definitions are known
+  sanitizeFilters();
+  Filters::configure(persist.filters, CH__COUNT);
+  if(!isTripFuelSource(persist.tripLog.fuelChannel)) persist.tripLog.fuelChannel = CH__COUNT;
+  Trip::attach(persist.tripLog);
+  Regen::attach(persist.regenLog);   // reads the lifetime odometer, so after Trip
   if(persist.victronEnabled > 1) persist.victronEnabled = 1;
-  ensureWifiDefaults();
-  ensureVictronDefaults();
-}
-
-// ===================== Backlight helpers (PWM on D0, active high) =====================
+  if(persist.parkedMonitorMin > Power::MONITOR_MAX_MIN) persist.parkedMonitorMin = 0;
+  Power::setMonitorMinutes(persist.parkedMonitorMin);
+  // WiFi/Victron defaults are filled in by the deferred boot tasks
+}
+
+// ===================== Backlight (LEDC hardware fade on D0, active high) =====================
+constexpr uint16_t BL_BOOT_FADE_MS = 360;   // first light after the boot paint
+constexpr uint16_t BL_STEP_FADE_MS = 80;    // brightness editor / web changes
+constexpr uint16_t BL_FADE_MS      = 400;   // headlight level change, same palette
+constexpr uint16_t BL_XFADE_OUT_MS = 250;   // day/night cross-fade: down to dark ...
+constexpr uint16_t BL_XFADE_IN_MS  = 350;   // ... and back up on the new palette
+constexpr uint8_t  THEME_BAND_H    = 40;    // rows cleared per loop while dark
+
+// Day/night cross-fade: dim -> swap palette and repaint in loop-sized pieces -> restore
+enum ThemeFade : uint8_t { TF_IDLE, TF_DIM, TF_CLEAR, TF_PAINT, TF_RESTORE };
+static ThemeFade g_themeFade = TF_IDLE;
+static uint8_t g_themeBand = 0;
+static bool g_uiFramePending = false;   // last scheduler frame deferred work
+static bool g_bootLit = false;          // boot fade-in started; serviceBacklight() waits for it
+
+static inline bool themeFadeActive(){ return g_themeFade != TF_IDLE; }
+static inline bool wantNightTheme(){ return headlightsOn && persist.nightPalette < paletteCount(); }
+
+// Follow the configured brightness; the cross-fade restores it itself when it finishes
 inline void applyBacklight(){
-  uint8_t pct = uiBrightnessPct();
-  if (pct == g_lastBacklightPct) return;
-  g_lastBacklightPct = pct;
-  uint16_t duty = (uint16_t)((pct * 255 + 50) / 100);
-  analogWrite(CFG::BACKLIGHT_PWM, duty);
-}
-
-//====================== Backlight helper fade in ========================
-inline void fadeInBacklight(){
-  uint8_t pct = uiBrightnessPct();
-  uint16_t targetDuty = (uint16_t)((pct * 255 + 50) / 100);
-  const uint8_t steps = 24;
-  for(uint8_t step = 1; step <= steps; ++step){
-    uint16_t duty = (uint16_t)((targetDuty * step) / steps);
-    analogWrite(CFG::BACKLIGHT_PWM, duty);
-    delay(15);
+  if(themeFadeActive()) return;
+  Backlight::fadeTo(uiBrightnessPct(), BL_STEP_FADE_MS);
+}
+
+// Called once per loop(). Each state does at most one band of drawing, so CAN keeps draining.
+void serviceBacklight(unsigned long now){
+  Backlight::update(now);
+  if(!g_bootLit || Power::state() != Power::PS_ACTIVE) return;   // parking owns the backlight
+  switch(g_themeFade){
+    case TF_IDLE:
+      if(wantNightTheme() != g_nightTheme){
+        prevHeadlightsOn = headlightsOn;
+        Backlight::fadeTo(0, BL_XFADE_OUT_MS);
+        g_themeFade = TF_DIM;
+      } else if(headlightsOn != prevHeadlightsOn){
+        prevHeadlightsOn = headlightsOn;
+        Backlight::fadeTo(uiBrightnessPct(), BL_FADE_MS);
+      }
+      break;
+    case TF_DIM:
+      if(Backlight::busy(now)) break;
+      g_nightTheme = wantNightTheme();
+      if(menuState == UI_MAIN){
+        g_themeBand = 0;
+        g_themeFade = TF_CLEAR;
+      } else {
+        redrawForDimmingChange();   // menus are short; redraw them in one go
+        Backlight::fadeTo(uiBrightnessPct(), BL_XFADE_IN_MS);
+        g_themeFade = TF_RESTORE;
+      }
+      break;
+    case TF_CLEAR:
+    case TF_PAINT:
+      if(menuState != UI_MAIN){
+        // Left the live screen mid-repaint: the menu was drawn with the new palette already
+        Backlight::fadeTo(uiBrightnessPct(), BL_XFADE_IN_MS);
+        g_themeFade = TF_RESTORE;
+      } else if(g_themeFade == TF_CLEAR){
+        clearRegion(0, g_themeBand * THEME_BAND_H, 320, THEME_BAND_H, COL_BG());
+        if(++g_themeBand * THEME_BAND_H >= 240){
+          drawAppBar();
+          updateRegenState();
+          renderStatic();   // widgets come back through the budgeted scheduler frames
+          g_uiFramePending = true;
+          g_themeFade = TF_PAINT;
+        }
+      } else if(!g_uiFramePending){
+        Backlight::fadeTo(uiBrightnessPct(), BL_XFADE_IN_MS);
+        g_themeFade = TF_RESTORE;
+      }
+      break;
+    case TF_RESTORE:
+      if(!Backlight::busy(now)) g_themeFade = TF_IDLE;
+      break;
   }
-  g_lastBacklightPct = pct;
 }
 
 // ===================== Drawing – Main UI =====================
@@ -1508,88 +2008,11 @@ void drawPillFrame(const PillSpec& p, bool sel, Channel ch){
   uint16_t fc= sel? COL_YELLOW(): COL_FRAME();
   tft.drawRoundRect(p.x,p.y,p.w,p.h,10,fc); if(sel) tft.drawRoundRect(p.x+1,p.y+1,p.w-2,p.h-2,9,fc);
 }
-void drawPillLabel(const PillSpec& p, const char* s){ tft.setFont(&FreeSans9pt7b); tft.setTextColor(COL_TXT(),COL_CARD()); tft.setCursor(p.x+10,p.y+17); tft.print(s); tft.setFont(); }
-void drawPillLabelWithSuffix(const PillSpec& p, const char* s, const char* suffix){
-  tft.setFont(&FreeSans9pt7b);
-  tft.setTextColor(COL_TXT(),COL_CARD());
-  tft.setCursor(p.x+10,p.y+17);
-  tft.print(s);
-  if(suffix && suffix[0]){
-    int16_t x1,y1; uint16_t w,h;
-    tft.getTextBounds((char*)s, p.x+10, p.y+17, &x1, &y1, &w, &h);
-    tft.setFont(&FreeSans9pt7b);
-    tft.setCursor(p.x+10 + (int)w + 4, p.y+16);
-    tft.print(suffix);
-  }
-  tft.setFont();
-}
-void drawPillLabelForChannel(const PillSpec& p, Channel ch){
-  const char* base = labelText(ch);
-  if(uiMinMaxActive){
-    const char* suffix = minMaxSuffixFor(ch);
-    if(suffix[0]){
-      drawPillLabelWithSuffix(p, base, suffix);
-      return;
-    }
-  }
-  drawPillLabel(p, base);
-}
-void clearPillValue(const PillSpec& p){ int y=p.y+25; clearRegion(p.x+6,y,p.w-12,max(0,p.y+p.h-y-4),COL_CARD()); }
-void drawValueInPill(const PillSpec& p, const char* num, const char* unit){
-  clearPillValue(p); tft.setFont(&FreeSans12pt7b); tft.setTextColor(COL_TXT(),COL_CARD()); int nx=p.x+10, ny=p.y+p.h-10; tft.setCursor(nx,ny); tft.print(num);
-  if(unit&&unit[0]){ int16_t bx,by; uint16_t bw,bh; tft.getTextBounds(num,nx,ny,&bx,&by,&bw,&bh); tft.setCursor(nx+bw+8,ny); tft.print(unit); }
-  tft.setFont();
-}
-// Draw bar ticks for an arbitrary screen (used in editor preview)
-inline void drawBarStaticForScreen(uint8_t screenSel, bool sel){
-  Channel ch=(Channel)persist.barChannel[screenSel]; uint16_t fc=sel?COL_YELLOW():COL_FRAME();
-  tft.fillRoundRect(BAR_X-2,BAR_Y-2,BAR_W+4,BAR_H+4,BAR_R+2,COL_CARD()); tft.drawRoundRect(BAR_X,BAR_Y,BAR_W,BAR_H,BAR_R,fc);
-  auto tick=[&](int x,float v,const char* u){ char b[24];
-    if(ch==CH_BATTV) snprintf(b,sizeof(b),"%.1f",v);
-    else if(ch==CH_BATTV2 || ch==CH_DCDC_OUT_V || ch==CH_DCDC_IN_V) snprintf(b,sizeof(b),"%.2f",v);
-    else if(u&&u[0]=='V') snprintf(b,sizeof(b),"%.2f",v);
-    else if(ch==CH_LAMBDA){
-      if(g_uLambda==U_L_lambda) snprintf(b,sizeof(b),"%.2f",v);
-      else snprintf(b,sizeof(b),"%.1f",v);
-    }
-    else snprintf(b,sizeof(b),"%.0f",v);
-    tft.setFont(&FreeSans12pt7b); tft.setTextColor(COL_TICKS(),COL_BG()); tft.setCursor(x,BAR_Y-6); tft.print(b); tft.setFont(); };
-  Range r=rangeFor(ch); float mid=(r.mn+r.mx)/2; clearRegion(0,BAR_Y-20,320,18,COL_BG());
-  char tmp[16]; if(ch==CH_LAMBDA && g_uLambda==U_L_lambda) snprintf(tmp,sizeof(tmp),"%.2f", mid); else snprintf(tmp,sizeof(tmp),"%.0f", mid);
-  int16_t x1,y1; uint16_t w,h; tft.setFont(&FreeSans12pt7b); tft.getTextBounds(tmp,0,0,&x1,&y1,&w,&h); tft.setFont();
-  tick(BAR_X,r.mn,unitLabel(ch)); tick(BAR_X+BAR_W/2-(int)w/2,mid,unitLabel(ch));
-  if(ch==CH_LAMBDA && g_uLambda==U_L_lambda) snprintf(tmp,sizeof(tmp),"%.2f", r.mx); else snprintf(tmp,sizeof(tmp),"%.0f", r.mx);
-  tft.setFont(&FreeSans12pt7b); tft.getTextBounds(tmp,0,0,&x1,&y1,&w,&h); tft.setFont();
-  tick(BAR_X+BAR_W-(int)w-4,r.mx,unitLabel(ch));
-}
-
-inline float displayValueForChannel(Channel ch, float baseValue){
-  switch(ch){
-    case CH_SPEED: return toDisplaySpeed(baseValue);
-    case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-    case CH_MANIFOLD: case CH_TURBO_OUT: case CH_EGT1: case CH_EGT2:
-      return toDisplayTemp(baseValue);
-    case CH_BOOST: case CH_OIL: return toDisplayPressure(baseValue);
-    case CH_LAMBDA: return toDisplayLambda(baseValue);
-    default: return baseValue;
-  }
-}
+inline float displayValueForChannel(Channel ch, float baseValue){ return Channels::toDisplay(ch, baseValue); }
 
 int valueKeyForDisplay(Channel ch, float displayValue){
-  switch(ch){
-    case CH_BATTV: return (int)lroundf(displayValue * 10.0f);
-    case CH_BATTV2: return (int)lroundf(displayValue * 100.0f);
-    case CH_BATT_CURR: return (int)lroundf(displayValue * 10.0f);
-    case CH_DCDC_OUT_A: return (int)lroundf(displayValue * 10.0f);
-    case CH_DCDC_OUT_V: return (int)lroundf(displayValue * 100.0f);
-    case CH_DCDC_IN_V: return (int)lroundf(displayValue * 100.0f);
-    case CH_PV_AMPS: return (int)lroundf(displayValue * 10.0f);
-    case CH_PV_YIELD: return (int)lroundf(displayValue * 100.0f);
-    case CH_LAMBDA:
-      if(g_uLambda==U_L_lambda) return (int)lroundf(displayValue * 100.0f);
-      return (int)lroundf(displayValue * 10.0f);
-    default: return (int)lroundf(displayValue);
-  }
+  if(!isfinite(displayValue)) return INT32_MIN;
+  return (int)lroundf(displayValue * Channels::rt(ch).keyScale);
 }
 
 const char* minMaxSuffixFor(Channel ch){
@@ -1603,47 +2026,16 @@ float minMaxDisplayValue(Channel ch){
   MinMaxMode mode = minMaxModeFor(ch);
   if(mode == MINMAX_NONE) return valueDisplay(ch);
   float baseValue = (mode == MINMAX_MIN) ? uiMinValues[ch] : uiMaxValues[ch];
-  if(!uiMinMaxHas[ch] || !isfinite(baseValue)) baseValue = valueRawBase(ch);
+  if(!uiMinMaxHas[ch] || !isfinite(baseValue)) baseValue = valueBase(ch);
   return displayValueForChannel(ch, baseValue);
 }
 
 int valueKey(Channel ch){
   switch(ch){
-    case CH_SOOT: return (int)lroundf(soot_pct); 
-    case CH_SPEED: return (int)lroundf(valueDisplay(CH_SPEED));
-    case CH_RPM: return (int)lroundf(rpm);
-    case CH_COOLANT: return (int)lroundf(valueDisplay(CH_COOLANT));
-    case CH_TRANS1: return (int)lroundf(valueDisplay(CH_TRANS1));
-    case CH_TRANS2: return (int)lroundf(valueDisplay(CH_TRANS2));
-    case CH_OIL: return (int)lroundf(valueDisplay(CH_OIL));
-    case CH_BATTV: return (int)lroundf(battV*100.0f);
-    case CH_BATT_SOC: return isfinite(g_victronReadings.battSocPct) ? (int)lroundf(g_victronReadings.battSocPct) : INT32_MIN;
-    case CH_BATT_CURR: return isfinite(g_victronReadings.battCurrentA) ? (int)lroundf(g_victronReadings.battCurrentA * 10.0f) : INT32_MIN;
-    case CH_BATT_TTG: return isfinite(g_victronReadings.battTimeMin) ? (int)lroundf(g_victronReadings.battTimeMin) : INT32_MIN;
-    case CH_BATTV2: return isfinite(g_victronReadings.battV2) ? (int)lroundf(g_victronReadings.battV2 * 100.0f) : INT32_MIN;
-    case CH_DCDC_OUT_A: return isfinite(g_victronReadings.dcdcOutA) ? (int)lroundf(g_victronReadings.dcdcOutA * 10.0f) : INT32_MIN;
-    case CH_DCDC_OUT_V: return isfinite(g_victronReadings.dcdcOutV) ? (int)lroundf(g_victronReadings.dcdcOutV * 100.0f) : INT32_MIN;
-    case CH_DCDC_IN_V: return isfinite(g_victronReadings.dcdcInV) ? (int)lroundf(g_victronReadings.dcdcInV * 100.0f) : INT32_MIN;
-    case CH_PV_WATTS: return isfinite(g_victronReadings.pvWatts) ? (int)lroundf(g_victronReadings.pvWatts) : INT32_MIN;
-    case CH_PV_AMPS: return isfinite(g_victronReadings.pvAmps) ? (int)lroundf(g_victronReadings.pvAmps * 10.0f) : INT32_MIN;
-    case CH_PV_YIELD: return isfinite(g_victronReadings.pvYieldKwh) ? (int)lroundf(g_victronReadings.pvYieldKwh * 100.0f) : INT32_MIN;
     case CH_GEAR: return ((gear & 0xFF) << 8) | (targetgear & 0xFF);
     case CH_LOCKUP: return (int)g_tcState;
-    case CH_TORQUE: return (int)lroundf(torqueNm);
-    case CH_PEDAL: return (int)lroundf(pedalPct); case CH_TQ_DEMAND: return (int)lroundf(tqDemandPct);
-    case CH_EGT1: return (int)lroundf(valueDisplay(CH_EGT1));
-    case CH_EGT2: return (int)lroundf(valueDisplay(CH_EGT2));
-    case CH_BOOST: return (int)lroundf(valueDisplay(CH_BOOST));
-    case CH_MANIFOLD: return (int)lroundf(valueDisplay(CH_MANIFOLD));
-    case CH_TURBO_OUT: return (int)lroundf(valueDisplay(CH_TURBO_OUT));
-    case CH_LAMBDA:
-      if(g_uLambda==U_L_lambda) return (int)lroundf(valueDisplay(CH_LAMBDA)*100.0f);
-      else return (int)lroundf(valueDisplay(CH_LAMBDA)*10.0f);
-    case CH_IAT: return (int)lroundf(valueDisplay(CH_IAT));
-    case CH_FUELT: return (int)lroundf(valueDisplay(CH_FUELT));
-    case CH_ACTUATOR: return (int)turboActRaw;
     case CH_HEADLIGHTS: return headlightsOn?1:0;
-    default: return INT32_MIN;
+    default: return valueKeyForDisplay(ch, valueDisplay(ch));
   }
 }
 
@@ -1660,7 +2052,7 @@ inline void updateMinMaxValues(){
     Channel ch = (Channel)i;
     MinMaxMode mode = minMaxModeFor(ch);
     if(mode == MINMAX_NONE) continue;
-    float baseValue = valueRawBase(ch);
+    float baseValue = valueBase(ch);
     if(!isfinite(baseValue)) continue;
     if(!uiMinMaxHas[i]){
       uiMinValues[i] = baseValue;
@@ -1677,29 +2069,8 @@ inline void updateMinMaxValues(){
 }
 
 void formatDisplayValue(Channel ch, float displayValue, char* out, size_t outSize){
-  if((ch == CH_BATT_SOC || ch == CH_BATT_CURR || ch == CH_BATT_TTG || ch == CH_BATTV2
-      || ch == CH_DCDC_OUT_A || ch == CH_DCDC_OUT_V || ch == CH_DCDC_IN_V
-      || ch == CH_PV_WATTS || ch == CH_PV_AMPS || ch == CH_PV_YIELD)
-      && !isfinite(displayValue)){
-    snprintf(out, outSize, "--");
-    return;
-  }
-  if(ch == CH_BATTV){
-    snprintf(out, outSize, "%.1f", displayValue);
-  } else if(ch == CH_BATTV2){
-    snprintf(out, outSize, "%.2f", displayValue);
-  } else if(ch == CH_BATT_CURR || ch == CH_DCDC_OUT_A || ch == CH_PV_AMPS){
-    snprintf(out, outSize, "%.1f", displayValue);
-  } else if(ch == CH_DCDC_OUT_V || ch == CH_DCDC_IN_V){
-    snprintf(out, outSize, "%.2f", displayValue);
-  } else if(ch == CH_PV_YIELD){
-    snprintf(out, outSize, "%.2f", displayValue);
-  } else if(ch == CH_LAMBDA){
-    if(g_uLambda==U_L_lambda) snprintf(out, outSize, "%.2f", displayValue);
-    else snprintf(out, outSize, "%.1f", displayValue);
-  } else {
-    snprintf(out, outSize, "%.0f", displayValue);
-  }
+  if(!isfinite(displayValue)) snprintf(out, outSize, "--");
+  else snprintf(out, outSize, "%.*f", (int)decimalsFor(ch), displayValue);
 }
 
 // ===================== WARNINGS: helpers & UI overlays =====================
@@ -1712,7 +2083,7 @@ uint8_t warnLevelFor(Channel ch){
   uint8_t m = persist.warnMode[ch];
   if(m == CFG::WARN_OFF) return 0;
 
-  float v = valueRawBase(ch);
+  float v = Filters::warnValue(ch);
   if(!isfinite(v)) return 0;
 
   float t1 = persist.warnT1[ch];
@@ -1773,10 +2144,17 @@ inline void fullScreenMenuFrame(const char* title){
   drawAppBar();
   drawMenuTitle(title);
 }
+// MenuList view callbacks
+static void menuListDrawRow(uint8_t slot, const char* left, const char* right, bool sel){
+  redrawMenuRowAtLogical(slot, left, right, sel);
+}
+static void menuListClearRow(uint8_t slot){
+  clearRegion(8, MENU_TOP + slot*MENU_ROW_H - 20, 304, 26, COL_BG());
+}
 
 // ===================== Root Menu =====================
-const char* MENU_ROOT_ITEMS[] = { "Screen Layout", "Gauge Warnings", "Colours", "OBD2 Scan Tool", "System" };
-const int   MENU_ROOT_COUNT   = 5;
+const char* MENU_ROOT_ITEMS[] = { "Screen Layout", "Gauge Warnings", "Colours", "OBD2 Scan Tool", "DPF Regens", "System" };
+const int   MENU_ROOT_COUNT   = 6;
 
 void showRootMenu(bool full=true){
   if(full) fullScreenMenuFrame("Settings");
@@ -1790,8 +2168,10 @@ void updateRootSel(uint8_t prev, uint8_t now){
 }
 
 // ===================== OBD2 Menu =====================
-const char* MENU_OBD2_ITEMS[] = { "Read Codes", "Clear Codes" };
-const int   MENU_OBD2_COUNT   = 2;
+const char* MENU_OBD2_ITEMS[] = { "Read Codes", "Clear Codes", "J1939 DM1" };
+const int   MENU_OBD2_COUNT   = 3;
+static uint16_t obd2Dm1Gen = 0;     // J1939 DTC list generation on the page
+static uint8_t  obd2Dm1Count = 0;
 
 static void clearObd2Codes(){
   for(uint8_t i=0;i<OBD2_MAX_CODES;i++){
@@ -1814,6 +2194,13 @@ static bool decodeObd2Dtc(uint8_t a, uint8_t b, char out[6]){
   return true;
 }
 
+// Queue refused the request, or the controller gave up on it (see serviceCanTx)
+static void obd2SendFailed(){
+  obd2SendOk = false;
+  obd2Awaiting = false;
+  obd2NeedsRedraw = true;
+}
+
 static void sendObd2ReadRequest(){
   clearObd2Codes();
   obd2TimedOut = false;
@@ -1825,16 +2212,12 @@ static void sendObd2ReadRequest(){
   obd2ClearOk = false;
 
   struct can_frame out{};
-  out.can_id = 0x7DF;
+  out.can_id = OBD2_FUNCTIONAL_ID;
   out.can_dlc = 8;
   out.data[0] = 0x02;
   out.data[1] = 0x03;
   for(uint8_t i=2;i<8;i++) out.data[i] = 0x00;
-  if(mcp.sendMessage(&out) != MCP2515::ERROR_OK){
-    obd2SendOk = false;
-    obd2Awaiting = false;
-    obd2NeedsRedraw = true;
-  }
+  if(CanTx::send(out, CanTx::PRIO_NORMAL, TX_TAG_OBD2) != CanTx::TX_QUEUED) obd2SendFailed();
 }
 
 static void sendObd2ClearRequest(){
@@ -1848,16 +2231,12 @@ static void sendObd2ClearRequest(){
   obd2ClearOk = false;
 
   struct can_frame out{};
-  out.can_id = 0x7DF;
+  out.can_id = OBD2_FUNCTIONAL_ID;
   out.can_dlc = 8;
   out.data[0] = 0x01;
   out.data[1] = 0x04;
   for(uint8_t i=2;i<8;i++) out.data[i] = 0x00;
-  if(mcp.sendMessage(&out) != MCP2515::ERROR_OK){
-    obd2SendOk = false;
-    obd2Awaiting = false;
-    obd2NeedsRedraw = true;
-  }
+  if(CanTx::send(out, CanTx::PRIO_NORMAL, TX_TAG_OBD2) != CanTx::TX_QUEUED) obd2SendFailed();
 }
 
 static void obd2MaybeCapture(const can_frame& f){
@@ -1892,6 +2271,82 @@ static void updateObd2Timeout(unsigned long now){
     obd2TimedOut = true;
     obd2NeedsRedraw = true;
   }
+  // DM1 is broadcast, not requested: the page follows the list as it changes or goes stale
+  if(obd2Sel == 2){
+    const uint8_t n = J1939::dtcCount(now);
+    if(J1939::dtcGeneration() != obd2Dm1Gen || n != obd2Dm1Count) obd2NeedsRedraw = true;
+  }
+}
+
+// ===================== DPF Regen page =====================
+// Rows 0-2: live summary (refreshed at 1 Hz, only rows whose text changed); rows 3-6: history
+static const uint8_t REGEN_SUMMARY_ROWS = 3;
+static const uint8_t REGEN_LIST_ROWS = 4;
+uint8_t regenTop = 0;
+static char regenRowCache[REGEN_SUMMARY_ROWS][40];
+
+
+static void regenSummaryText(uint8_t row, const char*& left, char* right, size_t n){
+  switch(row){
+    case 0:
+      left = "Soot";
+      if(isfinite(soot_pct)) snprintf(right, n, "%.1f%% / %.0f%%", soot_pct, Regen::triggerPct());
+      else snprintf(right, n, "-- / %.0f%%", Regen::triggerPct());
+      break;
+    case 1: {
+      left = "Rate";
+      const float km = Regen::sootPerKm(), h = Regen::sootPerHour();
+      if(!isfinite(km) && !isfinite(h)){ snprintf(right, n, "learning"); break; }
+      char a[16] = "--", b[12] = "--";
+      if(isfinite(km)) snprintf(a, sizeof(a), "%.1f/100%s", km * 100.0f / distInUnit(1.0f), distUnit());
+      if(isfinite(h)) snprintf(b, sizeof(b), "%.1f/h", h);
+      snprintf(right, n, "%s %s", a, b);
+    } break;
+    default: {
+      left = Regen::inEvent() ? "Regen" : "Next regen";
+      const float km = Regen::kmToNext(), h = Regen::hoursToNext();
+      if(Regen::inEvent()) snprintf(right, n, "%s", regenState == REGEN_PAUSED ? "paused" : "active");
+      else if(isfinite(km)) snprintf(right, n, "~%.0f %s", distInUnit(km), distUnit());
+      else if(isfinite(h)) snprintf(right, n, "~%.1f h", h);
+      else snprintf(right, n, "learning");
+    } break;
+  }
+}
+
+void drawRegenSummary(bool force){
+  for(uint8_t r=0;r<REGEN_SUMMARY_ROWS;r++){
+    const char* left = "";
+    char right[40];
+    regenSummaryText(r, left, right, sizeof(right));
+    if(!force && strcmp(right, regenRowCache[r]) == 0) continue;
+    snprintf(regenRowCache[r], sizeof(regenRowCache[r]), "%s", right);
+    redrawMenuRowAtLogical(r, left, right, false);
+  }
+}
+
+void drawRegenHistory(){
+  const RegenLog& lg = Regen::log();
+  for(uint8_t r=0;r<REGEN_LIST_ROWS;r++){
+    const uint8_t idx = regenTop + r;
+    const int row = REGEN_SUMMARY_ROWS + r;
+    if(idx >= lg.count){
+      redrawMenuRowAtLogical(row, (idx == 0) ? "No regens yet" : "", "", false);
+      continue;
+    }
+    const RegenEvent& e = Regen::event(idx);
+    char left[24], right[24];
+    snprintf(left, sizeof(left), "#%u %um %.0f%s%s", (unsigned)(lg.total - idx), (unsigned)((e.durationS + 30) / 60),
+             distInUnit(e.distance10M / 100.0f), distUnit(), (e.flags & Regen::EV_INCOMPLETE) ? " !" : "");
+    snprintf(right, sizeof(right), "%u>%u%% %dC", (unsigned)((e.sootStartX10 + 5) / 10), (unsigned)((e.sootEndX10 + 5) / 10),
+             (int)max(e.egt1MaxC, e.egt2MaxC));
+    redrawMenuRowAtLogical(row, left, right, false);
+  }
+}
+
+void showRegenPage(bool full=true){
+  if(full) fullScreenMenuFrame("DPF Regens");
+  drawRegenSummary(true);
+  drawRegenHistory();
 }
 
 void showObd2Menu(bool full=true){
@@ -1929,7 +2384,7 @@ void showObd2Action(bool full=true){
         redrawMenuRowAtLogical(i, code, "", i==0);
       }
     }
-  } else {
+  } else if(obd2Sel == 1){
     if(obd2Awaiting){
       redrawMenuRowAtLogical(0, "Clearing codes...", "", true);
       redrawMenuRowAtLogical(1, "Waiting for ECU", "", false);
@@ -1946,175 +2401,98 @@ void showObd2Action(bool full=true){
       redrawMenuRowAtLogical(0, "Clear request sent", "", true);
       redrawMenuRowAtLogical(1, "Press CANCEL to return", "", false);
     }
+  } else {
+    const unsigned long now = millis();
+    obd2Dm1Gen = J1939::dtcGeneration();
+    obd2Dm1Count = J1939::dtcCount(now);
+    if(obd2Dm1Count == 0){
+      redrawMenuRowAtLogical(0, "No active DTCs", "", true);
+      redrawMenuRowAtLogical(1, J1939::stats().frames ? "Listening for DM1" : "No J1939 traffic", "", false);
+      return;
+    }
+    const int perPage = MENU_PER_PAGE();
+    for(int i=0;i<perPage;i++){
+      J1939::Dtc d;
+      if(!J1939::dtc((uint8_t)i, now, d)){ redrawMenuRowAtLogical(i, "", "", false); continue; }
+      char left[24], right[24];
+      snprintf(left, sizeof(left), "SPN %lu FMI %u", (unsigned long)d.spn, (unsigned)d.fmi);
+      snprintf(right, sizeof(right), "x%u  SA %02X", (unsigned)d.oc, (unsigned)d.sa);
+      redrawMenuRowAtLogical(i, left, right, i==0);
+    }
   }
 }
 
 // ===================== Layout: Screen picker =====================
+// LEFT/RIGHT cycles the template of the highlighted screen
 void showLayoutScreenPick(bool full=true){
   if(full) fullScreenMenuFrame("Settings > Screen Layout");
   const char* items[]={"Screen 1","Screen 2","Screen 3","Screen 4","Screen 5"};
-  for(int i=0;i<SCREEN_COUNT;i++) redrawMenuRowAtLogical(i, items[i], "", i==layoutScreenSel);
+  for(int i=0;i<SCREEN_COUNT;i++) redrawMenuRowAtLogical(i, items[i], Layout::get(persist.layouts[i].tpl).name, i==layoutScreenSel);
 }
 void updateLayoutScreenSel(uint8_t prev, uint8_t now){
   const char* items[]={"Screen 1","Screen 2","Screen 3","Screen 4","Screen 5"};
-  redrawMenuRowAtLogical(prev, items[prev], "", false);
-  redrawMenuRowAtLogical(now,  items[now],  "", true);
+  redrawMenuRowAtLogical(prev, items[prev], Layout::get(persist.layouts[prev].tpl).name, false);
+  redrawMenuRowAtLogical(now,  items[now],  Layout::get(persist.layouts[now].tpl).name,  true);
 }
 
 // ===================== Layout: Slot navigator =====================
-inline uint8_t slotFromRowCol(int8_t r,int8_t c){ return (r<0)? 4 : (uint8_t)(r*2 + c); }
+inline uint8_t& layoutSlotChannel(){ return persist.layouts[layoutScreenSel].ch[layoutSlot]; }
 
 void showLayoutSlots(bool full=true){
   if(full){
-    char ttl[32];
-    snprintf(ttl, sizeof(ttl), "Layout: Screen %d", (int)layoutScreenSel+1);
+    char ttl[40];
+    snprintf(ttl, sizeof(ttl), "Screen %d: %s", (int)layoutScreenSel+1, Layout::get(persist.layouts[layoutScreenSel].tpl).name);
     fullScreenMenuFrame(ttl);
   }
-  // draw 2x2 + bar preview
-  for(int i=0;i<4;i++){
-    PillSpec p = pillSpec(i);
-    tft.fillRoundRect(p.x,p.y,p.w,p.h,10,COL_CARD());
-    drawPillFrame(p,false,(Channel)persist.pillChannel[layoutScreenSel][i]);
-    drawPillLabel(p, labelText((Channel)persist.pillChannel[layoutScreenSel][i]));
-    clearPillValue(p);
-    tft.setFont(&FreeSans12pt7b); tft.setTextColor(COL_TXT(),COL_CARD());
-    tft.setCursor(p.x+10,p.y+p.h-10); tft.print("--");
-    const char* unit = unitLabel((Channel)persist.pillChannel[layoutScreenSel][i]);
-    if(unit[0]){
-      int16_t bx,by; uint16_t bw,bh; tft.getTextBounds("--", p.x+10, p.y+p.h-10, &bx,&by,&bw,&bh);
-      tft.setCursor(p.x+10 + bw + 8, p.y+p.h-10); tft.print(unit);
-    }
-    tft.setFont();
-  }
-  drawBarStaticForScreen(layoutScreenSel, false);
-  uint8_t slot = slotFromRowCol(layoutRow,layoutCol);
-  if(slot==4) drawBarStaticForScreen(layoutScreenSel, true); else drawPillFrame(pillSpec(slot),true,(Channel)persist.pillChannel[layoutScreenSel][slot]);
+  renderLayoutPreview(persist.layouts[layoutScreenSel], layoutSlot);
 }
 void updateLayoutCursor(uint8_t prevSlot, uint8_t nowSlot){
   if(prevSlot==nowSlot) return;
-  if(prevSlot==4) drawBarStaticForScreen(layoutScreenSel, false);
-  else drawPillFrame(pillSpec(prevSlot),false,(Channel)persist.pillChannel[layoutScreenSel][prevSlot]);
-
-  if(nowSlot==4) drawBarStaticForScreen(layoutScreenSel, true);
-  else drawPillFrame(pillSpec(nowSlot),true,(Channel)persist.pillChannel[layoutScreenSel][nowSlot]);
+  renderLayoutSelection(persist.layouts[layoutScreenSel], prevSlot, false);
+  renderLayoutSelection(persist.layouts[layoutScreenSel], nowSlot, true);
 }
 
 // ===================== Gauge picker (latched window like warning list) =====================
-inline bool pickingBarSlot(){ return (layoutRow<0); }
+inline bool pickingBarSlot(){ const ScreenLayout& l = persist.layouts[layoutScreenSel]; return Layout::needsRange(Layout::cell(l.tpl, layoutSlot).kind); }
 inline bool isEligibleForPicker(Channel ch){
   if(!isGaugeAvailable(ch)) return false;
   return pickingBarSlot()? isBarEligible(ch) : true;
 }
-inline int eligibleCount(){ int n=0; for(int i=0;i<CH__COUNT;i++) if(isEligibleForPicker((Channel)i)) n++; return n; }
-inline uint8_t channelFromEligibleIndex(int idx){ for(int i=0;i<CH__COUNT;i++) if(isEligibleForPicker((Channel)i)){ if(idx==0) return (uint8_t)i; idx--; } return 0; }
-inline int eligibleIndexFromChannel(uint8_t ch){ int pos=0; for(int i=0;i<CH__COUNT;i++) if(isEligibleForPicker((Channel)i)){ if(i==ch) return pos; pos++; } return 0; }
+static MenuList::ChannelMap pickerMap;
+static inline uint16_t pickerCount(){ return pickerMap.count; }
+static MenuList::Row pickerRow(uint16_t idx){
+  const uint8_t ch = pickerMap.ch[idx];
+  return { labelText((Channel)ch), ch == layoutSlotChannel() ? "current" : "" };
+}
+static const MenuList::Model kPickerModel = { pickerCount, pickerRow };
+static MenuList::List pickerList = { &kPickerModel, 0, 0 };
 
-void showLayoutGaugePicker(uint8_t current, bool full=true){
+// Rebuilds the eligible map for the slot being edited and selects its channel
+void openLayoutGaugePicker(){
+  MenuList::buildMap(pickerMap, isEligibleForPicker);
+  MenuList::focus(pickerList, pickerMap.pos[layoutSlotChannel()]);
+}
+void showLayoutGaugePicker(bool full=true){
   if(full) fullScreenMenuFrame("Pick Gauge");
-  const int perPage = MENU_PER_PAGE();
-  int total = eligibleCount();
-  for(int i=0;i<perPage;i++){
-    int idx = pickerTop + i;
-    int y = MENU_TOP + (i*MENU_ROW_H);
-    if(idx >= total){ clearRegion(8,y-20,304,26,COL_BG()); continue; }
-    uint8_t ch = channelFromEligibleIndex(idx);
-    bool isCurr = pickingBarSlot() ? (eligibleIndexFromChannel(current) == idx) : (current == ch);
-    const char* right = isCurr ? "current" : "";
-    redrawMenuRowAtLogical(i, labelText((Channel)ch), right, idx==menuIndex2);
-  }
+  MenuList::show(pickerList);
 }
-void updateGaugePickerSel(uint8_t prev, uint8_t now, uint8_t current){
-  const int perPage = MENU_PER_PAGE();
-
-  // Adjust window
-  int prevTopWin = pickerTop;
-  if(now < pickerTop) pickerTop = now;
-  if(now >= pickerTop + perPage) pickerTop = now - perPage + 1;
-
-  if(prevTopWin != pickerTop){
-    // OLD: showLayoutGaugePicker(current,true);
-    repaintGaugePickerWindow(current);   // <-- minimal repaint, avoids flicker
-    return;
-  }
+// ===================== Warnings list (eligible channels only) =====================
+static MenuList::ChannelMap warnMap;
+static inline uint16_t warnListCount(){ return warnMap.count; }
+static MenuList::Row warnListRow(uint16_t idx){ return { labelText((Channel)warnMap.ch[idx]), "" }; }
+static const MenuList::Model kWarnListModel = { warnListCount, warnListRow };
+static MenuList::List warnList = { &kWarnListModel, 0, 0 };
 
-  int rowPrev = prev - pickerTop;
-  int rowNow  = now  - pickerTop;
+// Channel under the warnings list cursor
+inline uint8_t warnListChannel(){ return warnMap.count ? warnMap.ch[warnList.sel] : 0; }
 
-  if(rowPrev >= 0 && rowPrev < perPage){
-    uint8_t chPrev = channelFromEligibleIndex(prev);
-    bool isCurrPrev = pickingBarSlot() ? (eligibleIndexFromChannel(current) == prev) : (current == chPrev);
-    redrawMenuRowAtLogical(rowPrev, labelText((Channel)chPrev), isCurrPrev ? "current" : "", false);
-  }
-  if(rowNow >= 0 && rowNow < perPage){
-    uint8_t chNow = channelFromEligibleIndex(now);
-    bool isCurrNow = pickingBarSlot() ? (eligibleIndexFromChannel(current) == now) : (current == chNow);
-    redrawMenuRowAtLogical(rowNow, labelText((Channel)chNow), isCurrNow ? "current" : "", true);
-  }
+void openWarnList(){
+  MenuList::buildMap(warnMap, isWarnEligible);
+  MenuList::focus(warnList, 0);
 }
-// ===================== Warnings list (eligible channels only) =====================
-int warnEligibleCount(){ int n=0; for(int i=0;i<CH__COUNT;i++) if(isWarnEligible((Channel)i)) n++; return n; }
-uint8_t warnChFromIdx(int idx){ for(int i=0;i<CH__COUNT;i++) if(isWarnEligible((Channel)i)){ if(idx==0) return (uint8_t)i; idx--; } return 0; }
-int warnIdxFromCh(uint8_t ch){ int pos=0; for(int i=0;i<CH__COUNT;i++) if(isWarnEligible((Channel)i)){ if(i==ch) return pos; pos++; } return 0; }
-
 void showWarnList(bool full=true){
   if(full) fullScreenMenuFrame("Settings > Gauge Warnings");
-  const int perPage=MENU_PER_PAGE();
-  for(int i=0;i<perPage;i++){
-    int gi = warnListTop + i;
-    int y = MENU_TOP + (i*MENU_ROW_H);
-    if(gi >= warnEligibleCount()){ clearRegion(8,y-20,304,26,COL_BG()); continue; }
-    uint8_t ch = warnChFromIdx(gi);
-    redrawMenuRowAtLogical(i, labelText((Channel)ch), "", gi==warnListSel);
-  }
-}
-// ===== Minimal repaint: WARNING LIST (no full frame) =====
-static inline void repaintWarnListWindow(){
-  const int perPage = MENU_PER_PAGE();
-  // Clear only the list body area
-  clearRegion(8, MENU_TOP-20, 304, perPage*MENU_ROW_H + 26, COL_BG());
-
-  for(int i=0;i<perPage;i++){
-    int gi = warnListTop + i;
-    int y = MENU_TOP + (i*MENU_ROW_H);
-    if(gi >= warnEligibleCount()){ clearRegion(8,y-20,304,26,COL_BG()); continue; }
-    uint8_t ch = warnChFromIdx(gi);
-    redrawMenuRowAtLogical(i, labelText((Channel)ch), "", gi==warnListSel);
-  }
-}
-// ===== Minimal repaint: GAUGE PICKER (no full frame) =====
-static inline void repaintGaugePickerWindow(uint8_t current){
-  const int perPage = MENU_PER_PAGE();
-  // Clear only the list body area
-  clearRegion(8, MENU_TOP-20, 304, perPage*MENU_ROW_H + 26, COL_BG());
-
-  int total = eligibleCount();
-  for(int i=0;i<perPage;i++){
-    int idx = pickerTop + i;
-    int y = MENU_TOP + (i*MENU_ROW_H);
-    if(idx >= total){ clearRegion(8,y-20,304,26,COL_BG()); continue; }
-    uint8_t ch = channelFromEligibleIndex(idx);
-    bool isCurr = pickingBarSlot() ? (eligibleIndexFromChannel(current) == idx) : (current == ch);
-    const char* right = isCurr ? "current" : "";
-    redrawMenuRowAtLogical(i, labelText((Channel)ch), right, idx==menuIndex2);
-  }
-}
-void updateWarnListSel(int prevSel, int newSel, int prevTop, int newTop){
-  const int perPage=MENU_PER_PAGE();
-  if(prevTop!=newTop){
-    // OLD: showWarnList(true);
-    repaintWarnListWindow();         // <-- minimal repaint, avoids flicker
-    return;
-  }
-  int rowPrev = prevSel - newTop;
-  int rowNow  = newSel  - newTop;
-  if(rowPrev>=0 && rowPrev<perPage){
-    uint8_t chPrev = warnChFromIdx(prevSel);
-    redrawMenuRowAtLogical(rowPrev, labelText((Channel)chPrev), "", false);
-  }
-  if(rowNow>=0 && rowNow<perPage){
-    uint8_t chNow = warnChFromIdx(newSel);
-    redrawMenuRowAtLogical(rowNow, labelText((Channel)chNow), "", true);
-  }
+  MenuList::show(warnList);
 }
 
 // ===================== Warnings field editor (detail page) =====================
@@ -2122,19 +2500,6 @@ void drawWarnFieldRow(int row, uint8_t ch, bool sel, bool blinkHide=false, bool
   char left[24]; char right[24];
   float t1 = useStaged? editT1 : persist.warnT1[ch];
   float t2 = useStaged? editT2 : persist.warnT2[ch];
-  // convert to display units for presentation
-  auto toDisplayForCh = [&](float v)->float{
-    switch((Channel)ch){
-      case CH_BATTV: return v;
-      case CH_LAMBDA: return toDisplayLambda(v);
-      case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-      case CH_EGT1: case CH_EGT2: case CH_MANIFOLD: case CH_TURBO_OUT: return toDisplayTemp(v);
-      case CH_BOOST: case CH_OIL: return toDisplayPressure(v);
-      case CH_SPEED: return toDisplaySpeed(v);
-      default: return v;
-    }
-  };
-
   if(row==0){
     snprintf(left,sizeof(left),"Mode");
     uint8_t m = useStaged? editMode : persist.warnMode[ch];
@@ -2143,16 +2508,9 @@ void drawWarnFieldRow(int row, uint8_t ch, bool sel, bool blinkHide=false, bool
   }else if(row==1 || row==2){
     snprintf(left,sizeof(left), row==1?"Level 1":"Level 2");
     float v = (row==1)? t1 : t2;
-    v = toDisplayForCh(v);
+    v = Channels::toDisplay((Channel)ch, v);
     if(blinkHide) snprintf(right,sizeof(right),"      ");
-    else{
-      if((Channel)ch==CH_BATTV) snprintf(right,sizeof(right),"%0.2f", v);
-      else if((Channel)ch==CH_LAMBDA) {
-        if(g_uLambda==U_L_lambda) snprintf(right,sizeof(right),"%0.2f", v);
-        else snprintf(right,sizeof(right),"%0.1f", v);
-      }
-      else snprintf(right,sizeof(right),"%0.0f", v);
-    }
+    else snprintf(right,sizeof(right),"%0.*f", (int)decimalsFor((Channel)ch), v);
   }else{ left[0]=right[0]=0; }
   redrawMenuRowAtLogical(row, left, right, sel);
 }
@@ -2171,26 +2529,8 @@ inline void stepWarnValueOnce(uint8_t ch, bool up){
   // Work in DISPLAY units to feel natural, then convert back to staged base values
   float dispT = (warnFieldSel==1) ? editT1 : editT2; // still base currently
   // Convert base -> display
-  auto baseToDisp = [&](float v)->float{
-    switch((Channel)ch){
-      case CH_LAMBDA: return toDisplayLambda(v);
-      case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-      case CH_EGT1: case CH_EGT2: case CH_MANIFOLD: case CH_TURBO_OUT: return toDisplayTemp(v);
-      case CH_BOOST: case CH_OIL: return toDisplayPressure(v);
-      case CH_SPEED: return toDisplaySpeed(v);
-      default: return v;
-    }
-  };
-  auto dispToBase = [&](float v)->float{
-    switch((Channel)ch){
-      case CH_LAMBDA: return fromDisplayLambda(v);
-      case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-      case CH_EGT1: case CH_EGT2: case CH_MANIFOLD: case CH_TURBO_OUT: return fromDisplayTemp(v);
-      case CH_BOOST: case CH_OIL: return fromDisplayPressure(v);
-      case CH_SPEED: return fromDisplaySpeed(v);
-      default: return v;
-    }
-  };
+  auto baseToDisp = [&](float v)->float{ return Channels::toDisplay((Channel)ch, v); };
+  auto dispToBase = [&](float v)->float{ return Channels::fromDisplay((Channel)ch, v); };
   float curDisp = baseToDisp(dispT);
   float st = stepFor((Channel)ch);
   if(!up) st = -st;
@@ -2209,7 +2549,7 @@ inline void stepWarnValueOnce(uint8_t ch, bool up){
   else if(editMode==CFG::WARN_LOW){ if(editT2 > editT1) editT1 = editT2; }
 
   // Clamp to BASE ranges
-  Range rb = RNG_BASE[(Channel)ch];
+  Range rb = baseRangeFor((Channel)ch);
   editT1=clampf(editT1,rb.mn,rb.mx); editT2=clampf(editT2,rb.mn,rb.mx);
 }
 void commitWarnField(uint8_t ch){
@@ -2220,7 +2560,7 @@ void commitWarnField(uint8_t ch){
   if(persist.warnMode[ch]==CFG::WARN_HIGH){ if(persist.warnT2[ch] < persist.warnT1[ch]) persist.warnT2[ch] = persist.warnT1[ch]; }
   else if(persist.warnMode[ch]==CFG::WARN_LOW){ if(persist.warnT2[ch] > persist.warnT1[ch]) persist.warnT1[ch] = persist.warnT2[ch]; }
 
-  Range r=RNG_BASE[(Channel)ch];
+  Range r=baseRangeFor((Channel)ch);
   persist.warnT1[ch]=clampf(persist.warnT1[ch],r.mn,r.mx); persist.warnT2[ch]=clampf(persist.warnT2[ch],r.mn,r.mx);
   dirty=true;
 }
@@ -2230,66 +2570,15 @@ void discardWarnField(uint8_t ch){
   else editT2 = persist.warnT2[ch];
 }
 
-// Redraw whole visible window (used when the window scrolls)
-static inline void repaintColoursWindow(){
-  const int perPage = MENU_PER_PAGE();
-  const int total   = paletteCount();
-
-  // Clear only the list body area
-  clearRegion(8, MENU_TOP-20, 304, perPage*MENU_ROW_H + 26, COL_BG());
+// ===================== Colours =====================
+static inline uint16_t coloursCount(){ return (uint16_t)paletteCount(); }
+static MenuList::Row coloursRow(uint16_t idx){ return { paletteNameForIndex(idx), idx == paletteIndex ? "current" : "" }; }
+static const MenuList::Model kColoursModel = { coloursCount, coloursRow };
+static MenuList::List coloursList = { &kColoursModel, 0, 0 };
 
-  for(int i=0;i<perPage;i++){
-    int gi = coloursTop + i;
-    int y  = MENU_TOP + (i*MENU_ROW_H);
-    if (gi >= total) { clearRegion(8, y-20, 304, 26, COL_BG()); continue; }
-    const char* right = (gi == paletteIndex) ? "current" : "";
-    redrawMenuRowAtLogical(i, paletteNameForIndex(gi), right, gi==coloursSel);
-  }
-}
-
-// Incremental selection update (no window scroll)
-static inline void updateColoursSel(int prevSel, int curSel, int prevTop, int curTop){
-  const int perPage = MENU_PER_PAGE();
-  const int total   = paletteCount();
-
-  // If window moved, redraw the visible slice
-  if (prevTop != curTop) { repaintColoursWindow(); return; }
-
-  // Unhighlight previous row (if visible)
-  if (prevSel >= curTop && prevSel < curTop + perPage && prevSel < total) {
-    int i = prevSel - curTop;                       // logical row
-    const char* rightPrev = (prevSel == paletteIndex) ? "current" : "";
-    redrawMenuRowAtLogical(i, paletteNameForIndex(prevSel), rightPrev, false);
-  }
-
-  // Highlight current row (if visible)
-  if (curSel >= curTop && curSel < curTop + perPage && curSel < total) {
-    int i = curSel - curTop;                        // logical row
-    const char* rightNow = (curSel == paletteIndex) ? "current" : "";
-    redrawMenuRowAtLogical(i, paletteNameForIndex(curSel), rightNow, true);
-  }
-}
-
-// ===================== Colours =====================
-void showColoursPage(bool full=true){
-  if(full) fullScreenMenuFrame("Settings > Colours");
-
-  const int perPage = MENU_PER_PAGE();
-  const int total   = paletteCount();
-
-  for(int i=0;i<perPage;i++){
-    int gi = coloursTop + i;                         // global index
-    int y  = MENU_TOP + (i*MENU_ROW_H);              // same layout as warn list
-
-    if (gi >= total) {                               // clear trailing rows
-      clearRegion(8, y-20, 304, 26, COL_BG());
-      continue;
-    }
-
-    const char* right = (gi == paletteIndex) ? "current" : "";
-    // i is the logical row index (0..perPage-1), just like warn list
-    redrawMenuRowAtLogical(i, paletteNameForIndex(gi), right, gi==coloursSel);
-  }
+void showColoursPage(bool full=true){
+  if(full) fullScreenMenuFrame("Settings > Colours");
+  MenuList::show(coloursList);
 }
 
 // ===================== Custom palette =====================
@@ -2318,58 +2607,14 @@ void updateCustomPaletteSel(uint8_t prev, uint8_t now){
   drawCustomPaletteRow(now, true);
 }
 
-static inline void repaintCustomColourWindow(){
-  const int perPage = MENU_PER_PAGE();
-  const int total = customColourCount();
+static inline uint16_t customColourListCount(){ return customColourCount(); }
+static MenuList::Row customColourRow(uint16_t idx){
   const CustomPalette& palette = persist.customPalettes[customPaletteSel];
-  uint16_t currentValue = customZoneValue(palette, customZoneSel);
-  uint8_t currentIndex = customColourIndexForValue(currentValue);
-
-  clearRegion(8, MENU_TOP-20, 304, perPage*MENU_ROW_H + 26, COL_BG());
-
-  for(int i = 0; i < perPage; i++){
-    int gi = customColourTop + i;
-    int y  = MENU_TOP + (i * MENU_ROW_H);
-    if (gi >= total) { clearRegion(8, y-20, 304, 26, COL_BG()); continue; }
-    const char* right = (gi == currentIndex) ? "current" : "";
-    redrawMenuRowAtLogical(i, CUSTOM_COLOUR_OPTIONS[gi].name, right, gi == customColourSel);
-  }
-}
-
-static inline void updateCustomColourSel(int prevSel, int curSel, int prevTop, int curTop){
-  const int perPage = MENU_PER_PAGE();
-  const int total = customColourCount();
-
-  if (prevTop != curTop) { repaintCustomColourWindow(); return; }
-
-  if (prevSel >= curTop && prevSel < curTop + perPage && prevSel < total) {
-    int i = prevSel - curTop;
-    const CustomPalette& palette = persist.customPalettes[customPaletteSel];
-    uint8_t currentIndex = customColourIndexForValue(customZoneValue(palette, customZoneSel));
-    const char* rightPrev = (prevSel == currentIndex) ? "current" : "";
-    redrawMenuRowAtLogical(i, CUSTOM_COLOUR_OPTIONS[prevSel].name, rightPrev, false);
-  }
-
-  if (curSel >= curTop && curSel < curTop + perPage && curSel < total) {
-    int i = curSel - curTop;
-    const CustomPalette& palette = persist.customPalettes[customPaletteSel];
-    uint8_t currentIndex = customColourIndexForValue(customZoneValue(palette, customZoneSel));
-    const char* rightNow = (curSel == currentIndex) ? "current" : "";
-    redrawMenuRowAtLogical(i, CUSTOM_COLOUR_OPTIONS[curSel].name, rightNow, true);
-  }
-}
-
-static inline void enterCustomColourPicker(){
-  const CustomPalette& palette = persist.customPalettes[customPaletteSel];
-  uint16_t currentValue = customZoneValue(palette, customZoneSel);
-  customColourSel = customColourIndexForValue(currentValue);
-  const int perPage = MENU_PER_PAGE();
-  const int total = customColourCount();
-  customColourTop = customColourSel - perPage / 2;
-  if (customColourTop < 0) customColourTop = 0;
-  int maxTop = total - perPage; if (maxTop < 0) maxTop = 0;
-  if (customColourTop > maxTop) customColourTop = maxTop;
+  const bool isCurr = (CUSTOM_COLOUR_OPTIONS[idx].value == customZoneValue(palette, customZoneSel));
+  return { CUSTOM_COLOUR_OPTIONS[idx].name, isCurr ? "current" : "" };
 }
+static const MenuList::Model kCustomColourModel = { customColourListCount, customColourRow };
+static MenuList::List customColourList = { &kCustomColourModel, 0, 0 };
 
 void showCustomColourPicker(bool full=true){
   if(full){
@@ -2377,7 +2622,7 @@ void showCustomColourPicker(bool full=true){
     snprintf(title, sizeof(title), "Custom %u > %s", (unsigned)(customPaletteSel + 1), CUSTOM_ZONE_LABELS[customZoneSel]);
     fullScreenMenuFrame(title);
   }
-  repaintCustomColourWindow();
+  MenuList::show(customColourList);
 }
 
 // ===================== System Menus (NEW) =====================
@@ -2435,10 +2680,8 @@ void showUnitsPage(bool full=true){
 // ---- WiFi page ----
 static inline void drawWifiRow(int row, bool sel){
   const char* left = (row==0) ? "SSID" : (row==1) ? "Password" : "URL";
-  String rightStr;
-  if(row==0) rightStr = String(persist.wifiSsid);
-  else if(row==1) rightStr = String(persist.wifiPass);
-  else rightStr = wifiPageUrl();
+  char url[32];
+  const char* rightStr = (row==0) ? persist.wifiSsid : (row==1) ? persist.wifiPass : wifiPageUrl(url, sizeof(url));
   char right[40];
   copyStringToBuffer(rightStr, right, sizeof(right));
   redrawMenuRowAtLogical(row, left, right, sel);
@@ -2492,19 +2735,12 @@ static unsigned long lastEnterTapMs = 0;
 constexpr uint32_t ENTER_TAP_MS = 450;
 constexpr uint32_t ENTER_HOLD_MS = 2000;
 
-// Buttons (edge detect)
-static bool sw_up_prev=false, sw_down_prev=false, sw_left_prev=false, sw_right_prev=false, sw_enter_prev=false;
-#if DEBUG_BUTTONS
-static bool sw_cancel_prev=false;
-#endif
-
 inline bool bitSetSafe(const can_frame& f,uint8_t byteIdx,uint8_t bit){ if(bit>7||f.can_dlc<=byteIdx) return false; return (f.data[byteIdx]&(1u<<bit))!=0; }
 
 // Enter/exit settings
 void navEnterSettings(){
   menuState = MENU_ROOT;
   menuIndex = g_lastRootIndex;
-  menuIndex2 = 0;
   fullScreenMenuFrame("Settings");
   showRootMenu(false);
 }
@@ -2537,20 +2773,21 @@ template<typename T> inline void wrapDec(T& v, T maxIncl){ v = (v>0)? (T)(v-1) :
 // ---- CAN Sniffer: helpers ----
 static inline char hexNib(uint8_t v){ return (v<10)?('0'+v):('A'+(v-10)); }
 
-// Render one row (Address / From / To / Scale / Bias)
+// Render one row (Address / From / To / Scale / Bias / Byte order)
 void drawSniffRow(uint8_t row, bool sel, bool blinkHide){
   char left[16], right[40]; left[0]=right[0]=0;
 
   if(row==0){
     strcpy(left, "Address");
-    // Build "0x" + SNF_HEX_DIGITS nibbles (MSB..LSB). While editing & selected,
+    // Build "0x" + 3 or 8 nibbles (MSB..LSB). While editing & selected,
     // we only blink the *selected nibble* (snf_cursor); others stay visible.
+    const uint8_t digits = snfHexDigits();
     char tmp[16]; tmp[0]=0; strcat(tmp,"0x");
-    for(uint8_t i=0;i<SNF_HEX_DIGITS;i++){
-      // i=0 is MSB, i=SNF_HEX_DIGITS-1 is LSB
+    for(uint8_t i=0;i<digits;i++){
+      // i=0 is MSB, i=digits-1 is LSB
       uint8_t nibIndexFromMSB = i;
-      uint8_t shiftFromMSB = (SNF_HEX_DIGITS-1 - nibIndexFromMSB)*4; // convert to shift-from-LSB
-      uint8_t nib = (snf_id >> shiftFromMSB) & 0xF;
+      uint8_t shiftFromMSB = (digits-1 - nibIndexFromMSB)*4; // convert to shift-from-LSB
+      uint8_t nib = ((snf_id & CAN_EFF_MASK) >> shiftFromMSB) & 0xF;   // without the 29-bit flag, as snfFormatId
 
       bool blinkThisNib = (snf_editing && snf_sel==0 && blinkHide && (snf_cursor == nibIndexFromMSB));
       char c = blinkThisNib ? ' ' : ((nib<10)?('0'+nib):('A'+(nib-10)));
@@ -2573,31 +2810,27 @@ void drawSniffRow(uint8_t row, bool sel, bool blinkHide){
     if(blinkHide && snf_editing && snf_sel==3) strcpy(right,"     ");
     else snprintf(right,sizeof(right), "%.3f  (step %.3g)", snf_scale, snf_step);
   }
-  else { // row==4
+  else if(row==4){
     strcpy(left,"Bias");
     if(blinkHide && snf_editing && snf_sel==4) strcpy(right,"     ");
     else snprintf(right,sizeof(right), "%.3f  (step %.3g)", snf_bias, snf_step);
   }
+  else { // row==5
+    strcpy(left,"Byte order");
+    strcpy(right, (snf_order==CanField::ORDER_BE) ? "Big (Motorola)" : "Little (Intel)");
+  }
 
   redrawMenuRowAtLogical(row, left, right, sel);
 }
 
-// Pack payload little-endian into 64-bit lane:
-// data[0]→bits0..7, data[1]→8..15, data[2]→16..23, etc.
-static inline uint64_t snfPackLE(){
-  uint64_t v=0;
-  for(uint8_t i=0;i<snf_dlc && i<8;i++)
-    v |= ((uint64_t)snf_data[i]) << (8*i);
-  return v;
-}
 // Draw the live area (raw + scaled)
 void drawSniffLive(){
-  // We print 3 lines: DATA, RAW, SCALED
+  // We print 2 lines: DATA, RAW = SCALED
   // Use a safe baseline so last line never exceeds the 240px panel.
   const int LH = 20;                     // line height for FreeSans9 (roughly)
-  const int lines = 3;
+  const int lines = 2;
   const int yMaxBaseline = 236;          // a couple of pixels above bottom
-  int baseSuggested = MENU_TOP + 5*MENU_ROW_H + 6;  // below 5 rows of controls
+  int baseSuggested = MENU_TOP + SNF_ROWS*MENU_ROW_H + 6;  // below the control rows
   int liveTop = baseSuggested;
   int maxTop  = yMaxBaseline - (lines-1)*LH;
   if(liveTop > maxTop) liveTop = maxTop; // pull up if it would clip
@@ -2605,10 +2838,9 @@ void drawSniffLive(){
   static unsigned long lastDrawMs = 0;
   static char prevDATA[64]   = "";
   static char prevRAW[64]    = "";
-  static char prevSCALED[48] = "";
 
   // Build current strings
-  char DATA[64]="", RAW[64]="", SCALED[48]="--";
+  char DATA[64]="", RAW[64]="";
 
   // DATA line
   if(!snf_has){
@@ -2626,26 +2858,19 @@ void drawSniffLive(){
   // RAW / SCALED
   uint32_t rawVal = 0;
   if(!snf_has){
-    snprintf(RAW, sizeof(RAW), "RAW %u..%u: --", (unsigned)snf_bit_from, (unsigned)snf_bit_to);
-    snprintf(SCALED, sizeof(SCALED), "--");
+    snprintf(RAW, sizeof(RAW), "RAW: --");
   } else if(snf_bit_from > snf_bit_to){
-    snprintf(RAW, sizeof(RAW), "RAW %u..%u: (invalid)", (unsigned)snf_bit_from, (unsigned)snf_bit_to);
-    snprintf(SCALED, sizeof(SCALED), "--");
+    snprintf(RAW, sizeof(RAW), "RAW: (invalid range)");
   } else {
-    uint8_t width = (uint8_t)(snf_bit_to - snf_bit_from + 1);
-    if(width>32) width = 32;
-    uint64_t lane = snfPackLE();
-    uint64_t mask = (width==64)?~(uint64_t)0 : (((uint64_t)1<<width) - 1);
-    rawVal  = (uint32_t)((lane >> snf_bit_from) & mask);
-    snprintf(RAW, sizeof(RAW), "RAW %u..%u: 0x%X  (%u)",
-             (unsigned)snf_bit_from, (unsigned)snf_bit_to, rawVal, rawVal);
+    uint64_t lane = CanField::pack(snf_data, snf_dlc, snf_order);
+    rawVal  = CanField::extract(lane, snf_bit_from, snf_bit_to, snf_order);
     float scaled = (float)rawVal * snf_scale + snf_bias;
-    snprintf(SCALED, sizeof(SCALED), "SCALED: %.3f", scaled);
+    snprintf(RAW, sizeof(RAW), "RAW 0x%X (%u) = %.3f", rawVal, rawVal, scaled);
   }
 
   // Throttle + change-detect to reduce flicker
   unsigned long now = millis();
-  bool changed = (strcmp(DATA, prevDATA)!=0) || (strcmp(RAW, prevRAW)!=0) || (strcmp(SCALED, prevSCALED)!=0);
+  bool changed = (strcmp(DATA, prevDATA)!=0) || (strcmp(RAW, prevRAW)!=0);
   if(!changed && (now - lastDrawMs < 100)) return;  // 10 Hz max if nothing changed
   lastDrawMs = now;
 
@@ -2659,43 +2884,367 @@ void drawSniffLive(){
   tft.setCursor(16, liveTop);
   tft.print(DATA);
 
-  // RAW
+  // RAW = SCALED
   tft.setCursor(16, liveTop + LH);
   tft.print(RAW);
 
-  // SCALED
-  tft.setCursor(16, liveTop + 2*LH);
-  tft.print(SCALED);
-
   tft.setFont();
 
   // cache
   strncpy(prevDATA,   DATA,   sizeof(prevDATA));
   strncpy(prevRAW,    RAW,    sizeof(prevRAW));
-  strncpy(prevSCALED, SCALED, sizeof(prevSCALED));
+}
+
+// ---- CAN Sniffer: census list ----
+static uint8_t snf_censusSlots[CanCensus::MAX_IDS];
+static uint8_t snf_censusCount = 0;
+static char    snf_censusRowCache[7][48];
+
+static inline CanCensus::SortMode snfCensusSort(){
+  return (snf_view == SNF_VIEW_CENSUS_RECENT) ? CanCensus::SORT_RECENT : CanCensus::SORT_RATE;
+}
+
+static inline void snfRefreshCensusOrder(){
+  snf_censusCount = CanCensus::sorted(snfCensusSort(), snf_censusSlots, CanCensus::MAX_IDS);
+}
+
+static inline int snfCensusIndexOfId(uint32_t id, uint8_t bus){
+  for(uint8_t i=0;i<snf_censusCount;i++){
+    const CanCensus::Entry* e = CanCensus::slot(snf_censusSlots[i]);
+    if(e && e->id == id && e->bus == bus) return i;
+  }
+  return -1;
+}
+
+static inline void snfCensusSelect(const CanCensus::Entry* e){
+  snf_censusSelId = e ? e->id : 0xFFFFFFFF;
+  snf_censusSelBus = e ? e->bus : CFG::CAN_BUS_PT;
+}
+
+static inline void snfFormatId(uint32_t id, char* out, size_t n){
+  if(id & CAN_EFF_FLAG) snprintf(out, n, "0x%08lX", (unsigned long)(id & CAN_EFF_MASK));
+  else snprintf(out, n, "0x%03lX", (unsigned long)id);
+}
+
+// "B1 " in front of an ID once a second bus is fitted; nothing on a single-bus build
+static inline const char* snfBusTag(uint8_t bus){
+  static const char* const kTags[CanBus::MAX_BUSES] = { "B0 ", "B1 " };
+  return (CanBus::count() > 1 && bus < CanBus::MAX_BUSES) ? kTags[bus] : "";
+}
+
+static void drawSniffCensus(bool full){
+  const int perPage = MENU_PER_PAGE();
+  if(full){
+    clearRegion(8, MENU_TOP-20, 304, perPage*MENU_ROW_H + 26, COL_BG());
+    for(int i=0;i<perPage;i++) snf_censusRowCache[i][0] = '\0';
+  }
+  snfRefreshCensusOrder();
+
+  int sel = snfCensusIndexOfId(snf_censusSelId, snf_censusSelBus);
+  if(sel < 0){ sel = 0; snfCensusSelect((snf_censusCount > 0) ? CanCensus::slot(snf_censusSlots[0]) : nullptr); }
+  if(sel < snf_censusTop) snf_censusTop = sel;
+  if(sel >= snf_censusTop + perPage) snf_censusTop = sel - perPage + 1;
+  int maxTop = (int)snf_censusCount - perPage; if(maxTop < 0) maxTop = 0;
+  if(snf_censusTop > maxTop) snf_censusTop = maxTop;
+
+  const unsigned long now = millis();
+  for(int i=0;i<perPage;i++){
+    int gi = snf_censusTop + i;
+    char key[48];
+    char left[24] = "", right[20] = "";
+    if(gi < snf_censusCount){
+      const CanCensus::Entry* e = CanCensus::slot(snf_censusSlots[gi]);
+      char idTxt[12]; snfFormatId(e->id, idTxt, sizeof(idTxt));
+      snprintf(left, sizeof(left), "%s%s [%u]", snfBusTag(e->bus), idTxt, (unsigned)e->dlc);
+      if(snf_view == SNF_VIEW_CENSUS_RECENT){
+        if(e->lastChangeMs == 0) snprintf(right, sizeof(right), "static");
+        else snprintf(right, sizeof(right), "%.1fs", (now - e->lastChangeMs) / 1000.0f);
+      } else {
+        snprintf(right, sizeof(right), "%u Hz", (unsigned)e->rateHz);
+      }
+    }
+    snprintf(key, sizeof(key), "%c%s|%s", (gi == sel) ? '>' : ' ', left, right);
+    if(strcmp(key, snf_censusRowCache[i]) == 0) continue;
+    snprintf(snf_censusRowCache[i], sizeof(snf_censusRowCache[i]), "%s", key);
+    if(gi >= snf_censusCount){
+      clearRegion(8, MENU_TOP + i*MENU_ROW_H - 20, 304, 26, COL_BG());
+      continue;
+    }
+    redrawMenuRowAtLogical(i, left, right, gi == sel);
+  }
+}
+
+static void snfCensusMove(int delta){
+  snfRefreshCensusOrder();
+  if(snf_censusCount == 0) return;
+  int sel = snfCensusIndexOfId(snf_censusSelId, snf_censusSelBus);
+  if(sel < 0) sel = 0;
+  sel += delta;
+  if(sel < 0) sel = snf_censusCount - 1;
+  if(sel >= snf_censusCount) sel = 0;
+  snfCensusSelect(CanCensus::slot(snf_censusSlots[sel]));
+}
+
+// ---- CAN Sniffer: 64-bit toggle heatmap for snf_id ----
+static const int SNF_HM_TOP = APPBAR_H + 24;
+static const int SNF_HM_ROW_H = 22;
+static const int SNF_HM_LEFT = 40;
+static const int SNF_HM_CELL_W = 34;
+static uint8_t snf_hmCellCache[64];   // bucket | (bit<<2) | (inRange<<3); 0xFF = force redraw
+
+static inline uint8_t snfHeatBucket(uint8_t toggles){
+  if(toggles == 0) return 0;
+  if(toggles < 8) return 1;
+  if(toggles < 64) return 2;
+  return 3;
+}
+
+static inline uint16_t snfHeatColor(uint8_t bucket){
+  switch(bucket){
+    case 1: return COL_ACCENT();
+    case 2: return COL_ORANGE();
+    case 3: return COL_RED();
+    default: return COL_CARD();
+  }
+}
+
+static void drawSniffHeatmap(bool full){
+  if(full){
+    clearRegion(0, APPBAR_H+1, 320, 240-APPBAR_H-1, COL_BG());
+    memset(snf_hmCellCache, 0xFF, sizeof(snf_hmCellCache));
+    tft.setFont();
+    tft.setTextColor(COL_TICKS(), COL_BG());
+    for(uint8_t byteIdx=0; byteIdx<8; byteIdx++){
+      tft.setCursor(12, SNF_HM_TOP + byteIdx*SNF_HM_ROW_H + 7);
+      tft.print("B"); tft.print(byteIdx);
+    }
+  }
+  const CanCensus::Entry* e = CanCensus::find(snf_id, snf_bus);
+  for(uint8_t bit=0; bit<64; bit++){
+    const uint8_t byteIdx = bit / 8;
+    const uint8_t col = 7 - (bit % 8);      // MSB on the left, as hex reads
+    uint8_t bucket = e ? snfHeatBucket(e->toggles[bit]) : 0;
+    uint8_t val = (e && byteIdx < e->dlc) ? ((e->data[byteIdx] >> (bit % 8)) & 1) : 0;
+    // Heatmap cells use LE numbering; map to CanField BE numbering (bit 0 = MSB of data[0])
+    uint8_t fieldBit = (snf_order==CanField::ORDER_BE) ? (uint8_t)(byteIdx*8 + (7 - bit % 8)) : bit;
+    bool inRange = (snf_bit_from <= snf_bit_to) && fieldBit >= snf_bit_from && fieldBit <= snf_bit_to;
+    bool present = e && byteIdx < e->dlc;
+    uint8_t key = (uint8_t)(bucket | (val << 2) | (inRange ? 0x08 : 0) | (present ? 0x10 : 0));
+    if(key == snf_hmCellCache[bit]) continue;
+    snf_hmCellCache[bit] = key;
+
+    int x = SNF_HM_LEFT + col*SNF_HM_CELL_W;
+    int y = SNF_HM_TOP + byteIdx*SNF_HM_ROW_H;
+    uint16_t fill = present ? snfHeatColor(bucket) : COL_BG();
+    tft.fillRect(x+1, y+1, SNF_HM_CELL_W-2, SNF_HM_ROW_H-2, fill);
+    tft.drawRect(x, y, SNF_HM_CELL_W, SNF_HM_ROW_H, inRange ? COL_YELLOW() : COL_FRAME());
+    if(present){
+      tft.setFont();
+      tft.setTextColor(COL_TXT(), fill);
+      tft.setCursor(x + SNF_HM_CELL_W/2 - 3, y + 7);
+      tft.print(val ? '1' : '0');
+    }
+  }
+}
+
+// ---- CAN Sniffer: signal discovery ----
+// Reference channels offered for correlation; index 0 = off
+static const Channel SNF_DISC_REFS[] = { CH_SPEED, CH_RPM, CH_COOLANT, CH_BOOST, CH_PEDAL, CH_OIL, CH_TRANS1 };
+static const uint8_t SNF_DISC_REF_COUNT = sizeof(SNF_DISC_REFS)/sizeof(SNF_DISC_REFS[0]);
+static uint8_t snf_discRefIdx = 0;     // 0 = off, else SNF_DISC_REFS[idx-1]
+static uint8_t snf_discSel = 0;        // 0 = reference row, 1.. = candidates
+static SignalDiscovery::Candidate snf_discTop[6];
+static uint8_t snf_discCount = 0;
+static char    snf_discRowCache[7][48];
+
+static void drawSniffDiscover(bool full){
+  const int perPage = MENU_PER_PAGE();
+  if(full){
+    clearRegion(8, MENU_TOP-20, 304, perPage*MENU_ROW_H + 26, COL_BG());
+    for(int i=0;i<perPage;i++) snf_discRowCache[i][0] = '\0';
+  }
+  snf_discCount = SignalDiscovery::active() ? SignalDiscovery::top(snf_discTop, perPage-1) : 0;
+  if(snf_discSel > snf_discCount) snf_discSel = snf_discCount;
+
+  for(int i=0;i<perPage;i++){
+    char left[24] = "", right[28] = "", key[48];
+    if(i==0){
+      strcpy(left, "Reference");
+      if(snf_discRefIdx==0) strcpy(right, "Off");
+      else snprintf(right, sizeof(right), "%s  %lu", labelText(SNF_DISC_REFS[snf_discRefIdx-1]),
+                    (unsigned long)SignalDiscovery::sampledFrames());
+    } else if(i <= snf_discCount){
+      const SignalDiscovery::Candidate& c = snf_discTop[i-1];
+      char idTxt[12]; snfFormatId(c.id, idTxt, sizeof(idTxt));
+      snprintf(left, sizeof(left), "%s%s %u..%u %s", snfBusTag(c.bus), idTxt, (unsigned)c.fromBit, (unsigned)c.toBit,
+               (c.order==CanField::ORDER_BE) ? "BE" : "LE");
+      snprintf(right, sizeof(right), "r%.3f x%.4g", c.r, c.scale);
+    }
+    snprintf(key, sizeof(key), "%c%s|%s", (i == snf_discSel) ? '>' : ' ', left, right);
+    if(strcmp(key, snf_discRowCache[i]) == 0) continue;
+    snprintf(snf_discRowCache[i], sizeof(snf_discRowCache[i]), "%s", key);
+    if(i > 0 && i > snf_discCount){
+      clearRegion(8, MENU_TOP + i*MENU_ROW_H - 20, 304, 26, COL_BG());
+      continue;
+    }
+    redrawMenuRowAtLogical(i, left, right, i == snf_discSel);
+  }
+}
+
+// Cycle the reference channel; each change starts a fresh session
+static void snfDiscoverCycleRef(){
+  wrapInc(snf_discRefIdx, SNF_DISC_REF_COUNT);
+  if(snf_discRefIdx==0) SignalDiscovery::stop();
+  else SignalDiscovery::start((uint8_t)SNF_DISC_REFS[snf_discRefIdx-1]);
+  snf_discSel = 0;
+}
+
+// Load a ranked candidate into the detail editor
+static void snfDiscoverApply(const SignalDiscovery::Candidate& c){
+  snf_bus = c.bus;
+  snf_id = c.id;
+  snf_bit_from = c.fromBit;
+  snf_bit_to = c.toBit;
+  snf_order = c.order;
+  snf_scale = c.scale;
+  snf_bias = c.offset;
+  snf_has = false;
+}
+
+// ---- CAN Sniffer: save current field as a user gauge ----
+static uint8_t snf_saveSel = 0;
+
+static void drawSniffSaveRows(){
+  const int perPage = MENU_PER_PAGE();
+  int top = (snf_saveSel >= perPage) ? (snf_saveSel - perPage + 1) : 0;
+  for(int i=0;i<perPage;i++){
+    uint8_t slot = (uint8_t)(top + i);
+    if(slot >= USER_CHANNEL_COUNT){ clearRegion(8, MENU_TOP + i*MENU_ROW_H - 20, 304, 26, COL_BG()); continue; }
+    const UserChannelDef& u = persist.userChannels[slot];
+    char left[24], right[28];
+    snprintf(left, sizeof(left), "%u: %s", (unsigned)(slot + 1), u.label[0] ? u.label : "(unnamed)");
+    if(u.enabled){
+      char idTxt[12]; snfFormatId(u.canId, idTxt, sizeof(idTxt));
+      snprintf(right, sizeof(right), "%s %u..%u %s", idTxt, (unsigned)u.fromBit, (unsigned)u.toBit,
+               (u.order==CanField::ORDER_BE) ? "BE" : "LE");
+    } else {
+      strcpy(right, "free");
+    }
+    redrawMenuRowAtLogical(i, left, right, slot == snf_saveSel);
+  }
+}
+
+// Store the detail-view field into a user channel; label/unit/range are kept if already set
+static void snfSaveToUserChannel(uint8_t slot){
+  UserChannelDef& u = persist.userChannels[slot];
+  u.canId = snf_id;
+  u.bus = snf_bus;
+  u.fromBit = snf_bit_from;
+  u.toBit = snf_bit_to;
+  u.order = snf_order;
+  u.scale = snf_scale;
+  u.bias = snf_bias;
+  u.enabled = 1;
+  if(!u.label[0]){
+    char idTxt[12]; snfFormatId(snf_id, idTxt, sizeof(idTxt));
+    snprintf(u.label, sizeof(u.label), "%s", idTxt);
+    // Default range: the full raw span of the field after scaling
+    uint8_t width = (uint8_t)min(snf_bit_to - snf_bit_from + 1, 32);
+    float rawMax = (width >= 32) ? 4294967295.0f : (float)((1ull << width) - 1);
+    float a = snf_bias, b = rawMax * snf_scale + snf_bias;
+    u.rangeMin = min(a, b); u.rangeMax = max(a, b);
+  }
+  sanitizeUserChannels();
+  UserCh::configure(persist.userChannels, USER_CHANNEL_COUNT);
+  applyBodyAccept();   // takes effect when the sniffer closes
+  Channels::rebuild();
+  sanitizeFilters();   // the new range may be too wide for the channel's filter
+  Filters::configure(persist.filters, CH__COUNT);
+  dirty = true;
+}
+
+static void drawSniffViewTitle(){
+  char ttl[40];
+  switch(snf_view){
+    case SNF_VIEW_CENSUS_RATE:
+      snprintf(ttl, sizeof(ttl), "Census: %u IDs by rate", (unsigned)CanCensus::count()); break;
+    case SNF_VIEW_CENSUS_RECENT:
+      snprintf(ttl, sizeof(ttl), "Census: %u IDs by change", (unsigned)CanCensus::count()); break;
+    case SNF_VIEW_HEATMAP: {
+      char idTxt[12]; snfFormatId(snf_id, idTxt, sizeof(idTxt));
+      snprintf(ttl, sizeof(ttl), "Heatmap %s%s", snfBusTag(snf_bus), idTxt);
+    } break;
+    case SNF_VIEW_DISCOVER:
+      snprintf(ttl, sizeof(ttl), "Discover: %u IDs", (unsigned)SignalDiscovery::watchedIds()); break;
+    case SNF_VIEW_SAVE:
+      snprintf(ttl, sizeof(ttl), "Save as user gauge"); break;
+    default:
+      snprintf(ttl, sizeof(ttl), "System > CAN Sniff %s", snfBusTag(snf_bus)); break;
+  }
+  fullScreenMenuFrame(ttl);
+}
+
+// Draw the current sniffer view (frame + content)
+static void showSniffView(){
+  drawSniffViewTitle();
+  if(snf_view == SNF_VIEW_DETAIL){
+    for(uint8_t r=0;r<SNF_ROWS;r++) drawSniffRow(r, r==snf_sel, false);
+    drawSniffLive();
+  } else if(snf_view == SNF_VIEW_HEATMAP){
+    drawSniffHeatmap(true);
+  } else if(snf_view == SNF_VIEW_DISCOVER){
+    drawSniffDiscover(true);
+  } else if(snf_view == SNF_VIEW_SAVE){
+    drawSniffSaveRows();
+  } else {
+    drawSniffCensus(true);
+  }
 }
 
 // Build whole page
 void showCanSniff(bool full){
   if(full){
-    fullScreenMenuFrame("System > CAN Sniff");
     snf_sel = 0; snf_editing = false;
+    snf_view = SNF_VIEW_DETAIL;
   }
-  for(uint8_t r=0;r<5;r++) drawSniffRow(r, r==snf_sel, false);
-  drawSniffLive();
+  showSniffView();
 }
-// Record frames that match the selected ID and refresh live view if on page
-void snifferMaybeCapture(const can_frame& f){
-  // Standard 11-bit only. If using extended frames, adapt this check
-  // according to your MCP2515 lib’s EFF flag handling.
-  if (f.can_id != snf_id) return;
+// Record every frame in the census and latch the payload of the selected ID.
+// Runs inside the CAN drain: no drawing here, snifferUiTick() paints the result.
+void snifferMaybeCapture(const can_frame& f, uint8_t bus){
+  const unsigned long now = millis();
+  CanCensus::record(f, bus, now);
+  if(SignalDiscovery::active())
+    SignalDiscovery::record(f, bus, valueRawBase((Channel)SignalDiscovery::reference()), now);
+  if (f.can_id != snf_id || bus != snf_bus) return;
 
   snf_dlc = min<uint8_t>(f.can_dlc, 8);
   for(uint8_t i=0;i<snf_dlc;i++) snf_data[i] = f.data[i];
   snf_has = true;
-
-  if(menuState == MENU_CAN_SNIFF){
-    drawSniffLive();
+  snf_liveDirty = true;
+}
+
+// Throttled sniffer repaint, called once per loop() after the CAN drain
+void snifferUiTick(unsigned long now){
+  CanCensus::tick(now);
+  if(menuState != MENU_CAN_SNIFF) return;
+  static unsigned long lastMs = 0;
+  switch(snf_view){
+    case SNF_VIEW_DETAIL:
+      if(snf_liveDirty && now - lastMs >= SNF_LIVE_MS){
+        snf_liveDirty = false; lastMs = now;
+        drawSniffLive();
+      }
+      break;
+    case SNF_VIEW_HEATMAP:
+      if(now - lastMs >= SNF_HEATMAP_MS){ lastMs = now; drawSniffHeatmap(false); }
+      break;
+    case SNF_VIEW_DISCOVER:
+      if(now - lastMs >= SNF_DISCOVER_MS){ lastMs = now; drawSniffDiscover(false); }
+      break;
+    default:
+      if(now - lastMs >= SNF_CENSUS_MS){ lastMs = now; drawSniffCensus(false); }
+      break;
   }
 }
 
@@ -2728,16 +3277,13 @@ void redrawForDimmingChange(){
       showLayoutSlots(true);
       break;
     case MENU_LAYOUT_PICK_GAUGE: {
-      uint8_t current = pickingBarSlot()
-        ? persist.barChannel[layoutScreenSel]
-        : persist.pillChannel[layoutScreenSel][slotFromRowCol(layoutRow, layoutCol)];
-      showLayoutGaugePicker(current, true);
+      showLayoutGaugePicker(true);
     } break;
     case MENU_WARN_LIST:
       showWarnList(true);
       break;
     case MENU_WARN_EDIT:
-      showWarnFieldEditor(warnChFromIdx(warnListSel), true);
+      showWarnFieldEditor(warnListChannel(), true);
       break;
     case MENU_COLOURS:
       showColoursPage(true);
@@ -2761,9 +3307,7 @@ void redrawForDimmingChange(){
       showWifiMenu(true);
       break;
     case MENU_CAN_SNIFF:
-      fullScreenMenuFrame("System > CAN Sniff");
-      for(uint8_t r=0;r<5;r++) drawSniffRow(r, r==snf_sel, false);
-      drawSniffLive();
+      showSniffView();
       break;
     case MENU_FACTORY_RESET_CONFIRM:
       showFactoryResetConfirm(true);
@@ -2777,6 +3321,9 @@ void redrawForDimmingChange(){
     case MENU_OBD2_ACTION:
       showObd2Action(true);
       break;
+    case MENU_REGEN:
+      showRegenPage(true);
+      break;
     default:
       break;
   }
@@ -2784,9 +3331,7 @@ void redrawForDimmingChange(){
 
 // ===================== Buttons handler and nav =====================
 void handleButton(Btn b){
-#if DEBUG_BUTTONS
-  logButtonEvent("handle", b);
-#endif
+  Trace::log(Trace::TR_BTN_HANDLE, b, menuState);
   switch(menuState){
 
     case MENU_ROOT:{
@@ -2796,14 +3341,15 @@ void handleButton(Btn b){
       else if(b==BTN_ENTER){
         g_lastRootIndex = menuIndex;
         if(menuIndex==0){ menuState=MENU_LAYOUT; layoutScreenSel=persist.currentScreen; showLayoutScreenPick(true); }
-        else if(menuIndex==1){ menuState=MENU_WARN_LIST; warnListTop=0; warnListSel=0; showWarnList(true); }
+        else if(menuIndex==1){ menuState=MENU_WARN_LIST; openWarnList(); showWarnList(true); }
         else if (menuIndex == 2) {
           menuState = MENU_COLOURS;
-          enterColoursPage();        // <-- init coloursSel/coloursTop (centers on current)
+          MenuList::focus(coloursList, paletteIndex);   // open on the active palette
            showColoursPage(true);     // full draw of the scrolling window
           }
         else if(menuIndex==3){ menuState=MENU_OBD2; obd2Sel=0; showObd2Menu(true); }
-        else if(menuIndex==4){ menuState=MENU_SYSTEM; menuIndex=0; showSystemMenu(true); }
+        else if(menuIndex==4){ menuState=MENU_REGEN; regenTop=0; showRegenPage(true); }
+        else if(menuIndex==5){ menuState=MENU_SYSTEM; menuIndex=0; showSystemMenu(true); }
       } else if(b==BTN_CANCEL){ navExitSettings(); }
     } break;
 
@@ -2811,67 +3357,50 @@ void handleButton(Btn b){
       uint8_t prev = layoutScreenSel;
       if(b==BTN_UP){ wrapDec(layoutScreenSel,(uint8_t)(SCREEN_COUNT - 1)); updateLayoutScreenSel(prev,layoutScreenSel); }
       else if(b==BTN_DOWN){ wrapInc(layoutScreenSel,(uint8_t)(SCREEN_COUNT - 1)); updateLayoutScreenSel(prev,layoutScreenSel); }
+      else if(b==BTN_LEFT || b==BTN_RIGHT){
+        ScreenLayout& l = persist.layouts[layoutScreenSel];
+        if(b==BTN_RIGHT) wrapInc(l.tpl,(uint8_t)(LT__COUNT - 1)); else wrapDec(l.tpl,(uint8_t)(LT__COUNT - 1));
+        sanitizeLayout(); dirty=true;
+        updateLayoutScreenSel(layoutScreenSel,layoutScreenSel);
+      }
       else if(b==BTN_ENTER){
-        layoutRow=0; layoutCol=0; menuState=MENU_LAYOUT_PICK_SLOT; showLayoutSlots(true);
+        layoutSlot=0; menuState=MENU_LAYOUT_PICK_SLOT; showLayoutSlots(true);
       } else if(b==BTN_CANCEL){ menuState=MENU_ROOT; menuIndex=g_lastRootIndex; showRootMenu(true); }
     } break;
 
     case MENU_LAYOUT_PICK_SLOT:{
-      uint8_t prevSlot = slotFromRowCol(layoutRow,layoutCol);
-      if(b==BTN_LEFT){ if(layoutRow>=0) layoutCol = (layoutCol==0)?1:0; updateLayoutCursor(prevSlot,slotFromRowCol(layoutRow,layoutCol)); }
-      else if(b==BTN_RIGHT){ if(layoutRow>=0) layoutCol = (layoutCol==0)?1:0; updateLayoutCursor(prevSlot,slotFromRowCol(layoutRow,layoutCol)); }
-      else if(b==BTN_UP){ if(layoutRow<0) layoutRow=1; else if(layoutRow==0) layoutRow=-1; else layoutRow=0; updateLayoutCursor(prevSlot,slotFromRowCol(layoutRow,layoutCol)); }
-      else if(b==BTN_DOWN){ if(layoutRow<0) layoutRow=0; else if(layoutRow==1) layoutRow=-1; else layoutRow=1; updateLayoutCursor(prevSlot,slotFromRowCol(layoutRow,layoutCol)); }
+      uint8_t prevSlot = layoutSlot;
+      if(b==BTN_LEFT || b==BTN_RIGHT || b==BTN_UP || b==BTN_DOWN){
+        layoutSlot = Layout::neighbour(persist.layouts[layoutScreenSel].tpl, layoutSlot, b);
+        updateLayoutCursor(prevSlot, layoutSlot);
+      }
       else if(b==BTN_ENTER){
-        uint8_t current = (layoutRow<0)? persist.barChannel[layoutScreenSel]
-                                       : persist.pillChannel[layoutScreenSel][slotFromRowCol(layoutRow,layoutCol)];
-        menuIndex2 = eligibleIndexFromChannel(current);
-        const int perPage = MENU_PER_PAGE();
-        pickerTop = (menuIndex2 / perPage) * perPage;
-        menuState = MENU_LAYOUT_PICK_GAUGE; showLayoutGaugePicker(current,true);
+        openLayoutGaugePicker();
+        menuState = MENU_LAYOUT_PICK_GAUGE; showLayoutGaugePicker(true);
       } else if(b==BTN_CANCEL){ menuState=MENU_LAYOUT; showLayoutScreenPick(true); }
     } break;
 
     case MENU_LAYOUT_PICK_GAUGE:{
-      uint8_t &tgt = (layoutRow<0)? persist.barChannel[layoutScreenSel]
-                                  : persist.pillChannel[layoutScreenSel][slotFromRowCol(layoutRow,layoutCol)];
-      int total = eligibleCount();
-      uint8_t prev = menuIndex2;
-      if(b==BTN_UP){ menuIndex2 = (menuIndex2>0)? menuIndex2-1 : (uint8_t)(total-1); updateGaugePickerSel(prev,menuIndex2,tgt); }
-      else if(b==BTN_DOWN){ menuIndex2 = (menuIndex2<(total-1))? menuIndex2+1 : 0; updateGaugePickerSel(prev,menuIndex2,tgt); }
+      if(b==BTN_UP) MenuList::step(pickerList, -1);
+      else if(b==BTN_DOWN) MenuList::step(pickerList, +1);
       else if(b==BTN_ENTER){
-        uint8_t chosen = channelFromEligibleIndex(menuIndex2);
-        tgt = chosen; dirty=true; menuState=MENU_LAYOUT_PICK_SLOT; showLayoutSlots(true);
+        if(pickerMap.count) layoutSlotChannel() = pickerMap.ch[pickerList.sel];
+        dirty=true; menuState=MENU_LAYOUT_PICK_SLOT; showLayoutSlots(true);
       } else if(b==BTN_CANCEL){ menuState=MENU_LAYOUT_PICK_SLOT; showLayoutSlots(true); }
     } break;
 
     case MENU_WARN_LIST:{
-      int total = warnEligibleCount();
-      int prevSel = warnListSel, prevTop = warnListTop;
-      const int perPage=MENU_PER_PAGE();
-      if(b==BTN_UP){
-        if(total > 0){
-          warnListSel = (warnListSel>0) ? (warnListSel-1) : (total-1);
-        }
-        if(warnListSel < warnListTop) warnListTop = warnListSel;
-        if(warnListSel >= warnListTop+perPage) warnListTop = warnListSel - perPage + 1;
-        updateWarnListSel(prevSel,warnListSel,prevTop,warnListTop);
-      } else if(b==BTN_DOWN){
-        if(total > 0){
-          warnListSel = (warnListSel < total-1) ? (warnListSel+1) : 0;
-        }
-        if(warnListSel < warnListTop) warnListTop = warnListSel;
-        if(warnListSel >= warnListTop+perPage) warnListTop = warnListSel - perPage + 1;
-        updateWarnListSel(prevSel,warnListSel,prevTop,warnListTop);
-      } else if(b==BTN_ENTER){
-        warnFieldSel=0; menuState=MENU_WARN_EDIT; showWarnFieldEditor(warnChFromIdx(warnListSel), true);
+      if(b==BTN_UP) MenuList::step(warnList, -1);
+      else if(b==BTN_DOWN) MenuList::step(warnList, +1);
+      else if(b==BTN_ENTER){
+        warnFieldSel=0; menuState=MENU_WARN_EDIT; showWarnFieldEditor(warnListChannel(), true);
       } else if(b==BTN_CANCEL){
         menuState=MENU_ROOT; menuIndex=g_lastRootIndex; showRootMenu(true);
       }
     } break;
 
     case MENU_WARN_EDIT:{
-      uint8_t ch = warnChFromIdx(warnListSel);
+      uint8_t ch = warnListChannel();
       if(!warnFieldEditing){
         if(b==BTN_UP){ wrapDec(warnFieldSel,(uint8_t)2); for(int r=0;r<3;r++) drawWarnFieldRow(r,ch, r==warnFieldSel,false,false); }
         else if(b==BTN_DOWN){ wrapInc(warnFieldSel,(uint8_t)2); for(int r=0;r<3;r++) drawWarnFieldRow(r,ch, r==warnFieldSel,false,false); }
@@ -2922,48 +3451,30 @@ void handleButton(Btn b){
     } break;
 
     case MENU_COLOURS: {
-      const int total   = paletteCount();
-      const int perPage = MENU_PER_PAGE();
-
-     int prevSel = coloursSel;
-     int prevTop = coloursTop;
-
-     if (b == BTN_UP) {
-     if (total > 0) {
-       coloursSel = (coloursSel > 0) ? (coloursSel - 1) : (total - 1);
-     }
-     if (coloursSel < coloursTop) coloursTop = coloursSel;
-     if (coloursSel >= coloursTop + perPage) coloursTop = coloursSel - perPage + 1;
-     updateColoursSel(prevSel, coloursSel, prevTop, coloursTop);
-
-     } else if (b == BTN_DOWN) {
-      if (total > 0) {
-        coloursSel = (coloursSel < total - 1) ? (coloursSel + 1) : 0;
-      }
-      if (coloursSel < coloursTop) coloursTop = coloursSel;
-      if (coloursSel >= coloursTop + perPage) coloursTop = coloursSel - perPage + 1;
-      updateColoursSel(prevSel, coloursSel, prevTop, coloursTop);
-
-   } else if (b == BTN_ENTER) {
-     if (isCustomPaletteIndex(coloursSel)) {
-       paletteIndex = coloursSel;
-       dirty = true;
-       customPaletteSel = customPaletteSlot(coloursSel);
-       customZoneSel = 0;
-       menuState = MENU_COLOURS_CUSTOM;
-       showCustomPaletteMenu(true);
-     } else {
-       paletteIndex = coloursSel;                 // apply chosen palette
-       dirty = true;
-       showColoursPage(true);                      // full redraw to reflect theme
-     }
-
-   } else if (b == BTN_CANCEL) {
-      menuState       = MENU_ROOT;
+      const int coloursSel = coloursList.sel;
+      if (b == BTN_UP) {
+        MenuList::step(coloursList, -1);
+      } else if (b == BTN_DOWN) {
+        MenuList::step(coloursList, +1);
+      } else if (b == BTN_ENTER) {
+        if (isCustomPaletteIndex(coloursSel)) {
+          paletteIndex = coloursSel;
+          dirty = true;
+          customPaletteSel = customPaletteSlot(coloursSel);
+          customZoneSel = 0;
+          menuState = MENU_COLOURS_CUSTOM;
+          showCustomPaletteMenu(true);
+        } else {
+          paletteIndex = coloursSel;                 // apply chosen palette
+          dirty = true;
+          showColoursPage(true);                      // full redraw to reflect theme
+        }
+      } else if (b == BTN_CANCEL) {
+        menuState       = MENU_ROOT;
         g_lastRootIndex = 2;
-       menuIndex       = 2;
-       showRootMenu(true);
-     }
+        menuIndex       = 2;
+        showRootMenu(true);
+      }
     } break;
 
     case MENU_COLOURS_CUSTOM: {
@@ -2971,39 +3482,24 @@ void handleButton(Btn b){
       if (b == BTN_UP) { wrapDec(customZoneSel, (uint8_t)(CUSTOM_ZONE_COUNT - 1)); updateCustomPaletteSel(prev, customZoneSel); }
       else if (b == BTN_DOWN) { wrapInc(customZoneSel, (uint8_t)(CUSTOM_ZONE_COUNT - 1)); updateCustomPaletteSel(prev, customZoneSel); }
       else if (b == BTN_ENTER) {
-        enterCustomColourPicker();
+        MenuList::focus(customColourList, customColourIndexForValue(customZoneValue(persist.customPalettes[customPaletteSel], customZoneSel)));
         menuState = MENU_COLOURS_CUSTOM_PICK;
         showCustomColourPicker(true);
       } else if (b == BTN_CANCEL) {
         menuState = MENU_COLOURS;
-        setColoursSelection(paletteIndex);
+        MenuList::focus(coloursList, paletteIndex);
         showColoursPage(true);
       }
     } break;
 
     case MENU_COLOURS_CUSTOM_PICK: {
-      const int total   = customColourCount();
-      const int perPage = MENU_PER_PAGE();
-      int prevSel = customColourSel;
-      int prevTop = customColourTop;
-
       if (b == BTN_UP) {
-        if (total > 0) {
-          customColourSel = (customColourSel > 0) ? (customColourSel - 1) : (total - 1);
-        }
-        if (customColourSel < customColourTop) customColourTop = customColourSel;
-        if (customColourSel >= customColourTop + perPage) customColourTop = customColourSel - perPage + 1;
-        updateCustomColourSel(prevSel, customColourSel, prevTop, customColourTop);
+        MenuList::step(customColourList, -1);
       } else if (b == BTN_DOWN) {
-        if (total > 0) {
-          customColourSel = (customColourSel < total - 1) ? (customColourSel + 1) : 0;
-        }
-        if (customColourSel < customColourTop) customColourTop = customColourSel;
-        if (customColourSel >= customColourTop + perPage) customColourTop = customColourSel - perPage + 1;
-        updateCustomColourSel(prevSel, customColourSel, prevTop, customColourTop);
+        MenuList::step(customColourList, +1);
       } else if (b == BTN_ENTER) {
         CustomPalette& palette = persist.customPalettes[customPaletteSel];
-        setCustomZoneValue(palette, customZoneSel, CUSTOM_COLOUR_OPTIONS[customColourSel].value);
+        setCustomZoneValue(palette, customZoneSel, CUSTOM_COLOUR_OPTIONS[customColourList.sel].value);
         dirty = true;
         menuState = MENU_COLOURS_CUSTOM;
         showCustomPaletteMenu(true);
@@ -3047,6 +3543,14 @@ void handleButton(Btn b){
       }
     } break;
 
+    case MENU_REGEN:{
+      const uint8_t n = Regen::log().count;
+      const uint8_t maxTop = (n > REGEN_LIST_ROWS) ? (uint8_t)(n - REGEN_LIST_ROWS) : 0;
+      if(b==BTN_UP && regenTop > 0){ regenTop--; drawRegenHistory(); }
+      else if(b==BTN_DOWN && regenTop < maxTop){ regenTop++; drawRegenHistory(); }
+      else if(b==BTN_CANCEL){ menuState=MENU_ROOT; menuIndex=g_lastRootIndex; showRootMenu(true); }
+    } break;
+
     case MENU_OBD2_ACTION:{
       if(b==BTN_CANCEL){
         obd2Awaiting = false;
@@ -3132,9 +3636,59 @@ void handleButton(Btn b){
     } break;
 
    case MENU_CAN_SNIFF:{
-   if(!snf_editing){
-    if(b==BTN_UP){ uint8_t prev=snf_sel; wrapDec(snf_sel,(uint8_t)4); drawSniffRow(prev,false,false); drawSniffRow(snf_sel,true,false); }
-    else if(b==BTN_DOWN){ uint8_t prev=snf_sel; wrapInc(snf_sel,(uint8_t)4); drawSniffRow(prev,false,false); drawSniffRow(snf_sel,true,false); }
+   if(!snf_editing && (b==BTN_LEFT || b==BTN_RIGHT)){
+    if(b==BTN_RIGHT) wrapInc(snf_view,(uint8_t)(SNF_VIEW_COUNT-1));
+    else             wrapDec(snf_view,(uint8_t)(SNF_VIEW_COUNT-1));
+    showSniffView();
+   } else if(snf_view == SNF_VIEW_CENSUS_RATE || snf_view == SNF_VIEW_CENSUS_RECENT){
+    if(b==BTN_UP){ snfCensusMove(-1); drawSniffCensus(false); }
+    else if(b==BTN_DOWN){ snfCensusMove(+1); drawSniffCensus(false); }
+    else if(b==BTN_ENTER){
+      // Adopt the highlighted ID and inspect its bits
+      if(snf_censusSelId != 0xFFFFFFFF){
+        snf_id = snf_censusSelId;
+        snf_bus = snf_censusSelBus;
+        const CanCensus::Entry* e = CanCensus::find(snf_id, snf_bus);
+        snf_has = (e != nullptr);
+        if(e){ snf_dlc = e->dlc; memcpy(snf_data, e->data, sizeof(snf_data)); }
+        snf_view = SNF_VIEW_HEATMAP;
+        showSniffView();
+      }
+    } else if(b==BTN_CANCEL){ snf_view = SNF_VIEW_DETAIL; showSniffView(); }
+   } else if(snf_view == SNF_VIEW_HEATMAP){
+    if(b==BTN_UP || b==BTN_DOWN){
+      // Step through IDs in rate order
+      snf_view = SNF_VIEW_CENSUS_RATE;
+      snf_censusSelId = snf_id;
+      snf_censusSelBus = snf_bus;
+      snfCensusMove(b==BTN_UP ? -1 : +1);
+      snf_view = SNF_VIEW_HEATMAP;
+      if(snf_censusSelId != 0xFFFFFFFF){ snf_id = snf_censusSelId; snf_bus = snf_censusSelBus; }
+      snf_has = false;
+      showSniffView();
+    } else if(b==BTN_ENTER || b==BTN_CANCEL){ snf_view = SNF_VIEW_DETAIL; showSniffView(); }
+   } else if(snf_view == SNF_VIEW_DISCOVER){
+    if(b==BTN_UP){ snf_discSel = (snf_discSel>0) ? snf_discSel-1 : snf_discCount; drawSniffDiscover(false); }
+    else if(b==BTN_DOWN){ snf_discSel = (snf_discSel<snf_discCount) ? snf_discSel+1 : 0; drawSniffDiscover(false); }
+    else if(b==BTN_ENTER){
+      if(snf_discSel==0){ snfDiscoverCycleRef(); showSniffView(); }
+      else { snfDiscoverApply(snf_discTop[snf_discSel-1]); snf_view = SNF_VIEW_DETAIL; showSniffView(); }
+    } else if(b==BTN_CANCEL){ snf_view = SNF_VIEW_DETAIL; showSniffView(); }
+   } else if(snf_view == SNF_VIEW_SAVE){
+    if(b==BTN_UP){ wrapDec(snf_saveSel,(uint8_t)(USER_CHANNEL_COUNT-1)); drawSniffSaveRows(); }
+    else if(b==BTN_DOWN){ wrapInc(snf_saveSel,(uint8_t)(USER_CHANNEL_COUNT-1)); drawSniffSaveRows(); }
+    else if(b==BTN_ENTER){
+      if(snf_bit_from <= snf_bit_to){ snfSaveToUserChannel(snf_saveSel); drawSniffSaveRows(); }
+    } else if(b==BTN_CANCEL){ snf_view = SNF_VIEW_DETAIL; showSniffView(); }
+   } else if(!snf_editing){
+    if(b==BTN_UP){ uint8_t prev=snf_sel; wrapDec(snf_sel,(uint8_t)(SNF_ROWS-1)); drawSniffRow(prev,false,false); drawSniffRow(snf_sel,true,false); }
+    else if(b==BTN_DOWN){ uint8_t prev=snf_sel; wrapInc(snf_sel,(uint8_t)(SNF_ROWS-1)); drawSniffRow(prev,false,false); drawSniffRow(snf_sel,true,false); }
+    else if(b==BTN_ENTER && snf_sel==5){
+      // Byte order is a toggle, no edit mode
+      snf_order = (snf_order==CanField::ORDER_LE) ? CanField::ORDER_BE : CanField::ORDER_LE;
+      drawSniffRow(5, true, false);
+      drawSniffLive();
+    }
     else if(b==BTN_ENTER){
       snf_editing = true;
       drawSniffRow(snf_sel, true, false);
@@ -3146,20 +3700,31 @@ void handleButton(Btn b){
       // Address hex editor per nibble
       if(b==BTN_LEFT){
         if(snf_cursor>0) snf_cursor--;
+        else {
+          // Past the first digit: toggle 11-bit / 29-bit, keeping the low bits
+          snf_id = (snf_id & CAN_EFF_FLAG) ? (snf_id & CAN_SFF_MASK) : (snf_id | CAN_EFF_FLAG);
+          snf_has=false;
+          drawSniffLive();
+        }
         drawSniffRow(0, true, false);
       } else if(b==BTN_RIGHT){
-        if(snf_cursor+1 < SNF_HEX_DIGITS) snf_cursor++;
+        if(snf_cursor+1 < snfHexDigits()) snf_cursor++;
         drawSniffRow(0, true, false);
       } else if(b==BTN_UP || b==BTN_DOWN){
+        const uint8_t digits = snfHexDigits();
+        if(snf_cursor >= digits) snf_cursor = digits - 1;   // the ID changed format since the last edit
+        const uint32_t flag = snf_id & CAN_EFF_FLAG;
+        const uint32_t idMask = flag ? CAN_EFF_MASK : CAN_SFF_MASK;
         uint8_t posFromMSB = snf_cursor;
-        int8_t  bitShift   = (SNF_HEX_DIGITS-1 - posFromMSB) * 4;
+        int8_t  bitShift   = (digits-1 - posFromMSB) * 4;
         uint32_t mask      = (uint32_t)0xF << bitShift;
-        uint8_t oldNib     = (snf_id >> bitShift) & 0xF;
+        // The top digit holds the ID's last 1 (29-bit) or 3 (11-bit) bits and wraps within them
+        const int8_t nibMax = (int8_t)min<uint32_t>(idMask >> bitShift, 0xF);
+        uint8_t oldNib     = ((snf_id & idMask) >> bitShift) & 0xF;
         int8_t newNib      = oldNib + ((b==BTN_UP)? +1 : -1);
-        if(newNib < 0) newNib = 15;
-        if(newNib > 15) newNib = 0;
-        snf_id = (snf_id & ~mask) | ((uint32_t)newNib << bitShift);
-        if(snf_id > 0x7FF) snf_id = 0x7FF; // keep standard 11-bit
+        if(newNib < 0) newNib = nibMax;
+        if(newNib > nibMax) newNib = 0;
+        snf_id = (snf_id & idMask & ~mask) | ((uint32_t)newNib << bitShift) | flag;
         snf_has=false; // force wait until next match
         drawSniffRow(0, true, false);
         drawSniffLive();
@@ -3249,146 +3814,147 @@ void handleButton(Btn b){
   }
 }
 
-// Buttons from CAN + Double-tap Cancel + Press-hold to enter settings
-void updateButtonsFromFrame(const can_frame& f){
+// Steering-wheel buttons, CAN side: decode ID_SWBTN into press/release events and nothing else.
+// An edge that does not fit in the queue stays pending and is posted again with the next frame.
+void postButtonsFromFrame(const can_frame& f, unsigned long rxMs){
   if(f.can_id!=CFG::ID_SWBTN) return;
 
-  // Press states
-  bool cancel_now=bitSetSafe(f,6,4);
-  up_now   = bitSetSafe(f,6,2);
-  down_now = bitSetSafe(f,6,0);
-  bool left = bitSetSafe(f,7,4), right=bitSetSafe(f,7,2), enter=bitSetSafe(f,7,6);
-
-#if DEBUG_BUTTONS
-  if(cancel_now != sw_cancel_prev || up_now != sw_up_prev || down_now != sw_down_prev || left != sw_left_prev
-     || right != sw_right_prev || enter != sw_enter_prev){
-    logButtonFrame(f, cancel_now, up_now, down_now, left, right, enter);
+  // Posting order = dispatch order within one frame (cancel first, as before)
+  static const Btn kOrder[] = { BTN_CANCEL, BTN_UP, BTN_DOWN, BTN_LEFT, BTN_RIGHT, BTN_ENTER };
+  const bool now[] = {
+    bitSetSafe(f,6,4), bitSetSafe(f,6,2), bitSetSafe(f,6,0),
+    bitSetSafe(f,7,4), bitSetSafe(f,7,2), bitSetSafe(f,7,6)
+  };
+  static uint8_t postedMask = 0;   // button states as the UI will see them
+  for(uint8_t i=0;i<6;i++){
+    const uint8_t bit = 1u << i;
+    if(now[i] == ((postedMask & bit) != 0)) continue;
+    const InputQueue::Event e{ static_cast<uint32_t>(rxMs), now[i] ? InputQueue::EV_PRESS : InputQueue::EV_RELEASE, kOrder[i] };
+    if(InputQueue::post(e)) postedMask ^= bit;
   }
-#endif
+}
 
+// Time-driven gestures (cancel hold, enter hold, tap windows), evaluated at time t.
+// Runs before each event with the event's timestamp, then once with the loop clock.
+static void buttonTimers(unsigned long t){
   // Press & hold (2s) enter Settings WHILE holding (main UI only)
   if(!inSettings()){
-    if(cancel_now && !sw_cancel_pressed){ sw_cancel_pressed=true; sw_cancel_t0=millis(); }
-    if(cancel_now && sw_cancel_pressed){
-      if(millis()-sw_cancel_t0 >= 2000){
-        sw_cancel_pressed=false;
-#if DEBUG_BUTTONS
-        Serial.println("[BTN] cancel hold -> toggle settings");
-#endif
-        navEnterSettings();
-        cancelTapCount=0;
-        return;
-      }
+    if(sw_cancel_pressed && t - sw_cancel_t0 >= 2000){
+      sw_cancel_pressed=false;
+      Trace::log(Trace::TR_BTN_SETTINGS);
+      navEnterSettings();
+      cancelTapCount=0;
     }
   } else {
     sw_cancel_pressed = false;
   }
 
-  // Cancel actions on rising edge
-  if(cancel_now && !sw_cancel_prev){
-    if(inSettings()){
-#if DEBUG_BUTTONS
-      Serial.println("[BTN] cancel press in settings");
-#endif
-      handleButton(BTN_CANCEL); // Back via Cancel inside menus
-    } else {
-      // Double-tap (live UI) triggers on rising edge
-      unsigned long now = millis();
-      if (cancelTapCount == 0) {
-        cancelTapCount = 1;
-        lastCancelTapMs = now;
-      } else if (now - lastCancelTapMs <= DOUBLE_TAP_MS) {
-#if DEBUG_BUTTONS
-        Serial.println("[BTN] cancel double-tap -> next screen");
-#endif
-        persist.currentScreen = (persist.currentScreen + 1) % SCREEN_COUNT;       //  No. of screen in rotation
-        dirty = true;
-
-        // Redraw chrome
-        tft.fillScreen(COL_BG());
-        drawAppBar();
-
-        updateRegenState();
-        renderStatic();
-        renderDynamic();
+  // Expire single tap window
+  if(cancelTapCount==1 && (t - lastCancelTapMs > DOUBLE_TAP_MS)) cancelTapCount = 0;
 
-        cancelTapCount = 0;
-      } else {
-        cancelTapCount = 1;
-        lastCancelTapMs = now;
-      }
+  // Enter hold for min/max display (main UI only)
+  if(menuState == UI_MAIN){
+    if(sw_enter_pressed && !uiMinMaxActive && (t - sw_enter_t0 >= ENTER_HOLD_MS)){
+      setMinMaxActive(true);
+      Trace::log(Trace::TR_BTN_MINMAX_ON);
+      enterTapCount = 0;
+      suppressNextEnterRelease = true;
     }
+    if(enterTapCount > 0 && (t - lastEnterTapMs > ENTER_TAP_MS)) enterTapCount = 0;
   }
+}
 
-  if(!cancel_now && sw_cancel_pressed){
-    sw_cancel_pressed=false;
+static void onCancelPress(unsigned long t){
+  if(inSettings()){
+    handleButton(BTN_CANCEL); // Back via Cancel inside menus
+    return;
   }
+  sw_cancel_pressed=true; sw_cancel_t0=t;
+  // Double-tap (live UI) triggers on the second press
+  if (cancelTapCount == 0) {
+    cancelTapCount = 1;
+    lastCancelTapMs = t;
+  } else if (t - lastCancelTapMs <= DOUBLE_TAP_MS) {
+    persist.currentScreen = (persist.currentScreen + 1) % SCREEN_COUNT;       //  No. of screen in rotation
+    Trace::log(Trace::TR_BTN_NEXT_SCREEN, 0, persist.currentScreen);
+    dirty = true;
+
+    // Redraw chrome
+    tft.fillScreen(COL_BG());
+    drawAppBar();
+
+    updateRegenState();
+    renderStatic();
+    renderDynamic();
 
-  // Expire single tap window
-  if(cancelTapCount==1 && (millis() - lastCancelTapMs > DOUBLE_TAP_MS)) cancelTapCount = 0;
+    cancelTapCount = 0;
+  } else {
+    cancelTapCount = 1;
+    lastCancelTapMs = t;
+  }
+}
 
-  // Enter hold for min/max display (main UI only)
-  if(menuState == UI_MAIN){
-    if(enter && !sw_enter_pressed){
-      sw_enter_pressed = true;
-      sw_enter_t0 = millis();
-    }
-    if(enter && sw_enter_pressed){
-      if(!uiMinMaxActive && (millis() - sw_enter_t0 >= ENTER_HOLD_MS)){
-        setMinMaxActive(true);
-#if DEBUG_BUTTONS
-        Serial.println("[BTN] enter hold -> min/max on");
-#endif
-        enterTapCount = 0;
-        suppressNextEnterRelease = true;
-      }
+static void onEnterRelease(unsigned long t){
+  if(menuState != UI_MAIN || !sw_enter_pressed) return;
+  sw_enter_pressed = false;
+  if(uiMinMaxActive){
+    setMinMaxActive(false);
+    Trace::log(Trace::TR_BTN_MINMAX_OFF);
+    suppressNextEnterRelease = true;
+  }
+  if(suppressNextEnterRelease){
+    suppressNextEnterRelease = false;
+  } else if(enterTapCount == 0){
+    enterTapCount = 1;
+    lastEnterTapMs = t;
+  } else if(t - lastEnterTapMs <= ENTER_TAP_MS){
+    enterTapCount++;
+    lastEnterTapMs = t;
+    if(enterTapCount >= 3){
+      Trace::log(Trace::TR_BTN_MINMAX_RESET);
+      resetMinMaxValues();
+      enterTapCount = 0;
     }
-    if(!enter && sw_enter_pressed){
-      sw_enter_pressed = false;
-      if(uiMinMaxActive){
-        setMinMaxActive(false);
-#if DEBUG_BUTTONS
-        Serial.println("[BTN] enter release -> min/max off");
-#endif
-        suppressNextEnterRelease = true;
-      }
-      if(suppressNextEnterRelease){
-        suppressNextEnterRelease = false;
-      } else {
-        unsigned long now = millis();
-        if(enterTapCount == 0){
-          enterTapCount = 1;
-          lastEnterTapMs = now;
-        } else if(now - lastEnterTapMs <= ENTER_TAP_MS){
-          enterTapCount++;
-          lastEnterTapMs = now;
-          if(enterTapCount >= 3){
-#if DEBUG_BUTTONS
-            Serial.println("[BTN] enter triple-tap -> reset min/max");
-#endif
-            resetMinMaxValues();
-            enterTapCount = 0;
-          }
+  } else {
+    enterTapCount = 1;
+    lastEnterTapMs = t;
+  }
+}
+
+// Steering-wheel buttons, UI side: called once per loop() after the CAN drain
+void serviceButtonEvents(unsigned long now){
+  InputQueue::Event e;
+  const uint32_t listKeys = MenuList::stats().keys;
+  while(InputQueue::pop(e, now)){
+    buttonTimers(e.tMs);
+    Trace::log(e.kind == InputQueue::EV_PRESS ? Trace::TR_BTN_PRESS : Trace::TR_BTN_RELEASE, e.btn, menuState);
+    const bool down = (e.kind == InputQueue::EV_PRESS);
+    switch(e.btn){
+      case BTN_CANCEL:
+        if(down) onCancelPress(e.tMs);
+        else sw_cancel_pressed = false;
+        break;
+      case BTN_UP:
+      case BTN_DOWN:
+        (e.btn == BTN_UP ? up_now : down_now) = down;
+        if(down){ holdPressMs = e.tMs; handleButton(e.btn); }
+        break;
+      case BTN_ENTER:
+        if(down){
+          if(menuState == UI_MAIN){ sw_enter_pressed = true; sw_enter_t0 = e.tMs; }
+          handleButton(BTN_ENTER);
         } else {
-          enterTapCount = 1;
-          lastEnterTapMs = now;
+          onEnterRelease(e.tMs);
         }
-      }
+        break;
+      default:
+        if(down) handleButton(e.btn);
+        break;
     }
-
-    if(enterTapCount > 0 && (millis() - lastEnterTapMs > ENTER_TAP_MS)) enterTapCount = 0;
   }
-
-  // Edge-triggered dispatch
-  if(up_now && !sw_up_prev) handleButton(BTN_UP);
-  if(down_now && !sw_down_prev) handleButton(BTN_DOWN);
-  if(left && !sw_left_prev) handleButton(BTN_LEFT);
-  if(right && !sw_right_prev) handleButton(BTN_RIGHT);
-  if(enter && !sw_enter_prev) handleButton(BTN_ENTER);
-  sw_up_prev=up_now; sw_down_prev=down_now; sw_left_prev=left; sw_right_prev=right; sw_enter_prev=enter;
-#if DEBUG_BUTTONS
-  sw_cancel_prev = cancel_now;
-#endif
+  buttonTimers(now);
+  const MenuList::Stats& ms = MenuList::stats();
+  if(ms.keys != listKeys) Trace::log(Trace::TR_MENU_KEY, ms.lastKeyRows, ms.maxKeyRows);
 }
 
 // ===================== Regen banner =====================
@@ -3437,98 +4003,438 @@ inline void triggerClusterBeep(){
   out.can_id  = CFG::ID_CLUSTER_BEEP;
   out.can_dlc = CFG::CLUSTER_BEEP_DLC;
   for(uint8_t i=0;i<out.can_dlc && i<8;i++) out.data[i] = CFG::CLUSTER_BEEP_PAYLOAD[i];
-  mcp.sendMessage(&out);
+  CanTx::send(out, CanTx::PRIO_HIGH, TX_TAG_BEEP);
+}
+
+// Once per loop: trace the CAN, J1939 and input-queue trouble counters when they move
+static void traceCounters(unsigned long now){
+  if(now - lastCanOverflowReportMs >= kCanOverflowReportIntervalMs){
+    for(uint8_t b=0;b<CanBus::MAX_BUSES;b++){
+      if(!CanBus::present(b)) continue;
+      const CanBus::Stats& cs = CanBus::stats(b);
+      if(cs.overflows == g_canOverflowReported[b]) continue;
+      Trace::log(Trace::TR_CAN_OVERFLOW, b | (cs.lastEflg << 8), cs.overflows);
+      g_canOverflowReported[b] = cs.overflows;
+      lastCanOverflowReportMs = now;
+    }
+  }
+  const J1939::Stats& js = J1939::stats();
+  // Same order as the TR_J1939_TP_* events
+  const uint32_t tp[5] = {js.tpAborted, js.tpTimeouts, js.tpOrphan, js.tpTooLong, js.tpBadSeq};
+  for(uint8_t i=0;i<5;i++){
+    if(tp[i] == g_j1939TpReported[i]) continue;
+    Trace::log(static_cast<Trace::Event>(Trace::TR_J1939_TP_ABORT + i), 0, tp[i]);
+    g_j1939TpReported[i] = tp[i];
+  }
+  const CanTx::Stats& tx = CanTx::stats();
+  if(tx.retries + tx.full != g_canTxTroubleReported && now - lastCanTxReportMs >= kCanOverflowReportIntervalMs){
+    Trace::log(Trace::TR_CANTX_TROUBLE, tx.full > 0xFFFF ? 0xFFFF : tx.full, tx.retries);
+    g_canTxTroubleReported = tx.retries + tx.full;
+    lastCanTxReportMs = now;
+  }
+  const InputQueue::Stats& iq = InputQueue::stats();
+  if(iq.overflows != g_inputOverflowsReported){
+    Trace::log(Trace::TR_BTN_QUEUE_FULL, iq.maxDepth, iq.overflows);
+    g_inputOverflowsReported = iq.overflows;
+  }
 }
 
-// ===================== Setup / Loop =====================
-void setup(){
-#if DEBUG_BUTTONS
-  Serial.begin(115200);
-  unsigned long serialStart = millis();
-  while(!Serial && (millis() - serialStart < 2000)){
-    delay(10);
+// Once per loop: move queued frames into the TX buffers and act on their results
+static void serviceCanTx(unsigned long now){
+  CanTx::service(now);
+  CanTx::Event ev;
+  while(CanTx::pollEvent(ev)){
+    if(ev.kind != CanTx::EV_FAILED) continue;
+    if(ev.tag == TX_TAG_OBD2 && obd2Awaiting) obd2SendFailed();
+    Trace::log(Trace::TR_CANTX_FAILED, ev.attempts | (ev.ctrl << 8), ev.id);
+  }
+}
+
+// Copy the live settings into persist and save (batched unless forced)
+static void saveSettings(bool force){
+  persist.paletteIndex=paletteIndex;
+  persist.brightOn=brightOn; persist.brightOff=brightOff;
+  persist.uPressure=g_uPressure; persist.uTemp=g_uTemp; persist.uSpeed=g_uSpeed; persist.uLambda=g_uLambda;
+  persist.speedTrimPct = speedTrimPct;
+  savePersist(persist, dirty, force);
+}
+
+// ===================== Boot =====================
+// setup() only does what the first live frame needs: persist, CAN, then the static layer.
+// Widgets arrive through the normal scheduler frames, the backlight fades in once they are
+// all drawn, and the rest runs from loop() one task per iteration.
+struct BootMark { const char* stage; uint32_t ms; };
+static BootMark g_bootMarks[12];
+static uint8_t g_bootMarkCount = 0;
+static uint8_t g_bootTask = 0;
+
+// Timeline entry: millis() since reset at the end of a stage
+static void bootMark(const char* stage){
+  if(g_bootMarkCount < sizeof(g_bootMarks)/sizeof(g_bootMarks[0])) g_bootMarks[g_bootMarkCount++] = { stage, static_cast<uint32_t>(millis()) };
+}
+
+static void bootVictron(){ if(!victronInitAsync()) victronInit(); }
+
+struct BootTask { const char* stage; void (*run)(); };
+static const BootTask kBootTasks[] = {
+  { "wifi defaults",    ensureWifiDefaults },
+  { "victron defaults", ensureVictronDefaults },
+  { "ble task",         bootVictron },
+};
+constexpr uint8_t BOOT_TASK_COUNT = sizeof(kBootTasks)/sizeof(kBootTasks[0]);
+
+static inline bool bootDone(){ return g_bootLit && g_bootTask >= BOOT_TASK_COUNT; }
+
+void serviceBoot(){
+  if(!g_bootLit){
+    // First complete frame (or any menu, should one open first): light the screen
+    if(menuState == UI_MAIN && g_uiFramePending) return;
+    bootMark("first frame");
+    Backlight::fadeTo(uiBrightnessPct(), BL_BOOT_FADE_MS);
+    g_bootLit = true;
+    return;
   }
-  Serial.println("[BTN] Serial button debugging enabled");
+  if(g_bootTask < BOOT_TASK_COUNT){
+    kBootTasks[g_bootTask].run();
+    bootMark(kBootTasks[g_bootTask].stage);
+    if(++g_bootTask < BOOT_TASK_COUNT) return;
+#if DEBUG_BOOT
+    Serial.print("[BOOT]");
+    uint32_t prev = 0;
+    for(uint8_t i=0;i<g_bootMarkCount;i++){
+      Serial.print(' ');
+      Serial.print(g_bootMarks[i].stage);
+      Serial.print('=');
+      Serial.print(g_bootMarks[i].ms);
+      Serial.print("ms(+");
+      Serial.print(g_bootMarks[i].ms - prev);
+      Serial.print(')');
+      prev = g_bootMarks[i].ms;
+    }
+    Serial.println();
 #endif
+  }
+}
+
+// ===================== Power (parked sleep) =====================
+static bool g_canAsleep = false;
+static bool g_parked = false;        // PA_PARK applied; PA_RESUME undoes it
+static bool g_resumeLight = false;   // resumed, waiting for a complete frame before lighting
+
+// Parked: only the frames that mean ignition-on reach the RX buffers and pull CAN_INT low
+static const uint32_t kIgnitionIds[] = { CFG::ID_SPEED, CFG::ID_RPM_SPEED,
+                                         J1939::makeId(3, J1939::PGN_EEC1, 0x00) };   // engine #1
+static_assert(CanBus::acceptFits(CFG::CAN2_ACCEPT, sizeof(CFG::CAN2_ACCEPT) / sizeof(CFG::CAN2_ACCEPT[0])),
+              "CFG::CAN2_ACCEPT does not fit the MCP2515 filters (6 IDs; 2 standard + 4 extended when mixed)");
+
+// The library never sets WAKIE, so the wake-up interrupt goes through McpRegs
+static void canSleep(){
+  McpRegs::bitModify(CFG::CAN_CS, McpRegs::CANINTF, McpRegs::WAKIF, 0);
+  McpRegs::bitModify(CFG::CAN_CS, McpRegs::CANINTE, McpRegs::WAKIF, McpRegs::WAKIF);
+  mcp.setSleepMode();
+  g_canAsleep = true;
+}
+
+// Bus activity wakes the controller into listen-only mode with WAKIF holding CAN_INT low.
+// The frame that woke it is lost; the next ignition frame follows within one period.
+static void canWake(){
+  McpRegs::bitModify(CFG::CAN_CS, McpRegs::CANINTE, McpRegs::WAKIF, 0);
+  McpRegs::bitModify(CFG::CAN_CS, McpRegs::CANINTF, McpRegs::WAKIF, 0);
+  mcp.setNormalMode();
+  g_canAsleep = false;
+}
+
+#if DEBUG_POWER
+static void reportPower(){
+  const Power::Stats& ps = Power::stats();
+  Serial.print("[POWER]");
+  for(uint8_t i=0;i<Power::PS__COUNT;i++){
+    Serial.print(' ');
+    Serial.print(Power::stateName((Power::State)i));
+    Serial.print('=');
+    Serial.print(ps.stateMs[i] / 1000);
+    Serial.print("s/");
+    Serial.print(Power::awakePct((Power::State)i));
+    Serial.print('%');
+  }
+  Serial.print(" parks=");
+  Serial.print(ps.parks);
+  Serial.print(" canWakes=");
+  Serial.print(ps.canWakes);
+  Serial.print(" false=");
+  Serial.print(ps.falseWakes);
+  Serial.print(" timer=");
+  Serial.print(ps.timerWakes);
+  Serial.print(" rejects=");
+  Serial.print(ps.rejects);
+  Serial.print(" resume ms=");
+  Serial.print(ps.lastResumeMs);
+  Serial.print(" max=");
+  Serial.println(ps.maxResumeMs);
+}
+#endif
+
+// Acts on the power manager's decision. True while parked: loop() then stops after the CAN
+// drain, the Victron poll and the trip update.
+static bool servicePower(unsigned long now){
+  const bool hold = !bootDone() || g_wifiActive || themeFadeActive();
+  const Power::Action action = Power::update(now, hold);
+  switch(action){
+    case Power::PA_DIM:
+      Backlight::fadeTo(0, Power::PARK_DIM_MS);
+      break;
+    case Power::PA_PARK:
+      HeapMon::exemptPass();   // BLE scan start/stop allocates in the host stack
+      if(dirty) saveSettings(true);   // the supply may go before ignition comes back
+      victronSuspend(true);
+      g_victronReadings = victronLoop();
+      CanBus::setIrq(CFG::CAN_BUS_PT, false);   // CAN_INT becomes the level wake source
+      CanBus::setFilters(CFG::CAN_BUS_PT, kIgnitionIds, sizeof(kIgnitionIds) / sizeof(kIgnitionIds[0]));
+      if(CanBus::present(CFG::CAN_BUS_BODY)){   // ignition is read from the powertrain bus only
+        CanBus::setIrq(CFG::CAN_BUS_BODY, false);
+        mcp2.setSleepMode();
+      }
+      tft.sendCommand(ILI9341_SLPIN);   // GRAM is kept; only the panel drive stops
+      g_parked = true;
+      break;
+    case Power::PA_SLEEP:
+      if(!g_canAsleep && Power::controllerMaySleep(now)) canSleep();
+      if(Power::sleep(now) == Power::WAKE_CAN && g_canAsleep) canWake();
+      lastLoopUs = 0;   // the sleep is not a loop stall
+      break;
+    case Power::PA_MONITOR_START:
+      HeapMon::exemptPass();
+      if(g_canAsleep) canWake();   // the scan keeps the CPU up; take frames while it does
+      victronSuspend(false);       // the next Victron poll starts the scan
+      break;
+    case Power::PA_MONITOR_END:
+      HeapMon::exemptPass();
+      victronSuspend(true);
+      g_victronReadings = victronLoop();
+      break;
+    case Power::PA_RESUME:
+      HeapMon::exemptPass();
+      if(g_canAsleep) canWake();
+      if(g_parked){
+        for(uint8_t b=0;b<CanBus::MAX_BUSES;b++){
+          CanBus::restoreFilters(b);   // also takes the body controller out of sleep
+          CanBus::setIrq(b, true);
+        }
+        g_canFiltersOpen = false;   // the next pass opens them again for the sniffer or bridge
+        tft.sendCommand(ILI9341_SLPOUT);
+        delay(5);   // SLPOUT needs 5 ms before the next command
+        victronSuspend(false);
+        g_parked = false;
+      }
+      if(menuState == UI_MAIN){
+        renderStatic();   // values moved while dark; widgets come back through the scheduler
+        g_uiFramePending = true;
+      }
+      g_resumeLight = true;
+      break;
+    default:
+      break;
+  }
+  if(g_resumeLight && !(menuState == UI_MAIN && g_uiFramePending)){
+    Backlight::fadeTo(uiBrightnessPct(), BL_BOOT_FADE_MS);
+    Power::resumed(now);
+    g_resumeLight = false;
+#if DEBUG_POWER
+    reportPower();
+#endif
+  }
+  const bool parked = Power::state() >= Power::PS_PARKED;
+  if(parked && action == Power::PA_NONE) delay(Power::PARKED_IDLE_MS);
+  return parked;
+}
+
+// ===================== Setup / Loop =====================
+// Every frame the controllers hold, through the decoders. loop() starts with it and runs it again
+// after the radio and web stage; the render scheduler runs it before each widget
+// (setRenderService). The MCP2515 holds two frames, which at 500 kbit/s is 240-480 us, while a
+// frame's drawing budget is 8 ms. Events it posts are handled by the next pass.
+static void drainCan(){
+  struct can_frame f;
+  uint8_t bus;
+  while(CanBus::read(f, bus)){
+    const uint32_t rxUs = micros();
+    const unsigned long rxMs = millis();
+    CanDec::decodeFrame(f, bus);
+    UserCh::decodeFrame(f, bus);
+    Power::noteFrame(f.can_id, bus, rxMs);
+    if(bus == CFG::CAN_BUS_PT){
+      Trip::onFrame(f, rxUs);
+      obd2MaybeCapture(f);   // requests go out on the powertrain controller
+    }
+    if(bus == CanDec::bodyBus()) postButtonsFromFrame(f, rxMs);
+    snifferMaybeCapture(f, bus);
+    Gvret::capture(f, bus, rxUs);
+  }
+}
+
+void setup(){
+  Serial.begin(115200);   // no wait for a host: early lines are simply lost
+  Trace::begin(Trace::TC_TRACE | (DEBUG_CAN ? uint32_t(Trace::TC_CAN) : 0u)
+               | (DEBUG_BUTTONS ? uint32_t(Trace::TC_BUTTONS | Trace::TC_MENU) : 0u)
+               | (DEBUG_HEAP ? uint32_t(Trace::TC_HEAP) : 0u));
+  bootMark("start");
   loadPersistState();
   resetMinMaxValues();
-  g_lastBacklightPct = 255;
+  bootMark("persist");
 
   // Ensure CS lines idle high before SPI
   pinMode(CFG::TFT_CS,OUTPUT); digitalWrite(CFG::TFT_CS,HIGH);
   pinMode(CFG::CAN_CS,OUTPUT); digitalWrite(CFG::CAN_CS,HIGH);
-  pinMode(CFG::BACKLIGHT_PWM, OUTPUT);
-  analogWrite(CFG::BACKLIGHT_PWM, 0);
+  if(CFG::CAN2_ENABLED){ pinMode(CFG::CAN_CS2,OUTPUT); digitalWrite(CFG::CAN_CS2,HIGH); }
+  Backlight::begin(CFG::BACKLIGHT_PWM);   // dark until the first live frame is drawn
 
   SPI.begin(CFG::SPI_SCK,CFG::SPI_MISO,CFG::SPI_MOSI); SPI.setFrequency(TFT_SPI_HZ);
 
-  // --- TFT boot & first paint ---
+  // --- CAN first: the controller buffers while the screen is set up ---
+  CanBus::begin(CFG::CAN_BUS_PT, mcp, { CFG::CAN_CS, CFG::CAN_INT, CFG::CAN_SPEED_SEL, CFG::CAN_CLOCK_SEL, nullptr, 0 });
+  if(CFG::CAN2_ENABLED
+     && CanBus::begin(CFG::CAN_BUS_BODY, mcp2, { CFG::CAN_CS2, CFG::CAN_INT2, CFG::CAN2_SPEED_SEL, CFG::CAN2_CLOCK_SEL,
+                                                 g_bodyAccept, buildBodyAccept() })){
+    CanDec::setBodyBus(CFG::CAN_BUS_BODY);
+  }
+#if BUS_SIM
+  BusSim::install({ { CanBus::bitsPerSecond(CFG::CAN_SPEED_SEL), CFG::CAN2_ENABLED ? CanBus::bitsPerSecond(CFG::CAN2_SPEED_SEL) : 0 },
+                    BusSim::FAULT_MISSING | BusSim::FAULT_SHORT_DLC | BusSim::FAULT_BURST });
+#endif
+  J1939::begin();
+  Power::begin(CFG::CAN_INT);
+  CanTx::begin(mcp, CFG::CAN_CS);
+  CanTx::setRateLimit(OBD2_FUNCTIONAL_ID, OBD2_TX_MIN_MS);
+  bootMark("can");
+
+  // --- TFT: static layer only; widgets come from the scheduler in loop() ---
   tft.begin(); tft.setRotation(1);
   initUi(tft, nullptr);
+  setRenderService(drainCan);
+  MenuList::begin(menuListDrawRow, menuListClearRow);
   tft.fillScreen(COL_BG());
   drawAppBar();
   renderStatic();
-  renderDynamic();
-
-  // After first frame is ready, apply backlight PWM
-  brightOn  = max<uint8_t>(brightOn,  MIN_BRIGHT);
-  brightOff = max<uint8_t>(brightOff, MIN_BRIGHT);
-  fadeInBacklight();
-
-  // --- CAN init ---
-  pinMode(CFG::CAN_INT,INPUT_PULLUP); mcp.reset(); mcp.setBitrate(CFG::CAN_SPEED_SEL,CFG::CAN_CLOCK_SEL);
-  mcp.setFilterMask(MCP2515::MASK0,false,0x000); mcp.setFilterMask(MCP2515::MASK1,false,0x000);
-  mcp.setFilter(MCP2515::RXF0,false,0x000); mcp.setFilter(MCP2515::RXF1,false,0x000); mcp.setFilter(MCP2515::RXF2,false,0x000);
-  mcp.setFilter(MCP2515::RXF3,false,0x000); mcp.setFilter(MCP2515::RXF4,false,0x000); mcp.setFilter(MCP2515::RXF5,false,0x000);
-  mcp.setNormalMode(); attachInterrupt(digitalPinToInterrupt(CFG::CAN_INT), onCanInt, FALLING);
+  g_uiFramePending = true;
+  bootMark("static layer");
 
-  // --- BLE scan for Victron Instant Readout ---
-  victronInit();
-
-  unsigned long now=millis(); lastMillis=lastDraw=now;
+  unsigned long now=millis(); lastMillis=now;
+  lastFrameUs = micros() - CFG::SCREEN_REFRESH_US;   // first scheduler frame on the first loop
+  HeapMon::begin();
 }
 
 void loop(){
   unsigned long now=millis();
-  if(can_irq){
-    can_irq=false;
-  }
-  struct can_frame f;
-  while(mcp.readMessage(&f)==MCP2515::ERROR_OK){
-    CanDec::decodeFrame(f);
-    updateButtonsFromFrame(f);
-    snifferMaybeCapture(f);
-    obd2MaybeCapture(f);
-  }
-#if DEBUG_CAN
-  uint8_t eflg = mcp.getErrorFlags();
-  if(eflg & (EFLG_RX0OVR | EFLG_RX1OVR)){
-    g_canOverflowCount++;
-    mcp.clearRXnOVR();
-  }
-  if(g_canOverflowCount != g_canOverflowReported
-     && now - lastCanOverflowReportMs >= kCanOverflowReportIntervalMs){
-    Serial.print("[CAN] RX overflow count=");
-    Serial.print(g_canOverflowCount);
-    Serial.print(" eflg=0x");
-    Serial.println(eflg, HEX);
-    g_canOverflowReported = g_canOverflowCount;
-    lastCanOverflowReportMs = now;
+  HeapMon::tick(now);
+  if(g_wifiPageActive) HeapMon::exemptPass();   // AP, web server and GVRET sockets allocate
+  const uint32_t loopUs = micros();
+  if(lastLoopUs){
+    const uint32_t gap = loopUs - lastLoopUs;
+    if(gap > loopMaxGapUs) loopMaxGapUs = gap;
+    if(themeFadeActive() && gap > fadeLoopMaxGapUs) fadeLoopMaxGapUs = gap;
+  }
+  lastLoopUs = loopUs;
+  drainCan();
+  now = millis();   // UI stage clock; never older than an event posted by the drain
+  serviceCanTx(now);
+  serviceButtonEvents(now);
+  Derived::update();
+  Channels::sync();   // cheap compare; rebuilds the unit table only after a unit/trim change
+  Filters::update(now);   // after sync: filter stats use the current display keys
+  snifferUiTick(now);
+  traceCounters(now);
+#if DEBUG_RENDER
+  if(now - lastRenderReportMs >= kRenderReportIntervalMs){
+    const ArcGauge::Stats& st = ArcGauge::stats();
+    if(st.updates){
+      Serial.print("[RENDER] needle updates=");
+      Serial.print(st.updates);
+      Serial.print(" px/update=");
+      Serial.print(st.pixelsWritten / st.updates);
+      Serial.print(" naive px/update=");
+      Serial.println(st.naivePixels / st.updates);
+    }
+    ArcGauge::resetStats();
+    Serial.print("[FILTER] display changes/s raw=");
+    Serial.print(Filters::stats().rawKeyChangesPerSec);
+    Serial.print(" filtered=");
+    Serial.println(Filters::stats().keyChangesPerSec);
+    const RenderStats& rs = renderStats();
+    Serial.print("[RENDER] fps=");
+    Serial.print(rs.fps);
+    Serial.print(" ticks/s=");
+    Serial.print(rs.ticksPerSec);
+    Serial.print(" widgets/frame=");
+    Serial.print(rs.fps ? (float)rs.widgetsPerSec / rs.fps : 0.0f, 1);
+    Serial.print(" max=");
+    Serial.print(rs.maxWidgetsPerFrame);
+    Serial.print(" maxFrameUs=");
+    Serial.print(rs.maxFrameUs);
+    Serial.print(" overruns=");
+    Serial.print(rs.overruns);
+    Serial.print(" deferred=");
+    Serial.println(rs.deferred);
+    Serial.print("[LOOP] max stall us=");
+    Serial.print(loopMaxGapUs);
+    Serial.print(" during backlight fades=");
+    Serial.println(fadeLoopMaxGapUs);
+    loopMaxGapUs = 0;
+    lastRenderReportMs = now;
   }
 #endif
 
   if(now - lastVictronPollMs >= kVictronPollIntervalMs){
+    victronSetCoex(radioCoexMode(now));
     g_victronReadings = victronLoop();
     lastVictronPollMs = now;
   }
+#if DEBUG_RADIO
+  if(g_wifiActive && now - lastRadioReportMs >= kRadioReportIntervalMs){
+    const VictronScanStats& vs = victronScanStats();
+    Serial.print("[RADIO] coex=");
+    Serial.print(vs.coex);
+    Serial.print(" scan=");
+    Serial.print(vs.windowMs);
+    Serial.print('/');
+    Serial.print(vs.intervalMs);
+    Serial.print(" adverts/s=");
+    Serial.print(vs.advertsPerSec);
+    Serial.print(" switches=");
+    Serial.print(vs.dutySwitches);
+    Serial.print(" http n=");
+    Serial.print(g_webStats.requests);
+    Serial.print(" last us=");
+    Serial.print(g_webStats.lastUs);
+    Serial.print(" max us=");
+    Serial.println(g_webStats.maxUs);
+    lastRadioReportMs = now;
+  }
+#endif
   if(g_webServerActive){
     webServer.handleClient();
   }
+  Gvret::service(now);
+  drainCan();   // the radio and web stage can outlast two frame times on its own
 
-  // Regen banner update
-  RegenState old = regenState; updateRegenState();
-  if(old!=regenState && !inSettings() && !uiMinMaxActive)
-    renderDynamic();
+  // Regen banner update (the render scheduler picks up the state change)
+  updateRegenState();
+  if(Regen::update(regenState, now)) dirty = true;
+  switch(Trip::update(now)){
+    case Trip::SAVE_BATCH: dirty = true; break;
+    case Trip::SAVE_NOW: dirty = true; savePersist(persist, dirty, true); break;   // engine off: commit before power goes
+    default: break;
+  }
+  if(servicePower(now)) return;
+  serviceCanFilters();
+  if(menuState == MENU_REGEN){
+    static unsigned long regenPageMs = 0;
+    static uint16_t regenPageTotal = 0;
+    if(now - regenPageMs >= 1000){
+      regenPageMs = now;
+      drawRegenSummary(false);
+      if(Regen::log().total != regenPageTotal){ regenPageTotal = Regen::log().total; drawRegenHistory(); }
+    }
+  }
 
   updateMinMaxValues();
   if(menuState == MENU_OBD2_ACTION){
@@ -3540,15 +4446,18 @@ void loop(){
   }
 
   if(menuState==UI_MAIN){
-    // blink tick for warning overlays/title
+    // blink tick for warning overlays; the next frame redraws only the warned pills
     if(now - uiWarnBlinkMs >= 500){
       uiWarnBlinkMs = now; uiWarnBlinkOn = !uiWarnBlinkOn;
-      renderDynamic(); // flip overlays/title immediately
-      lastDraw = now;
     }
-    // regular dynamic refresh
-    if(now-lastDraw>=CFG::SCREEN_REFRESH_MS){ renderDynamic(); lastDraw=now; }
+    // change-driven frame: only dirty widgets, within the budget
+    const uint32_t nowUs = micros();
+    if(g_themeFade != TF_CLEAR && nowUs - lastFrameUs >= CFG::SCREEN_REFRESH_US){
+      lastFrameUs = nowUs;
+      g_uiFramePending = renderFrame(CFG::RENDER_BUDGET_US);
+    }
   }
+  if(!bootDone()) serviceBoot();
 
   // ===== Units page blink while editing =====
   if(menuState==MENU_UNITS && unitsEditing){
@@ -3569,7 +4478,7 @@ void loop(){
   }
 // ===== PATCH: Warning editor: blink & hold-to-repeat with decade acceleration =====
 if (menuState == MENU_WARN_EDIT) {
-  uint8_t ch = warnChFromIdx(warnListSel);
+  uint8_t ch = warnListChannel();
 
   // Blink the active field while editing
   if (warnFieldEditing) {
@@ -3589,8 +4498,8 @@ if (menuState == MENU_WARN_EDIT) {
     // Start a new repeat session
     if (pressed && !repeating) {
       repeating      = true;
-      repeatStartMs  = now;
-      lastRepeatMs   = now;
+      repeatStartMs  = holdPressMs;
+      lastRepeatMs   = holdPressMs;
       holdDir        = pressedUp ? HOLD_UP : HOLD_DOWN;
       holdLevel      = 0;
       holdStep       = stepFor((Channel)ch);  // base step in DISPLAY units
@@ -3610,8 +4519,8 @@ if (menuState == MENU_WARN_EDIT) {
         holdDir       = currentDir;
         holdLevel     = 0;
         holdStep      = stepFor((Channel)ch);
-        repeatStartMs = now;
-        lastRepeatMs  = now;
+        repeatStartMs = holdPressMs;
+        lastRepeatMs  = holdPressMs;
       }
     }
     // Timed repeat ticks
@@ -3625,26 +4534,8 @@ if (menuState == MENU_WARN_EDIT) {
         // Convert staged BASE -> DISPLAY for the field being edited
         float dispT = (warnFieldSel == 1) ? editT1 : editT2;
 
-        auto baseToDisp = [&](float v)->float{
-          switch ((Channel)ch) {
-            case CH_LAMBDA: return toDisplayLambda(v);
-            case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-            case CH_EGT1: case CH_EGT2: case CH_MANIFOLD: case CH_TURBO_OUT: return toDisplayTemp(v);
-            case CH_BOOST: case CH_OIL: return toDisplayPressure(v);
-            case CH_SPEED: return toDisplaySpeed(v);
-            default: return v;
-          }
-        };
-        auto dispToBase = [&](float v)->float{
-          switch ((Channel)ch) {
-            case CH_LAMBDA: return fromDisplayLambda(v);
-            case CH_COOLANT: case CH_TRANS1: case CH_TRANS2: case CH_IAT: case CH_FUELT:
-            case CH_EGT1: case CH_EGT2: case CH_MANIFOLD: case CH_TURBO_OUT: return fromDisplayTemp(v);
-            case CH_BOOST: case CH_OIL: return fromDisplayPressure(v);
-            case CH_SPEED: return fromDisplaySpeed(v);
-            default: return v;
-          }
-        };
+        auto baseToDisp = [&](float v)->float{ return Channels::toDisplay((Channel)ch, v); };
+        auto dispToBase = [&](float v)->float{ return Channels::fromDisplay((Channel)ch, v); };
 
         float curDisp  = baseToDisp(dispT);
         float stepDisp = holdStep * ((holdDir == HOLD_UP) ? +1.0f : -1.0f);
@@ -3689,7 +4580,7 @@ if(menuState==MENU_SPEED_TRIM){
     bool pressed = pressedUp || pressedDown;
 
     if(pressed && !repeating){
-      repeating=true; repeatStartMs=now; lastRepeatMs=now;
+      repeating=true; repeatStartMs=holdPressMs; lastRepeatMs=holdPressMs;
       holdDir = pressedUp ? HOLD_UP : HOLD_DOWN;
       holdLevel = 0;
       holdStep = SPEED_TRIM_STEP;   // base step in percentage points
@@ -3700,7 +4591,7 @@ if(menuState==MENU_SPEED_TRIM){
     if(repeating){
       HoldDir currentDir = pressedUp ? HOLD_UP : (pressedDown ? HOLD_DOWN : HOLD_NONE);
       if(currentDir != HOLD_NONE && currentDir != holdDir){
-        holdDir = currentDir; holdLevel=0; holdStep=SPEED_TRIM_STEP; repeatStartMs=now; lastRepeatMs=now;
+        holdDir = currentDir; holdLevel=0; holdStep=SPEED_TRIM_STEP; repeatStartMs=holdPressMs; lastRepeatMs=holdPressMs;
       }
     }
     if(repeating){
@@ -3738,7 +4629,7 @@ if(menuState==MENU_SPEED_TRIM){
       bool pressed = pressedUp || pressedDown;
 
       if(pressed && !repeating){
-        repeating=true; repeatStartMs=now; lastRepeatMs=now;
+        repeating=true; repeatStartMs=holdPressMs; lastRepeatMs=holdPressMs;
         holdDir = pressedUp ? HOLD_UP : HOLD_DOWN;
         holdLevel = 0;
         holdStep  = 1.0f; // base step 1%
@@ -3749,7 +4640,7 @@ if(menuState==MENU_SPEED_TRIM){
       if(repeating){
         HoldDir currentDir = pressedUp ? HOLD_UP : (pressedDown ? HOLD_DOWN : HOLD_NONE);
         if(currentDir != HOLD_NONE && currentDir != holdDir){
-          holdDir = currentDir; holdLevel=0; holdStep=1.0f; repeatStartMs=now; lastRepeatMs=now;
+          holdDir = currentDir; holdLevel=0; holdStep=1.0f; repeatStartMs=holdPressMs; lastRepeatMs=holdPressMs;
         }
       }
       if(repeating){
@@ -3790,19 +4681,10 @@ if(menuState==MENU_SPEED_TRIM){
   }
   globalL2ActivePrev = globalL2ActiveNow;
 
-  // --- Backlight: react to headlights state changes ---
-  if (headlightsOn != prevHeadlightsOn) {
-    prevHeadlightsOn = headlightsOn;
-    applyBacklight();
-  }
+  // --- Backlight: headlight level changes and day/night cross-fade ---
+  serviceBacklight(now);
 
   // Save if dirty
-  if(dirty){
-    persist.paletteIndex=paletteIndex;
-    persist.brightOn=brightOn; persist.brightOff=brightOff;
-    persist.uPressure=g_uPressure; persist.uTemp=g_uTemp; persist.uSpeed=g_uSpeed; persist.uLambda=g_uLambda;
-    persist.speedTrimPct = speedTrimPct;
-    savePersist(persist, dirty);
-  }
+  if(dirty) saveSettings(false);
   lastMillis=now;
 }
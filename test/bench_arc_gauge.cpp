@@ -0,0 +1,89 @@
+// Dial arcs: the per-row span fill against the per-pixel atan2 walk it replaced. Drawing goes
+// to a sink that only counts runs, so the figures are the arc maths alone; the runs column is
+// the address windows each version would open on the panel.
+#include <Adafruit_GFX.h>
+#include <chrono>
+#include "ArcGauge.h"
+
+namespace {
+constexpr float START_DEG = 150.0f;
+
+class Sink : public Adafruit_GFX {
+ public:
+  Sink() : Adafruit_GFX(320, 240) {}
+  void drawPixel(int16_t, int16_t, uint16_t) override { runs++; }
+  void drawFastHLine(int16_t x, int16_t, int16_t w, uint16_t) override {
+    runs++;
+    pixels += w;
+    sum += x;
+  }
+  uint32_t runs = 0, pixels = 0, sum = 0;
+};
+
+void atan2Arc(Adafruit_GFX& g, const ArcGauge::Geometry& d, int16_t r0, int16_t r1, uint16_t s0, uint16_t s1, uint16_t col) {
+  const float a0 = START_DEG + s0 * 0.5f, a1 = START_DEG + s1 * 0.5f;
+  const int32_t rin2 = static_cast<int32_t>(r0) * r0, rout2 = static_cast<int32_t>(r1) * r1;
+  for (int dy = -r1; dy <= r1; dy++) {
+    int runStart = 0;
+    bool inRun = false;
+    for (int dx = -r1; dx <= r1 + 1; dx++) {
+      bool in = false;
+      if (dx <= r1) {
+        const int32_t q = dx * dx + dy * dy;
+        if (q >= rin2 && q <= rout2) {
+          float deg = atan2f(static_cast<float>(dy), static_cast<float>(dx)) * (180.0f / PI);
+          if (deg < 0) deg += 360.0f;
+          if (deg < START_DEG) deg += 360.0f;
+          in = (deg >= a0 && deg <= a1);
+        }
+      }
+      if (in && !inRun) { runStart = dx; inRun = true; }
+      else if (!in && inRun) {
+        g.drawFastHLine(d.cx + runStart, d.cy + dy, dx - runStart, col);
+        inRun = false;
+      }
+    }
+  }
+}
+
+struct Case {
+  const char* name;
+  int16_t w, h;
+  bool band;
+  uint16_t s0, s1;
+};
+
+template <typename F>
+double usPer(uint32_t n, F body) {
+  const auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; i++) {
+    body();
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t1 - t0).count() / n;
+}
+}  // namespace
+
+int main() {
+  const Case cases[] = {
+    {"band, 1/4 screen dial", 160, 120, true, 0, ArcGauge::SWEEP_STEPS},
+    {"band, full-height dial", 240, 240, true, 0, ArcGauge::SWEEP_STEPS},
+    {"warn zone, 1/4 screen", 160, 120, false, 380, 440},
+    {"warn zone, full-height", 240, 240, false, 380, 440},
+  };
+  printf("dial arcs, us per fillArc (host), runs = address windows\n");
+  printf("  %-24s %10s %6s %10s %6s %7s\n", "", "atan2", "runs", "span", "runs", "speedup");
+  for (const Case& c : cases) {
+    const ArcGauge::Geometry d = ArcGauge::geometryFor(0, 0, c.w, c.h);
+    const int16_t r0 = c.band ? d.bandIn : d.zoneIn, r1 = c.band ? d.r : d.bandIn - 1;
+    Sink a, b;
+    const uint32_t n = 2000;
+    const double ta = usPer(n, [&] { atan2Arc(a, d, r0, r1, c.s0, c.s1, 1); });
+    const double tb = usPer(n, [&] { ArcGauge::fillArc(b, d, r0, r1, c.s0, c.s1, 1); });
+    if (a.pixels != b.pixels) {
+      fprintf(stderr, "%s: %u vs %u pixels\n", c.name, a.pixels / n, b.pixels / n);
+    }
+    printf("  %-24s %10.2f %6u %10.2f %6u %6.1fx\n", c.name, ta, a.runs / n, tb, b.runs / n, ta / tb);
+  }
+  return 0;
+}
@@ -0,0 +1,169 @@
+// Derived channels: compiled bytecode against evaluating the expression text every time.
+// The naive evaluator below is the obvious alternative to Compiler + run(): the same grammar,
+// walked over the string on each update with names looked up through channelName(). Each
+// update() pass changes every input, so all four programs run; the "unchanged" row is the
+// steady case where update() only compares the input snapshot.
+#include <Arduino.h>
+#include <chrono>
+#include "DerivedChannels.h"
+#include "ValueConversion.h"
+
+namespace {
+float g_in[CH__COUNT];
+
+const char* const kExprs[DERIVED_CHANNEL_COUNT] = {
+  "torque * rpm / 9549",
+  "egt1 - egt2",
+  "(boost + 101.3) / 101.3 * 100",
+  "max(egt1, egt2) - min(egt1, egt2) + sqrt(abs(batt_a * battv))",
+};
+
+class Naive {
+ public:
+  explicit Naive(const char* src) : p_(src) {}
+  float run() { return expr(); }
+
+ private:
+  const char* p_;
+
+  void ws() {
+    while (*p_ == ' ') {
+      p_++;
+    }
+  }
+  float expr() {
+    float v = term();
+    for (;;) {
+      ws();
+      if (*p_ == '+') { p_++; v += term(); }
+      else if (*p_ == '-') { p_++; v -= term(); }
+      else return v;
+    }
+  }
+  float term() {
+    float v = unary();
+    for (;;) {
+      ws();
+      if (*p_ == '*') { p_++; v *= unary(); }
+      else if (*p_ == '/') { p_++; const float d = unary(); v = d != 0.0f ? v / d : NAN; }
+      else return v;
+    }
+  }
+  float unary() {
+    ws();
+    if (*p_ == '-') { p_++; return -unary(); }
+    return primary();
+  }
+  float primary() {
+    ws();
+    if (*p_ == '(') { p_++; const float v = expr(); ws(); p_++; return v; }
+    if (isdigit(static_cast<unsigned char>(*p_)) || *p_ == '.') {
+      char* end;
+      const float v = strtof(p_, &end);
+      p_ = end;
+      return v;
+    }
+    char name[16];
+    uint8_t n = 0;
+    while ((isalnum(static_cast<unsigned char>(*p_)) || *p_ == '_') && n < sizeof(name) - 1) {
+      name[n++] = *p_++;
+    }
+    name[n] = '\0';
+    ws();
+    if (*p_ == '(') {
+      p_++;
+      const float a = expr();
+      ws();
+      float b = 0;
+      if (*p_ == ',') { p_++; b = expr(); ws(); }
+      p_++;
+      if (!strcmp(name, "abs")) return fabsf(a);
+      if (!strcmp(name, "sqrt")) return a >= 0 ? sqrtf(a) : NAN;
+      if (!strcmp(name, "min")) return fminf(a, b);
+      return fmaxf(a, b);
+    }
+    for (uint8_t c = 0; c < CH__COUNT; c++) {
+      const char* cn = Derived::channelName(static_cast<Channel>(c));
+      if (cn && !strcmp(cn, name)) {
+        return valueRawBase(static_cast<Channel>(c));
+      }
+    }
+    return NAN;
+  }
+};
+
+void perturb(uint32_t i) {
+  const float k = static_cast<float>(i & 1023);
+  g_in[CH_RPM] = 1500 + k;
+  g_in[CH_TORQUE] = 250 + k * 0.1f;
+  g_in[CH_EGT1] = 500 + k * 0.2f;
+  g_in[CH_EGT2] = 520 + k * 0.1f;
+  g_in[CH_BOOST] = 80 + k * 0.05f;
+  g_in[CH_BATT_CURR] = 10 + k * 0.01f;
+  g_in[CH_BATTV] = 13.5f;
+}
+
+template <typename F>
+double nsPer(uint32_t n, F body) {
+  const auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; i++) {
+    body(i);
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+}
+
+volatile float g_sink;
+}  // namespace
+
+float valueRawBase(Channel ch) { return ch < CH__COUNT ? g_in[ch] : NAN; }
+
+int main() {
+  constexpr uint32_t PASSES = 400000;
+  DerivedChannelDef defs[DERIVED_CHANNEL_COUNT] = {};
+  for (uint8_t i = 0; i < DERIVED_CHANNEL_COUNT; i++) {
+    defs[i].enabled = 1;
+    strncpy(defs[i].expr, kExprs[i], DERIVED_EXPR_LEN);
+  }
+  Derived::configure(defs, DERIVED_CHANNEL_COUNT);
+
+  // Same answers both ways before timing anything
+  perturb(7);
+  Derived::update();
+  for (uint8_t i = 0; i < DERIVED_CHANNEL_COUNT; i++) {
+    const float a = Derived::value(i), b = Naive(kExprs[i]).run();
+    if (fabsf(a - b) > 1e-3f * fmaxf(1.0f, fabsf(b))) {
+      fprintf(stderr, "mismatch on '%s': %g vs %g\n", kExprs[i], a, b);
+      return 1;
+    }
+  }
+
+  const double naive = nsPer(PASSES, [](uint32_t i) {
+    perturb(i);
+    for (const char* e : kExprs) {
+      g_sink = Naive(e).run();
+    }
+  });
+  const double compiled = nsPer(PASSES, [](uint32_t i) {
+    perturb(i);
+    Derived::update();
+    g_sink = Derived::value(0);
+  });
+  const double unchanged = nsPer(PASSES, [](uint32_t) {
+    Derived::update();
+    g_sink = Derived::value(0);
+  });
+  const double base = nsPer(PASSES, [](uint32_t i) {
+    perturb(i);
+    g_sink = g_in[CH_RPM];
+  });
+
+  printf("derived channels, %u expressions, ns per update pass (host, input update excluded)\n", DERIVED_CHANNEL_COUNT);
+  printf("  naive text walk   %8.1f\n", naive - base);
+  printf("  bytecode          %8.1f  (%.1fx)\n", compiled - base, (naive - base) / (compiled - base));
+  printf("  unchanged inputs  %8.1f\n", unchanged);
+  for (uint8_t i = 0; i < DERIVED_CHANNEL_COUNT; i++) {
+    printf("  %-62s %2u bytes of code\n", kExprs[i], Derived::codeSize(i));
+  }
+  return 0;
+}
@@ -0,0 +1,228 @@
+// Render cost of the whole sketch on the host display: setup() and loop() as they are, the
+// synthetic vehicle from BusSim on the buses, and the ILI9341 mock counting address windows,
+// pixels and SPI bytes at TFT_SPI_HZ. The mock moves the clock by the bus time it counts, so the
+// render budget and the frame scheduler see real frame lengths; the rest of a pass is PASS_US.
+// A pass that drew anything is a frame. Each scenario runs SCENARIO_MS after a settle that is
+// not counted, and its load comes in the way the car would bring it: steering buttons on 0x402
+// and headlights on 0x401 rewritten in the frames BusSim delivers, warning thresholds in persist.
+// Output is one [BENCH] line per scenario for tools/render_bench_diff.py, the windows split by
+// shape, and a PNG of the last frame of each scenario in build/render/ (or the directory given).
+#include <sys/stat.h>
+#include "Xiao_Dash_V1_211.ino"
+
+namespace {
+constexpr uint32_t SCENARIO_MS = 15000;
+constexpr uint32_t SETTLE_MS = 3000;
+constexpr uint32_t BOOT_MS = 5000;
+constexpr uint32_t PASS_US = 150;   // drain, decoders and bookkeeping around the drawing
+
+enum Scenario : uint8_t { SC_STEADY, SC_WARN_STORM, SC_SCREEN_SWITCH, SC_PALETTE, SC_MENU, SC__COUNT };
+const char* const kNames[SC__COUNT] = {"steady", "warn-storm", "screen-switch", "palette", "menu"};
+
+enum Shape : uint8_t { SH_PIXEL, SH_HLINE, SH_VLINE, SH_RECT, SH__COUNT };
+
+struct Stats {
+  uint32_t frames;
+  uint32_t windows;
+  uint64_t pixels;
+  uint64_t bytes;
+  uint32_t maxPixels;
+  uint32_t maxWindows;
+  uint32_t maxSpiUs;
+  uint32_t shapes[SH__COUNT];
+};
+
+// What the car is doing, written into the body frames on their way to CanBus
+bool g_headlights = false;
+uint8_t g_buttons6 = 0, g_buttons7 = 0;   // bytes 6 and 7 of 0x402
+constexpr uint8_t BTN6_CANCEL = 1 << 4, BTN6_DOWN = 1 << 0;
+constexpr uint8_t BTN6_MASK = (1 << 4) | (1 << 2) | (1 << 0), BTN7_MASK = (1 << 4) | (1 << 2) | (1 << 6);
+
+bool benchRead(uint8_t bus, can_frame& f) {
+  if (!BusSim::read(bus, f)) {
+    return false;
+  }
+  if (f.can_id == CFG::ID_HEADLIGHTS && f.can_dlc >= 2) {
+    f.data[1] = (f.data[1] & ~0x50) | (g_headlights ? 0x50 : 0);
+  } else if (f.can_id == CFG::ID_SWBTN && f.can_dlc >= 8) {
+    f.data[6] = (f.data[6] & ~BTN6_MASK) | g_buttons6;
+    f.data[7] = (f.data[7] & ~BTN7_MASK) | g_buttons7;
+  }
+  return true;
+}
+
+// ---- per-scenario load ----
+
+uint8_t g_savedWarnMode[PERSIST_CH_CAPACITY];
+float g_savedWarnT1[PERSIST_CH_CAPACITY], g_savedWarnT2[PERSIST_CH_CAPACITY];
+uint8_t g_savedNightPalette = 0, g_savedScreen = 0;
+
+// Every warn-eligible channel past its L1 threshold, or past both
+void setStorm(uint8_t level) {
+  for (uint8_t i = 0; i < CH__COUNT; i++) {
+    const Channel ch = static_cast<Channel>(i);
+    if (!isWarnEligible(ch)) continue;
+    persist.warnMode[ch] = CFG::WARN_HIGH;
+    persist.warnT1[ch] = -1e9f;
+    persist.warnT2[ch] = level == 2 ? -1e9f : 1e9f;
+  }
+}
+
+void begin(Scenario sc) {
+  switch (sc) {
+    case SC_WARN_STORM:
+      memcpy(g_savedWarnMode, persist.warnMode, sizeof(g_savedWarnMode));
+      memcpy(g_savedWarnT1, persist.warnT1, sizeof(g_savedWarnT1));
+      memcpy(g_savedWarnT2, persist.warnT2, sizeof(g_savedWarnT2));
+      break;
+    case SC_SCREEN_SWITCH:
+      g_savedScreen = persist.currentScreen;
+      break;
+    case SC_PALETTE:
+      g_savedNightPalette = persist.nightPalette;
+      persist.nightPalette = (paletteIndex + 1) % basePaletteCount();
+      break;
+    case SC_MENU:
+      navEnterSettings();
+      break;
+    default:
+      break;
+  }
+}
+
+// The scripted input at t ms into the scenario
+void drive(Scenario sc, uint32_t t) {
+  g_buttons6 = g_buttons7 = 0;
+  switch (sc) {
+    case SC_WARN_STORM:   // L1 and L2 in turn, a second each
+      setStorm(1 + (t / 1000) % 2);
+      break;
+    case SC_SCREEN_SWITCH: {   // CANCEL double-tap once a second: down 0-100 ms and 200-300 ms
+      const uint32_t b = t % 1000;
+      if (b < 100 || (b >= 200 && b < 300)) g_buttons6 = BTN6_CANCEL;
+    } break;
+    case SC_PALETTE:   // headlights on and off every 3 s: the night palette cross-fade each way
+      g_headlights = (t / 3000) % 2;
+      break;
+    case SC_MENU:   // DOWN through the settings list, four rows a second
+      if (t % 250 < 100) g_buttons6 = BTN6_DOWN;
+      break;
+    default:
+      break;
+  }
+}
+
+void end(Scenario sc) {
+  g_buttons6 = g_buttons7 = 0;
+  switch (sc) {
+    case SC_WARN_STORM:
+      memcpy(persist.warnMode, g_savedWarnMode, sizeof(g_savedWarnMode));
+      memcpy(persist.warnT1, g_savedWarnT1, sizeof(g_savedWarnT1));
+      memcpy(persist.warnT2, g_savedWarnT2, sizeof(g_savedWarnT2));
+      break;
+    case SC_SCREEN_SWITCH:
+      if (persist.currentScreen != g_savedScreen) {
+        persist.currentScreen = g_savedScreen;
+        redrawForDimmingChange();
+      }
+      break;
+    case SC_PALETTE:
+      g_headlights = false;
+      persist.nightPalette = g_savedNightPalette;
+      break;
+    case SC_MENU:
+      if (menuState != UI_MAIN) navExitSettings();
+      break;
+    default:
+      break;
+  }
+}
+
+// ---- passes ----
+
+Shape shapeOf(const Adafruit_ILI9341::Window& w) {
+  if (w.w == 1 && w.h == 1) return SH_PIXEL;
+  if (w.h == 1) return SH_HLINE;
+  if (w.w == 1) return SH_VLINE;
+  return SH_RECT;
+}
+
+void pass(Stats* s) {
+  tft.resetCounters();
+  loop();
+  host::advanceUs(PASS_US);
+  if (!s || !tft.windows) {
+    return;
+  }
+  const uint32_t us = static_cast<uint32_t>(tft.spiUs());
+  s->frames++;
+  s->windows += tft.windows;
+  s->pixels += tft.pixels;
+  s->bytes += tft.bytes;
+  s->maxPixels = max(s->maxPixels, tft.pixels);
+  s->maxWindows = max(s->maxWindows, tft.windows);
+  s->maxSpiUs = max(s->maxSpiUs, us);
+  for (const Adafruit_ILI9341::Window& w : tft.log) {
+    s->shapes[shapeOf(w)]++;
+  }
+}
+
+void settle(uint32_t ms) {
+  const uint64_t endUs = host::nowUs() + ms * 1000ull;
+  while (host::nowUs() < endUs) {
+    pass(nullptr);
+  }
+}
+
+Stats run(Scenario sc) {
+  Stats s = {};
+  begin(sc);
+  const uint64_t startUs = host::nowUs();
+  for (uint64_t t = 0; t < SCENARIO_MS * 1000ull; t = host::nowUs() - startUs) {
+    drive(sc, static_cast<uint32_t>(t / 1000));
+    pass(&s);
+  }
+  return s;
+}
+
+uint32_t spiUs(uint64_t bytes) { return static_cast<uint32_t>(bytes * 8 * 1000000ull / tft.spiHz); }
+
+void report(Scenario sc, const Stats& s) {
+  const uint32_t n = s.frames ? s.frames : 1;
+  printf("[BENCH] %s frames=%u px/frame=%u windows/frame=%u spiUs/frame=%u max px=%u max windows=%u max spiUs=%u\n",
+         kNames[sc], s.frames, static_cast<uint32_t>(s.pixels / n), s.windows / n, spiUs(s.bytes / n), s.maxPixels,
+         s.maxWindows, s.maxSpiUs);
+  printf("  windows: %u pixels, %u hlines, %u vlines, %u rects\n", s.shapes[SH_PIXEL], s.shapes[SH_HLINE],
+         s.shapes[SH_VLINE], s.shapes[SH_RECT]);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::string dir = argc > 1 ? argv[1] : "build/render";
+  mkdir(dir.c_str(), 0755);
+  host::setMicros(1000000);
+  host::setHeap(180000, 110000);
+
+  setup();
+  tft.spiHz = TFT_SPI_HZ;
+  tft.clockBus = true;
+  tft.recordWindows = true;
+  BusSim::install({{CanBus::bitsPerSecond(CFG::CAN_SPEED_SEL), CFG::CAN2_ENABLED ? CanBus::bitsPerSecond(CFG::CAN2_SPEED_SEL) : 0}, 0});
+  CanBus::setSimSource(benchRead);
+  settle(BOOT_MS);
+
+  printf("render bench: %u s per scenario, SPI %u MHz, %u us per pass besides drawing\n", SCENARIO_MS / 1000,
+         static_cast<unsigned>(TFT_SPI_HZ / 1000000), PASS_US);
+  for (uint8_t i = 0; i < SC__COUNT; i++) {
+    const Scenario sc = static_cast<Scenario>(i);
+    const Stats s = run(sc);
+    report(sc, s);
+    const std::string png = dir + "/" + kNames[sc] + ".png";
+    if (!tft.savePng(png.c_str())) {
+      fprintf(stderr, "%s: cannot write\n", png.c_str());
+    }
+    end(sc);
+    settle(SETTLE_MS);
+  }
+  return 0;
+}
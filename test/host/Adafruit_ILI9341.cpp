@@ -0,0 +1,35 @@
+#include "Adafruit_ILI9341.h"
+
+void Adafruit_ILI9341::setRotation(uint8_t r) {
+  Adafruit_SPITFT::setRotation(r);
+  sendCommand(0x36, &r, 1);   // MADCTL
+}
+
+void Adafruit_ILI9341::setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  windows++;
+  clocked(WINDOW_BYTES);
+  if (recordWindows) {
+    log.push_back(Window{x, y, w, h});
+  }
+  openWindow(x, y, w, h);
+}
+
+void Adafruit_ILI9341::sendCommand(uint8_t cmd, const uint8_t*, uint8_t n) {
+  commands.push_back(cmd);
+  clocked(1 + n);
+}
+
+void Adafruit_ILI9341::clocked(uint32_t n) {
+  bytes += n;
+  if (clockBus) {
+    busCarry_ += n * 8ull * 1000000;
+    host::advanceUs(busCarry_ / spiHz);
+    busCarry_ %= spiHz;
+  }
+}
+
+void Adafruit_ILI9341::resetCounters() {
+  windows = pixels = bytes = 0;
+  commands.clear();
+  log.clear();
+}
@@ -0,0 +1,82 @@
+#pragma once
+// Host ILI9341: 240x320 panel on the SPITFT framebuffer. It counts what the real driver would
+// clock out (CASET/PASET/RAMWR per address window, two bytes per pixel, commands with their
+// parameters) and can keep a log of the windows for tests that look at individual primitives.
+// With clockBus set, the host clock moves by the bus time of every byte counted, so a renderer
+// that watches micros() against a budget sees its frames take as long as they would on the panel.
+#include <Adafruit_SPITFT.h>
+
+#define ILI9341_TFTWIDTH 240
+#define ILI9341_TFTHEIGHT 320
+
+#define ILI9341_SLPIN 0x10
+#define ILI9341_SLPOUT 0x11
+#define ILI9341_DISPOFF 0x28
+#define ILI9341_DISPON 0x29
+
+#define ILI9341_BLACK 0x0000
+#define ILI9341_NAVY 0x000F
+#define ILI9341_DARKGREEN 0x03E0
+#define ILI9341_DARKCYAN 0x03EF
+#define ILI9341_MAROON 0x7800
+#define ILI9341_PURPLE 0x780F
+#define ILI9341_OLIVE 0x7BE0
+#define ILI9341_LIGHTGREY 0xC618
+#define ILI9341_DARKGREY 0x7BEF
+#define ILI9341_BLUE 0x001F
+#define ILI9341_GREEN 0x07E0
+#define ILI9341_CYAN 0x07FF
+#define ILI9341_RED 0xF800
+#define ILI9341_MAGENTA 0xF81F
+#define ILI9341_YELLOW 0xFFE0
+#define ILI9341_WHITE 0xFFFF
+#define ILI9341_ORANGE 0xFD20
+#define ILI9341_GREENYELLOW 0xAFE5
+#define ILI9341_PINK 0xFC18
+
+class Adafruit_ILI9341 : public Adafruit_SPITFT {
+ public:
+  Adafruit_ILI9341(int8_t cs, int8_t dc, int8_t rst = -1) : Adafruit_SPITFT(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT) {
+    (void)cs;
+    (void)dc;
+    (void)rst;
+  }
+
+  void begin(uint32_t freq = 0) { spiHz = freq ? freq : 24000000; }
+  void setRotation(uint8_t r) override;
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override;
+  void invertDisplay(bool) override { clocked(1); }
+  void scrollTo(uint16_t) { clocked(3); }
+  void setScrollMargins(uint16_t, uint16_t) { clocked(7); }
+  void sendCommand(uint8_t cmd, const uint8_t* data = nullptr, uint8_t n = 0);
+
+  // ---- host side ----
+  struct Window {
+    uint16_t x, y, w, h;
+  };
+  static constexpr uint32_t WINDOW_BYTES = 11;   // CASET + 4, PASET + 4, RAMWR
+
+  // Bytes clocked since the last resetCounters(); pixels are the two-byte colour writes
+  uint32_t windows = 0;
+  uint32_t pixels = 0;
+  uint32_t bytes = 0;
+  std::vector<uint8_t> commands;
+  bool recordWindows = false;
+  std::vector<Window> log;
+  uint32_t spiHz = 24000000;
+  bool clockBus = false;
+
+  void resetCounters();
+  // Bus time for what was counted, at spiHz
+  double spiUs() const { return bytes * 8.0 * 1e6 / spiHz; }
+
+ protected:
+  void pushed(uint32_t n) override {
+    pixels += n;
+    clocked(2 * n);
+  }
+
+ private:
+  void clocked(uint32_t n);
+  uint64_t busCarry_ = 0;   // bit-microseconds not yet a whole microsecond at spiHz
+};
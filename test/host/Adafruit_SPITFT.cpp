@@ -0,0 +1,156 @@
+#include "Adafruit_SPITFT.h"
+
+#include <stdio.h>
+
+namespace {
+uint32_t crc32(const uint8_t* d, size_t n, uint32_t crc = 0) {
+  crc = ~crc;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= d[i];
+    for (uint8_t k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+void putBe32(std::vector<uint8_t>& out, uint32_t v) {
+  for (int s = 24; s >= 0; s -= 8) {
+    out.push_back(static_cast<uint8_t>(v >> s));
+  }
+}
+
+void chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+  putBe32(out, static_cast<uint32_t>(data.size()));
+  const size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  putBe32(out, crc32(&out[start], out.size() - start));
+}
+}  // namespace
+
+Adafruit_SPITFT::Adafruit_SPITFT(uint16_t w, uint16_t h) : Adafruit_GFX(w, h), fb_(static_cast<size_t>(w) * h) {}
+
+void Adafruit_SPITFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) {
+    return;
+  }
+  setAddrWindow(x, y, 1, 1);
+  writeColor(color, 1);
+}
+
+void Adafruit_SPITFT::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (w < 0) {
+    x += w + 1;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  int16_t x2 = x + w - 1, y2 = y + h - 1;
+  if (w == 0 || h == 0 || x >= _width || y >= _height || x2 < 0 || y2 < 0) {
+    return;
+  }
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x2 >= _width) x2 = _width - 1;
+  if (y2 >= _height) y2 = _height - 1;
+  setAddrWindow(x, y, x2 - x + 1, y2 - y + 1);
+  writeColor(color, static_cast<uint32_t>(x2 - x + 1) * (y2 - y + 1));
+}
+
+void Adafruit_SPITFT::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+void Adafruit_SPITFT::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+
+void Adafruit_SPITFT::openWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  wx_ = x;
+  wy_ = y;
+  ww_ = w;
+  wh_ = h;
+  wpos_ = 0;
+}
+
+void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
+  pushed(len);
+  for (; len > 0; len--) {
+    put(color);
+  }
+}
+
+void Adafruit_SPITFT::put(uint16_t color) {
+  if (ww_ == 0 || wpos_ >= static_cast<uint32_t>(ww_) * wh_) {
+    return;
+  }
+  const uint32_t x = wx_ + wpos_ % ww_, y = wy_ + wpos_ / ww_;
+  wpos_++;
+  if (x < static_cast<uint32_t>(_width) && y < static_cast<uint32_t>(_height)) {
+    fb_[y * _width + x] = color;
+  }
+}
+
+void Adafruit_SPITFT::writePixels(uint16_t* colors, uint32_t len, bool, bool bigEndian) {
+  pushed(len);
+  for (uint32_t i = 0; i < len; i++) {
+    const uint16_t c = bigEndian ? static_cast<uint16_t>((colors[i] >> 8) | (colors[i] << 8)) : colors[i];
+    put(c);
+  }
+}
+
+uint16_t Adafruit_SPITFT::pixel(int16_t x, int16_t y) const {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) {
+    return 0;
+  }
+  return fb_[static_cast<size_t>(y) * _width + x];
+}
+
+void Adafruit_SPITFT::clearFrame(uint16_t color) { fb_.assign(fb_.size(), color); }
+
+bool Adafruit_SPITFT::savePng(const char* path) const {
+  // Scanlines with filter byte 0, RGB565 widened to 8 bits per channel
+  std::vector<uint8_t> raw;
+  raw.reserve(static_cast<size_t>(_height) * (1 + 3 * _width));
+  for (int16_t y = 0; y < _height; y++) {
+    raw.push_back(0);
+    for (int16_t x = 0; x < _width; x++) {
+      const uint16_t c = pixel(x, y);
+      const uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+      raw.push_back(static_cast<uint8_t>((r << 3) | (r >> 2)));
+      raw.push_back(static_cast<uint8_t>((g << 2) | (g >> 4)));
+      raw.push_back(static_cast<uint8_t>((b << 3) | (b >> 2)));
+    }
+  }
+  // zlib stream of stored blocks
+  std::vector<uint8_t> z = {0x78, 0x01};
+  uint32_t a = 1, b = 0;
+  for (size_t i = 0; i < raw.size(); i += 65535) {
+    const uint16_t n = static_cast<uint16_t>(std::min<size_t>(65535, raw.size() - i));
+    z.push_back(i + n == raw.size() ? 1 : 0);
+    z.push_back(n & 0xFF);
+    z.push_back(n >> 8);
+    z.push_back(~n & 0xFF);
+    z.push_back((~n >> 8) & 0xFF);
+    z.insert(z.end(), raw.begin() + i, raw.begin() + i + n);
+  }
+  for (uint8_t v : raw) {
+    a = (a + v) % 65521;
+    b = (b + a) % 65521;
+  }
+  putBe32(z, (b << 16) | a);
+
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  std::vector<uint8_t> ihdr;
+  putBe32(ihdr, static_cast<uint32_t>(_width));
+  putBe32(ihdr, static_cast<uint32_t>(_height));
+  ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});   // 8-bit RGB, deflate, no filter, no interlace
+  chunk(png, "IHDR", ihdr);
+  chunk(png, "IDAT", z);
+  chunk(png, "IEND", {});
+
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    return false;
+  }
+  const bool ok = fwrite(png.data(), 1, png.size(), f) == png.size();
+  return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,49 @@
+#pragma once
+// Host Adafruit_SPITFT: every primitive ends as setAddrWindow() followed by writeColor(), as on
+// the panel, and the pixels land in a framebuffer the test can read back. The driver below
+// (Adafruit_ILI9341) meters what would cross the SPI bus.
+#include <Adafruit_GFX.h>
+#include <vector>
+
+class Adafruit_SPITFT : public Adafruit_GFX {
+ public:
+  Adafruit_SPITFT(uint16_t w, uint16_t h);
+
+  virtual void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) = 0;
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void writePixel(int16_t x, int16_t y, uint16_t color) override { drawPixel(x, y, color); }
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override { fillRect(x, y, w, h, color); }
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override { drawFastHLine(x, y, w, color); }
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override { drawFastVLine(x, y, h, color); }
+
+  void writeColor(uint16_t color, uint32_t len);
+  void writePixels(uint16_t* colors, uint32_t len, bool block = true, bool bigEndian = false);
+  void pushColor(uint16_t color) { writeColor(color, 1); }
+  uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
+    return static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+  }
+
+  // ---- host side ----
+  // Framebuffer in the current rotation, width() x height()
+  uint16_t pixel(int16_t x, int16_t y) const;
+  const uint16_t* frame() const { return fb_.data(); }
+  void clearFrame(uint16_t color = 0);
+  // The framebuffer as an 8-bit RGB PNG (uncompressed deflate); false if the file cannot be written
+  bool savePng(const char* path) const;
+
+ protected:
+  // The window the next writeColor() fills, left to right and top to bottom
+  void openWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+  // Every colour write, before it reaches the framebuffer
+  virtual void pushed(uint32_t n) { (void)n; }
+
+ private:
+  void put(uint16_t color);
+  std::vector<uint16_t> fb_;
+  uint16_t wx_ = 0, wy_ = 0, ww_ = 0, wh_ = 0;
+  uint32_t wpos_ = 0;
+};
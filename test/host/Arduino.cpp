@@ -0,0 +1,289 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include <deque>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace {
+uint64_t g_us = 0;
+
+struct Pin {
+  uint8_t level = HIGH;
+  host::PinReader reader = nullptr;
+  void* readerCtx = nullptr;
+  void (*isr)() = nullptr;
+  int isrMode = 0;
+};
+Pin g_pins[64];
+
+struct Writer {
+  host::PinWriter fn;
+  void* ctx;
+};
+// Function-local so mocks constructed as globals in other files can register before main()
+std::vector<Writer>& writers() {
+  static std::vector<Writer> w;
+  return w;
+}
+
+std::string g_serialOut;
+std::deque<uint8_t> g_serialIn;
+
+uint32_t g_heapFree = 200 * 1024, g_heapMin = 200 * 1024, g_heapLargest = 110 * 1024;
+}  // namespace
+
+unsigned long millis() { return static_cast<unsigned long>(g_us / 1000); }
+unsigned long micros() { return static_cast<unsigned long>(g_us); }
+void delay(uint32_t ms) { g_us += static_cast<uint64_t>(ms) * 1000; }
+void delayMicroseconds(uint32_t us) { g_us += us; }
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < 64) {
+    g_pins[pin].level = val ? HIGH : LOW;
+  }
+  std::vector<Writer>& w = writers();
+  for (size_t i = 0; i < w.size(); i++) {
+    w[i].fn(pin, val, w[i].ctx);
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= 64) {
+    return LOW;
+  }
+  const Pin& p = g_pins[pin];
+  return p.reader ? p.reader(pin, p.readerCtx) : p.level;
+}
+
+void attachInterrupt(int irq, void (*isr)(), int mode) {
+  if (irq >= 0 && irq < 64) {
+    g_pins[irq].isr = isr;
+    g_pins[irq].isrMode = mode;
+  }
+}
+
+void detachInterrupt(int irq) {
+  if (irq >= 0 && irq < 64) {
+    g_pins[irq].isr = nullptr;
+  }
+}
+
+// ---- String ----
+String::String(float v, unsigned decimals) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", static_cast<int>(decimals), static_cast<double>(v));
+  s_ = buf;
+}
+
+void String::trim() {
+  size_t a = 0, b = s_.size();
+  while (a < b && isspace(static_cast<unsigned char>(s_[a]))) {
+    a++;
+  }
+  while (b > a && isspace(static_cast<unsigned char>(s_[b - 1]))) {
+    b--;
+  }
+  s_ = s_.substr(a, b - a);
+}
+
+void String::toLowerCase() {
+  for (char& c : s_) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+}
+
+void String::toUpperCase() {
+  for (char& c : s_) {
+    c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+  }
+}
+
+int String::indexOf(char c, unsigned from) const {
+  const size_t at = s_.find(c, from);
+  return at == std::string::npos ? -1 : static_cast<int>(at);
+}
+
+String String::substring(unsigned from, unsigned to) const {
+  if (to > s_.size()) {
+    to = s_.size();
+  }
+  if (from >= to) {
+    return String();
+  }
+  return String(s_.substr(from, to - from));
+}
+
+bool String::endsWith(const String& p) const {
+  return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+}
+
+bool String::equalsIgnoreCase(const String& o) const {
+  if (s_.size() != o.s_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < s_.size(); i++) {
+    if (tolower(static_cast<unsigned char>(s_[i])) != tolower(static_cast<unsigned char>(o.s_[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// ---- Print ----
+size_t Print::write(const uint8_t* buf, size_t n) {
+  size_t w = 0;
+  while (n--) {
+    w += write(*buf++);
+  }
+  return w;
+}
+
+size_t Print::print(long v, int base) {
+  if (base == DEC) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", v);
+    return write(buf);
+  }
+  return print(static_cast<unsigned long>(v), base);
+}
+
+size_t Print::print(unsigned long v, int base) {
+  char buf[72];
+  if (base == HEX) {
+    snprintf(buf, sizeof(buf), "%lX", v);
+  } else if (base == DEC) {
+    snprintf(buf, sizeof(buf), "%lu", v);
+  } else {
+    char* p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+      const unsigned d = v % base;
+      *--p = static_cast<char>(d < 10 ? '0' + d : 'A' + d - 10);
+      v /= base;
+    } while (v);
+    return write(p);
+  }
+  return write(buf);
+}
+
+size_t Print::print(double v, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, v);
+  return write(buf);
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[512];
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  return n > 0 ? write(reinterpret_cast<const uint8_t*>(buf), n < static_cast<int>(sizeof(buf)) ? n : sizeof(buf) - 1) : 0;
+}
+
+// ---- Serial ----
+int HardwareSerial::available() { return static_cast<int>(g_serialIn.size()); }
+
+int HardwareSerial::read() {
+  if (g_serialIn.empty()) {
+    return -1;
+  }
+  const uint8_t c = g_serialIn.front();
+  g_serialIn.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() { return g_serialIn.empty() ? -1 : g_serialIn.front(); }
+
+size_t HardwareSerial::write(uint8_t c) {
+  g_serialOut.push_back(static_cast<char>(c));
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  g_serialOut.append(reinterpret_cast<const char*>(buf), n);
+  return n;
+}
+
+// ---- ESP ----
+uint32_t EspClass::getFreeHeap() { return g_heapFree; }
+uint32_t EspClass::getMinFreeHeap() { return g_heapMin; }
+uint32_t EspClass::getMaxAllocHeap() { return g_heapLargest; }
+
+// ---- FreeRTOS ----
+BaseType_t xTaskCreate(void (*)(void*), const char*, uint32_t, void*, UBaseType_t, TaskHandle_t* handle) {
+  static int s_task;
+  if (handle) {
+    *handle = &s_task;
+  }
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stack, void* arg, UBaseType_t prio,
+                                   TaskHandle_t* handle, BaseType_t) {
+  return xTaskCreate(fn, name, stack, arg, prio, handle);
+}
+
+void vTaskDelay(TickType_t ticks) { g_us += static_cast<uint64_t>(ticks) * 1000; }
+void vTaskDelete(TaskHandle_t) {}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  static int s_loop;
+  return &s_loop;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 4096; }
+
+// ---- host controls ----
+namespace host {
+void setMicros(uint64_t us) { g_us = us; }
+void advanceUs(uint64_t us) { g_us += us; }
+uint64_t nowUs() { return g_us; }
+
+void setPinReader(uint8_t pin, PinReader fn, void* ctx) {
+  if (pin < 64) {
+    g_pins[pin].reader = fn;
+    g_pins[pin].readerCtx = ctx;
+  }
+}
+
+void addPinWriter(PinWriter fn, void* ctx) { writers().push_back({fn, ctx}); }
+
+void removePinWriter(PinWriter fn, void* ctx) {
+  std::vector<Writer>& w = writers();
+  for (size_t i = 0; i < w.size(); i++) {
+    if (w[i].fn == fn && w[i].ctx == ctx) {
+      w.erase(w.begin() + i);
+      return;
+    }
+  }
+}
+
+uint8_t pinLevel(uint8_t pin) { return pin < 64 ? g_pins[pin].level : LOW; }
+
+void pinEdge(uint8_t pin, bool rising) {
+  if (pin >= 64 || !g_pins[pin].isr) {
+    return;
+  }
+  const int mode = g_pins[pin].isrMode;
+  if (mode == CHANGE || (rising && mode == RISING) || (!rising && mode == FALLING)) {
+    g_pins[pin].isr();
+  }
+}
+
+std::string& serialOut() { return g_serialOut; }
+
+void serialIn(const uint8_t* d, size_t n) { g_serialIn.insert(g_serialIn.end(), d, d + n); }
+
+void setHeap(uint32_t freeBytes, uint32_t largestBlock) {
+  g_heapFree = freeBytes;
+  g_heapLargest = largestBlock;
+  if (freeBytes < g_heapMin) {
+    g_heapMin = freeBytes;
+  }
+}
+}  // namespace host
@@ -0,0 +1,201 @@
+#pragma once
+// Host stand-in for the parts of the ESP32 Arduino core the modules use.
+// Time only moves when a test moves it (host::advanceUs), pins are plain state with an optional
+// per-pin reader so a mock peripheral can drive its INT line, and Serial output is captured.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define DEC 10
+#define HEX 16
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define IRAM_ATTR
+#define PROGMEM
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+enum { D0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10 };
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+inline void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(int irq, void (*isr)(), int mode);
+void detachInterrupt(int irq);
+
+class String {
+ public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(unsigned v) : s_(std::to_string(v)) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long v) : s_(std::to_string(v)) {}
+  String(float v, unsigned decimals = 2);
+  const char* c_str() const { return s_.c_str(); }
+  unsigned length() const { return s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  char operator[](unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+  char charAt(unsigned i) const { return (*this)[i]; }
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  friend String operator+(String a, const String& b) { return a += b; }
+  friend String operator+(String a, const char* b) { return a += b; }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return s_ == o; }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+  int indexOf(char c, unsigned from = 0) const;
+  String substring(unsigned from, unsigned to = 0xFFFFFFFFu) const;
+  bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  bool endsWith(const String& p) const;
+  bool equalsIgnoreCase(const String& o) const;
+  void reserve(unsigned n) { s_.reserve(n); }
+
+ private:
+  std::string s_;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n);
+  size_t write(const char* s) { return write(reinterpret_cast<const uint8_t*>(s), strlen(s)); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str()); }
+  size_t print(const __FlashStringHelper* s) { return write(reinterpret_cast<const char*>(s)); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(unsigned char v, int base = DEC) { return print(static_cast<unsigned long>(v), base); }
+  size_t print(int v, int base = DEC) { return print(static_cast<long>(v), base); }
+  size_t print(unsigned v, int base = DEC) { return print(static_cast<unsigned long>(v), base); }
+  size_t print(long v, int base = DEC);
+  size_t print(unsigned long v, int base = DEC);
+  size_t print(long long v, int base = DEC) { return print(static_cast<long>(v), base); }
+  size_t print(unsigned long long v, int base = DEC) { return print(static_cast<unsigned long>(v), base); }
+  size_t print(double v, int digits = 2);
+  template <typename T>
+  size_t println(const T& v) { return print(v) + println(); }
+  template <typename T>
+  size_t println(const T& v, int fmt) { return print(v, fmt) + println(); }
+  size_t println() { return write("\r\n"); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  virtual void flush() {}
+};
+
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long) {}
+  void end() {}
+  int available();
+  int read();
+  int peek();
+  int availableForWrite() { return 4096; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+  void setTxBufferSize(size_t) {}
+  void setRxBufferSize(size_t) {}
+  operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+ public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getHeapSize() { return 320 * 1024; }
+  void restart() { exit(0); }
+};
+extern EspClass ESP;
+
+// FreeRTOS: tasks are recorded, never run; vTaskDelay advances the clock
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define tskIDLE_PRIORITY 0
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+BaseType_t xTaskCreate(void (*fn)(void*), const char* name, uint32_t stack, void* arg, UBaseType_t prio,
+                       TaskHandle_t* handle);
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t t);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t t);
+
+namespace host {
+  // Clock
+  void setMicros(uint64_t us);
+  void advanceUs(uint64_t us);
+  inline void advanceMs(uint64_t ms) { advanceUs(ms * 1000); }
+  uint64_t nowUs();
+
+  // Pins: a reader overrides the stored level (mock INT lines); writers see every digitalWrite
+  typedef int (*PinReader)(uint8_t pin, void* ctx);
+  typedef void (*PinWriter)(uint8_t pin, uint8_t val, void* ctx);
+  void setPinReader(uint8_t pin, PinReader fn, void* ctx);
+  void addPinWriter(PinWriter fn, void* ctx);
+  void removePinWriter(PinWriter fn, void* ctx);
+  uint8_t pinLevel(uint8_t pin);
+  // Runs the ISR attached to pin, if any and if the edge matches its mode
+  void pinEdge(uint8_t pin, bool rising);
+
+  // Serial capture
+  std::string& serialOut();
+  void serialIn(const uint8_t* d, size_t n);
+
+  // Heap figures reported through ESP
+  void setHeap(uint32_t freeBytes, uint32_t largestBlock);
+  // host/Heap.cpp only: from now on allocations are carved from a simulated heap of `bytes`
+  // (at most 200 KB, the starting low-water mark) and ESP reports its figures
+  void trackHeap(uint32_t bytes);
+}
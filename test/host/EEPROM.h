@@ -0,0 +1,30 @@
+#pragma once
+// Host EEPROM: a zeroed byte array behind get/put, as a blank flash page reads after begin()
+#include <Arduino.h>
+
+class EEPROMClass {
+ public:
+  bool begin(size_t n) {
+    size_ = n < sizeof(data_) ? n : sizeof(data_);
+    return true;
+  }
+  template <typename T>
+  T& get(int addr, T& t) {
+    memcpy(&t, data_ + addr, sizeof(T));
+    return t;
+  }
+  template <typename T>
+  const T& put(int addr, const T& t) {
+    memcpy(data_ + addr, &t, sizeof(T));
+    return t;
+  }
+  bool commit() { return true; }
+  uint8_t read(int addr) { return data_[addr]; }
+  void write(int addr, uint8_t v) { data_[addr] = v; }
+  size_t length() const { return size_; }
+
+ private:
+  uint8_t data_[4096] = {};
+  size_t size_ = 0;
+};
+inline EEPROMClass EEPROM;
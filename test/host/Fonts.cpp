@@ -0,0 +1,77 @@
+// Synthetic FreeSans glyphs. Sizes, offsets and advances follow the real fonts per character
+// class (digits share one tabular width, capitals are wider, lowercase has an x-height with
+// ascenders and descenders), scaled from the 12pt figures by yAdvance, so layout and text
+// extents come out within a pixel or two. The ink is a box outline with a stroke of about
+// 2 px at 12pt and a middle bar on every other character: close to the set-bit count of the
+// real outlines, which is what the panel pays for, and nothing like their shapes.
+#include <Fonts/FreeSans12pt7b.h>
+#include <Fonts/FreeSans18pt7b.h>
+#include <Fonts/FreeSans24pt7b.h>
+#include <Fonts/FreeSans9pt7b.h>
+#include <vector>
+
+namespace {
+constexpr uint16_t FIRST = 0x20, LAST = 0x7E;
+
+struct Shape {
+  float w, h, adv, top;   // at 12pt: ink box, advance, baseline to top of the box
+};
+
+Shape shapeOf(char c) {
+  if (c >= '0' && c <= '9') return {11, 17, 13, 17};
+  if (c >= 'A' && c <= 'Z') return {c == 'I' ? 2.f : (c == 'M' || c == 'W' ? 17.f : 13.f), 17, c == 'I' ? 6.f : 16.f, 17};
+  if (c == 'i' || c == 'l' || c == 'j') return {2, c == 'j' ? 22.f : 17.f, 5, 17};
+  if (strchr("bdfhkt", c)) return {10, 17, c == 'f' || c == 't' ? 7.f : 13.f, 17};
+  if (strchr("gpqy", c)) return {10, 18, 13, 13};
+  if (c >= 'a' && c <= 'z') return {c == 'm' || c == 'w' ? 16.f : 10.f, 13, c == 'm' || c == 'w' ? 19.f : 12.f, 13};
+  switch (c) {
+    case '.': case ',': return {2, c == ',' ? 5.f : 2.f, 7, 2};
+    case ':': case ';': return {2, 13, 7, 13};
+    case '-': return {6, 2, 8, 8};
+    case '%': return {18, 17, 21, 17};
+    case '/': return {7, 17, 7, 17};
+    case '(': case ')': case '[': case ']': return {5, 22, 8, 17};
+    default: return {8, 10, 10, 14};
+  }
+}
+
+struct Built {
+  std::vector<uint8_t> bitmap;
+  GFXglyph glyph[LAST - FIRST + 1];
+};
+
+uint8_t px(float v, float k) { return static_cast<uint8_t>(v * k + 0.5f); }
+
+GFXfont build(Built& b, uint8_t yAdvance) {
+  const float k = yAdvance / 29.0f;
+  const uint8_t stroke = px(2, k) ? px(2, k) : 1;
+  uint32_t bit = 0;
+  for (uint16_t c = FIRST; c <= LAST; c++) {
+    GFXglyph& g = b.glyph[c - FIRST];
+    const Shape s = shapeOf(static_cast<char>(c));
+    g.bitmapOffset = static_cast<uint16_t>(b.bitmap.size());
+    g.width = c == ' ' ? 0 : px(s.w, k);
+    g.height = c == ' ' ? 0 : px(s.h, k);
+    g.xAdvance = c == ' ' ? px(7, k) : px(s.adv, k);
+    g.xOffset = static_cast<int8_t>(px(1, k));
+    g.yOffset = static_cast<int8_t>(-px(s.top, k));
+    bit = 0;
+    for (uint8_t y = 0; y < g.height; y++) {
+      for (uint8_t x = 0; x < g.width; x++, bit++) {
+        const bool edge = x < stroke || y < stroke || x + stroke >= g.width || y + stroke >= g.height;
+        const bool bar = (c & 1) && y >= g.height / 2 && y < g.height / 2 + stroke;
+        if (!(bit & 7)) b.bitmap.push_back(0);
+        if (edge || bar) b.bitmap.back() |= static_cast<uint8_t>(0x80 >> (bit & 7));
+      }
+    }
+  }
+  return GFXfont{b.bitmap.data(), b.glyph, FIRST, LAST, yAdvance};
+}
+
+Built g9, g12, g18, g24;
+}  // namespace
+
+const GFXfont FreeSans9pt7b = build(g9, 22);
+const GFXfont FreeSans12pt7b = build(g12, 29);
+const GFXfont FreeSans18pt7b = build(g18, 42);
+const GFXfont FreeSans24pt7b = build(g24, 56);
@@ -0,0 +1,5 @@
+#pragma once
+// Host FreeSans 18pt: synthetic glyphs with the font's metrics (see Fonts.cpp)
+#include <Adafruit_GFX.h>
+
+extern const GFXfont FreeSans18pt7b;
@@ -0,0 +1,5 @@
+#pragma once
+// Host FreeSans 9pt: synthetic glyphs with the font's metrics (see Fonts.cpp)
+#include <Adafruit_GFX.h>
+
+extern const GFXfont FreeSans9pt7b;
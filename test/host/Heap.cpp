@@ -0,0 +1,231 @@
+// Simulated device heap, for the host programs that link this file (the heap soak).
+// malloc and friends are replaced. Memory still comes from glibc; once trackHeap() has run, each
+// allocation also takes a first-fit block from a simulated heap of the given size and free()
+// returns it, coalescing with its neighbours. ESP then reports that heap's free bytes, low-water
+// mark and largest free block, so a leak shows as free heap falling and fragmentation as the
+// largest block shrinking. Blocks round up to 8 bytes plus an 8-byte header, near multi_heap.
+// With CONFIG_HEAP_USE_HOOKS the IDF allocation hooks run for every malloc, as on the device.
+#include <Arduino.h>
+#include <errno.h>
+#include <unistd.h>
+
+extern "C" {
+void* __libc_malloc(size_t n);
+void __libc_free(void* p);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t n);
+void* __libc_memalign(size_t align, size_t n);
+#if defined(CONFIG_HEAP_USE_HOOKS)
+void esp_heap_trace_alloc_hook(void* p, size_t size, uint32_t caps);
+void esp_heap_trace_free_hook(void* p);
+#endif
+}
+
+namespace {
+constexpr uint32_t GRAIN = 8;
+constexpr uint32_t HEADER = 8;
+constexpr size_t MAX_SPANS = 1024;      // free spans of the simulated heap, by offset
+constexpr size_t SLOTS = 1u << 16;      // live blocks, open addressing on the host pointer
+
+struct Span {
+  uint32_t off, len;
+};
+struct Block {
+  void* p;
+  uint32_t off, len;
+};
+
+Span g_spans[MAX_SPANS];
+size_t g_spanCount = 0;
+Block g_blocks[SLOTS];
+size_t g_live = 0;
+bool g_tracking = false;
+uint32_t g_freeBytes = 0;
+
+// No stdio here: it may allocate
+[[noreturn]] void die(const char* why) {
+  const ssize_t r = write(2, why, strlen(why));
+  (void)r;
+  abort();
+}
+
+size_t slotOf(const void* p) {
+  return static_cast<size_t>((reinterpret_cast<uintptr_t>(p) >> 4) * 0x9E3779B97F4A7C15ull >> 48) & (SLOTS - 1);
+}
+
+void publish() {
+  uint32_t largest = 0;
+  for (size_t i = 0; i < g_spanCount; i++) {
+    largest = max(largest, g_spans[i].len - min(g_spans[i].len, HEADER));
+  }
+  host::setHeap(g_freeBytes, largest);
+}
+
+bool carve(uint32_t len, uint32_t& off) {
+  for (size_t i = 0; i < g_spanCount; i++) {
+    Span& s = g_spans[i];
+    if (s.len < len) {
+      continue;
+    }
+    off = s.off;
+    s.off += len;
+    s.len -= len;
+    if (!s.len) {
+      memmove(&g_spans[i], &g_spans[i + 1], (g_spanCount - i - 1) * sizeof(Span));
+      g_spanCount--;
+    }
+    return true;
+  }
+  return false;
+}
+
+void release(uint32_t off, uint32_t len) {
+  size_t i = 0;
+  while (i < g_spanCount && g_spans[i].off < off) {
+    i++;
+  }
+  const bool joinPrev = i > 0 && g_spans[i - 1].off + g_spans[i - 1].len == off;
+  const bool joinNext = i < g_spanCount && off + len == g_spans[i].off;
+  if (joinPrev && joinNext) {
+    g_spans[i - 1].len += len + g_spans[i].len;
+    memmove(&g_spans[i], &g_spans[i + 1], (g_spanCount - i - 1) * sizeof(Span));
+    g_spanCount--;
+  } else if (joinPrev) {
+    g_spans[i - 1].len += len;
+  } else if (joinNext) {
+    g_spans[i].off = off;
+    g_spans[i].len += len;
+  } else {
+    if (g_spanCount == MAX_SPANS) {
+      die("host heap: too many free spans\n");
+    }
+    memmove(&g_spans[i + 1], &g_spans[i], (g_spanCount - i) * sizeof(Span));
+    g_spans[i] = {off, len};
+    g_spanCount++;
+  }
+}
+
+void note(void* p, size_t n) {
+#if defined(CONFIG_HEAP_USE_HOOKS)
+  esp_heap_trace_alloc_hook(p, n, 0);
+#endif
+  if (!g_tracking) {
+    return;
+  }
+  const uint32_t len = static_cast<uint32_t>((max<size_t>(n, 1) + GRAIN - 1) / GRAIN * GRAIN) + HEADER;
+  uint32_t off = 0;
+  if (!carve(len, off)) {
+    die("host heap: simulated heap exhausted\n");
+  }
+  if (g_live == SLOTS / 2) {
+    die("host heap: too many live blocks\n");
+  }
+  size_t i = slotOf(p);
+  while (g_blocks[i].p) {
+    i = (i + 1) & (SLOTS - 1);
+  }
+  g_blocks[i] = {p, off, len};
+  g_live++;
+  g_freeBytes -= len;
+  publish();
+}
+
+// Blocks from before trackHeap() are not in the table and are left alone
+void forget(void* p) {
+#if defined(CONFIG_HEAP_USE_HOOKS)
+  esp_heap_trace_free_hook(p);
+#endif
+  if (!g_live) {
+    return;
+  }
+  size_t i = slotOf(p);
+  while (g_blocks[i].p && g_blocks[i].p != p) {
+    i = (i + 1) & (SLOTS - 1);
+  }
+  if (!g_blocks[i].p) {
+    return;
+  }
+  release(g_blocks[i].off, g_blocks[i].len);
+  g_freeBytes += g_blocks[i].len;
+  g_live--;
+  // Backward-shift deletion keeps every probe chain unbroken
+  size_t hole = i;
+  for (size_t j = (i + 1) & (SLOTS - 1); g_blocks[j].p; j = (j + 1) & (SLOTS - 1)) {
+    const size_t home = slotOf(g_blocks[j].p);
+    if (((j - home) & (SLOTS - 1)) >= ((j - hole) & (SLOTS - 1))) {
+      g_blocks[hole] = g_blocks[j];
+      hole = j;
+    }
+  }
+  g_blocks[hole] = {};
+  publish();
+}
+}  // namespace
+
+extern "C" {
+void* malloc(size_t n) {
+  void* p = __libc_malloc(n);
+  if (p) {
+    note(p, n);
+  }
+  return p;
+}
+
+void free(void* p) {
+  if (p) {
+    forget(p);
+    __libc_free(p);
+  }
+}
+
+void* calloc(size_t n, size_t size) {
+  void* p = __libc_calloc(n, size);
+  if (p) {
+    note(p, n * size);
+  }
+  return p;
+}
+
+void* realloc(void* p, size_t n) {
+  if (!p) {
+    return malloc(n);
+  }
+  void* q = __libc_realloc(p, n);
+  if (q || !n) {
+    forget(p);
+  }
+  if (q) {
+    note(q, n);
+  }
+  return q;
+}
+
+void* memalign(size_t align, size_t n) {
+  void* p = __libc_memalign(align, n);
+  if (p) {
+    note(p, n);
+  }
+  return p;
+}
+
+void* aligned_alloc(size_t align, size_t n) { return memalign(align, n); }
+
+int posix_memalign(void** out, size_t align, size_t n) {
+  void* p = memalign(align, n);
+  if (!p) {
+    return ENOMEM;
+  }
+  *out = p;
+  return 0;
+}
+}
+
+namespace host {
+void trackHeap(uint32_t bytes) {
+  g_spans[0] = {0, bytes};
+  g_spanCount = 1;
+  g_freeBytes = bytes;
+  g_tracking = true;
+  publish();
+}
+}  // namespace host
@@ -0,0 +1,16 @@
+// The sketch's live values (Xiao_Dash_V1_211.ino), which the decoders write through CanDecode.h
+#include "CanDecode.h"
+#include "DashTypes.h"
+
+RegenState regenState = REGEN_IDLE;
+float soot_pct = 0, regen_pct = 0, speed_kmh = 0;
+float rpm = 0, coolantC = 0, trans1C = 0, trans2C = 0, oil_kPa = 0, battV = 0, pedalPct = 0, tqDemandPct = 0;
+float torqueNm = 0;
+float egt1C = 0, egt2C = 0, boost_kPa = 0, manifoldC = 0, turboOutC = 0, lambdaVal = 1.00f, iatC = 0, fuelC = 0;
+uint8_t turboActRaw = 0;
+bool headlightsOn = false;
+int gear = 0;
+int targetgear = 0;
+volatile TCState g_tcState = TC_Unlocked;
+bool lockup = false;
+uint8_t g_lockByteRaw3 = 0;
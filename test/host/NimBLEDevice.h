@@ -0,0 +1,74 @@
+#pragma once
+// Host NimBLE: scans start and stop and never report an advertiser by themselves; a host program
+// builds an advertisement and hands it to the registered callbacks.
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+class NimBLEAddress {
+ public:
+  NimBLEAddress() {}
+  explicit NimBLEAddress(const uint8_t (&val)[6]) { memcpy(val_, val, sizeof(val_)); }
+  std::string toString() const { return "00:00:00:00:00:00"; }
+  const uint8_t* getVal() const { return val_; }
+  const uint8_t* getBase() const { return val_; }
+
+ private:
+  uint8_t val_[6] = {};
+};
+
+class NimBLEAdvertisedDevice {
+ public:
+  bool haveManufacturerData() const { return false; }
+  std::string getManufacturerData(uint8_t = 0) const { return std::string(); }
+  NimBLEAddress getAddress() const { return address_; }
+  const std::vector<uint8_t>& getPayload() const { return payload_; }
+
+  // host
+  void setAddress(const NimBLEAddress& a) { address_ = a; }
+  void setPayload(const uint8_t* d, size_t n) { payload_.assign(d, d + n); }
+
+ private:
+  NimBLEAddress address_;
+  std::vector<uint8_t> payload_;
+};
+
+class NimBLEScanCallbacks {
+ public:
+  virtual ~NimBLEScanCallbacks() {}
+  virtual void onResult(const NimBLEAdvertisedDevice*) {}
+};
+
+class NimBLEScan {
+ public:
+  void setScanCallbacks(NimBLEScanCallbacks* cb, bool = false) { callbacks_ = cb; }
+  void setDuplicateFilter(bool) {}
+  void setActiveScan(bool) {}
+  void setInterval(uint16_t) {}
+  void setWindow(uint16_t) {}
+  bool isScanning() { return scanning_; }
+  bool start(uint32_t, bool = false, bool = true) { return scanning_ = true; }
+  bool stop() {
+    scanning_ = false;
+    return true;
+  }
+
+ private:
+  bool scanning_ = false;
+  NimBLEScanCallbacks* callbacks_ = nullptr;
+
+ public:
+  // host
+  NimBLEScanCallbacks* callbacks() const { return callbacks_; }
+};
+
+class NimBLEDevice {
+ public:
+  static bool init(const std::string&) { return true; }
+  static bool deinit(bool = false) { return true; }
+  static NimBLEScan* getScan() {
+    static NimBLEScan scan;
+    return &scan;
+  }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+
+struct SPISettings {
+  SPISettings() {}
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+// A device on the host bus; it selects itself when its CS pin goes low and is then handed
+// every transferred byte until CS goes high again
+class SpiDevice {
+ public:
+  virtual ~SpiDevice() {}
+  virtual uint8_t spiTransfer(uint8_t out) = 0;
+};
+
+class SPIClass {
+ public:
+  void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+  void end() {}
+  void setFrequency(uint32_t) {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction() {}
+  uint8_t transfer(uint8_t v) {
+    bytes++;
+    return selected ? selected->spiTransfer(v) : 0xFF;
+  }
+
+  SpiDevice* selected = nullptr;
+  uint64_t bytes = 0;
+};
+extern SPIClass SPI;
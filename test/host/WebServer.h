@@ -0,0 +1,75 @@
+#pragma once
+// Host WebServer: routes are recorded and, like the ESP32 server, kept across stop(). A request
+// queued with hostRequest() is served by the next handleClient() with its form arguments; the
+// response body is kept in body.
+#include <WiFi.h>
+#include <string>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST };
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+class WebServer {
+ public:
+  struct Arg {
+    String name, value;
+  };
+
+  explicit WebServer(int) {}
+  void on(const char* uri, HTTPMethod, void (*fn)()) { routes_.push_back({uri, fn}); }
+  void begin() { running_ = true; }
+  void stop() { running_ = false; }
+  void handleClient() {
+    if (!running_ || !pending_) return;
+    pending_ = false;
+    for (const Route& r : routes_) {
+      if (r.uri == uri_) {   // first match wins
+        r.fn();
+        return;
+      }
+    }
+  }
+  bool hasArg(const String& name) const { return find(name) != nullptr; }
+  String arg(const String& name) const {
+    const Arg* a = find(name);
+    return a ? a->value : String();
+  }
+  String arg(int i) const { return i >= 0 && i < args() ? args_[i].value : String(); }
+  String argName(int i) const { return i >= 0 && i < args() ? args_[i].name : String(); }
+  int args() const { return static_cast<int>(args_.size()); }
+  void send(int, const char* = nullptr, const String& s = String()) { body.append(s.c_str(), s.length()); }
+  void send(int, const char*, const char* s) { body.append(s ? s : ""); }
+  void sendHeader(const String&, const String&, bool = false) {}
+  void setContentLength(size_t) {}
+  void sendContent(const char* s, size_t n) { body.append(s, n); }
+  void sendContent(const char* s) { body.append(s); }
+  void sendContent(const String& s) { body.append(s.c_str(), s.length()); }
+  WiFiClient client() { return WiFiClient(); }
+
+  // host
+  void hostRequest(const char* uri, const Arg* args, size_t n) {
+    uri_ = uri;
+    args_.assign(args, args + n);
+    pending_ = true;
+    body.clear();
+  }
+  size_t routeCount() const { return routes_.size(); }
+  std::string body;
+
+ private:
+  struct Route {
+    String uri;
+    void (*fn)();
+  };
+  const Arg* find(const String& name) const {
+    for (const Arg& a : args_) {
+      if (a.name == name) return &a;
+    }
+    return nullptr;
+  }
+  std::vector<Route> routes_;
+  std::vector<Arg> args_;
+  String uri_;
+  bool running_ = false;
+  bool pending_ = false;
+};
@@ -0,0 +1,59 @@
+#pragma once
+// Host WiFi: the access point comes up with no stations and the servers never see a client
+#include <Arduino.h>
+
+class IPAddress {
+ public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : b_{a, b, c, d} {}
+  uint8_t operator[](int i) const { return b_[i & 3]; }
+  String toString() const {
+    char s[16];
+    snprintf(s, sizeof(s), "%u.%u.%u.%u", b_[0], b_[1], b_[2], b_[3]);
+    return String(s);
+  }
+
+ private:
+  uint8_t b_[4] = {};
+};
+
+enum wifi_mode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+
+class WiFiClient : public Print {
+ public:
+  int fd() const { return -1; }
+  explicit operator bool() { return false; }
+  bool connected() { return false; }
+  int available() { return 0; }
+  int read() { return -1; }
+  int read(uint8_t*, size_t) { return -1; }
+  void stop() {}
+  void setNoDelay(bool) {}
+  IPAddress remoteIP() { return IPAddress(); }
+  using Print::write;
+  size_t write(uint8_t) override { return 0; }
+  size_t write(const uint8_t*, size_t) override { return 0; }
+};
+
+class WiFiServer {
+ public:
+  explicit WiFiServer(uint16_t) {}
+  void begin() {}
+  void end() {}
+  void stop() {}
+  void setNoDelay(bool) {}
+  bool hasClient() { return false; }
+  WiFiClient available() { return WiFiClient(); }
+  WiFiClient accept() { return WiFiClient(); }
+};
+
+class WiFiClass {
+ public:
+  bool mode(wifi_mode_t) { return true; }
+  bool softAP(const char*, const char* = nullptr, int = 1, int = 0, int = 4) { return true; }
+  IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+  bool softAPdisconnect(bool = false) { return true; }
+  uint8_t softAPgetStationNum() { return 0; }
+  bool setSleep(bool) { return true; }
+};
+inline WiFiClass WiFi;
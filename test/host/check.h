@@ -0,0 +1,50 @@
+#pragma once
+// Minimal assertions for the host tests: a failed CHECK prints where and why and counts;
+// main() returns checkResult() so make stops on the first failing binary.
+#include <stdio.h>
+#include <math.h>
+
+namespace check {
+  inline int& failures() {
+    static int n = 0;
+    return n;
+  }
+  inline void fail(const char* file, int line, const char* what) {
+    fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, what);
+    failures()++;
+  }
+}
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) check::fail(__FILE__, __LINE__, #cond); \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    const long long a_ = static_cast<long long>(a), b_ = static_cast<long long>(b); \
+    if (a_ != b_) { \
+      char msg_[160]; \
+      snprintf(msg_, sizeof(msg_), "%s == %s (%lld vs %lld)", #a, #b, a_, b_); \
+      check::fail(__FILE__, __LINE__, msg_); \
+    } \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tol) \
+  do { \
+    const double a_ = (a), b_ = (b); \
+    if (!(fabs(a_ - b_) <= (tol))) { \
+      char msg_[160]; \
+      snprintf(msg_, sizeof(msg_), "%s ~= %s (%g vs %g, tol %g)", #a, #b, a_, b_, static_cast<double>(tol)); \
+      check::fail(__FILE__, __LINE__, msg_); \
+    } \
+  } while (0)
+
+inline int checkResult(const char* name) {
+  if (check::failures()) {
+    fprintf(stderr, "%s: %d check(s) failed\n", name, check::failures());
+    return 1;
+  }
+  printf("%s: ok\n", name);
+  return 0;
+}
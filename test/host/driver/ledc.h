@@ -0,0 +1,34 @@
+#pragma once
+// Host LEDC: duty and fades are accepted; the backlight has no pixels to dim
+#include <stdint.h>
+
+typedef enum { LEDC_LOW_SPEED_MODE } ledc_mode_t;
+typedef enum { LEDC_CHANNEL_0 } ledc_channel_t;
+typedef enum { LEDC_TIMER_0 } ledc_timer_t;
+typedef enum { LEDC_TIMER_12_BIT = 12 } ledc_timer_bit_t;
+typedef enum { LEDC_AUTO_CLK } ledc_clk_cfg_t;
+typedef enum { LEDC_FADE_NO_WAIT } ledc_fade_mode_t;
+typedef struct {
+  ledc_mode_t speed_mode;
+  ledc_timer_bit_t duty_resolution;
+  ledc_timer_t timer_num;
+  uint32_t freq_hz;
+  ledc_clk_cfg_t clk_cfg;
+} ledc_timer_config_t;
+typedef struct {
+  int gpio_num;
+  ledc_mode_t speed_mode;
+  ledc_channel_t channel;
+  int intr_type;
+  ledc_timer_t timer_sel;
+  uint32_t duty;
+  int hpoint;
+} ledc_channel_config_t;
+
+inline int ledc_timer_config(const ledc_timer_config_t*) { return 0; }
+inline int ledc_channel_config(const ledc_channel_config_t*) { return 0; }
+inline int ledc_fade_func_install(int) { return 0; }
+inline int ledc_set_duty(ledc_mode_t, ledc_channel_t, uint32_t) { return 0; }
+inline int ledc_update_duty(ledc_mode_t, ledc_channel_t) { return 0; }
+inline int ledc_set_fade_with_time(ledc_mode_t, ledc_channel_t, uint32_t, int) { return 0; }
+inline int ledc_fade_start(ledc_mode_t, ledc_channel_t, ledc_fade_mode_t) { return 0; }
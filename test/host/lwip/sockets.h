@@ -0,0 +1,4 @@
+#pragma once
+// Host lwIP: the POSIX socket calls stand in; the host WiFiClient never has a descriptor
+#include <errno.h>
+#include <sys/socket.h>
@@ -0,0 +1,306 @@
+#include <mcp2515.h>
+
+SPIClass SPI;
+
+namespace {
+constexpr uint8_t INSTR_WRITE = 0x02;
+constexpr uint8_t INSTR_READ = 0x03;
+constexpr uint8_t INSTR_BIT_MODIFY = 0x05;
+
+inline bool isExt(const can_frame& f) { return (f.can_id & CAN_EFF_FLAG) != 0; }
+inline uint16_t sidOf(const can_frame& f) {
+  return static_cast<uint16_t>(isExt(f) ? (f.can_id & CAN_EFF_MASK) >> 18 : f.can_id & CAN_SFF_MASK);
+}
+inline uint32_t eidOf(const can_frame& f) { return isExt(f) ? f.can_id & 0x3FFFF : 0; }
+
+// prepareId() in the library: a 29-bit value splits into SID (top 11) and EID (low 18)
+MCP2515::Filter split(bool ext, uint32_t data) {
+  MCP2515::Filter r;
+  r.ext = ext;
+  if (ext) {
+    r.sid = static_cast<uint16_t>((data & CAN_EFF_MASK) >> 18);
+    r.eid = data & 0x3FFFF;
+  } else {
+    r.sid = static_cast<uint16_t>(data & CAN_SFF_MASK);
+    r.eid = 0;
+  }
+  return r;
+}
+}  // namespace
+
+MCP2515::MCP2515(uint8_t cs, uint32_t, SPIClass*) : cs_(cs) { host::addPinWriter(onPinWrite, this); }
+
+MCP2515::~MCP2515() {
+  host::removePinWriter(onPinWrite, this);
+  if (intPin_ != 0xFF) {
+    host::setPinReader(intPin_, nullptr, nullptr);
+  }
+  if (SPI.selected == this) {
+    SPI.selected = nullptr;
+  }
+}
+
+void MCP2515::attachIntPin(uint8_t pin) {
+  intPin_ = pin;
+  host::setPinReader(pin, readInt, this);
+  updateInt();
+}
+
+int MCP2515::readInt(uint8_t, void* ctx) { return static_cast<MCP2515*>(ctx)->intLow_ ? LOW : HIGH; }
+
+void MCP2515::onPinWrite(uint8_t pin, uint8_t val, void* ctx) {
+  MCP2515* m = static_cast<MCP2515*>(ctx);
+  if (pin != m->cs_) {
+    return;
+  }
+  if (val == LOW) {
+    SPI.selected = m;
+    m->spiPos_ = 0;
+  } else if (SPI.selected == m) {
+    SPI.selected = nullptr;
+  }
+}
+
+uint8_t MCP2515::spiTransfer(uint8_t out) {
+  const uint8_t pos = spiPos_++;
+  if (pos == 0) {
+    spiInstr_ = out;
+    return 0xFF;
+  }
+  if (pos == 1) {
+    spiAddr_ = out & 0x7F;
+    return 0xFF;
+  }
+  switch (spiInstr_) {
+    case INSTR_READ:
+      return reg_[(spiAddr_ + pos - 2) & 0x7F];
+    case INSTR_WRITE:
+      modify(static_cast<uint8_t>((spiAddr_ + pos - 2) & 0x7F), 0xFF, out);
+      return 0xFF;
+    case INSTR_BIT_MODIFY:
+      if (pos == 2) {
+        spiMask_ = out;
+      } else if (pos == 3) {
+        modify(spiAddr_, spiMask_, out);
+      }
+      return 0xFF;
+    default:
+      return 0xFF;
+  }
+}
+
+void MCP2515::modify(uint8_t addr, uint8_t mask, uint8_t data) {
+  const uint8_t before = reg_[addr];
+  uint8_t after = static_cast<uint8_t>((before & ~mask) | (data & mask));
+  for (uint8_t n = 0; n < 3; n++) {
+    if (addr != txbCtrlReg(n)) {
+      continue;
+    }
+    if ((before & TXB_TXREQ) && !(after & TXB_TXREQ)) {
+      // Abort request: the buffer was not on the wire, so it aborts at once
+      after |= TXB_ABTF;
+      aborts++;
+    } else if (!(before & TXB_TXREQ) && (after & TXB_TXREQ)) {
+      after &= static_cast<uint8_t>(~(TXB_ABTF | TXB_MLOA | TXB_TXERR));
+    }
+  }
+  reg_[addr] = after;
+  if (addr == REG_CANINTF || addr == REG_CANINTE) {
+    updateInt();
+  }
+}
+
+void MCP2515::updateInt() {
+  const bool low = (reg_[REG_CANINTF] & reg_[REG_CANINTE]) != 0;
+  const bool fell = low && !intLow_;
+  intLow_ = low;
+  if (fell && intPin_ != 0xFF) {
+    host::pinEdge(intPin_, false);
+  }
+}
+
+MCP2515::ERROR MCP2515::reset() {
+  memset(reg_, 0, sizeof(reg_));
+  memset(tx_, 0, sizeof(tx_));
+  memset(rx_, 0, sizeof(rx_));
+  mode_ = MODE_CONFIG;
+  if (!present_) {
+    return ERROR_FAIL;
+  }
+  // As the library's reset(): RX, error and message-error interrupts enabled
+  modify(REG_CANINTE, 0xFF, CANINTF_RX0IF | CANINTF_RX1IF | CANINTF_ERRIF | CANINTF_MERRF);
+  // ... and filters open on both formats
+  for (uint8_t i = 0; i < 6; i++) {
+    filter_[i] = split((i & 1) != 0, 0);
+  }
+  mask_[0] = mask_[1] = split(false, 0);
+  return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::setMode(Mode m) {
+  if (!present_) {
+    return ERROR_FAIL;
+  }
+  mode_ = m;
+  return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::setBitrate(CAN_SPEED speed, CAN_CLOCK) {
+  const ERROR e = setConfigMode();
+  if (e != ERROR_OK) {
+    return e;
+  }
+  speed_ = speed;
+  return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::setFilterMask(MASK num, bool ext, uint32_t data) {
+  const ERROR e = setConfigMode();
+  if (e != ERROR_OK) {
+    return e;
+  }
+  mask_[num] = split(ext, data);
+  return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::setFilter(RXF num, bool ext, uint32_t data) {
+  const ERROR e = setConfigMode();
+  if (e != ERROR_OK) {
+    return e;
+  }
+  filter_[num] = split(ext, data);
+  return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::sendMessage(TXBn txbn, const struct can_frame* frame) {
+  if (frame->can_dlc > CAN_MAX_DLEN) {
+    return ERROR_FAILTX;
+  }
+  tx_[txbn] = *frame;
+  const uint8_t ctrl = txbCtrlReg(txbn);
+  modify(ctrl, TXB_TXREQ, TXB_TXREQ);
+  return (reg_[ctrl] & (TXB_ABTF | TXB_MLOA | TXB_TXERR)) ? ERROR_FAILTX : ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::sendMessage(const struct can_frame* frame) {
+  if (frame->can_dlc > CAN_MAX_DLEN) {
+    return ERROR_FAILTX;
+  }
+  for (uint8_t n = 0; n < 3; n++) {
+    if (!txPending(n)) {
+      return sendMessage(static_cast<TXBn>(n), frame);
+    }
+  }
+  return ERROR_ALLTXBUSY;
+}
+
+MCP2515::ERROR MCP2515::readMessage(RXBn rxbn, struct can_frame* frame) {
+  const uint8_t flag = rxbn == RXB0 ? CANINTF_RX0IF : CANINTF_RX1IF;
+  if (!(reg_[REG_CANINTF] & flag)) {
+    return ERROR_NOMSG;
+  }
+  *frame = rx_[rxbn];
+  modify(REG_CANINTF, flag, 0);
+  return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::readMessage(struct can_frame* frame) {
+  const uint8_t st = getStatus();
+  if (st & CANINTF_RX0IF) {
+    return readMessage(RXB0, frame);
+  }
+  if (st & CANINTF_RX1IF) {
+    return readMessage(RXB1, frame);
+  }
+  return ERROR_NOMSG;
+}
+
+uint8_t MCP2515::getStatus() {
+  const uint8_t intf = reg_[REG_CANINTF];
+  uint8_t st = intf & (CANINTF_RX0IF | CANINTF_RX1IF);
+  for (uint8_t n = 0; n < 3; n++) {
+    if (txPending(n)) {
+      st |= static_cast<uint8_t>(0x04 << (2 * n));
+    }
+    if (intf & (CANINTF_TX0IF << n)) {
+      st |= static_cast<uint8_t>(0x08 << (2 * n));
+    }
+  }
+  return st;
+}
+
+void MCP2515::clearRXnOVR() {
+  if (getErrorFlags() != 0) {
+    clearRXnOVRFlags();
+    clearInterrupts();
+  }
+}
+
+bool MCP2515::accepts(uint8_t rxb, const can_frame& f) const {
+  const Filter& m = mask_[rxb];
+  const uint8_t first = rxb == 0 ? 0 : 2, last = rxb == 0 ? 2 : 6;
+  for (uint8_t i = first; i < last; i++) {
+    const Filter& flt = filter_[i];
+    if (flt.ext != isExt(f)) {
+      continue;
+    }
+    if (((sidOf(f) ^ flt.sid) & m.sid) != 0) {
+      continue;
+    }
+    if (flt.ext && ((eidOf(f) ^ flt.eid) & m.eid) != 0) {
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+MCP2515::Offer MCP2515::inject(const can_frame& f) {
+  if (mode_ != MODE_NORMAL && mode_ != MODE_LISTENONLY) {
+    return OFFER_OFF;
+  }
+  uint8_t target;
+  if (accepts(0, f)) {
+    target = (reg_[REG_CANINTF] & CANINTF_RX0IF) ? 1 : 0;   // BUKT rollover
+  } else if (accepts(1, f)) {
+    target = 1;
+  } else {
+    filtered++;
+    return OFFER_FILTERED;
+  }
+  const uint8_t flag = target == 0 ? CANINTF_RX0IF : CANINTF_RX1IF;
+  if (reg_[REG_CANINTF] & flag) {
+    overflows++;
+    modify(REG_EFLG, target == 0 ? EFLG_RX0OVR : EFLG_RX1OVR, 0xFF);
+    modify(REG_CANINTF, CANINTF_ERRIF, CANINTF_ERRIF);
+    return OFFER_OVERFLOW;
+  }
+  rx_[target] = f;
+  modify(REG_CANINTF, flag, flag);
+  return target == 0 ? OFFER_RXB0 : OFFER_RXB1;
+}
+
+int MCP2515::transmitNext() {
+  if (mode_ != MODE_NORMAL) {
+    return -1;
+  }
+  int best = -1;
+  for (int n = 2; n >= 0; n--) {
+    if (txPending(static_cast<uint8_t>(n)) &&
+        (best < 0 || (reg_[txbCtrlReg(n)] & TXB_TXP) > (reg_[txbCtrlReg(best)] & TXB_TXP))) {
+      best = n;
+    }
+  }
+  if (best < 0) {
+    return -1;
+  }
+  sent.push_back({host::nowUs(), static_cast<uint8_t>(best), ack_, tx_[best]});
+  const uint8_t ctrl = txbCtrlReg(static_cast<uint8_t>(best));
+  if (ack_) {
+    reg_[ctrl] &= static_cast<uint8_t>(~(TXB_TXREQ | TXB_TXERR));
+    modify(REG_CANINTF, static_cast<uint8_t>(CANINTF_TX0IF << best), 0xFF);
+  } else {
+    reg_[ctrl] |= TXB_TXERR;   // TXREQ stays set: the controller keeps retrying
+  }
+  return best;
+}
@@ -0,0 +1,162 @@
+#pragma once
+// Host model of the MCP2515 behind the arduino-mcp2515 API.
+// The controller side follows the datasheet closely enough for the queueing and drain code:
+// three TX buffers with TXREQ / ABTF / TXERR in TXBnCTRL and transmit order by TXP then buffer
+// number, two RX buffers with rollover (BUKT, which the library's reset() enables), masks and
+// format-specific filters (EXIDE), EFLG overflow bits, CANINTF/CANINTE and an INT line that
+// falls when an enabled flag is raised. Raw SPI READ / BIT MODIFY reach the same registers,
+// so McpRegs sees what the library sees. The bus side is driven by the test: inject() offers a
+// received frame, transmitNext() puts the next pending TX buffer on the wire, with or without
+// an acknowledge. Data-byte filtering of standard frames is not modelled.
+#include <Arduino.h>
+#include <SPI.h>
+#include <vector>
+
+#define CAN_EFF_FLAG 0x80000000U
+#define CAN_RTR_FLAG 0x40000000U
+#define CAN_ERR_FLAG 0x20000000U
+#define CAN_SFF_MASK 0x000007FFU
+#define CAN_EFF_MASK 0x1FFFFFFFU
+#define CAN_ERR_MASK 0x1FFFFFFFU
+#define CAN_MAX_DLEN 8
+
+struct can_frame {
+  uint32_t can_id;
+  uint8_t can_dlc;
+  uint8_t data[CAN_MAX_DLEN] __attribute__((aligned(8)));
+};
+
+enum CAN_SPEED {
+  CAN_5KBPS, CAN_10KBPS, CAN_20KBPS, CAN_31K25BPS, CAN_33KBPS, CAN_40KBPS, CAN_50KBPS, CAN_80KBPS,
+  CAN_83K3BPS, CAN_95KBPS, CAN_100KBPS, CAN_125KBPS, CAN_200KBPS, CAN_250KBPS, CAN_500KBPS, CAN_1000KBPS
+};
+
+enum CAN_CLOCK { MCP_20MHZ, MCP_16MHZ, MCP_8MHZ };
+
+enum /*class*/ CANINTF : uint8_t {
+  CANINTF_RX0IF = 0x01, CANINTF_RX1IF = 0x02, CANINTF_TX0IF = 0x04, CANINTF_TX1IF = 0x08,
+  CANINTF_TX2IF = 0x10, CANINTF_ERRIF = 0x20, CANINTF_WAKIF = 0x40, CANINTF_MERRF = 0x80
+};
+
+enum /*class*/ EFLG : uint8_t {
+  EFLG_RX1OVR = (1 << 7), EFLG_RX0OVR = (1 << 6), EFLG_TXBO = (1 << 5), EFLG_TXEP = (1 << 4),
+  EFLG_RXEP = (1 << 3), EFLG_TXWAR = (1 << 2), EFLG_RXWAR = (1 << 1), EFLG_EWARN = (1 << 0)
+};
+
+class MCP2515 : public SpiDevice {
+ public:
+  enum ERROR { ERROR_OK = 0, ERROR_FAIL = 1, ERROR_ALLTXBUSY = 2, ERROR_FAILINIT = 3, ERROR_FAILTX = 4, ERROR_NOMSG = 5 };
+  enum MASK { MASK0, MASK1 };
+  enum RXF { RXF0 = 0, RXF1 = 1, RXF2 = 2, RXF3 = 3, RXF4 = 4, RXF5 = 5 };
+  enum RXBn { RXB0 = 0, RXB1 = 1 };
+  enum TXBn { TXB0 = 0, TXB1 = 1, TXB2 = 2 };
+  enum Mode { MODE_NORMAL, MODE_SLEEP, MODE_LOOPBACK, MODE_LISTENONLY, MODE_CONFIG };
+
+  // Register addresses the raw-SPI side exposes
+  static constexpr uint8_t REG_CANINTE = 0x2B;
+  static constexpr uint8_t REG_CANINTF = 0x2C;
+  static constexpr uint8_t REG_EFLG = 0x2D;
+  static constexpr uint8_t TXB_ABTF = 0x40;
+  static constexpr uint8_t TXB_MLOA = 0x20;
+  static constexpr uint8_t TXB_TXERR = 0x10;
+  static constexpr uint8_t TXB_TXREQ = 0x08;
+  static constexpr uint8_t TXB_TXP = 0x03;
+  static uint8_t txbCtrlReg(uint8_t n) { return static_cast<uint8_t>(0x30 + 0x10 * n); }
+
+  explicit MCP2515(uint8_t cs, uint32_t spiClock = 10000000, SPIClass* spi = nullptr);
+  ~MCP2515();
+
+  ERROR reset();
+  ERROR setConfigMode() { return setMode(MODE_CONFIG); }
+  ERROR setListenOnlyMode() { return setMode(MODE_LISTENONLY); }
+  ERROR setSleepMode() { return setMode(MODE_SLEEP); }
+  ERROR setLoopbackMode() { return setMode(MODE_LOOPBACK); }
+  ERROR setNormalMode() { return setMode(MODE_NORMAL); }
+  ERROR setBitrate(CAN_SPEED speed) { return setBitrate(speed, MCP_16MHZ); }
+  ERROR setBitrate(CAN_SPEED speed, CAN_CLOCK clock);
+  ERROR setFilterMask(MASK num, bool ext, uint32_t data);
+  ERROR setFilter(RXF num, bool ext, uint32_t data);
+  ERROR sendMessage(TXBn txbn, const struct can_frame* frame);
+  ERROR sendMessage(const struct can_frame* frame);
+  ERROR readMessage(RXBn rxbn, struct can_frame* frame);
+  ERROR readMessage(struct can_frame* frame);
+  bool checkReceive() { return (getStatus() & (CANINTF_RX0IF | CANINTF_RX1IF)) != 0; }
+  bool checkError() { return (getErrorFlags() & 0xF8) != 0; }
+  uint8_t getErrorFlags() { return reg_[REG_EFLG]; }
+  void clearRXnOVRFlags() { modify(REG_EFLG, EFLG_RX0OVR | EFLG_RX1OVR, 0); }
+  uint8_t getInterrupts() { return reg_[REG_CANINTF]; }
+  uint8_t getInterruptMask() { return reg_[REG_CANINTE]; }
+  // As in the library: writes the whole of CANINTF, pending RX flags included
+  void clearInterrupts() { modify(REG_CANINTF, 0xFF, 0); }
+  void clearTXInterrupts() { modify(REG_CANINTF, CANINTF_TX0IF | CANINTF_TX1IF | CANINTF_TX2IF, 0); }
+  uint8_t getStatus();
+  void clearRXnOVR();
+  void clearMERR() { modify(REG_CANINTF, CANINTF_MERRF, 0); }
+  void clearERRIF() { modify(REG_CANINTF, CANINTF_ERRIF, 0); }
+  uint8_t errorCountRX() { return 0; }
+  uint8_t errorCountTX() { return 0; }
+
+  uint8_t spiTransfer(uint8_t out) override;
+
+  // ---- host side ----
+  struct Filter {
+    uint16_t sid;
+    uint32_t eid;
+    bool ext;
+  };
+  struct Sent {
+    uint64_t us;
+    uint8_t buffer;
+    bool acked;
+    can_frame f;
+  };
+  enum Offer : uint8_t { OFFER_RXB0, OFFER_RXB1, OFFER_FILTERED, OFFER_OVERFLOW, OFFER_OFF };
+
+  // A missing controller: every mode change fails
+  void setPresent(bool p) { present_ = p; }
+  // The INT line is held low while an enabled interrupt flag is set
+  void attachIntPin(uint8_t pin);
+  // Without an acknowledge a transmission leaves TXREQ set and raises TXERR, like a lone node
+  void setAck(bool ack) { ack_ = ack; }
+  // A frame arriving from the bus; returns where it went
+  Offer inject(const can_frame& f);
+  // Transmits the highest-priority pending buffer; -1 when none is pending
+  int transmitNext();
+  bool txPending(uint8_t n) const { return (reg_[txbCtrlReg(n)] & TXB_TXREQ) != 0; }
+  Mode mode() const { return mode_; }
+  CAN_SPEED speed() const { return speed_; }
+  uint8_t reg(uint8_t addr) const { return reg_[addr]; }
+  const Filter& mask(uint8_t n) const { return mask_[n]; }
+  const Filter& filter(uint8_t n) const { return filter_[n]; }
+  bool accepts(uint8_t rxb, const can_frame& f) const;
+
+  std::vector<Sent> sent;
+  uint32_t aborts = 0;
+  uint32_t filtered = 0;
+  uint32_t overflows = 0;
+
+ private:
+  ERROR setMode(Mode m);
+  void modify(uint8_t addr, uint8_t mask, uint8_t data);
+  void updateInt();
+  static void onPinWrite(uint8_t pin, uint8_t val, void* ctx);
+  static int readInt(uint8_t pin, void* ctx);
+
+  uint8_t cs_;
+  uint8_t intPin_ = 0xFF;
+  bool intLow_ = false;
+  bool present_ = true;
+  bool ack_ = true;
+  Mode mode_ = MODE_CONFIG;
+  CAN_SPEED speed_ = CAN_500KBPS;
+  uint8_t reg_[128] = {};
+  Filter mask_[2] = {};
+  Filter filter_[6] = {};
+  can_frame tx_[3] = {};
+  can_frame rx_[2] = {};
+  // Raw SPI instruction in progress
+  uint8_t spiPos_ = 0;
+  uint8_t spiInstr_ = 0;
+  uint8_t spiAddr_ = 0;
+  uint8_t spiMask_ = 0;
+};
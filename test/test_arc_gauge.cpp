@@ -0,0 +1,92 @@
+// Dial arcs: the span fill against a per-pixel atan2 reference (the previous implementation)
+// for every arc the renderer draws, on dials of several sizes. The edge directions come from
+// the Q14 sine table, so a pixel whose centre lies on an edge ray may go either way; any other
+// difference is a failure.
+#include <Adafruit_ILI9341.h>
+#include "ArcGauge.h"
+#include "check.h"
+
+namespace {
+constexpr float START_DEG = 150.0f;
+
+void referenceArc(Adafruit_GFX& g, const ArcGauge::Geometry& d, int16_t r0, int16_t r1, uint16_t s0, uint16_t s1, uint16_t col) {
+  if (s1 < s0 || r1 < r0) return;
+  const float a0 = START_DEG + s0 * 0.5f, a1 = START_DEG + s1 * 0.5f;
+  const int32_t rin2 = static_cast<int32_t>(r0) * r0, rout2 = static_cast<int32_t>(r1) * r1;
+  for (int dy = -r1; dy <= r1; dy++) {
+    for (int dx = -r1; dx <= r1; dx++) {
+      const int32_t q = dx * dx + dy * dy;
+      if (q < rin2 || q > rout2) continue;
+      float deg = atan2f(static_cast<float>(dy), static_cast<float>(dx)) * (180.0f / PI);
+      if (deg < 0) deg += 360.0f;
+      if (deg < START_DEG) deg += 360.0f;
+      if (deg >= a0 && deg <= a1) g.drawPixel(d.cx + dx, d.cy + dy, col);
+    }
+  }
+}
+
+// Distance in pixels from (dx, dy) to the ray at sweep step s
+float offRay(int dx, int dy, uint16_t s) {
+  const float a = (START_DEG + s * 0.5f) * (PI / 180.0f);
+  const float ux = cosf(a), uy = sinf(a);
+  if (dx * ux + dy * uy < 0) return 1e9f;
+  return fabsf(ux * dy - uy * dx);
+}
+
+Adafruit_ILI9341 g_ref(0, 0), g_span(0, 0);
+uint32_t g_arcs = 0, g_pixels = 0, g_onEdge = 0;
+
+void compare(const ArcGauge::Geometry& d, int16_t r0, int16_t r1, uint16_t s0, uint16_t s1) {
+  g_ref.clearFrame();
+  g_span.clearFrame();
+  g_ref.resetCounters();
+  g_span.resetCounters();
+  referenceArc(g_ref, d, r0, r1, s0, s1, 1);
+  ArcGauge::fillArc(g_span, d, r0, r1, s0, s1, 1);
+  g_arcs++;
+  g_pixels += g_ref.pixels;
+  for (int16_t y = 0; y < g_ref.height(); y++) {
+    for (int16_t x = 0; x < g_ref.width(); x++) {
+      if (g_ref.pixel(x, y) == g_span.pixel(x, y)) continue;
+      const int dx = x - d.cx, dy = y - d.cy;
+      const float off = fminf(offRay(dx, dy, s0), offRay(dx, dy, s1));
+      if (off < 0.01f) {
+        g_onEdge++;
+        continue;
+      }
+      char what[96];
+      snprintf(what, sizeof(what), "r %d..%d steps %u..%u: pixel (%d,%d) %.3f px off the edges", r0, r1, s0, s1, dx, dy, off);
+      check::fail(__FILE__, __LINE__, what);
+      return;
+    }
+  }
+  // One window per run: never more than four runs a row
+  CHECK(g_span.windows <= 4u * (2 * r1 + 1));
+}
+}  // namespace
+
+int main() {
+  g_ref.setRotation(1);
+  g_span.setRotation(1);
+  const int16_t cells[][4] = {{0, 0, 106, 100}, {0, 0, 160, 120}, {0, 0, 160, 240}, {80, 0, 240, 240}};
+  for (const auto& c : cells) {
+    const ArcGauge::Geometry d = ArcGauge::geometryFor(c[0], c[1], c[2], c[3]);
+    compare(d, d.bandIn, d.r, 0, ArcGauge::SWEEP_STEPS);
+    // Warning zones as UiRenderer draws them, both orientations, empty and full ones included
+    for (uint16_t s1 = 0; s1 <= ArcGauge::SWEEP_STEPS; s1 += 37) {
+      for (uint16_t s2 = s1; s2 <= ArcGauge::SWEEP_STEPS; s2 += 53) {
+        compare(d, d.zoneIn, d.bandIn - 1, s1, s2);
+        compare(d, d.zoneIn, d.bandIn - 1, s2, ArcGauge::SWEEP_STEPS);
+        compare(d, d.zoneIn, d.bandIn - 1, 0, s1);
+      }
+    }
+    // Every edge direction once, across both half-sweep boundaries
+    for (uint16_t s = 0; s <= ArcGauge::SWEEP_STEPS; s++) {
+      compare(d, d.bandIn, d.r, 0, s);
+      compare(d, d.bandIn, d.r, s, ArcGauge::SWEEP_STEPS);
+    }
+    compare(d, 0, d.r, 120, 121);
+  }
+  printf("arc_gauge: %u arcs, %u reference pixels, %u on an edge ray\n", g_arcs, g_pixels, g_onEdge);
+  return checkResult("arc_gauge");
+}
@@ -0,0 +1,157 @@
+// The synthetic vehicle bus driven the way loop() drives it: install() as setup() calls it after
+// the controllers are up, then loop passes that drain CanBus::read() into the decoders and spend
+// a modelled amount of time on the rest of the loop. BusSim finds the pass boundaries, times
+// them and prints its [SIM] lines on its own; the loop has no other hook.
+#include <Arduino.h>
+#include <mcp2515.h>
+#include <string>
+#include "BusSim.h"
+#include "CanBus.h"
+#include "CanDecode.h"
+#include "Config.h"
+#include "HeapMon.h"
+#include "check.h"
+
+namespace {
+MCP2515 g_mcp0(5), g_mcp1(6);
+constexpr uint8_t INT0_PIN = 7, INT1_PIN = 8;
+constexpr uint32_t READ_US = 40;   // readMessage() plus the decoders, per frame
+
+// loop() as the sketch runs it: drainCan(), half the pass, drainCan() after the radio and web
+// stage, the other half, and on a display tick the render frame, with a drain before each widget
+struct LoopModel {
+  const char* name;
+  uint32_t passUs;     // everything besides the drains and the render
+  uint32_t renderUs;   // a display frame, every CFG::SCREEN_REFRESH_US
+  uint32_t widgetUs;   // one draw in it
+};
+constexpr uint32_t MAX_PASSES = BusSim::LEVEL_MS * 10;   // one level, at 100 ns a pass
+uint32_t g_drained = 0;   // frames the loop passes read, not yet counted to a finished level
+
+uint32_t drain() {
+  can_frame f;
+  uint8_t bus;
+  uint32_t n = 0;
+  while (CanBus::read(f, bus)) {
+    host::advanceUs(READ_US);
+    CanDec::decodeFrame(f, bus);
+    n++;
+  }
+  return n;
+}
+
+// One loop pass; returns the frames it drained
+uint32_t pass(const LoopModel& m, uint64_t* nextFrameUs) {
+  HeapMon::tick(millis());
+  uint32_t n = drain();
+  host::advanceUs(m.passUs / 2);
+  n += drain();
+  host::advanceUs(m.passUs - m.passUs / 2);
+  if (host::nowUs() >= *nextFrameUs) {
+    for (uint32_t us = 0; us < m.renderUs; us += m.widgetUs) {
+      n += drain();
+      host::advanceUs(m.widgetUs);
+    }
+    *nextFrameUs += CFG::SCREEN_REFRESH_US;
+  }
+  return n;
+}
+
+uint32_t countLines(const std::string& s, const char* tag) {
+  uint32_t n = 0;
+  for (size_t i = s.find(tag); i != std::string::npos; i = s.find(tag, i + 1)) {
+    n++;
+  }
+  return n;
+}
+
+// A level ends at the start of a pass, so the frames of that pass belong to the next one
+void runLevels(const LoopModel& m, BusSim::LevelResult* out) {
+  uint64_t nextFrameUs = host::nowUs();
+  for (uint8_t lv = 0; lv < BusSim::LEVEL_COUNT; lv++) {
+    const uint32_t done = BusSim::levelsDone();
+    uint32_t n = pass(m, &nextFrameUs);
+    uint32_t passes = 1;
+    while (BusSim::levelsDone() == done && passes < MAX_PASSES) {
+      g_drained += n;
+      n = pass(m, &nextFrameUs);
+      passes++;
+    }
+    CHECK(passes < MAX_PASSES);   // the level never ended: pass boundaries went unseen
+    out[lv] = BusSim::lastResult();
+    CHECK_EQ(out[lv].frames, g_drained);
+    g_drained = n;
+  }
+}
+}  // namespace
+
+int main() {
+  host::setMicros(1000000);
+  host::setHeap(180000, 110000);
+  g_mcp0.attachIntPin(INT0_PIN);
+  g_mcp1.attachIntPin(INT1_PIN);
+  CHECK(CanBus::begin(CFG::CAN_BUS_PT, g_mcp0, {5, INT0_PIN, CFG::CAN_SPEED_SEL, CFG::CAN_CLOCK_SEL, nullptr, 0}));
+  CHECK(CanBus::begin(CFG::CAN_BUS_BODY, g_mcp1, {6, INT1_PIN, CFG::CAN2_SPEED_SEL, CFG::CAN2_CLOCK_SEL,
+                                                   CFG::CAN2_ACCEPT, sizeof(CFG::CAN2_ACCEPT) / sizeof(CFG::CAN2_ACCEPT[0])}));
+  HeapMon::begin();
+  BusSim::install({{CanBus::bitsPerSecond(CFG::CAN_SPEED_SEL), CFG::CAN2_ENABLED ? CanBus::bitsPerSecond(CFG::CAN2_SPEED_SEL) : 0},
+                   BusSim::FAULT_MISSING | BusSim::FAULT_SHORT_DLC | BusSim::FAULT_BURST});
+  CHECK(BusSim::active());
+
+  // The real controllers are not read while the sim is installed
+  const can_frame stray = {0x7FF, 8, {0xEE}};
+  g_mcp0.inject(stray);
+
+  // A loop that keeps up: 300 us of everything else, a 2 ms render per display frame in 200 us widgets
+  const LoopModel lean = {"lean", 300, 2000, 200};
+  BusSim::LevelResult r[BusSim::LEVEL_COUNT];
+  host::serialOut().clear();
+  runLevels(lean, r);
+  const std::string log = host::serialOut();
+  CHECK_EQ(countLines(log, "[SIM] load="), BusSim::LEVEL_COUNT);
+  CHECK_EQ(countLines(log, "[SIM] loop us"), BusSim::LEVEL_COUNT);
+  for (uint8_t i = 0; i < BusSim::LEVEL_COUNT; i++) {
+    printf("bus_sim: %s load %u%%: wire %u%%, %u frames, %u dropped, loop p50 %u p99 %u max %u us\n", lean.name, r[i].loadPct,
+           r[i].measuredPct, r[i].frames, r[i].dropped, r[i].loopP50Us, r[i].loopP99Us, r[i].loopMaxUs);
+    CHECK_EQ(r[i].loadPct, BusSim::LEVELS[i]);
+    CHECK(r[i].measuredPct + 3 >= r[i].loadPct && r[i].measuredPct <= r[i].loadPct + 3);
+    CHECK(r[i].frames > 0);
+    CHECK_EQ(r[i].skippedMs, 0);
+    CHECK_EQ(r[i].minFreeHeap, 180000);
+    // The gap between drains is what the model spends between them: half the pass, or a widget
+    CHECK(r[i].loopP50Us >= lean.passUs / 2 && r[i].loopP50Us < lean.passUs / 2 + 400);
+    CHECK(r[i].loopMaxUs >= lean.widgetUs && r[i].loopMaxUs < lean.renderUs);
+    CHECK(r[i].loopP50Us <= r[i].loopP99Us && r[i].loopP99Us <= r[i].loopMaxUs);
+    if (r[i].loadPct <= 50) {
+      CHECK_EQ(r[i].dropped, 0);   // short frames and bursts included
+    }
+  }
+  CHECK(r[BusSim::LEVEL_COUNT - 1].frames > r[0].frames);
+  uint32_t total = g_drained;
+  for (const BusSim::LevelResult& x : r) {
+    total += x.frames;
+  }
+  CHECK_EQ(CanBus::stats(0).frames + CanBus::stats(1).frames, total);
+  CHECK_EQ(digitalRead(INT0_PIN), LOW);   // the stray frame is still in the real controller
+
+  // The decoders saw the vehicle: idle or driving, never garbage
+  CHECK(rpm >= 700 && rpm < 4000);
+  CHECK(speed_kmh >= 0 && speed_kmh < 110);
+  CHECK(coolantC > 20);
+
+  // A loop that stalls: one 30 ms draw every display frame, which no drain can split. Both RX
+  // buffers fill during it, and the losses grow with the load.
+  const LoopModel stall = {"stall", 300, 30000, 30000};
+  runLevels(stall, r);
+  for (uint8_t i = 0; i < BusSim::LEVEL_COUNT; i++) {
+    printf("bus_sim: %s load %u%%: %u frames, %u dropped, loop p50 %u max %u us\n", stall.name, r[i].loadPct, r[i].frames,
+           r[i].dropped, r[i].loopP50Us, r[i].loopMaxUs);
+    CHECK(r[i].dropped > 0);
+    CHECK(r[i].loopMaxUs >= stall.renderUs);
+    CHECK(r[i].loopP50Us <= r[i].loopMaxUs);
+    if (i) {
+      CHECK(r[i].dropped > r[i - 1].dropped);
+    }
+  }
+  return checkResult("bus_sim");
+}
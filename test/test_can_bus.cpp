@@ -0,0 +1,201 @@
+// Two controllers under full load: read() alternates between buses with frames waiting, every
+// frame comes back tagged with the bus it arrived on, a flooded bus does not cost the other one
+// frames, and overflows are counted. Then the accept-list split between the two RX buffers, the
+// lists that do not fit, which open the filters instead of losing IDs, and a set replaced at runtime.
+#include <Arduino.h>
+#include <mcp2515.h>
+#include <vector>
+#include "CanBus.h"
+#include "check.h"
+
+namespace {
+MCP2515 g_mcp0(5), g_mcp1(6);
+constexpr uint8_t INT0_PIN = 7, INT1_PIN = 8;
+constexpr uint32_t SPI_READ_US = 40;    // one readMessage() at 10 MHz, with the INT check
+
+constexpr uint32_t kMixed[] = {0x321, 0x322, 0x18FEF100u | CAN_EFF_FLAG, 0x18FEF200u | CAN_EFF_FLAG};
+constexpr uint32_t kThreeStd[] = {0x321, 0x322, 0x323, 0x18FEF100u | CAN_EFF_FLAG};
+constexpr uint32_t kSeven[] = {1, 2, 3, 4, 5, 6, 7};
+static_assert(CanBus::acceptFits(kMixed, 4), "2 standard + 2 extended fit");
+static_assert(!CanBus::acceptFits(kThreeStd, 4), "3 standard IDs do not fit RXB0 when mixed");
+static_assert(!CanBus::acceptFits(kSeven, 7), "six filters");
+static_assert(CanBus::acceptFits(kSeven, 6), "six standard IDs");
+
+can_frame frame(uint32_t id, uint32_t seq) {
+  can_frame f = {};
+  f.can_id = id;
+  f.can_dlc = 8;
+  memcpy(f.data, &seq, sizeof(seq));
+  return f;
+}
+uint32_t seqOf(const can_frame& f) {
+  uint32_t s;
+  memcpy(&s, f.data, sizeof(s));
+  return s;
+}
+
+struct Feed {
+  MCP2515& mcp;
+  uint32_t id;
+  uint32_t periodUs;
+  uint32_t nextUs;
+  uint32_t offered;
+};
+
+// Runs `us` of simulated time: frames arrive on each bus at its period, the loop reads one
+// frame per SPI_READ_US. Returns the bus of every frame read, in order.
+std::vector<uint8_t> run(Feed* feeds, uint8_t n, uint32_t us, std::vector<uint32_t>* lastSeq) {
+  std::vector<uint8_t> order;
+  uint32_t readyUs = 0;
+  for (uint32_t t = 0; t < us; t++) {
+    for (uint8_t i = 0; i < n; i++) {
+      if (t >= feeds[i].nextUs) {
+        feeds[i].mcp.inject(frame(feeds[i].id, feeds[i].offered++));
+        feeds[i].nextUs += feeds[i].periodUs;
+      }
+    }
+    host::advanceUs(1);
+    if (t < readyUs) continue;
+    can_frame f;
+    uint8_t bus;
+    if (CanBus::read(f, bus)) {
+      order.push_back(bus);
+      CHECK(bus < 2);
+      if (bus < 2) {
+        CHECK_EQ(f.can_id, feeds[bus].id);   // routed by controller, not by ID
+        CHECK(seqOf(f) > (*lastSeq)[bus] || (*lastSeq)[bus] == UINT32_MAX);
+        (*lastSeq)[bus] = seqOf(f);
+      }
+      readyUs = t + SPI_READ_US;
+    }
+  }
+  return order;
+}
+
+void drain() {
+  can_frame f;
+  uint8_t bus;
+  while (CanBus::read(f, bus)) {
+  }
+}
+
+void fullLoad() {
+  // Both buses faster than the reader: strict alternation, equal shares
+  Feed both[] = {{g_mcp0, 0x100, 30, 0, 0}, {g_mcp1, 0x200, 30, 0, 0}};
+  std::vector<uint32_t> last(2, UINT32_MAX);
+  std::vector<uint8_t> order = run(both, 2, 200000, &last);
+  uint32_t reads[2] = {};
+  uint32_t repeats = 0;
+  for (size_t i = 0; i < order.size(); i++) {
+    reads[order[i]]++;
+    repeats += i > 0 && order[i] == order[i - 1];
+  }
+  printf("can_bus: both saturated, %zu reads: bus0 %u bus1 %u, %u back-to-back on one bus\n", order.size(), reads[0], reads[1], repeats);
+  CHECK(order.size() > 4000);
+  CHECK(reads[0] - reads[1] + 1 <= 2);
+  CHECK_EQ(repeats, 0);
+  CHECK(g_mcp0.overflows > 0 && g_mcp1.overflows > 0);
+  CHECK(CanBus::stats(0).overflows > 0 && CanBus::stats(1).overflows > 0);
+  CHECK_EQ(CanBus::stats(0).frames + CanBus::stats(1).frames, order.size());
+  drain();
+
+  // Bus 0 flooded, bus 1 at a rate the reader can follow: bus 1 loses nothing
+  const uint32_t lost1 = g_mcp1.overflows;
+  Feed flood[] = {{g_mcp0, 0x101, 20, 0, 0}, {g_mcp1, 0x201, 250, 0, 0}};
+  std::vector<uint32_t> last2(2, UINT32_MAX);
+  order = run(flood, 2, 200000, &last2);
+  drain();
+  uint32_t got1 = 0;
+  for (uint8_t b : order) got1 += b == 1;
+  printf("can_bus: bus0 flooded, bus1 %u of %u frames read, %u lost\n", got1, flood[1].offered, g_mcp1.overflows - lost1);
+  CHECK_EQ(g_mcp1.overflows, lost1);
+  CHECK(got1 + 1 >= flood[1].offered);
+}
+
+void mixedSplit() {
+  CHECK(CanBus::setFilters(1, kMixed, 4));
+  CHECK_EQ(g_mcp1.mask(0).ext, false);
+  CHECK_EQ(g_mcp1.mask(1).ext, true);
+  CHECK_EQ(g_mcp1.filter(0).sid, 0x321);
+  CHECK_EQ(g_mcp1.filter(1).sid, 0x322);
+  for (uint8_t i = 2; i < 6; i++) {
+    CHECK(g_mcp1.filter(i).ext);
+  }
+  CHECK(g_mcp1.inject(frame(0x321, 0)) == MCP2515::OFFER_RXB0);
+  CHECK(g_mcp1.inject(frame(0x18FEF200u | CAN_EFF_FLAG, 0)) == MCP2515::OFFER_RXB1);
+  drain();
+  CHECK(g_mcp1.inject(frame(0x323, 0)) == MCP2515::OFFER_FILTERED);
+  CHECK(g_mcp1.inject(frame(0x18FEF300u | CAN_EFF_FLAG, 0)) == MCP2515::OFFER_FILTERED);
+  CHECK(g_mcp1.mode() == MCP2515::MODE_NORMAL);
+
+  // Three standard IDs in a mixed list, or seven IDs: refused, filters open, counted
+  const uint32_t rejects = CanBus::stats(1).filterRejects;
+  CHECK(!CanBus::setFilters(1, kThreeStd, 4));
+  CHECK(g_mcp1.inject(frame(0x323, 0)) == MCP2515::OFFER_RXB0);
+  CHECK(g_mcp1.inject(frame(0x7FF, 0)) == MCP2515::OFFER_RXB1);
+  drain();
+  CHECK(!CanBus::setFilters(1, kSeven, 7));
+  CHECK(g_mcp1.inject(frame(0x18FEF300u | CAN_EFF_FLAG, 0)) != MCP2515::OFFER_FILTERED);
+  drain();
+  CHECK_EQ(CanBus::stats(1).filterRejects - rejects, 2);
+  CHECK(g_mcp1.mode() == MCP2515::MODE_NORMAL);
+
+  CHECK(CanBus::setFilters(1, nullptr, 0));
+  CHECK(g_mcp1.inject(frame(0x18FEF300u | CAN_EFF_FLAG, 0)) != MCP2515::OFFER_FILTERED);
+  drain();
+}
+
+// A configured set replaced at runtime: restoreFilters() applies it, and accepts() answers for
+// whatever is in the filters, open or not
+void runtimeAccept() {
+  static const uint32_t kBody[] = {0x401, 0x18FEF100u | CAN_EFF_FLAG, 0x5A0};
+  CanBus::setAccept(1, kBody, 3);
+  CHECK(CanBus::accepts(1, 0x402));   // not applied yet
+  CanBus::restoreFilters(1);
+  CHECK(CanBus::accepts(1, 0x401));
+  CHECK(CanBus::accepts(1, 0x5A0));
+  CHECK(CanBus::accepts(1, 0x18FEF100u | CAN_EFF_FLAG));
+  CHECK(!CanBus::accepts(1, 0x402));
+  CHECK(!CanBus::accepts(1, 0x401 | CAN_EFF_FLAG));
+  CHECK(g_mcp1.inject(frame(0x5A0, 0)) != MCP2515::OFFER_FILTERED);
+  drain();
+  CHECK(g_mcp1.inject(frame(0x402, 0)) == MCP2515::OFFER_FILTERED);
+
+  // Opened for a capture, then back to the set
+  CHECK(CanBus::setFilters(1, nullptr, 0));
+  CHECK(CanBus::accepts(1, 0x402));
+  CanBus::restoreFilters(1);
+  CHECK(!CanBus::accepts(1, 0x402));
+  CHECK(CanBus::accepts(0, 0x402));   // bus 0 was never narrowed
+
+  // A set that outgrows the filters leaves them open, counted on every restore
+  const uint32_t rejects = CanBus::stats(1).filterRejects;
+  CanBus::setAccept(1, kSeven, 7);
+  CanBus::restoreFilters(1);
+  CHECK(CanBus::accepts(1, 0x402));
+  CHECK(g_mcp1.inject(frame(0x402, 0)) != MCP2515::OFFER_FILTERED);
+  drain();
+  CHECK_EQ(CanBus::stats(1).filterRejects - rejects, 1);
+  CanBus::setAccept(1, nullptr, 0);
+  CanBus::restoreFilters(1);
+}
+}  // namespace
+
+int main() {
+  host::setMicros(1000000);
+  g_mcp0.attachIntPin(INT0_PIN);
+  g_mcp1.attachIntPin(INT1_PIN);
+  CHECK(CanBus::begin(0, g_mcp0, {5, INT0_PIN, CAN_500KBPS, MCP_16MHZ, nullptr, 0}));
+  // A configured list that does not fit still brings the bus up, open
+  CHECK(CanBus::begin(1, g_mcp1, {6, INT1_PIN, CAN_250KBPS, MCP_16MHZ, kThreeStd, 4}));
+  CHECK_EQ(CanBus::stats(1).filterRejects, 1);
+  CHECK_EQ(CanBus::count(), 2);
+  CanBus::restoreFilters(1);
+  CHECK_EQ(CanBus::stats(1).filterRejects, 2);
+  CHECK(CanBus::setFilters(1, nullptr, 0));
+
+  fullLoad();
+  mixedSplit();
+  runtimeAccept();
+  return checkResult("can_bus");
+}
@@ -0,0 +1,155 @@
+// CAN transmit queue against the MCP2515 model: one TX buffer per priority class and the
+// controller's own send order, the 50 ms abort with 10/20/40 ms back-off, the failure event
+// after MAX_ATTEMPTS, and the per-ID rate limit holding a frame without blocking its class.
+#include <Arduino.h>
+#include <mcp2515.h>
+#include <vector>
+#include "CanTx.h"
+#include "McpRegs.h"
+#include "check.h"
+
+namespace {
+constexpr uint8_t CS = 5;
+MCP2515 g_mcp(CS);
+
+can_frame frame(uint32_t id) {
+  can_frame f = {};
+  f.can_id = id;
+  f.can_dlc = 2;
+  f.data[0] = static_cast<uint8_t>(id);
+  return f;
+}
+
+void tick(uint32_t ms = 1) {
+  host::advanceMs(ms);
+  CanTx::service(millis());
+}
+
+std::vector<CanTx::Event> drainEvents() {
+  std::vector<CanTx::Event> out;
+  CanTx::Event e;
+  while (CanTx::pollEvent(e)) {
+    out.push_back(e);
+  }
+  return out;
+}
+
+void priorityOrder() {
+  g_mcp.sent.clear();
+  CanTx::send(frame(0x300), CanTx::PRIO_LOW, 1);
+  CanTx::send(frame(0x200), CanTx::PRIO_NORMAL, 2);
+  CanTx::send(frame(0x101), CanTx::PRIO_HIGH, 3);
+  CanTx::send(frame(0x102), CanTx::PRIO_HIGH, 4);
+  tick();
+  // One frame per class in its own buffer; the second high frame waits for TXB2
+  CHECK(g_mcp.txPending(0) && g_mcp.txPending(1) && g_mcp.txPending(2));
+  CHECK_EQ(CanTx::depth(), 4);
+  while (g_mcp.transmitNext() >= 0) {
+    tick();
+  }
+  const uint32_t want[] = {0x101, 0x102, 0x200, 0x300};
+  CHECK_EQ(g_mcp.sent.size(), 4);
+  for (size_t i = 0; i < g_mcp.sent.size() && i < 4; i++) {
+    CHECK_EQ(g_mcp.sent[i].f.can_id, want[i]);
+    CHECK_EQ(g_mcp.sent[i].buffer, g_mcp.sent[i].f.can_id < 0x200 ? 2 : (g_mcp.sent[i].f.can_id < 0x300 ? 1 : 0));
+  }
+  const std::vector<CanTx::Event> ev = drainEvents();
+  CHECK_EQ(ev.size(), 4);
+  for (const CanTx::Event& e : ev) {
+    CHECK(e.kind == CanTx::EV_SENT);
+    CHECK_EQ(e.attempts, 1);
+  }
+  CHECK_EQ(CanTx::depth(), 0);
+}
+
+// Nobody acknowledges: every attempt sits with TXREQ set until the timeout aborts it
+void abortAndBackoff() {
+  g_mcp.setAck(false);
+  g_mcp.sent.clear();
+  const uint32_t abortsBefore = g_mcp.aborts;
+  const uint32_t retriesBefore = CanTx::stats().retries;
+  CanTx::send(frame(0x7E0), CanTx::PRIO_NORMAL, 42);
+  std::vector<uint32_t> loadedAt, abortedAt;
+  const uint32_t t0 = millis() + 1;
+  bool pending = false;
+  uint32_t aborts = g_mcp.aborts;
+  for (uint32_t i = 0; i < 400; i++) {
+    tick();
+    if (g_mcp.txPending(1) && !pending) {
+      loadedAt.push_back(millis() - t0);
+      g_mcp.transmitNext();   // on the wire, no ACK: TXERR, TXREQ stays set
+    }
+    pending = g_mcp.txPending(1);
+    if (g_mcp.aborts != aborts) {
+      abortedAt.push_back(millis() - t0);
+      aborts = g_mcp.aborts;
+      CHECK(g_mcp.reg(MCP2515::txbCtrlReg(1)) & MCP2515::TXB_ABTF);
+    }
+  }
+  CHECK_EQ(loadedAt.size(), CanTx::MAX_ATTEMPTS);
+  CHECK_EQ(abortedAt.size(), CanTx::MAX_ATTEMPTS);
+  CHECK_EQ(g_mcp.aborts - abortsBefore, CanTx::MAX_ATTEMPTS);
+  // Loaded at 0; aborted 50 ms after each load; reloaded 10, 20, 40 ms after each abort
+  const uint32_t backoff[] = {10, 20, 40};
+  for (size_t i = 0; i < abortedAt.size() && i < loadedAt.size(); i++) {
+    CHECK_EQ(abortedAt[i] - loadedAt[i], CanTx::TX_TIMEOUT_MS);
+    if (i + 1 < loadedAt.size()) {
+      CHECK_EQ(loadedAt[i + 1] - abortedAt[i], backoff[i]);
+    }
+  }
+  CHECK_EQ(CanTx::stats().retries - retriesBefore, CanTx::MAX_ATTEMPTS - 1);
+
+  const std::vector<CanTx::Event> ev = drainEvents();
+  CHECK_EQ(ev.size(), 1);
+  if (!ev.empty()) {
+    CHECK(ev[0].kind == CanTx::EV_FAILED);
+    CHECK_EQ(ev[0].tag, 42);
+    CHECK_EQ(ev[0].id, 0x7E0);
+    CHECK_EQ(ev[0].attempts, CanTx::MAX_ATTEMPTS);
+    CHECK(ev[0].ctrl & McpRegs::TXB_ABTF);
+    CHECK(ev[0].ctrl & McpRegs::TXB_TXERR);
+  }
+  CHECK_EQ(CanTx::stats().failed, 1);
+  CHECK_EQ(CanTx::depth(), 0);
+  g_mcp.setAck(true);
+}
+
+// 0x123 may go every 100 ms: the second copy waits in the queue, 0x124 behind it does not
+void rateLimit() {
+  CHECK(CanTx::setRateLimit(0x123, 100));
+  g_mcp.sent.clear();
+  const uint32_t heldBefore = CanTx::stats().rateHeld;
+  CanTx::send(frame(0x123), CanTx::PRIO_NORMAL, 1);
+  CanTx::send(frame(0x123), CanTx::PRIO_NORMAL, 2);
+  CanTx::send(frame(0x124), CanTx::PRIO_NORMAL, 3);
+  const uint32_t t0 = millis() + 1;
+  for (uint32_t i = 0; i < 150; i++) {
+    tick();
+    g_mcp.transmitNext();
+  }
+  CHECK_EQ(g_mcp.sent.size(), 3);
+  if (g_mcp.sent.size() == 3) {
+    CHECK_EQ(g_mcp.sent[0].f.can_id, 0x123);
+    CHECK_EQ(g_mcp.sent[1].f.can_id, 0x124);
+    CHECK_EQ(g_mcp.sent[2].f.can_id, 0x123);
+    CHECK_EQ(g_mcp.sent[0].us / 1000 - t0, 0);
+    CHECK_EQ(g_mcp.sent[2].us / 1000 - t0, 100);
+  }
+  CHECK(CanTx::stats().rateHeld > heldBefore);
+  drainEvents();
+  CHECK(CanTx::setRateLimit(0x123, 0));
+}
+}  // namespace
+
+int main() {
+  host::setMicros(10000000);
+  g_mcp.reset();
+  g_mcp.setBitrate(CAN_500KBPS);
+  g_mcp.setNormalMode();
+  CanTx::begin(g_mcp, CS);
+
+  priorityOrder();
+  abortAndBackoff();
+  rateLimit();
+  return checkResult("can_tx");
+}
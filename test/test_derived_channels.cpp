@@ -0,0 +1,81 @@
+// Derived channel compiler: results against hand-computed values, and the limits that keep a
+// stored expression from overrunning the stack or the compiler's recursion.
+#include <Arduino.h>
+#include "DerivedChannels.h"
+#include "ValueConversion.h"
+#include "check.h"
+
+namespace {
+float g_in[CH__COUNT];
+
+DerivedChannelDef def(const char* expr) {
+  DerivedChannelDef d = {};
+  d.enabled = 1;
+  strncpy(d.expr, expr, DERIVED_EXPR_LEN);
+  return d;
+}
+
+// Compiles expr into CH_CALC1; returns its value after one update
+float eval(const char* expr) {
+  const DerivedChannelDef d = def(expr);
+  Derived::configure(&d, 1);
+  Derived::update();
+  return Derived::value(0);
+}
+
+std::string nested(const char* open, const char* close, int levels) {
+  std::string s;
+  for (int i = 0; i < levels; i++) {
+    s += open;
+  }
+  s += "rpm";
+  for (int i = 0; i < levels; i++) {
+    s += close;
+  }
+  return s;
+}
+}  // namespace
+
+float valueRawBase(Channel ch) { return ch < CH__COUNT ? g_in[ch] : NAN; }
+
+int main() {
+  for (float& v : g_in) {
+    v = NAN;
+  }
+  g_in[CH_RPM] = 2000;
+  g_in[CH_TORQUE] = 300;
+  g_in[CH_EGT1] = 540;
+  g_in[CH_EGT2] = 610;
+
+  CHECK_NEAR(eval("torque * rpm / 9549"), 300.0 * 2000 / 9549, 1e-3);
+  CHECK_NEAR(eval("egt1 - egt2"), -70, 1e-4);
+  CHECK_NEAR(eval("max(egt1, egt2) - min(egt1, egt2)"), 70, 1e-4);
+  CHECK_NEAR(eval("-(rpm - 2 * 1000) + sqrt(abs(-16))"), 4, 1e-4);
+  CHECK(isnan(eval("rpm / (torque - 300)")));
+  CHECK(isnan(eval("oil")));   // no reading yet
+
+  // MAX_NEST levels compile; one more is refused before the recursion goes further
+  const std::string parens = nested("(", ")", Derived::MAX_NEST);
+  CHECK_NEAR(eval(parens.c_str()), 2000, 0);
+  CHECK(Derived::enabled(0));
+  const std::string tooDeep = nested("(", ")", Derived::MAX_NEST + 1);
+  eval(tooDeep.c_str());
+  CHECK(!Derived::enabled(0));
+  CHECK(strncmp(Derived::error(0), "too deep", 8) == 0);
+
+  CHECK_NEAR(eval(nested("-", "", Derived::MAX_NEST).c_str()), 2000, 0);
+  eval(nested("-", "", Derived::MAX_NEST + 1).c_str());
+  CHECK(strncmp(Derived::error(0), "too deep", 8) == 0);
+
+  eval(nested("abs(", ")", Derived::MAX_NEST + 1).c_str());
+  CHECK(strncmp(Derived::error(0), "too deep", 8) == 0);
+
+  // A full-length expression of nothing but brackets stops at the limit, not at the end
+  eval(std::string(DERIVED_EXPR_LEN, '(').c_str());
+  CHECK(strncmp(Derived::error(0), "too deep", 8) == 0);
+
+  // Operand stack: nine pending operands do not fit in MAX_STACK
+  eval("1+(2+(3+(4+(5+(6+(7+(8+rpm)))))))");
+  CHECK(strncmp(Derived::error(0), "too deep", 8) == 0);
+  return checkResult("derived_channels");
+}
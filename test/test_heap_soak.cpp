@@ -0,0 +1,251 @@
+// Heap soak: the whole sketch, setup() and loop() as they are, through hours of simulated driving
+// from BusSim. host/Heap.cpp carves every allocation from a simulated 180 KB heap and, built with
+// CONFIG_HEAP_USE_HOOKS, reports each malloc to HeapMon (Arduino String included, not just
+// operator new); HEAP_ABORT_ON_ALLOC aborts on the first allocation in a pass that is not exempt.
+// Victron adverts for the three configured devices go to VictronScanCallbacks::onResult from
+// ordinary passes. Every WEB_EVERY_MS the config page is opened: a form with markup in a gauge
+// label is posted to handleWebConfigSave(), "/" is served (HtmlOut escaping it), and it is closed.
+// Those passes are exempt, but every visit must leave the heap as the first one did: same free
+// bytes, same largest block. The run ends with the heap low-water mark and the smallest largest
+// block. First the counting and the abort themselves: an exempt pass may allocate, a normal one dies.
+#include <NimBLEDevice.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Xiao_Dash_V1_211.ino"
+#include "check.h"
+
+static_assert(DEBUG_HEAP && HEAP_ABORT_ON_ALLOC, "built with -DDEBUG_HEAP=1 -DHEAP_ABORT_ON_ALLOC=1");
+#if !defined(CONFIG_HEAP_USE_HOOKS)
+#error "built with -DCONFIG_HEAP_USE_HOOKS so malloc itself is counted"
+#endif
+
+namespace {
+constexpr uint32_t SOAK_HOURS = 2;
+constexpr uint32_t HEAP_BYTES = 180000;
+constexpr uint32_t PASS_US = 500;             // a device pass besides the drawing; the mock display takes none
+constexpr uint32_t ADVERT_EVERY_MS = 100;     // one device in turn, each at its ~300 ms period
+constexpr uint32_t WEB_EVERY_MS = 600000;
+constexpr uint32_t WEB_OPEN_MS = 3000;
+constexpr size_t SERIAL_RESERVE = 1 << 20;
+constexpr size_t PAGE_RESERVE = 256 << 10;
+
+int* volatile g_sink;   // keeps the test allocations from being elided
+
+void counting() {
+  const HeapMon::Stats before = HeapMon::stats();
+  host::advanceMs(1);
+  HeapMon::tick(millis());
+  HeapMon::exemptPass();
+  g_sink = new int(1);
+  delete g_sink;
+  HeapMon::tick(millis());
+  CHECK_EQ(HeapMon::stats().exemptPasses - before.exemptPasses, 1);
+  CHECK_EQ(HeapMon::stats().allocPasses, before.allocPasses);
+
+  fflush(stdout);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    char* s = static_cast<char*>(malloc(16));   // a normal pass, and plain malloc: abort() here
+    g_sink = reinterpret_cast<int*>(s);
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+  HeapMon::tick(millis());
+}
+
+// ---- Victron: one instant-readout record per device, the AES mock passing the payload through ----
+
+struct Advertiser {
+  const char* mac;
+  const uint8_t* key;
+  uint8_t record;
+  uint8_t plain[16];
+  NimBLEAdvertisedDevice dev;
+};
+
+// 12.80 V from the BMV, 100 W from the MPPT, 13.12 V out of the Orion; every other field n/a
+Advertiser g_adv[] = {
+  {VictronBle::kBmvMac, persist.victronBmvKey, 0x02, {0xFF, 0xFF, 0x00, 0x05, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, {}},
+  {VictronBle::kMpptMac, persist.victronMpptKey, 0x01, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x64, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, {}},
+  {VictronBle::kOrionMac, persist.victronOrionKey, 0x0F, {0xFF, 0xFF, 0x20, 0x05, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, {}},
+};
+constexpr uint8_t ADVERTISERS = sizeof(g_adv) / sizeof(g_adv[0]);
+
+// Built before the first tick, so the payload vectors exist before the loop is watched
+void buildAdverts() {
+  for (Advertiser& a : g_adv) {
+    uint8_t addr[6];
+    for (int i = 0; i < 6; i++) {
+      addr[5 - i] = static_cast<uint8_t>(strtoul(a.mac + 3 * i, nullptr, 16));   // NimBLE keeps it LSB first
+    }
+    a.dev.setAddress(NimBLEAddress(addr));
+    const uint8_t head[] = {0x02, 0x01, 0x06, 27, 0xFF, 0xE1, 0x02, 0x10, 0xA0, 0x89, 0x00, a.record, 0x12, 0x34, a.key[0]};
+    uint8_t p[sizeof(head) + 16];
+    memcpy(p, head, sizeof(head));
+    memcpy(p + sizeof(head), a.plain, 16);
+    a.dev.setPayload(p, sizeof(p));
+  }
+}
+
+// ---- Config page ----
+
+const char* const kForm[][2] = {
+  {"victronEnabled", "1"},
+  {"bmvMac", "E2-0E-AB-C7-49-5B"},
+  {"bmvKey", "a5 85 12 40 7b 4c 5c 4a d1 fa fb 30 6e 05 69 12"},
+  {"uc0_id", "600"},
+  {"uc0_en", "1"},
+  {"uc0_bus", "0"},
+  {"uc0_label", "<a&b>"},
+  {"uc0_unit", "\"q\""},
+  {"uc0_from", "0"},
+  {"uc0_to", "7"},
+  {"uc0_scale", "1"},
+  {"uc0_max", "255"},
+  {"uc1_id", "5A0"},   // on the body bus: its filters must let it through
+  {"uc1_en", "1"},
+  {"uc1_bus", "1"},
+  {"dc0_expr", "rpm / 1000"},
+  {"dc0_en", "1"},
+  {"dc0_label", "kRPM"},
+  {"tpl_s0", "1"},
+};
+constexpr size_t FORM_ARGS = sizeof(kForm) / sizeof(kForm[0]);
+WebServer::Arg* g_form = nullptr;
+
+struct Visit {
+  size_t pageBytes;
+  bool escaped;
+  uint32_t freeAfter;
+  uint32_t largestAfter;
+};
+
+void settle(uint32_t ms);
+
+// POST /save, then GET / to see the saved form, the way a phone on the AP would
+Visit visitConfigPage() {
+  Visit v = {};
+  enterWifiPage();
+  settle(WEB_OPEN_MS / 3);
+  webServer.hostRequest("/save", g_form, FORM_ARGS);
+  settle(WEB_OPEN_MS / 3);
+  webServer.hostRequest("/", nullptr, 0);
+  settle(WEB_OPEN_MS / 3);
+  v.pageBytes = webServer.body.size();
+  v.escaped = webServer.body.find("&lt;a&amp;b&gt;") != std::string::npos
+              && webServer.body.find("<a&b>") == std::string::npos;
+  exitWifiPage();
+  settle(1000);
+  v.freeAfter = ESP.getFreeHeap();
+  v.largestAfter = ESP.getMaxAllocHeap();
+  return v;
+}
+
+// ---- passes ----
+
+uint8_t g_nextAdvert = 0;
+uint64_t g_nextAdvertUs = 0;
+
+void pass() {
+  loop();
+  host::advanceUs(PASS_US);
+  if (host::nowUs() >= g_nextAdvertUs) {
+    NimBLEScanCallbacks* cb = NimBLEDevice::getScan()->callbacks();
+    if (cb) {
+      cb->onResult(&g_adv[g_nextAdvert].dev);
+    }
+    g_nextAdvert = (g_nextAdvert + 1) % ADVERTISERS;
+    g_nextAdvertUs += ADVERT_EVERY_MS * 1000ull;
+  }
+  // The capture must not grow mid-pass; clear() keeps its capacity
+  if (host::serialOut().size() > SERIAL_RESERVE / 2) {
+    host::serialOut().clear();
+  }
+}
+
+void settle(uint32_t ms) {
+  const uint64_t endUs = host::nowUs() + ms * 1000ull;
+  while (host::nowUs() < endUs) {
+    pass();
+  }
+}
+}  // namespace
+
+int main() {
+  host::setMicros(1000000);
+  host::serialOut().reserve(SERIAL_RESERVE);
+  webServer.body.reserve(PAGE_RESERVE);   // the response leaves through the socket on the device
+  g_form = new WebServer::Arg[FORM_ARGS];   // host scaffolding, outside the simulated heap
+  for (size_t i = 0; i < FORM_ARGS; i++) {
+    g_form[i] = {kForm[i][0], kForm[i][1]};
+  }
+
+  // Setup: everything from here on is on the device heap, and may allocate until the first tick
+  host::trackHeap(HEAP_BYTES);
+  setup();
+  BusSim::install({{CanBus::bitsPerSecond(CFG::CAN_SPEED_SEL), CFG::CAN2_ENABLED ? CanBus::bitsPerSecond(CFG::CAN2_SPEED_SEL) : 0},
+                   BusSim::FAULT_MISSING | BusSim::FAULT_SHORT_DLC | BusSim::FAULT_BURST});
+  if (!victronReady()) {
+    victronInit();   // the boot task's work; host tasks never run
+  }
+  persist.victronEnabled = 1;
+  buildAdverts();
+  g_nextAdvertUs = host::nowUs();
+  const uint32_t setupFree = ESP.getFreeHeap();
+
+  counting();
+
+  const HeapMon::Stats before = HeapMon::stats();
+  const VictronScanStats advertsBefore = victronScanStats();
+  Visit first = {};
+  uint32_t visits = 0, unstable = 0, unescaped = 0;
+  const uint64_t endUs = host::nowUs() + SOAK_HOURS * 3600ull * 1000000;
+  uint64_t nextWebUs = host::nowUs() + WEB_EVERY_MS * 1000ull;
+  while (host::nowUs() < endUs) {
+    pass();
+    if (host::nowUs() >= nextWebUs) {
+      const Visit v = visitConfigPage();
+      if (!visits) {
+        first = v;
+      } else if (v.freeAfter != first.freeAfter || v.largestAfter != first.largestAfter) {
+        unstable++;
+      }
+      if (!v.escaped || v.pageBytes < 10000) {
+        unescaped++;
+      }
+      visits++;
+      nextWebUs += WEB_EVERY_MS * 1000ull;
+    }
+  }
+  HeapMon::tick(millis());
+  HeapMon::exemptPass();   // stdio allocates its buffer on the first printf
+
+  const HeapMon::Stats& hs = HeapMon::stats();
+  const uint32_t passes = hs.passes - before.passes;
+  const uint32_t adverts = victronScanStats().adverts - advertsBefore.adverts;
+  printf("heap_soak: %u h simulated, %u loop passes, %u frames read, %u adverts, %u page visits, %u allocating passes\n",
+         SOAK_HOURS, passes, CanBus::stats(0).frames + CanBus::stats(1).frames, adverts, visits,
+         hs.allocPasses - before.allocPasses);
+  printf("heap_soak: heap %u B, %u free after setup, %u after a page visit; free min %u, largest block min %u\n",
+         HEAP_BYTES, setupFree, first.freeAfter, ESP.getMinFreeHeap(), hs.minLargestBlock);
+  CHECK(passes > SOAK_HOURS * 3600 * 100);
+  CHECK_EQ(hs.allocPasses, before.allocPasses);
+  CHECK_EQ(hs.allocs, before.allocs);
+  CHECK(adverts >= SOAK_HOURS * 3600 * (1000 / ADVERT_EVERY_MS) * 9 / 10);
+  CHECK_NEAR(victronReadings().battV2, 12.80, 0.01);
+  CHECK_NEAR(victronReadings().pvWatts, 100, 0.01);
+  CHECK_NEAR(victronReadings().dcdcOutV, 13.12, 0.01);
+  CHECK_EQ(visits, SOAK_HOURS * 3600000 / WEB_EVERY_MS);
+  CHECK_EQ(unescaped, 0);
+  CHECK_EQ(unstable, 0);
+  CHECK(strcmp(persist.userChannels[0].label, "<a&b>") == 0);
+  CHECK(CanBus::accepts(CFG::CAN_BUS_BODY, 0x5A0));
+  CHECK(!CanBus::accepts(CFG::CAN_BUS_BODY, 0x5A1));
+  CHECK(ESP.getMinFreeHeap() > 0 && ESP.getMinFreeHeap() <= first.freeAfter);
+  CHECK(hs.minLargestBlock > 0);
+  CHECK(Trip::distanceKm(Trip::LIFETIME) > 0);
+  return checkResult("heap_soak");
+}
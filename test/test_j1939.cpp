@@ -0,0 +1,273 @@
+// J1939 decoder: identifier split and build for PDU1 and PDU2, the EEC1 / IC1 / ET1 scaling with
+// the not-available range left alone, BAM and RTS/CTS reassembly (out of order, duplicated
+// packets, the T1 timeout, an abort from the receiver), and the DM1 generation moving only when
+// an ECU's DTC list really changes.
+#include <Arduino.h>
+#include <mcp2515.h>
+#include <initializer_list>
+#include "CanDecode.h"
+#include "J1939.h"
+#include "check.h"
+
+namespace {
+unsigned long g_now = 1000;
+
+can_frame frame(uint32_t id, std::initializer_list<uint8_t> bytes) {
+  can_frame f = {};
+  f.can_id = id;
+  f.can_dlc = 8;
+  memset(f.data, 0xFF, sizeof(f.data));
+  uint8_t i = 0;
+  for (uint8_t b : bytes) {
+    f.data[i++] = b;
+  }
+  return f;
+}
+
+void send(uint32_t id, std::initializer_list<uint8_t> bytes, unsigned long afterMs = 10) {
+  g_now += afterMs;
+  J1939::onFrame(frame(id, bytes), g_now);
+}
+
+// SPN conversion method 4: SPN low 16 bits, then the top 3 bits over the FMI, then CM/OC
+void putDtc(uint8_t* p, uint32_t spn, uint8_t fmi, uint8_t oc) {
+  p[0] = spn & 0xFF;
+  p[1] = (spn >> 8) & 0xFF;
+  p[2] = static_cast<uint8_t>(((spn >> 11) & 0xE0) | (fmi & 0x1F));
+  p[3] = oc & 0x7F;
+}
+
+// TP.DT packet seq of msg, padded with 0xFF past the end
+void sendPacket(uint8_t sa, uint8_t da, const uint8_t* msg, uint16_t size, uint8_t seq, unsigned long afterMs = 10) {
+  can_frame f = frame(J1939::makeId(7, J1939::PGN_TP_DT, sa, da), {seq});
+  const uint16_t at = (seq - 1) * 7;
+  for (uint16_t i = 0; i < 7 && at + i < size; i++) {
+    f.data[1 + i] = msg[at + i];
+  }
+  g_now += afterMs;
+  J1939::onFrame(f, g_now);
+}
+
+bool hasDtc(uint32_t spn, uint8_t fmi, uint8_t oc, uint8_t sa) {
+  J1939::Dtc d;
+  for (uint8_t i = 0; J1939::dtc(i, g_now, d); i++) {
+    if (d.spn == spn && d.fmi == fmi && d.oc == oc && d.sa == sa) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void identifiers() {
+  // EEC1 from engine #1, as it appears on the wire: 0x0CF00400
+  CHECK_EQ(J1939::makeId(3, J1939::PGN_EEC1, 0x00), 0x0CF00400u | CAN_EFF_FLAG);
+  J1939::Id id = J1939::parse(0x0CF00400u | CAN_EFF_FLAG);
+  CHECK_EQ(id.prio, 3);
+  CHECK_EQ(id.pgn, J1939::PGN_EEC1);
+  CHECK_EQ(id.sa, 0x00);
+  CHECK_EQ(id.da, J1939::ADDR_GLOBAL);
+
+  // PDU2 with the data page bit: the PS byte stays in the PGN
+  id = J1939::parse(0x19FECA3D);
+  CHECK_EQ(id.prio, 6);
+  CHECK_EQ(id.pgn, 0x1FECAu);
+  CHECK_EQ(id.sa, 0x3D);
+  CHECK_EQ(id.da, J1939::ADDR_GLOBAL);
+
+  // PDU1: the PS byte is the destination and the PGN's low byte is zero
+  CHECK_EQ(J1939::makeId(7, J1939::PGN_TP_CM, 0x00, 0xF9), 0x1CECF900u | CAN_EFF_FLAG);
+  id = J1939::parse(0x1CECF900u | CAN_EFF_FLAG);
+  CHECK_EQ(id.prio, 7);
+  CHECK_EQ(id.pgn, J1939::PGN_TP_CM);
+  CHECK_EQ(id.sa, 0x00);
+  CHECK_EQ(id.da, 0xF9);
+  // A PDU1 PGN handed in with a low byte: the destination replaces it
+  const uint32_t raw = J1939::makeId(6, 0xEF12, 0x10, 0x20);
+  CHECK_EQ(raw, 0x18EF2010u | CAN_EFF_FLAG);
+  id = J1939::parse(raw);
+  CHECK_EQ(id.pgn, 0xEF00u);
+  CHECK_EQ(id.da, 0x20);
+  CHECK_EQ(id.sa, 0x10);
+}
+
+void parameters() {
+  const uint32_t decoded = J1939::stats().decoded;
+  const uint32_t eec1 = J1939::makeId(3, J1939::PGN_EEC1, 0x00);
+  send(eec1, {0xF0, 0x7D, 0x7D, 0x20, 0x4E});
+  CHECK_NEAR(rpm, 2500, 0.01);                    // 0x4E20 * 0.125
+  send(eec1, {0xF0, 0x7D, 0x7D, 0xFF, 0xFF});     // not available
+  CHECK_NEAR(rpm, 2500, 0.01);
+  send(eec1, {0xF0, 0x7D, 0x7D, 0x00, 0xFB});     // error range
+  CHECK_NEAR(rpm, 2500, 0.01);
+  send(eec1, {0xF0, 0x7D, 0x7D, 0xFF, 0xFA});     // top of the valid range
+  CHECK_NEAR(rpm, 0xFAFF * 0.125, 0.01);
+
+  // IC1: SPN 102 is gauge pressure, like every other boost source
+  const uint32_t ic1 = J1939::makeId(6, J1939::PGN_IC1, 0x00);
+  send(ic1, {0xFF, 0x00, 0x46});
+  CHECK_NEAR(boost_kPa, 0, 0.01);                 // idle: no boost
+  CHECK_NEAR(manifoldC, 30, 0.01);
+  send(ic1, {0xFF, 0x32, 0x50});
+  CHECK_NEAR(boost_kPa, 100, 0.01);
+  CHECK_NEAR(manifoldC, 40, 0.01);
+  send(ic1, {0xFF, 0xFB, 0xFE});
+  CHECK_NEAR(boost_kPa, 100, 0.01);
+  CHECK_NEAR(manifoldC, 40, 0.01);
+  send(ic1, {0xFF, 0xFA, 0xFF});
+  CHECK_NEAR(boost_kPa, 500, 0.01);
+  CHECK_NEAR(manifoldC, 40, 0.01);
+
+  const uint32_t et1 = J1939::makeId(6, J1939::PGN_ET1, 0x00);
+  send(et1, {0x7D});
+  CHECK_NEAR(coolantC, 85, 0.01);
+  for (uint8_t na : {0xFB, 0xFC, 0xFD, 0xFE, 0xFF}) {
+    send(et1, {na});
+    CHECK_NEAR(coolantC, 85, 0.01);
+  }
+  send(et1, {0x00});
+  CHECK_NEAR(coolantC, -40, 0.01);
+  CHECK_EQ(J1939::stats().decoded - decoded, 15);
+
+  // Nothing reads an unknown PGN
+  send(J1939::makeId(6, 0xFEE5, 0x00), {0x01, 0x02});
+  CHECK_EQ(J1939::stats().decoded - decoded, 15);
+}
+
+// Three DTCs from the engine by BAM, the second packet first
+void bamReassembly() {
+  const J1939::Stats before = J1939::stats();
+  const uint16_t gen = J1939::dtcGeneration();
+  uint8_t msg[14] = {0x04, 0xFF};
+  putDtc(&msg[2], 100, 1, 3);
+  putDtc(&msg[6], 110, 0, 1);
+  putDtc(&msg[10], 3719, 16, 2);
+  send(J1939::makeId(7, J1939::PGN_TP_CM, 0x00, J1939::ADDR_GLOBAL), {32, 14, 0, 2, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(0x00, J1939::ADDR_GLOBAL, msg, sizeof(msg), 2, 50);
+  CHECK_EQ(J1939::dtcCount(g_now), 0);
+  sendPacket(0x00, J1939::ADDR_GLOBAL, msg, sizeof(msg), 1, 50);
+  CHECK_EQ(J1939::stats().tpStarted - before.tpStarted, 1);
+  CHECK_EQ(J1939::stats().tpDone - before.tpDone, 1);
+  CHECK_EQ(J1939::dtcCount(g_now), 3);
+  CHECK(hasDtc(100, 1, 3, 0x00));
+  CHECK(hasDtc(110, 0, 1, 0x00));
+  CHECK(hasDtc(3719, 16, 2, 0x00));
+  CHECK_EQ(static_cast<uint16_t>(J1939::dtcGeneration() - gen), 1);
+
+  // A gap just under T1 is still one transfer
+  send(J1939::makeId(7, J1939::PGN_TP_CM, 0x00, J1939::ADDR_GLOBAL), {32, 14, 0, 2, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(0x00, J1939::ADDR_GLOBAL, msg, sizeof(msg), 1, J1939::TP_BAM_MS - 1);
+  sendPacket(0x00, J1939::ADDR_GLOBAL, msg, sizeof(msg), 2, J1939::TP_BAM_MS - 1);
+  CHECK_EQ(J1939::stats().tpDone - before.tpDone, 2);
+  CHECK_EQ(J1939::stats().tpTimeouts, before.tpTimeouts);
+  CHECK_EQ(static_cast<uint16_t>(J1939::dtcGeneration() - gen), 1);   // the same three DTCs
+}
+
+// Four DTCs from the transmission to a service tool, followed passively: packets 1, 1 again, 3, 2
+void rtsCtsReassembly() {
+  const J1939::Stats before = J1939::stats();
+  const uint8_t sa = 0x03, da = 0xF9;
+  uint8_t msg[18] = {0x00, 0xFF};
+  for (uint8_t i = 0; i < 4; i++) {
+    putDtc(&msg[2 + 4 * i], 0x70000 + 177 + i, 2 + i, 1);   // SPNs above 16 bits too
+  }
+  send(J1939::makeId(7, J1939::PGN_TP_CM, sa, da), {16, 18, 0, 3, 0xFF, 0xCA, 0xFE, 0x00});
+  send(J1939::makeId(7, J1939::PGN_TP_CM, da, sa), {17, 2, 1, 0xFF, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(sa, da, msg, sizeof(msg), 1);
+  sendPacket(sa, da, msg, sizeof(msg), 1);   // retransmitted
+  CHECK_EQ(J1939::stats().tpDone, before.tpDone);
+  send(J1939::makeId(7, J1939::PGN_TP_CM, da, sa), {17, 2, 3, 0xFF, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(sa, da, msg, sizeof(msg), 3);
+  sendPacket(sa, da, msg, sizeof(msg), 2);
+  send(J1939::makeId(7, J1939::PGN_TP_CM, da, sa), {19, 18, 0, 3, 0xFF, 0xCA, 0xFE, 0x00});
+  CHECK_EQ(J1939::stats().tpDone - before.tpDone, 1);
+  CHECK_EQ(J1939::stats().tpBadSeq, before.tpBadSeq);
+  CHECK_EQ(J1939::stats().tpOrphan, before.tpOrphan);
+  for (uint8_t i = 0; i < 4; i++) {
+    CHECK(hasDtc(0x70000 + 177 + i, 2 + i, 1, sa));
+  }
+  CHECK_EQ(J1939::dtcCount(g_now), 7);
+
+  // A packet number past the announced count is rejected, not written past the buffer
+  send(J1939::makeId(7, J1939::PGN_TP_CM, sa, da), {16, 18, 0, 3, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(sa, da, msg, sizeof(msg), 4);
+  CHECK_EQ(J1939::stats().tpBadSeq - before.tpBadSeq, 1);
+  send(J1939::makeId(7, J1939::PGN_TP_CM, da, sa), {255, 1, 0xFF, 0xFF, 0xFF, 0xCA, 0xFE, 0x00});
+}
+
+void timeoutAndAbort() {
+  const J1939::Stats before = J1939::stats();
+  uint8_t msg[14] = {0x00, 0xFF};
+  putDtc(&msg[2], 520, 7, 1);
+  putDtc(&msg[6], 521, 7, 1);
+  putDtc(&msg[10], 522, 7, 1);
+
+  // BAM: T1 runs out between the packets; the late one has no session left
+  send(J1939::makeId(7, J1939::PGN_TP_CM, 0x05, J1939::ADDR_GLOBAL), {32, 14, 0, 2, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(0x05, J1939::ADDR_GLOBAL, msg, sizeof(msg), 1);
+  sendPacket(0x05, J1939::ADDR_GLOBAL, msg, sizeof(msg), 2, J1939::TP_BAM_MS);
+  CHECK_EQ(J1939::stats().tpTimeouts - before.tpTimeouts, 1);
+  CHECK_EQ(J1939::stats().tpOrphan - before.tpOrphan, 1);
+  CHECK_EQ(J1939::stats().tpDone, before.tpDone);
+  CHECK(!hasDtc(520, 7, 1, 0x05));
+
+  // RTS/CTS: the receiver gives up after the first packet
+  send(J1939::makeId(7, J1939::PGN_TP_CM, 0x06, 0x22), {16, 14, 0, 2, 0xFF, 0xCA, 0xFE, 0x00});
+  send(J1939::makeId(7, J1939::PGN_TP_CM, 0x22, 0x06), {17, 2, 1, 0xFF, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(0x06, 0x22, msg, sizeof(msg), 1);
+  send(J1939::makeId(7, J1939::PGN_TP_CM, 0x22, 0x06), {255, 3, 0xFF, 0xFF, 0xFF, 0xCA, 0xFE, 0x00});
+  sendPacket(0x06, 0x22, msg, sizeof(msg), 2);
+  CHECK_EQ(J1939::stats().tpAborted - before.tpAborted, 1);
+  CHECK_EQ(J1939::stats().tpOrphan - before.tpOrphan, 2);
+  CHECK_EQ(J1939::stats().tpDone, before.tpDone);
+  CHECK(!hasDtc(520, 7, 1, 0x06));
+
+  // Unknown PGNs are not reassembled, and their data is expected rather than orphaned
+  send(J1939::makeId(7, J1939::PGN_TP_CM, 0x07, J1939::ADDR_GLOBAL), {32, 14, 0, 2, 0xFF, 0xE5, 0xFE, 0x00});
+  sendPacket(0x07, J1939::ADDR_GLOBAL, msg, sizeof(msg), 1);
+  sendPacket(0x07, J1939::ADDR_GLOBAL, msg, sizeof(msg), 2);
+  CHECK_EQ(J1939::stats().tpStarted - before.tpStarted, 2);
+  CHECK_EQ(J1939::stats().tpOrphan - before.tpOrphan, 2);
+}
+
+// Single-frame DM1 every second from one ECU while the others stay quiet
+void dm1Generation() {
+  const uint32_t dm1 = J1939::makeId(6, J1939::PGN_DM1, 0x10);
+  uint16_t gen = J1939::dtcGeneration();
+  send(dm1, {0x04, 0xFF, 0xBE, 0x00, 0x03, 0x01}, 1000);   // SPN 190 FMI 3
+  CHECK_EQ(static_cast<uint16_t>(J1939::dtcGeneration() - gen), 1);
+  CHECK(hasDtc(190, 3, 1, 0x10));
+  gen = J1939::dtcGeneration();
+  send(dm1, {0x04, 0xFF, 0xBE, 0x00, 0x03, 0x01}, 1000);
+  send(dm1, {0x14, 0xFF, 0xBE, 0x00, 0x03, 0x01}, 1000);   // lamps change, the list does not
+  CHECK_EQ(J1939::dtcGeneration(), gen);
+  send(dm1, {0x04, 0xFF, 0xBE, 0x00, 0x03, 0x02}, 1000);   // occurrence count
+  CHECK_EQ(static_cast<uint16_t>(J1939::dtcGeneration() - gen), 1);
+  CHECK(hasDtc(190, 3, 2, 0x10));
+  gen = J1939::dtcGeneration();
+  send(dm1, {0x04, 0xFF, 0xBE, 0x00, 0x04, 0x02}, 1000);   // failure mode
+  CHECK_EQ(static_cast<uint16_t>(J1939::dtcGeneration() - gen), 1);
+  gen = J1939::dtcGeneration();
+  send(dm1, {0x00, 0xFF, 0x00, 0x00, 0x00, 0x00}, 1000);   // cleared
+  CHECK_EQ(static_cast<uint16_t>(J1939::dtcGeneration() - gen), 1);
+  CHECK(!hasDtc(190, 4, 2, 0x10));
+  gen = J1939::dtcGeneration();
+  send(dm1, {0x00, 0xFF, 0x00, 0x00, 0x00, 0x00}, 1000);
+  CHECK_EQ(J1939::dtcGeneration(), gen);
+
+  // The other ECUs went quiet: their lists drop out of the count without a generation change
+  CHECK_EQ(J1939::dtcCount(g_now), 0);
+  CHECK_EQ(J1939::dtcGeneration(), gen);
+}
+}  // namespace
+
+int main() {
+  J1939::begin();
+  CHECK(J1939::stats().maxProbe < 4);
+  identifiers();
+  parameters();
+  bamReassembly();
+  rtsCtsReassembly();
+  timeoutAndAbort();
+  dm1Generation();
+  return checkResult("j1939");
+}
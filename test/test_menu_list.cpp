@@ -0,0 +1,92 @@
+// Menu lists: rows drawn per key on a 20-row list, against the scrolling window the menus used
+// before (a step past either edge moved the window one row, cleared the body and drew every
+// visible row), plus the slot cache's behaviour on refresh and a shrinking model.
+#include <Arduino.h>
+#include <vector>
+#include "MenuList.h"
+#include "check.h"
+
+namespace {
+uint16_t g_count = 20;
+char g_text[32][12];
+uint32_t g_draws = 0, g_clears = 0;
+
+uint16_t count() { return g_count; }
+MenuList::Row row(uint16_t idx) { return MenuList::Row{g_text[idx], "x"}; }
+const MenuList::Model kModel = {count, row};
+
+void drawRow(uint8_t, const char*, const char*, bool) { g_draws++; }
+void clearRow(uint8_t) { g_clears++; }
+
+// The old window: scrolls to keep the selection on screen, full redraw whenever it moves
+struct Legacy {
+  uint16_t sel = 0, top = 0;
+  uint32_t rows = 0;
+  uint8_t maxRows = 0;
+  void step(int8_t dir) {
+    sel = dir < 0 ? (sel > 0 ? sel - 1 : g_count - 1) : (sel + 1 < g_count ? sel + 1 : 0);
+    const uint16_t oldTop = top;
+    if (sel < top) top = sel;
+    if (sel >= top + MenuList::ROWS) top = sel - MenuList::ROWS + 1;
+    const uint8_t n = top != oldTop ? MenuList::ROWS : 2;
+    rows += n;
+    if (n > maxRows) maxRows = n;
+  }
+};
+
+uint32_t g_seed = 7;
+int8_t randomKey() {
+  g_seed = g_seed * 1664525u + 1013904223u;
+  return (g_seed >> 16) % 5 < 3 ? 1 : -1;   // browsing mostly goes down
+}
+}  // namespace
+
+int main() {
+  for (uint16_t i = 0; i < 32; i++) {
+    snprintf(g_text[i], sizeof(g_text[i]), "Row %u", i);
+  }
+  MenuList::begin(drawRow, clearRow);
+  MenuList::List l = {&kModel, 0, 0};
+  MenuList::focus(l, 0);
+  MenuList::show(l);
+  CHECK_EQ(g_draws, MenuList::ROWS);
+
+  // Two laps down, two laps up, then a random walk
+  Legacy old;
+  std::vector<int8_t> keys(40, 1);
+  keys.insert(keys.end(), 40, -1);
+  for (int i = 0; i < 200; i++) {
+    keys.push_back(randomKey());
+  }
+  for (int8_t k : keys) {
+    const uint16_t before = l.top;
+    const uint8_t n = MenuList::step(l, k);
+    old.step(k);
+    if (l.top == before) {
+      CHECK_EQ(n, 2);   // old and new highlight only
+    }
+    CHECK(n <= MenuList::ROWS);
+  }
+  const MenuList::Stats& s = MenuList::stats();
+  CHECK_EQ(s.keys, keys.size());
+  const float perKey = static_cast<float>(s.rowsDrawn) / s.keys;
+  const float oldPerKey = static_cast<float>(old.rows) / keys.size();
+  printf("menu_list: %u keys on %u rows: %.2f rows drawn per key (max %u), scrolling window %.2f (max %u)\n",
+         s.keys, g_count, perKey, s.maxKeyRows, oldPerKey, old.maxRows);
+  CHECK(perKey < oldPerKey);
+
+  // Nothing changed: nothing drawn. One row's text changed: that row only.
+  CHECK_EQ(MenuList::refresh(l), 0);
+  snprintf(g_text[l.top + 1], sizeof(g_text[0]), "changed");
+  CHECK_EQ(MenuList::refresh(l), l.top + 1 < g_count ? 1 : 0);
+
+  // The model shrinks while the list is closed: show() clamps and clears the empty slots
+  MenuList::focus(l, 19);
+  g_count = 16;
+  g_clears = 0;
+  MenuList::show(l);
+  CHECK_EQ(l.sel, 15);
+  CHECK_EQ(l.top, 14);
+  CHECK_EQ(g_clears, MenuList::ROWS - 2);
+  return checkResult("menu_list");
+}
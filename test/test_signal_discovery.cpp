@@ -0,0 +1,126 @@
+// Signal discovery replayed over a two-bus capture.
+// data/discovery_two_bus.log is a candump log of the bus generator (BusSim) during the drive
+// cycle's speed ramp: powertrain IDs on can0 and, on can1, a body ECU that reuses 0x141 for an
+// unrelated counter at its own 25 ms period. Frames go through the decoders, the census and
+// discovery in drain order, with the decoded speed as the reference, as snifferMaybeCapture()
+// feeds them on the dash. The winner is then saved as a user gauge, which must only decode it from
+// the bus it was found on.
+#include <Arduino.h>
+#include "CanCensus.h"
+#include "CanDecode.h"
+#include "SignalDiscovery.h"
+#include "UserChannels.h"
+#include "check.h"
+
+namespace {
+struct Frame {
+  uint64_t us;
+  uint8_t bus;
+  can_frame f;
+};
+
+bool parse(const char* line, Frame& out) {
+  unsigned long sec, usec;
+  unsigned bus;
+  char id[16], data[24] = "";
+  if (sscanf(line, "(%lu.%lu) can%u %15[0-9A-Fa-f]#%23[0-9A-Fa-f]", &sec, &usec, &bus, id, data) < 4) {
+    return false;
+  }
+  out = {};
+  out.us = static_cast<uint64_t>(sec) * 1000000 + usec;
+  out.bus = static_cast<uint8_t>(bus);
+  out.f.can_id = static_cast<uint32_t>(strtoul(id, nullptr, 16));
+  if (strlen(id) > 3) {
+    out.f.can_id |= CAN_EFF_FLAG;
+  }
+  out.f.can_dlc = static_cast<uint8_t>(strlen(data) / 2);
+  for (uint8_t i = 0; i < out.f.can_dlc && i < 8; i++) {
+    char byte[3] = {data[2 * i], data[2 * i + 1], 0};
+    out.f.data[i] = static_cast<uint8_t>(strtoul(byte, nullptr, 16));
+  }
+  return true;
+}
+
+void replay(FILE* log, uint64_t startAfterUs) {
+  char line[128];
+  Frame fr;
+  uint64_t firstUs = 0;
+  while (fgets(line, sizeof(line), log)) {
+    if (!parse(line, fr)) {
+      continue;
+    }
+    if (!firstUs) {
+      firstUs = fr.us;
+    }
+    host::setMicros(fr.us - firstUs + 1000000);
+    const unsigned long now = millis();
+    CanDec::decodeFrame(fr.f, fr.bus);
+    CanCensus::record(fr.f, fr.bus, now);
+    CanCensus::tick(now);
+    if (!SignalDiscovery::active() && fr.us - firstUs >= startAfterUs) {
+      SignalDiscovery::start(0);   // seeded from the census, as the sniffer page does
+    }
+    if (SignalDiscovery::active()) {
+      SignalDiscovery::record(fr.f, fr.bus, speed_kmh, now);
+    }
+  }
+}
+}  // namespace
+
+int main() {
+  FILE* log = fopen("data/discovery_two_bus.log", "r");
+  if (!log) {
+    perror("data/discovery_two_bus.log");
+    return 1;
+  }
+  CanDec::setBodyBus(1);
+  CanCensus::reset();
+  replay(log, 1000000);
+  fclose(log);
+
+  // 0x141 on each bus is its own source, next to the other seven IDs of the capture
+  CHECK_EQ(SignalDiscovery::watchedIds(), 9);
+
+  SignalDiscovery::Candidate top[32];
+  const uint8_t n = SignalDiscovery::top(top, 32);
+  CHECK(n > 0);
+  if (n > 0) {
+    const SignalDiscovery::Candidate& c = top[0];
+    CHECK_EQ(c.id, 0x141);
+    CHECK_EQ(c.bus, 0);
+    CHECK_EQ(c.fromBit, 8);
+    CHECK_EQ(c.toBit, 23);
+    CHECK_EQ(c.order, CanField::ORDER_BE);
+    CHECK(c.r > 0.9999f);
+    CHECK_NEAR(c.scale, 1.0 / 64, 1e-5);
+    CHECK_NEAR(c.offset, 0.0, 0.05);
+    CHECK(c.samples >= SignalDiscovery::MIN_SAMPLES);
+
+    // Saved the way snfSaveToUserChannel() does: the body bus's 0x141 leaves the gauge alone
+    UserChannelDef u = {};
+    u.canId = c.id;
+    u.bus = c.bus;
+    u.enabled = 1;
+    u.fromBit = c.fromBit;
+    u.toBit = c.toBit;
+    u.order = c.order;
+    u.scale = c.scale;
+    u.bias = c.offset;
+    UserCh::configure(&u, 1);
+    can_frame f = {};
+    f.can_id = 0x141;
+    f.can_dlc = 8;
+    f.data[1] = 0x10;   // 4096 / 64 = 64 km/h
+    UserCh::decodeFrame(f, 1);
+    CHECK(isnan(UserCh::value(0)));
+    UserCh::decodeFrame(f, 0);
+    CHECK_NEAR(UserCh::value(0), 64.0, 0.1);
+  }
+  // The body bus's 0x141 carries nothing related; it must not borrow the speed samples
+  for (uint8_t i = 0; i < n; i++) {
+    if (top[i].id == 0x141 && top[i].bus == 1) {
+      CHECK(fabsf(top[i].r) < 0.5f);
+    }
+  }
+  return checkResult("signal_discovery");
+}
@@ -0,0 +1,111 @@
+// Signal filters: the pill-redraw reduction on a noisy boost trace, per-channel fixed-point
+// scaling for channels whose range passes the old +/-32767 clamp, and the bounds checks.
+#include <Arduino.h>
+#include "ChannelTraits.h"
+#include "DerivedChannels.h"
+#include "SignalFilter.h"
+#include "check.h"
+
+extern float boost_kPa, rpm, lambdaVal;
+
+uint8_t g_uPressure = 0, g_uTemp = 0, g_uSpeed = 0, g_uLambda = 0;
+float speedTrimPct = 0;
+const VictronReadings& victronReadings() {
+  static VictronReadings r{};
+  return r;
+}
+
+namespace {
+// Deterministic Gaussian noise (Box-Muller over a 32-bit LCG)
+uint32_t g_seed = 12345;
+float uniform() {
+  g_seed = g_seed * 1664525u + 1013904223u;
+  return ((g_seed >> 8) + 0.5f) / 16777216.0f;
+}
+float gauss(float sigma) { return sigma * sqrtf(-2.0f * logf(uniform())) * cosf(2.0f * PI * uniform()); }
+
+// 50 Hz samples for `seconds`, filters ticking alongside; returns mean key changes/s (raw, filtered)
+void replayBoost(uint32_t seconds, float* rawPerSec, float* filteredPerSec) {
+  uint32_t raw = 0, filtered = 0, windows = 0;
+  for (uint32_t i = 0; i < seconds * 50; i++) {
+    const float t = i / 50.0f;
+    boost_kPa = 80.0f + 60.0f * sinf(2.0f * PI * t / 12.0f) + gauss(1.5f);
+    host::advanceMs(20);
+    Filters::update(millis());
+    if (i % 50 == 49 && i > 50) {
+      raw += Filters::stats().rawKeyChangesPerSec;
+      filtered += Filters::stats().keyChangesPerSec;
+      windows++;
+    }
+  }
+  *rawPerSec = static_cast<float>(raw) / windows;
+  *filteredPerSec = static_cast<float>(filtered) / windows;
+}
+
+DerivedChannelDef derived(const char* expr, float mn, float mx) {
+  DerivedChannelDef d = {};
+  d.enabled = 1;
+  d.rangeMin = mn;
+  d.rangeMax = mx;
+  strncpy(d.expr, expr, DERIVED_EXPR_LEN);
+  return d;
+}
+}  // namespace
+
+int main() {
+  host::setMicros(1000000);
+  ChannelFilterDef defs[CH__COUNT] = {};
+
+  // Boost, median 3 then a 150 ms EMA: the redraw count the filter exists to cut
+  Channels::rebuild();
+  defs[CH_BOOST].median = 3;
+  defs[CH_BOOST].emaTauMs = 150;
+  Filters::configure(defs, CH__COUNT);
+  CHECK(Filters::active(CH_BOOST));
+  float rawPerSec, filteredPerSec;
+  replayBoost(60, &rawPerSec, &filteredPerSec);
+  printf("signal_filter: boost key changes/s %.1f raw, %.1f filtered\n", rawPerSec, filteredPerSec);
+  CHECK(rawPerSec > 30);
+  CHECK(filteredPerSec < rawPerSec / 2);
+
+  // A derived channel ranged past 32767 keeps its value instead of clamping there
+  const DerivedChannelDef wide[] = {derived("rpm * 20", 0, 120000), derived("rpm * 1000000", 0, 5e9f)};
+  Derived::configure(wide, 2);
+  Channels::rebuild();
+  rpm = 4500;
+  Derived::update();
+  defs[CH_CALC1].median = 3;
+  defs[CH_CALC2].median = 3;
+  Filters::configure(defs, CH__COUNT);
+  CHECK(Filters::supports(CH_CALC1));
+  CHECK(Filters::active(CH_CALC1));
+  for (int i = 0; i < 5; i++) {
+    host::advanceMs(20);
+    Filters::update(millis());
+  }
+  CHECK_NEAR(Filters::value(CH_CALC1), 90000, 0.01);
+
+  // Too wide for any scaling: refused, and the raw value passes through
+  CHECK(!Filters::supports(CH_CALC2));
+  CHECK(!Filters::active(CH_CALC2));
+  CHECK_NEAR(Filters::value(CH_CALC2), 4.5e9, 1e3);
+
+  // Narrow channels keep 16 fractional bits: a slew limit of 0.05/s still moves
+  defs[CH_LAMBDA] = ChannelFilterDef{0, 0, 0, 0.05f};
+  Filters::configure(defs, CH__COUNT);
+  lambdaVal = 1.0f;
+  host::advanceMs(20);
+  Filters::update(millis());
+  lambdaVal = 2.0f;
+  for (int i = 0; i < 50; i++) {
+    host::advanceMs(20);
+    Filters::update(millis());
+  }
+  CHECK_NEAR(Filters::value(CH_LAMBDA), 1.05, 0.001);
+
+  CHECK(!Filters::active(CH__COUNT));
+  CHECK(!Filters::supports(static_cast<Channel>(CH__COUNT + 3)));
+  CHECK(isnan(Filters::value(CH__COUNT)));
+  CHECK(isnan(Filters::warnValue(static_cast<Channel>(0xFF))));
+  return checkResult("signal_filter");
+}
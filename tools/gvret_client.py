@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""Check the dash's GVRET bridge (Gvret.h) over TCP: handshake, framing, throughput and TX.
+
+Connects the way SavvyCAN does (binary mode, then the bus/info queries), checks every record in
+the stream for framing (command byte, length, bus, checksum byte) and prints the frames/s it
+sustains each second. Echo frames (F1 0B) are looped back by the dash into its own stream and
+must come back intact; --tx frames go out on the powertrain bus through CanTx.
+
+  gvret_client.py                              192.168.4.1:23, run until Ctrl-C
+  gvret_client.py --seconds 30 --echo 20       30 s, 20 echo frames/s checked on return
+  gvret_client.py --tx 7DF#0201050000000000 --tx-rate 10
+                                               also send an OBD request 10 times a second
+"""
+import argparse
+import socket
+import struct
+import sys
+import time
+
+GV_BINARY = 0xE7
+GV_CMD = 0xF1
+GV_FRAME = 0x00
+GV_BUSES = 0x06
+GV_INFO = 0x07
+GV_KEEP = 0x09
+GV_ECHO = 0x0B
+GV_NBUSES = 0x0C
+
+# Fixed reply lengths, header included; frames are 12 + dlc
+REPLY_LEN = {0x01: 6, 0x02: 4, 0x03: 11, GV_BUSES: 12, GV_INFO: 8, GV_KEEP: 4, GV_NBUSES: 3, 0x0D: 17}
+FRAME_HEAD = struct.Struct("<BBIIB")
+EXT_BIT = 1 << 31
+ECHO_ID = EXT_BIT | 0x1FFFF7AB   # extended, clear of anything on the dash's buses
+
+
+def parse_frame(spec):
+    """ID#DATA, candump style; an ID of more than three hex digits is extended."""
+    ident, _, data = spec.partition("#")
+    can_id = int(ident, 16)
+    if len(ident) > 3:
+        can_id |= EXT_BIT
+    payload = bytes.fromhex(data)
+    if len(payload) > 8:
+        sys.exit("%s: more than 8 data bytes" % spec)
+    return can_id, payload
+
+
+def encode(cmd, can_id, bus, payload):
+    body = struct.pack("<BBIBB", GV_CMD, cmd, can_id, bus, len(payload)) + payload
+    return body + b"\x00"
+
+
+class Stream:
+    def __init__(self, out):
+        self.out = out
+        self.buf = bytearray()
+        self.replies = {}
+        self.frames = 0
+        self.per_bus = [0, 0]
+        self.bad = 0
+        self.bad_checksum = 0
+        self.echo_sent = {}
+        self.echo_back = 0
+        self.echo_mismatch = 0
+        self.second = 0
+        self.window_start = None
+        self.rates = []
+
+    def framing(self, what):
+        if self.bad < 10:
+            self.out.write("framing: %s\n" % what)
+        self.bad += 1
+
+    def record(self, ts, can_id, bus, data):
+        self.frames += 1
+        self.second += 1
+        if bus < len(self.per_bus):
+            self.per_bus[bus] += 1
+        if can_id == ECHO_ID and len(data) == 8:
+            seq = struct.unpack_from("<I", data)[0]
+            want = self.echo_sent.pop(seq, None)
+            if want is None:
+                self.echo_mismatch += 1
+            else:
+                self.echo_back += 1
+                if want != bytes(data):
+                    self.echo_mismatch += 1
+
+    def feed(self, data):
+        self.buf += data
+        i = 0
+        n = len(self.buf)
+        while i < n:
+            if self.buf[i] != GV_CMD:
+                self.framing("0x%02X where a record should start" % self.buf[i])
+                i += 1
+                continue
+            if n - i < 2:
+                break
+            cmd = self.buf[i + 1]
+            if cmd == GV_FRAME:
+                if n - i < FRAME_HEAD.size:
+                    break
+                _, _, ts, can_id, lenbus = FRAME_HEAD.unpack_from(self.buf, i)
+                dlc, bus = lenbus & 0x0F, lenbus >> 4
+                if dlc > 8 or bus > 1:
+                    self.framing("frame with dlc %d on bus %d" % (dlc, bus))
+                    i += 1
+                    continue
+                end = i + FRAME_HEAD.size + dlc + 1
+                if end > n:
+                    break
+                if self.buf[end - 1] != 0:
+                    self.bad_checksum += 1
+                self.record(ts, can_id, bus, self.buf[i + FRAME_HEAD.size:end - 1])
+                i = end
+            elif cmd in REPLY_LEN:
+                if n - i < REPLY_LEN[cmd]:
+                    break
+                self.replies[cmd] = bytes(self.buf[i + 2:i + REPLY_LEN[cmd]])
+                i += REPLY_LEN[cmd]
+            else:
+                self.framing("unknown command 0x%02X" % cmd)
+                i += 1
+        del self.buf[:i]
+
+    def tick(self, now):
+        if self.window_start is None:
+            self.window_start = now
+        elif now - self.window_start >= 1.0:
+            rate = self.second / (now - self.window_start)
+            self.rates.append(rate)
+            self.out.write("%6.0f frames/s  (bus0 %d, bus1 %d total)\n" % (rate, self.per_bus[0], self.per_bus[1]))
+            self.out.flush()
+            self.second = 0
+            self.window_start = now
+
+
+def wait_reply(sock, stream, cmd, timeout=2.0):
+    end = time.monotonic() + timeout
+    while cmd not in stream.replies:
+        left = end - time.monotonic()
+        if left <= 0:
+            sys.exit("no reply to command 0x%02X" % cmd)
+        sock.settimeout(left)
+        try:
+            data = sock.recv(4096)
+        except socket.timeout:
+            continue
+        if not data:
+            sys.exit("connection closed during the handshake")
+        stream.feed(data)
+    return stream.replies.pop(cmd)
+
+
+def handshake(sock, stream):
+    sock.sendall(bytes([GV_BINARY, GV_BINARY]))
+    sock.sendall(bytes([GV_CMD, GV_NBUSES, GV_CMD, GV_BUSES, GV_CMD, GV_INFO, GV_CMD, GV_KEEP]))
+    nbuses = wait_reply(sock, stream, GV_NBUSES)[0]
+    buses = wait_reply(sock, stream, GV_BUSES)
+    build = struct.unpack_from("<H", wait_reply(sock, stream, GV_INFO))[0]
+    if wait_reply(sock, stream, GV_KEEP) != b"\xde\xad":
+        sys.exit("keepalive reply is not DE AD")
+    desc = []
+    for b in range(2):
+        enabled, rate = struct.unpack_from("<BI", buses, 5 * b)
+        desc.append("bus%d %s %d bit/s" % (b, "on" if enabled else "off", rate))
+    print("build %d, %d buses: %s" % (build, nbuses, ", ".join(desc)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("host", nargs="?", default="192.168.4.1", help="dash address on its config AP")
+    ap.add_argument("--port", type=int, default=23)
+    ap.add_argument("--seconds", type=float, default=0, help="stop after this long (default: Ctrl-C)")
+    ap.add_argument("--echo", type=float, default=0, help="echo frames per second to loop back and check")
+    ap.add_argument("--tx", type=parse_frame, help="frame to send on bus 0, ID#DATA in hex")
+    ap.add_argument("--tx-rate", type=float, default=1, help="--tx frames per second (default 1)")
+    args = ap.parse_args()
+
+    sock = socket.create_connection((args.host, args.port), timeout=5)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    stream = Stream(sys.stdout)
+    handshake(sock, stream)
+
+    start = time.monotonic()
+    next_echo = next_tx = next_keep = start
+    echo_seq = tx_sent = 0
+    sock.settimeout(0.05)
+    try:
+        while not args.seconds or time.monotonic() - start < args.seconds:
+            now = time.monotonic()
+            if args.echo and now >= next_echo:
+                payload = struct.pack("<II", echo_seq, echo_seq ^ 0xA5A5A5A5)
+                stream.echo_sent[echo_seq] = payload
+                sock.sendall(encode(GV_ECHO, ECHO_ID, 0, payload))
+                echo_seq += 1
+                next_echo += 1.0 / args.echo
+            if args.tx and now >= next_tx:
+                sock.sendall(encode(GV_FRAME, args.tx[0], 0, args.tx[1]))
+                tx_sent += 1
+                next_tx += 1.0 / args.tx_rate
+            if now >= next_keep:
+                sock.sendall(bytes([GV_CMD, GV_KEEP]))   # SavvyCAN's keepalive, the reply is dropped
+                next_keep += 1.0
+            try:
+                data = sock.recv(65536)
+            except socket.timeout:
+                data = b""
+            else:
+                if not data:
+                    print("connection closed by the dash")
+                    break
+            stream.feed(data)
+            stream.tick(time.monotonic())
+    except KeyboardInterrupt:
+        pass
+    sock.close()
+
+    elapsed = time.monotonic() - start
+    sustained = stream.rates[1:] or stream.rates
+    print("%d frames in %.1f s (bus0 %d, bus1 %d)" % (stream.frames, elapsed, stream.per_bus[0], stream.per_bus[1]))
+    if sustained:
+        print("sustained %.0f frames/s, min %.0f, max %.0f" % (sum(sustained) / len(sustained), min(sustained), max(sustained)))
+    if args.echo:
+        print("echo: %d sent, %d back, %d corrupted or unexpected, %d outstanding"
+              % (echo_seq, stream.echo_back, stream.echo_mismatch, len(stream.echo_sent)))
+    if args.tx:
+        print("tx: %d frames sent to bus 0" % tx_sent)
+    print("framing errors %d, nonzero checksum bytes %d" % (stream.bad, stream.bad_checksum))
+    # Echoes still in flight at the end are not failures; a few batches may be unsent
+    lost = len(stream.echo_sent) > 2 * max(args.echo * 0.1, 1)
+    return 1 if stream.bad or stream.bad_checksum or stream.echo_mismatch or lost else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
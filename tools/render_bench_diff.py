@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Compare render bench results (test/bench_render.cpp) between two runs.
+
+Each capture is the bench's output, e.g. `make -C test bench > base.txt`; only the [BENCH]
+lines are used, so other output around them does no harm. Per-frame figures are averaged over
+every round of a scenario in the capture, maxima are the worst seen.
+
+  render_bench_diff.py base.txt candidate.txt
+  render_bench_diff.py capture.txt                 summary of one capture
+"""
+import argparse
+import re
+import sys
+
+LINE = re.compile(rb"\[BENCH\] (\S+) (.*)")
+FIELD = re.compile(r"(max )?([\w/]+)=(\d+)")
+ORDER = ["steady", "warn-storm", "screen-switch", "palette", "menu"]
+
+
+def load(path):
+    rounds = {}
+    for line in open(path, "rb").read().split(b"\n"):
+        m = LINE.search(line)
+        if not m:
+            continue
+        fields = {("max " if mx else "") + k: int(v) for mx, k, v in FIELD.findall(m.group(2).decode(errors="replace"))}
+        if fields.get("frames"):
+            rounds.setdefault(m.group(1).decode(), []).append(fields)
+    summary = {}
+    for sc, rs in rounds.items():
+        s = {"rounds": len(rs)}
+        for key in rs[0]:
+            vals = [r.get(key, 0) for r in rs]
+            s[key] = max(vals) if key.startswith("max ") else sum(vals) / len(vals)
+        summary[sc] = s
+    return summary
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("baseline")
+    ap.add_argument("candidate", nargs="?")
+    args = ap.parse_args()
+
+    base = load(args.baseline)
+    cand = load(args.candidate) if args.candidate else None
+    if not base:
+        sys.exit("%s: no [BENCH] lines" % args.baseline)
+    keys = ["px/frame", "windows/frame", "spiUs/frame", "max px", "max windows", "max spiUs"]
+    for sc in sorted(set(base) | set(cand or {}), key=lambda s: ORDER.index(s) if s in ORDER else len(ORDER)):
+        b = base.get(sc)
+        c = cand.get(sc) if cand is not None else None
+        print("%s (%s)" % (sc, ", ".join("%d rounds" % x["rounds"] for x in (b, c) if x)))
+        for k in keys:
+            bv = b.get(k) if b else None
+            if cand is None:
+                print("  %-14s %10.0f" % (k, bv or 0))
+                continue
+            cv = c.get(k) if c else None
+            if bv is None or cv is None:
+                print("  %-14s %10s %10s" % (k, "-" if bv is None else "%.0f" % bv, "-" if cv is None else "%.0f" % cv))
+                continue
+            pct = (cv - bv) * 100.0 / bv if bv else 0.0
+            print("  %-14s %10.0f %10.0f  %+6.1f%%" % (k, bv, cv, pct))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Decode the dash's binary trace log (Trace.h) from a serial port or a capture file.
+
+The event dictionary is read from TraceEvents.h and the category bits from Trace.h, so the tool
+always matches the firmware it sits next to. Text lines sharing the port ([BOOT], [POWER], ...)
+are passed through unchanged.
+
+  trace_decode.py /dev/ttyACM0                 live, needs pyserial
+  trace_decode.py /dev/ttyACM0 --mask can      change the enabled categories, then decode
+  trace_decode.py capture.bin                  a file written by e.g. `cat /dev/ttyACM0 > capture.bin`
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+FRAME_LEN = 15
+RECORD = struct.Struct("<IBBHI")
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..")
+
+
+def load_events(path):
+    events = []
+    for m in re.finditer(r'X\(\s*(\w+)\s*,\s*TC_(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', open(path).read()):
+        events.append((m.group(1), m.group(2).lower(), m.group(3)))
+    return events
+
+
+def load_categories(path):
+    return {m.group(1).lower(): 1 << int(m.group(2))
+            for m in re.finditer(r"TC_(\w+)\s*=\s*1u\s*<<\s*(\d+)", open(path).read())}
+
+
+def load_buttons(path):
+    m = re.search(r"enum\s+Btn\s*\{([^}]*)\}", open(path).read())
+    if not m:
+        return []
+    return [n.strip().replace("BTN_", "") for n in m.group(1).split(",") if n.strip()]
+
+
+class Decoder:
+    def __init__(self, events, buttons, out):
+        self.events = events
+        self.buttons = buttons
+        self.out = out
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.last_us = None
+        self.wraps = 0
+        self.t0 = None
+        self.seq = None
+        self.bad = 0
+
+    def field(self, name, conv, a, b):
+        v = {"a": a, "b": b, "alo": a & 0xFF, "ahi": a >> 8}[name]
+        if conv == "x":
+            return "%X" % v
+        if conv == "btn":
+            return self.buttons[v] if v < len(self.buttons) else str(v)
+        return str(v)
+
+    def record(self, us, event, seq, a, b):
+        if self.last_us is not None and us < self.last_us:
+            self.wraps += 1
+        self.last_us = us
+        t = (self.wraps << 32) + us
+        if self.t0 is None:
+            self.t0 = t
+        if self.seq is not None and seq != (self.seq + 1) & 0xFF:
+            self.out.write("%12s  -- %d records missing (no host attached)\n" % ("", (seq - self.seq - 1) & 0xFF))
+        self.seq = seq
+        if event < len(self.events):
+            name, cat, fmt = self.events[event]
+            msg = re.sub(r"\{(\w+)(?::(\w+))?\}", lambda m: self.field(m.group(1), m.group(2), a, b), fmt)
+        else:
+            name, cat, msg = "event%d" % event, "?", "a=%d b=%d" % (a, b)
+        self.out.write("%12.6f  %-8s %-20s %s\n" % ((t - self.t0) / 1e6, cat, name[3:].lower(), msg))
+
+    def feed(self, data):
+        self.buf += data
+        i = 0
+        n = len(self.buf)
+        while i < n:
+            if self.buf[i] == SYNC[0]:
+                if n - i < FRAME_LEN:
+                    break
+                frame = self.buf[i:i + FRAME_LEN]
+                body = frame[2:14]
+                x = 0
+                for c in body:
+                    x ^= c
+                if frame[1] == SYNC[1] and x == frame[14]:
+                    self.flush_text()
+                    self.record(*RECORD.unpack(bytes(body)))
+                    i += FRAME_LEN
+                    continue
+                self.bad += 1
+            c = self.buf[i]
+            if c == 0x0A:
+                self.flush_text()
+            elif c != 0x0D:
+                self.text.append(c)
+            i += 1
+        del self.buf[:i]
+        self.out.flush()
+
+    def flush_text(self):
+        if self.text:
+            self.out.write(self.text.decode("ascii", "replace") + "\n")
+            self.text.clear()
+
+
+def parse_mask(spec, categories):
+    try:
+        return int(spec, 16)
+    except ValueError:
+        pass
+    mask = 0
+    for name in spec.split(","):
+        name = name.strip().lower()
+        if name not in categories:
+            sys.exit("unknown category %r, have: %s" % (name, ", ".join(sorted(categories))))
+        mask |= categories[name]
+    return mask
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="serial port, capture file, or - for stdin")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--mask", help="categories to enable: hex bits or names, e.g. can,buttons")
+    ap.add_argument("--src", default=SRC, help="firmware source directory (default: the repo)")
+    args = ap.parse_args()
+
+    events = load_events(os.path.join(args.src, "TraceEvents.h"))
+    categories = load_categories(os.path.join(args.src, "Trace.h"))
+    buttons = load_buttons(os.path.join(args.src, "DashTypes.h"))
+    dec = Decoder(events, buttons, sys.stdout)
+
+    if args.source == "-":
+        stream = sys.stdin.buffer
+    elif os.path.isfile(args.source):
+        stream = open(args.source, "rb")
+    else:
+        import serial  # pyserial
+        stream = serial.Serial(args.source, args.baud, timeout=0.1)
+        if args.mask:
+            stream.write(b"T%X\n" % parse_mask(args.mask, categories))
+    try:
+        while True:
+            data = stream.read(4096) if hasattr(stream, "in_waiting") else stream.read1(4096)
+            if data:
+                dec.feed(data)
+            elif not hasattr(stream, "in_waiting"):
+                break
+    except KeyboardInterrupt:
+        pass
+    dec.flush_text()
+    if dec.bad:
+        sys.stderr.write("%d sync bytes failed the checksum\n" % dec.bad)
+
+
+if __name__ == "__main__":
+    main()